@@ -1,8 +1,19 @@
 #include "SimpleDemo.h"
 #include "DemoSystem.h"
+#include "VertexQuantization.h"
+
+#include <glm/gtc/matrix_transform.hpp>
 
 struct VERTEX { vec3 pos; vec2 texCoord; uint32_t color; };
 struct UI_VERTEX { vec2 pos; vec2 texCoord; uint32_t color; };
+struct INSTANCE { mat4 world; uint32_t color; };
+
+#define INSTANCE_GRID_SIZE 100
+#define INSTANCE_COUNT (INSTANCE_GRID_SIZE * INSTANCE_GRID_SIZE)
+
+static const VertexAttributes instanceAttributeFlags = VertexAttributes::InstanceWorld | VertexAttributes::InstanceColor32;
+
+static INSTANCE instances[INSTANCE_COUNT];
 
 //struct VERTEX_COLOR { vec3 pos; vec4 color; };
 
@@ -191,27 +202,70 @@ void SimpleDemo::CreateGraphics(IGraphicsDevice* gDevice)
 										  VertexAttributes::TexCoord |
 										  VertexAttributes::Color32;
 
-	MeshData myMeshData(texCubeVertices, 36, texCubeIndices, 36);
-	myMesh = gDevice->CreateMesh(myMeshData, vertAttributeFlags, BufferUsage::Stream);
-	myShader = gDevice->CreateShader("TestShader");
+	// the cube's texture coordinates are all inside [0, 1], so its vertices shrink from 24 to 16 bytes
+	VertexAttributes compactAttributeFlags = GetCompactVertexAttributes(vertAttributeFlags, true);
+	std::vector<uint8> compactVertices;
+
+	MeshData myMeshData = QuantizeMeshData(MeshData(texCubeVertices, 36, texCubeIndices, 36), vertAttributeFlags, compactAttributeFlags, compactVertices);
+	myMesh = gDevice->CreateMesh(myMeshData, compactAttributeFlags, BufferUsage::Stream);
+
+	// both shaders compile in the background, draws using them are skipped until they are ready
+	myShader = gDevice->CreateShaderAsync("TestShader");
 
 	// create texture
 	myTexture = demoSystem->LoadTexture("Resources/TestTexture.png");
+
+	// the instance data is rewritten every frame
+	instancedShader = gDevice->CreateShaderAsync("InstancedShader");
+	instanceBuffer = gDevice->CreateBuffer(nullptr, sizeof(instances), BufferTarget::Vertex, BufferUsage::Stream);
 }
 
 void SimpleDemo::Draw(IGraphicsDevice* gDevice)
 {
 	if (true)
 	{
-		gDevice->SetShader(myShader);
-		gDevice->SetTexture(myTexture, 0);
-		gDevice->DrawMeshIndexed(myMesh, 0);
+		RenderItem item;
+		item.mesh = myMesh;
+		item.shader = myShader;
+		item.textures[0] = myTexture;
+
+		demoSystem->renderQueue.Push(item);
 	}
+
+	// animate a grid of small cubes behind the main cube and draw them all in one call
+	float time = Time::time();
+	float spacing = 0.05f;
+	float gridOffset = (INSTANCE_GRID_SIZE - 1) * spacing * 0.5f;
+
+	for (uint32 y = 0; y < INSTANCE_GRID_SIZE; y++)
+	{
+		for (uint32 x = 0; x < INSTANCE_GRID_SIZE; x++)
+		{
+			INSTANCE &instance = instances[y * INSTANCE_GRID_SIZE + x];
+
+			float u = static_cast<float>(x) / (INSTANCE_GRID_SIZE - 1);
+			float v = static_cast<float>(y) / (INSTANCE_GRID_SIZE - 1);
+			float wave = sin(time * 2.0f + (u + v) * 10.0f) * 0.1f;
+
+			vec3 position(x * spacing - gridOffset, y * spacing - gridOffset, wave - 1.5f);
+
+			instance.world = glm::scale(glm::translate(mat4(1.0f), position), vec3(0.03f));
+			instance.color = GET_COLOR32(u, v, 1.0f, 1.0f);
+		}
+	}
+
+	gDevice->UpdateBuffer(instanceBuffer, instances, sizeof(instances));
+
+	gDevice->SetShader(instancedShader);
+	gDevice->SetTexture(myTexture, 0);
+	gDevice->DrawMeshIndexedInstanced(myMesh, instanceBuffer, instanceAttributeFlags, INSTANCE_COUNT);
 }
 
 void SimpleDemo::ReleaseGraphics(IGraphicsDevice* gDevice)
 {
 	gDevice->ReleaseShader(myShader);
+	gDevice->ReleaseShader(instancedShader);
+	gDevice->ReleaseBuffer(instanceBuffer);
 	gDevice->ReleaseMesh(myMesh);
 	gDevice->ReleaseTexture(myTexture);
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 class Shader;
 class Mesh;
 class Texture;
+class Buffer;
 
 class SimpleDemo : public Demo
 {
@@ -27,6 +28,10 @@ private:
 	Texture* myTexture = nullptr;
 	Mesh* myMesh = nullptr;
 	Mesh* myMesh2 = nullptr;
+
+	// grid of cubes drawn with a single instanced draw
+	Shader* instancedShader = nullptr;
+	Buffer* instanceBuffer = nullptr;
 };
 
 #endif // _SIMPLE_DEMO_H
\ No newline at end of file
@@ -0,0 +1,50 @@
+//--------------------------------------------------------------------------------------
+// Vertex Shader
+//--------------------------------------------------------------------------------------
+
+#include "Common.fxh"
+
+struct VS_INPUT
+{
+	float4 Pos : POSITION;
+	float2 Tex : TEXCOORD0;
+	float4 Col : COLOR;
+
+	// per instance, the world matrix is passed as its 4 columns
+	float4 World0 : INSTANCE_WORLD0;
+	float4 World1 : INSTANCE_WORLD1;
+	float4 World2 : INSTANCE_WORLD2;
+	float4 World3 : INSTANCE_WORLD3;
+	float4 InstCol : INSTANCE_COLOR;
+};
+
+struct PS_INPUT
+{
+	float4 Pos : SV_POSITION;
+	float2 Tex : TEXCOORD0;
+	float4 Col : COLOR;
+};
+
+PS_INPUT VS(VS_INPUT input )
+{
+	PS_INPUT output = (PS_INPUT)0;
+	float4 worldPos = input.World0 * input.Pos.x + input.World1 * input.Pos.y + input.World2 * input.Pos.z + input.World3 * input.Pos.w;
+
+	output.Pos = mul(viewProjection, worldPos);
+	output.Tex = input.Tex;
+	output.Col = input.Col * input.InstCol;
+    return output;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Pixel Shader
+//--------------------------------------------------------------------------------------
+
+Texture2D<float4> Tex : register(t0);
+SamplerState Sam : register(s0);
+
+float4 PS(PS_INPUT input) : SV_Target
+{
+    return Tex.Sample(Sam, input.Tex) * input.Col;
+}
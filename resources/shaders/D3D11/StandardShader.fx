@@ -0,0 +1,77 @@
+//--------------------------------------------------------------------------------------
+// Vertex Shader
+//--------------------------------------------------------------------------------------
+
+// variants are selected with ShaderFeatures, each defines its DS_ name when set
+#include "Common.fxh"
+
+struct VS_INPUT
+{
+	float4 Pos : POSITION;
+
+#ifdef DS_TEXTURED
+	float2 Tex : TEXCOORD0;
+#endif
+
+#ifdef DS_VERTEX_COLOR
+	float4 Col : COLOR;
+#endif
+
+#ifdef DS_INSTANCED
+	// per instance, the world matrix is passed as its 4 columns
+	float4 World0 : INSTANCE_WORLD0;
+	float4 World1 : INSTANCE_WORLD1;
+	float4 World2 : INSTANCE_WORLD2;
+	float4 World3 : INSTANCE_WORLD3;
+	float4 InstCol : INSTANCE_COLOR;
+#endif
+};
+
+struct PS_INPUT
+{
+	float4 Pos : SV_POSITION;
+	float2 Tex : TEXCOORD0;
+	float4 Col : COLOR;
+};
+
+PS_INPUT VS(VS_INPUT input )
+{
+	PS_INPUT output = (PS_INPUT)0;
+	float4 worldPos = input.Pos;
+	output.Col = float4(1.f, 1.f, 1.f, 1.f);
+
+#ifdef DS_TEXTURED
+	output.Tex = input.Tex;
+#endif
+
+#ifdef DS_VERTEX_COLOR
+	output.Col *= input.Col;
+#endif
+
+#ifdef DS_INSTANCED
+	worldPos = input.World0 * input.Pos.x + input.World1 * input.Pos.y + input.World2 * input.Pos.z + input.World3 * input.Pos.w;
+	output.Col *= input.InstCol;
+#endif
+
+	output.Pos = mul(viewProjection, worldPos);
+	return output;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Pixel Shader
+//--------------------------------------------------------------------------------------
+
+#ifdef DS_TEXTURED
+Texture2D<float4> Tex : register(t0);
+SamplerState Sam : register(s0);
+#endif
+
+float4 PS(PS_INPUT input) : SV_Target
+{
+#ifdef DS_TEXTURED
+	return Tex.Sample(Sam, input.Tex) * input.Col;
+#else
+	return input.Col;
+#endif
+}
@@ -2,11 +2,7 @@
 // Vertex Shader
 //--------------------------------------------------------------------------------------
 
-cbuffer perFrameUniforms : register(b0)
-{
-	float4x4 viewProjection;
-	float4x4 uiOrthoProjection;
-}
+#include "Common.fxh"
 
 struct VS_INPUT
 {
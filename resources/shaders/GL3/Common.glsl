@@ -0,0 +1,7 @@
+// declarations shared by every shader, included after the #version directive
+
+layout(std140) uniform perFrameUniforms
+{
+	mat4 viewProjection;
+	mat4 uiOrthoProjection;
+};
@@ -0,0 +1,15 @@
+#version 330 core
+
+in vec2 texCoord;
+in vec4 color;
+flat in float materialLayer;
+
+// every material is a layer of one array, so instances with different materials share a draw
+uniform sampler2DArray tex;
+
+out vec4 out_color;
+
+void main()
+{
+	out_color = texture(tex, vec3(texCoord, materialLayer)) * color;
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#version 330 core
+
+layout (location = 0) in vec3 v_position;
+layout (location = 1) in vec2 v_texCoord;
+layout (location = 2) in vec4 v_color;
+
+// per instance attributes start at location 8, the matrix takes locations 8 to 11
+layout (location = 8) in mat4 i_world;
+layout (location = 12) in vec4 i_color;
+layout (location = 13) in float i_material;
+
+#include "Common.glsl"
+
+out vec2 texCoord;
+out vec4 color;
+flat out float materialLayer;
+
+void main()
+{
+	texCoord = v_texCoord;
+	color = v_color * i_color;
+	materialLayer = i_material;
+	gl_Position = viewProjection * i_world * vec4(v_position, 1.0f);
+}
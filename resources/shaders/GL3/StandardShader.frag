@@ -0,0 +1,19 @@
+#version 330 core
+
+in vec2 texCoord;
+in vec4 color;
+
+#ifdef DS_TEXTURED
+uniform sampler2D tex;
+#endif
+
+out vec4 out_color;
+
+void main()
+{
+#ifdef DS_TEXTURED
+	out_color = texture(tex, texCoord) * color;
+#else
+	out_color = color;
+#endif
+}
@@ -0,0 +1,51 @@
+#version 330 core
+
+// variants are selected with ShaderFeatures, each defines its DS_ name when set
+#include "Common.glsl"
+
+// per vertex attributes take consecutive locations in the order of their VertexAttributes bits, so the mesh
+// must have exactly the attributes of the variant
+layout (location = 0) in vec3 v_position;
+
+#ifdef DS_TEXTURED
+layout (location = 1) in vec2 v_texCoord;
+#define DS_COLOR_LOCATION 2
+#else
+#define DS_COLOR_LOCATION 1
+#endif
+
+#ifdef DS_VERTEX_COLOR
+layout (location = DS_COLOR_LOCATION) in vec4 v_color;
+#endif
+
+#ifdef DS_INSTANCED
+// per instance attributes start at location 8, the matrix takes locations 8 to 11
+layout (location = 8) in mat4 i_world;
+layout (location = 12) in vec4 i_color;
+#endif
+
+out vec2 texCoord;
+out vec4 color;
+
+void main()
+{
+	vec4 position = vec4(v_position, 1.0f);
+	color = vec4(1.0f);
+
+#ifdef DS_TEXTURED
+	texCoord = v_texCoord;
+#else
+	texCoord = vec2(0.0f);
+#endif
+
+#ifdef DS_VERTEX_COLOR
+	color *= v_color;
+#endif
+
+#ifdef DS_INSTANCED
+	color *= i_color;
+	position = i_world * position;
+#endif
+
+	gl_Position = viewProjection * position;
+}
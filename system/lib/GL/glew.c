@@ -30,15 +30,15 @@
 ** THE POSSIBILITY OF SUCH DAMAGE.
 */
 
-#include <GL\glew.h>
+#include <GL/glew.h>
 
 #if defined(GLEW_OSMESA)
 #  define GLAPI extern
-#  include <GL\osmesa.h>
+#  include <GL/osmesa.h>
 #elif defined(GLEW_EGL)
-#  include <GL\eglew.h>
+#  include <GL/eglew.h>
 #elif defined(_WIN32)
-#  include <GL\wglew.h>
+#  include <GL/wglew.h>
 #elif !defined(__ANDROID__) && !defined(__native_client__) && !defined(__HAIKU__) && (!defined(__APPLE__) || defined(GLEW_APPLE_GLX))
 #  include <GL/glxew.h>
 #endif
@@ -0,0 +1,105 @@
+#include "BufferUpdateBatch.h"
+#include "IGraphicsDevice.h"
+
+#include <algorithm>
+#include <functional>
+
+BufferUpdateBatch::BufferUpdateBatch(uint32 initialSizeBytes)
+{
+	writeData.reserve(initialSizeBytes);
+	uploadCount = 0;
+}
+
+void BufferUpdateBatch::Reset()
+{
+	writes.clear();
+	writeData.clear();
+}
+
+void BufferUpdateBatch::Write(Buffer* buffer, const void* data, uint32 offset, uint32 size)
+{
+	DS_ASSERT(buffer);	// buffer must not be null
+
+	if (size == 0)
+		return;
+
+	BufferWrite write;
+	write.buffer = buffer;
+	write.offset = offset;
+	write.size = size;
+	write.dataOffset = static_cast<uint32>(writeData.size());
+	write.sequence = static_cast<uint32>(writes.size());
+
+	writes.push_back(write);
+
+	const uint8* bytes = static_cast<const uint8*>(data);
+	writeData.insert(writeData.end(), bytes, bytes + size);
+}
+
+void BufferUpdateBatch::Submit(IGraphicsDevice* device)
+{
+	uploadCount = 0;
+
+	if (writes.empty())
+		return;
+
+	// writes to the same buffer end up next to each other, ordered by where they start
+	std::sort(writes.begin(), writes.end(), [](const BufferWrite &a, const BufferWrite &b)
+	{
+		if (a.buffer != b.buffer)
+			return std::less<Buffer*>()(a.buffer, b.buffer);
+
+		if (a.offset != b.offset)
+			return a.offset < b.offset;
+
+		return a.sequence < b.sequence;
+	});
+
+	uint32 writeCount = static_cast<uint32>(writes.size());
+	uint32 first = 0;
+
+	while (first < writeCount)
+	{
+		Buffer* buffer = writes[first].buffer;
+		uint32 rangeStart = writes[first].offset;
+		uint32 rangeEnd = rangeStart + writes[first].size;
+
+		// extend the range over every following write that overlaps or touches it
+		uint32 last = first + 1;
+
+		while (last < writeCount && writes[last].buffer == buffer && writes[last].offset <= rangeEnd)
+		{
+			rangeEnd = glm::max(rangeEnd, writes[last].offset + writes[last].size);
+			last++;
+		}
+
+		const uint8* rangeData;
+
+		if (last - first == 1)
+		{
+			rangeData = &writeData[writes[first].dataOffset];
+		}
+		else
+		{
+			// copy the writes in the order they were made so later writes win where they overlap
+			std::sort(writes.begin() + first, writes.begin() + last, [](const BufferWrite &a, const BufferWrite &b)
+			{
+				return a.sequence < b.sequence;
+			});
+
+			mergeData.resize(rangeEnd - rangeStart);
+
+			for (uint32 w = first; w < last; w++)
+			{
+				memcpy(&mergeData[writes[w].offset - rangeStart], &writeData[writes[w].dataOffset], writes[w].size);
+			}
+
+			rangeData = mergeData.data();
+		}
+
+		device->UpdateBufferRegion(buffer, rangeData, rangeStart, rangeEnd - rangeStart);
+		uploadCount++;
+
+		first = last;
+	}
+}
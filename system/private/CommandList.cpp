@@ -0,0 +1,411 @@
+#include "CommandList.h"
+#include "IGraphicsDevice.h"
+
+// commands are padded so each header and payload stays aligned for the pointers it holds
+#define COMMAND_ALIGNMENT 8
+#define COMMAND_ALIGN(_size) (((_size) + (COMMAND_ALIGNMENT - 1)) & ~(COMMAND_ALIGNMENT - 1))
+
+// ==============================================
+// Command Payloads
+// ==============================================
+
+// payloads only hold plain data, pointers to resources and values, so they can be copied with memcpy
+
+struct SetShaderCommand
+{
+	Shader* shader;
+};
+
+struct SetTextureCommand
+{
+	Texture* texture;
+	uint32 slot;
+};
+
+struct SetUniformBufferCommand
+{
+	Buffer* buffer;
+	uint32 slot;
+	ShaderStage stage;
+};
+
+struct SetUniformBufferRangeCommand
+{
+	Buffer* buffer;
+	uint32 slot;
+	uint32 offset;
+	uint32 size;
+	ShaderStage stage;
+};
+
+struct SetBlendStateCommand
+{
+	BlendState* state;
+};
+
+struct SetDepthStencilStateCommand
+{
+	DepthStencilState* state;
+};
+
+struct SetRasterizerStateCommand
+{
+	RasterizerState* state;
+};
+
+// followed by numRects DSRects
+struct SetScissorRectsCommand
+{
+	uint32 numRects;
+};
+
+struct SetViewportCommand
+{
+	int32 x, y, width, height;
+};
+
+// followed by size bytes of buffer data
+struct UpdateBufferCommand
+{
+	Buffer* buffer;
+	uint32 size;
+};
+
+// followed by size bytes of buffer data
+struct UpdateBufferRegionCommand
+{
+	Buffer* buffer;
+	uint32 offset;
+	uint32 size;
+};
+
+struct DrawMeshCommand
+{
+	Mesh* mesh;
+};
+
+struct DrawMeshIndexedCommand
+{
+	Mesh* mesh;
+	uint32 elementCount;
+	uint32 vertexOffset;
+	uint32 indexOffset;
+};
+
+struct DrawMeshIndexedInstancedCommand
+{
+	Mesh* mesh;
+	Buffer* instanceBuffer;
+	VertexAttributes instanceAttributeFlags;
+	uint32 instanceCount;
+	uint32 firstInstance;
+	uint32 elementCount;
+	uint32 vertexOffset;
+	uint32 indexOffset;
+};
+
+// ==============================================
+
+CommandList::CommandList(uint32 initialSizeBytes) :
+	data(initialSizeBytes),
+	usedBytes(0),
+	commandCount(0)
+{
+
+}
+
+void CommandList::Reset()
+{
+	usedBytes = 0;
+	commandCount = 0;
+}
+
+uint8* CommandList::AllocateCommand(CommandType type, uint32 payloadSize, uint32 extraSize)
+{
+	uint32 payloadOffset = COMMAND_ALIGN(sizeof(CommandHeader));
+	uint32 commandSize = COMMAND_ALIGN(payloadOffset + payloadSize + extraSize);
+
+	// grow by doubling so recording stays amortized constant time
+	if (usedBytes + commandSize > data.size())
+	{
+		data.resize(glm::max(static_cast<uint32>(data.size()) * 2, usedBytes + commandSize));
+	}
+
+	uint8* command = data.data() + usedBytes;
+
+	CommandHeader* header = reinterpret_cast<CommandHeader*>(command);
+	header->type = type;
+	header->size = commandSize;
+
+	usedBytes += commandSize;
+	commandCount++;
+
+	return command + payloadOffset;
+}
+
+void CommandList::SetShader(Shader* shader)
+{
+	SetShaderCommand* command = reinterpret_cast<SetShaderCommand*>(AllocateCommand(CommandType::SetShader, sizeof(SetShaderCommand)));
+	command->shader = shader;
+}
+
+void CommandList::SetTexture(Texture* texture, uint32 slot)
+{
+	SetTextureCommand* command = reinterpret_cast<SetTextureCommand*>(AllocateCommand(CommandType::SetTexture, sizeof(SetTextureCommand)));
+	command->texture = texture;
+	command->slot = slot;
+}
+
+void CommandList::SetUniformBuffer(uint32 slot, Buffer* buffer, ShaderStage stage)
+{
+	SetUniformBufferCommand* command = reinterpret_cast<SetUniformBufferCommand*>(AllocateCommand(CommandType::SetUniformBuffer, sizeof(SetUniformBufferCommand)));
+	command->buffer = buffer;
+	command->slot = slot;
+	command->stage = stage;
+}
+
+void CommandList::SetUniformBufferRange(uint32 slot, Buffer* buffer, uint32 offset, uint32 size, ShaderStage stage)
+{
+	SetUniformBufferRangeCommand* command = reinterpret_cast<SetUniformBufferRangeCommand*>(AllocateCommand(CommandType::SetUniformBufferRange, sizeof(SetUniformBufferRangeCommand)));
+	command->buffer = buffer;
+	command->slot = slot;
+	command->offset = offset;
+	command->size = size;
+	command->stage = stage;
+}
+
+void CommandList::SetBlendState(BlendState* state)
+{
+	SetBlendStateCommand* command = reinterpret_cast<SetBlendStateCommand*>(AllocateCommand(CommandType::SetBlendState, sizeof(SetBlendStateCommand)));
+	command->state = state;
+}
+
+void CommandList::SetDepthStencilState(DepthStencilState* state)
+{
+	SetDepthStencilStateCommand* command = reinterpret_cast<SetDepthStencilStateCommand*>(AllocateCommand(CommandType::SetDepthStencilState, sizeof(SetDepthStencilStateCommand)));
+	command->state = state;
+}
+
+void CommandList::SetRasterizerState(RasterizerState* state)
+{
+	SetRasterizerStateCommand* command = reinterpret_cast<SetRasterizerStateCommand*>(AllocateCommand(CommandType::SetRasterizerState, sizeof(SetRasterizerStateCommand)));
+	command->state = state;
+}
+
+void CommandList::SetScissorRects(uint32 numRects, const DSRect* pRects)
+{
+	if (!pRects)
+		return;
+
+	uint32 payloadSize = COMMAND_ALIGN(sizeof(SetScissorRectsCommand));
+	uint8* payload = AllocateCommand(CommandType::SetScissorRects, payloadSize, numRects * sizeof(DSRect));
+
+	SetScissorRectsCommand* command = reinterpret_cast<SetScissorRectsCommand*>(payload);
+	command->numRects = numRects;
+
+	memcpy(payload + payloadSize, pRects, numRects * sizeof(DSRect));
+}
+
+void CommandList::SetViewport(int32 x, int32 y, int32 width, int32 height)
+{
+	SetViewportCommand* command = reinterpret_cast<SetViewportCommand*>(AllocateCommand(CommandType::SetViewport, sizeof(SetViewportCommand)));
+	command->x = x;
+	command->y = y;
+	command->width = width;
+	command->height = height;
+}
+
+void CommandList::UpdateBuffer(Buffer* buffer, const void* bufferData, uint32 size)
+{
+	uint32 payloadSize = COMMAND_ALIGN(sizeof(UpdateBufferCommand));
+	uint8* payload = AllocateCommand(CommandType::UpdateBuffer, payloadSize, size);
+
+	UpdateBufferCommand* command = reinterpret_cast<UpdateBufferCommand*>(payload);
+	command->buffer = buffer;
+	command->size = size;
+
+	memcpy(payload + payloadSize, bufferData, size);
+}
+
+void CommandList::UpdateBufferRegion(Buffer* buffer, const void* bufferData, uint32 offset, uint32 size)
+{
+	uint32 payloadSize = COMMAND_ALIGN(sizeof(UpdateBufferRegionCommand));
+	uint8* payload = AllocateCommand(CommandType::UpdateBufferRegion, payloadSize, size);
+
+	UpdateBufferRegionCommand* command = reinterpret_cast<UpdateBufferRegionCommand*>(payload);
+	command->buffer = buffer;
+	command->offset = offset;
+	command->size = size;
+
+	memcpy(payload + payloadSize, bufferData, size);
+}
+
+void CommandList::DrawMesh(Mesh* mesh)
+{
+	DrawMeshCommand* command = reinterpret_cast<DrawMeshCommand*>(AllocateCommand(CommandType::DrawMesh, sizeof(DrawMeshCommand)));
+	command->mesh = mesh;
+}
+
+void CommandList::DrawMeshIndexed(Mesh* mesh, uint32 elementCount, uint32 vertexOffset, uint32 indexOffset)
+{
+	DrawMeshIndexedCommand* command = reinterpret_cast<DrawMeshIndexedCommand*>(AllocateCommand(CommandType::DrawMeshIndexed, sizeof(DrawMeshIndexedCommand)));
+	command->mesh = mesh;
+	command->elementCount = elementCount;
+	command->vertexOffset = vertexOffset;
+	command->indexOffset = indexOffset;
+}
+
+void CommandList::DrawMeshIndexedInstanced(Mesh* mesh, Buffer* instanceBuffer, VertexAttributes instanceAttributeFlags, uint32 instanceCount,
+										   uint32 firstInstance, uint32 elementCount, uint32 vertexOffset, uint32 indexOffset)
+{
+	DrawMeshIndexedInstancedCommand* command = reinterpret_cast<DrawMeshIndexedInstancedCommand*>(AllocateCommand(CommandType::DrawMeshIndexedInstanced, sizeof(DrawMeshIndexedInstancedCommand)));
+	command->mesh = mesh;
+	command->instanceBuffer = instanceBuffer;
+	command->instanceAttributeFlags = instanceAttributeFlags;
+	command->instanceCount = instanceCount;
+	command->firstInstance = firstInstance;
+	command->elementCount = elementCount;
+	command->vertexOffset = vertexOffset;
+	command->indexOffset = indexOffset;
+}
+
+void CommandList::Execute(IGraphicsDevice* device) const
+{
+	const uint32 payloadOffset = COMMAND_ALIGN(sizeof(CommandHeader));
+
+	const uint8* command = data.data();
+	const uint8* end = command + usedBytes;
+
+	while (command < end)
+	{
+		const CommandHeader* header = reinterpret_cast<const CommandHeader*>(command);
+		const uint8* payload = command + payloadOffset;
+
+		switch (header->type)
+		{
+			case CommandType::SetShader:
+			{
+				const SetShaderCommand* cmd = reinterpret_cast<const SetShaderCommand*>(payload);
+				device->SetShader(cmd->shader);
+			}
+			break;
+
+			case CommandType::SetTexture:
+			{
+				const SetTextureCommand* cmd = reinterpret_cast<const SetTextureCommand*>(payload);
+				device->SetTexture(cmd->texture, cmd->slot);
+			}
+			break;
+
+			case CommandType::SetUniformBuffer:
+			{
+				const SetUniformBufferCommand* cmd = reinterpret_cast<const SetUniformBufferCommand*>(payload);
+				device->SetUniformBuffer(cmd->slot, cmd->buffer, cmd->stage);
+			}
+			break;
+
+			case CommandType::SetUniformBufferRange:
+			{
+				const SetUniformBufferRangeCommand* cmd = reinterpret_cast<const SetUniformBufferRangeCommand*>(payload);
+				device->SetUniformBufferRange(cmd->slot, cmd->buffer, cmd->offset, cmd->size, cmd->stage);
+			}
+			break;
+
+			case CommandType::SetBlendState:
+			{
+				const SetBlendStateCommand* cmd = reinterpret_cast<const SetBlendStateCommand*>(payload);
+				device->SetBlendState(cmd->state);
+			}
+			break;
+
+			case CommandType::SetDepthStencilState:
+			{
+				const SetDepthStencilStateCommand* cmd = reinterpret_cast<const SetDepthStencilStateCommand*>(payload);
+				device->SetDepthStencilState(cmd->state);
+			}
+			break;
+
+			case CommandType::SetRasterizerState:
+			{
+				const SetRasterizerStateCommand* cmd = reinterpret_cast<const SetRasterizerStateCommand*>(payload);
+				device->SetRasterizerState(cmd->state);
+			}
+			break;
+
+			case CommandType::SetScissorRects:
+			{
+				const SetScissorRectsCommand* cmd = reinterpret_cast<const SetScissorRectsCommand*>(payload);
+				const DSRect* rects = reinterpret_cast<const DSRect*>(payload + COMMAND_ALIGN(sizeof(SetScissorRectsCommand)));
+				device->SetScissorRects(cmd->numRects, rects);
+			}
+			break;
+
+			case CommandType::SetViewport:
+			{
+				const SetViewportCommand* cmd = reinterpret_cast<const SetViewportCommand*>(payload);
+				device->SetViewport(cmd->x, cmd->y, cmd->width, cmd->height);
+			}
+			break;
+
+			case CommandType::UpdateBuffer:
+			{
+				const UpdateBufferCommand* cmd = reinterpret_cast<const UpdateBufferCommand*>(payload);
+				device->UpdateBuffer(cmd->buffer, payload + COMMAND_ALIGN(sizeof(UpdateBufferCommand)), cmd->size);
+			}
+			break;
+
+			case CommandType::UpdateBufferRegion:
+			{
+				const UpdateBufferRegionCommand* cmd = reinterpret_cast<const UpdateBufferRegionCommand*>(payload);
+				device->UpdateBufferRegion(cmd->buffer, payload + COMMAND_ALIGN(sizeof(UpdateBufferRegionCommand)), cmd->offset, cmd->size);
+			}
+			break;
+
+			case CommandType::DrawMesh:
+			{
+				const DrawMeshCommand* cmd = reinterpret_cast<const DrawMeshCommand*>(payload);
+				device->DrawMesh(cmd->mesh);
+			}
+			break;
+
+			case CommandType::DrawMeshIndexed:
+			{
+				const DrawMeshIndexedCommand* cmd = reinterpret_cast<const DrawMeshIndexedCommand*>(payload);
+				device->DrawMeshIndexed(cmd->mesh, cmd->elementCount, cmd->vertexOffset, cmd->indexOffset);
+			}
+			break;
+
+			case CommandType::DrawMeshIndexedInstanced:
+			{
+				const DrawMeshIndexedInstancedCommand* cmd = reinterpret_cast<const DrawMeshIndexedInstancedCommand*>(payload);
+				device->DrawMeshIndexedInstanced(cmd->mesh, cmd->instanceBuffer, cmd->instanceAttributeFlags, cmd->instanceCount,
+												 cmd->firstInstance, cmd->elementCount, cmd->vertexOffset, cmd->indexOffset);
+			}
+			break;
+
+			default:
+				LOG_ERROR("CommandList contains unknown command type %u", static_cast<uint32>(header->type));
+				return;
+		}
+
+		command += header->size;
+	}
+}
+
+// ==============================================
+// IGraphicsDevice
+// ==============================================
+
+void IGraphicsDevice::ExecuteCommandLists(uint32 numLists, CommandList* const* pLists)
+{
+	if (!pLists)
+		return;
+
+	for (uint32 l = 0; l < numLists; l++)
+	{
+		if (pLists[l] != nullptr)
+		{
+			pLists[l]->Execute(this);
+		}
+	}
+}
@@ -2,7 +2,7 @@
 #ifndef _DX11_DEFINITIONS_H
 #define _DX11_DEFINITIONS_H
 
-#include <d3d11.h>
+#include <d3d11_1.h>
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
 #include <string>
@@ -17,14 +17,25 @@ static const D3D11_TEXTURE_ADDRESS_MODE DX11WrapMode[] = { D3D11_TEXTURE_ADDRESS
 // maps VertexAttribute values to there D3D Semantic Name
 static const char* D3D11InputElementName[] =
 {
-	"POSITION",	// Position
-	"POSITION",	// UIPosition
-	"TEXCOORD",	// TexCoord
-	"COLOR",	// Color32
-	"NORMAL"	// Normal
+	"POSITION",			// Position
+	"POSITION",			// PositionHalf
+	"POSITION",			// UIPosition
+	"TEXCOORD",			// TexCoord
+	"TEXCOORD",			// TexCoordHalf
+	"TEXCOORD",			// TexCoordUNorm16
+	"COLOR",			// Color32
+	"NORMAL",			// Normal
+	"NORMAL",			// NormalSNorm16
+	"NORMAL",			// NormalPacked
+	"INSTANCE_WORLD",	// InstanceWorld
+	"INSTANCE_COLOR",	// InstanceColor32
+	"INSTANCE_MATERIAL"	// InstanceMaterial
 };
 
-static const DXGI_FORMAT const D3D11BaseTypeMap[8][4] =
+// maps IndexFormat to DXGI equivalent
+static const DXGI_FORMAT D3D11IndexFormatMap[] = { DXGI_FORMAT_R16_UINT, DXGI_FORMAT_R32_UINT };
+
+static const DXGI_FORMAT const D3D11BaseTypeMap[10][4] =
 {
 	{ DXGI_FORMAT_R8_SINT, DXGI_FORMAT_R8G8_SINT, DXGI_FORMAT_R8G8B8A8_SINT, DXGI_FORMAT_R8G8B8A8_SINT},				// Int8
 	{ DXGI_FORMAT_R8_UINT, DXGI_FORMAT_R8G8_UINT, DXGI_FORMAT_R8G8B8A8_UINT, DXGI_FORMAT_R8G8B8A8_UINT},				// UInt8
@@ -37,6 +48,9 @@ static const DXGI_FORMAT const D3D11BaseTypeMap[8][4] =
 
 	{ DXGI_FORMAT_R32_FLOAT, DXGI_FORMAT_R32G32_FLOAT, DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R32G32B32A32_FLOAT},	// Float
 	{ DXGI_FORMAT_R32_FLOAT, DXGI_FORMAT_R32G32_FLOAT, DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R32G32B32A32_FLOAT},	// Double
+
+	{ DXGI_FORMAT_R16_FLOAT, DXGI_FORMAT_R16G16_FLOAT, DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_R16G16B16A16_FLOAT},	// HalfFloat
+	{ DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_R10G10B10A2_UINT},						// UInt10_10_10_2
 };
 
 static const DXGI_FORMAT const D3D11NormalizedBaseTypeMap[4][4] =
@@ -45,7 +59,7 @@ static const DXGI_FORMAT const D3D11NormalizedBaseTypeMap[4][4] =
 	{ DXGI_FORMAT_R8_UNORM, DXGI_FORMAT_R8G8_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM },				// UInt8
 
 	{ DXGI_FORMAT_R16_SNORM, DXGI_FORMAT_R16G16_SNORM, DXGI_FORMAT_R16G16B16A16_SNORM, DXGI_FORMAT_R16G16B16A16_SNORM },	// Int16
-	{ DXGI_FORMAT_R16_UNORM, DXGI_FORMAT_R16G16_UNORM, DXGI_FORMAT_R16G16B16A16_SNORM, DXGI_FORMAT_R16G16B16A16_UINT },		// UInt16
+	{ DXGI_FORMAT_R16_UNORM, DXGI_FORMAT_R16G16_UNORM, DXGI_FORMAT_R16G16B16A16_UNORM, DXGI_FORMAT_R16G16B16A16_UNORM },	// UInt16
 };
 
 // Get a DXGI format that the given layout will fit in to
@@ -58,22 +72,28 @@ static DXGI_FORMAT GetDXGIFormat(BaseType type, uint32 components, bool normaliz
 	uint32 typeIndex = static_cast<uint32>(type);
 	uint32 componentIndex = components-1;
 
-	// 8 and 16 bit int types do not support 3 components, produce warning 
+	// 8 and 16 bit types do not support 3 components, produce warning 
 	if (components == 3 && 
 	    (type == BaseType::Int8 || type == BaseType::UInt8 ||
-		type == BaseType::Int16 || type == BaseType::UInt16))
+		type == BaseType::Int16 || type == BaseType::UInt16 || type == BaseType::HalfFloat))
 	{
 		LOG_WARNING("GetDXGIFormat : No matching 3 component format for 8 and 16 bit int/uint types, returning 4 component format.");
 	}
 
-	if (!normalized)
+	if (type == BaseType::UInt10_10_10_2)
+	{
+		// the packed type always has all 4 components, there is no signed normalized variant in DXGI
+		DS_ASSERT(components == 4);
+		format = normalized ? DXGI_FORMAT_R10G10B10A2_UNORM : DXGI_FORMAT_R10G10B10A2_UINT;
+	}
+	else if (!normalized)
 	{
 		format = D3D11BaseTypeMap[typeIndex][componentIndex];
 	}
 	else
 	{
 		if (type != BaseType::UInt32 && type != BaseType::Int32 &&
-			type != BaseType::Float && type != BaseType::Double )
+			type != BaseType::Float && type != BaseType::Double && type != BaseType::HalfFloat)
 		{
 			format = D3D11NormalizedBaseTypeMap[typeIndex][componentIndex];
 		}
@@ -91,6 +111,10 @@ static DXGI_FORMAT GetDXGIFormat(BaseType type, uint32 components, bool normaliz
 // maps BufferTarget to DirectX11 equivalent
 static const UINT DX11BindTargetMap[] = { D3D11_BIND_VERTEX_BUFFER, D3D11_BIND_INDEX_BUFFER, D3D11_BIND_CONSTANT_BUFFER };
 
+// constant buffer ranges are bound in 16 byte constants, offsets and sizes are multiples of 16 constants
+#define DX11_CONSTANT_SIZE 16
+#define DX11_CONSTANT_BUFFER_ALIGNMENT 256
+
 // maps BufferUsage to DirectX11 equivalent
 static const D3D11_USAGE DX11UsageMap[] = { D3D11_USAGE_IMMUTABLE, D3D11_USAGE_DEFAULT, D3D11_USAGE_DYNAMIC };
 
@@ -128,6 +152,7 @@ static const D3D11_BLEND D3D11BlendMap[] =
 	D3D11_BLEND_DEST_ALPHA,
 	D3D11_BLEND_INV_DEST_ALPHA,
 	D3D11_BLEND_DEST_COLOR,
+	D3D11_BLEND_INV_DEST_COLOR,
 	D3D11_BLEND_SRC_ALPHA_SAT,
 	D3D11_BLEND_BLEND_FACTOR,
 	D3D11_BLEND_INV_BLEND_FACTOR
@@ -196,6 +221,59 @@ public:
 
 // ==============================================
 
+// ==============================================
+// Rasterizer State
+// ==============================================
+
+static const D3D11_CULL_MODE D3D11CullModeMap[] = { D3D11_CULL_NONE, D3D11_CULL_FRONT, D3D11_CULL_BACK };
+
+static const D3D11_FILL_MODE D3D11FillModeMap[] = { D3D11_FILL_SOLID, D3D11_FILL_WIREFRAME };
+
+class RasterizerStateD3D11 : public RasterizerState
+{
+public:
+
+	RasterizerStateD3D11(ID3D11RasterizerState* pRasterizerState) :
+		pRasterizerState(pRasterizerState)
+	{}
+
+	ID3D11RasterizerState* pRasterizerState;
+};
+
+// helper macros
+#define GET_D3D11_CULL_MODE(cullMode) D3D11CullModeMap[static_cast<int32>(cullMode)]
+#define GET_D3D11_FILL_MODE(fillMode) D3D11FillModeMap[static_cast<int32>(fillMode)]
+
+// ==============================================
+
+// ==============================================
+// Render Targets
+// ==============================================
+
+struct RenderTargetFormatD3D11
+{
+	// depth formats are created typeless so they can be viewed both as depth and as a shader resource
+	DXGI_FORMAT textureFormat;
+	DXGI_FORMAT viewFormat;
+	DXGI_FORMAT resourceFormat;
+};
+
+// maps RenderTargetFormat to DirectX equivalent
+static const RenderTargetFormatD3D11 D3D11RenderTargetFormatMap[] =
+{
+	{ DXGI_FORMAT_R8G8B8A8_UNORM,		DXGI_FORMAT_R8G8B8A8_UNORM,		DXGI_FORMAT_R8G8B8A8_UNORM },
+	{ DXGI_FORMAT_R16G16B16A16_FLOAT,	DXGI_FORMAT_R16G16B16A16_FLOAT,	DXGI_FORMAT_R16G16B16A16_FLOAT },
+	{ DXGI_FORMAT_R32G32B32A32_FLOAT,	DXGI_FORMAT_R32G32B32A32_FLOAT,	DXGI_FORMAT_R32G32B32A32_FLOAT },
+	{ DXGI_FORMAT_R32_FLOAT,			DXGI_FORMAT_R32_FLOAT,			DXGI_FORMAT_R32_FLOAT },
+	{ DXGI_FORMAT_R24G8_TYPELESS,		DXGI_FORMAT_D24_UNORM_S8_UINT,	DXGI_FORMAT_R24_UNORM_X8_TYPELESS },
+	{ DXGI_FORMAT_R32_TYPELESS,			DXGI_FORMAT_D32_FLOAT,			DXGI_FORMAT_R32_FLOAT }
+};
+
+// readbacks that can be in flight, requesting another waits for the oldest to finish
+#define DX11_READBACK_BUFFER_COUNT 4
+
+// ==============================================
+
 // ==============================================
 // DirectX Debugging
 // ==============================================
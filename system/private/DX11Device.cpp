@@ -1,6 +1,8 @@
 #include "DX11Device.h"
 #include "DemoCommon.h"
 
+#include <algorithm>
+
 std::string DX11Device::GetAPIName()
 {
 	return "DirectX 11";
@@ -59,6 +61,13 @@ bool DX11Device::Create(const RenderInfo& info)
 		return false;
 	}
 
+	// constant buffer offsets need the D3D11.1 context, without it only whole buffers can be bound
+	if (FAILED(pDeviceContext->QueryInterface(__uuidof(ID3D11DeviceContext1), reinterpret_cast<void**>(&pDeviceContext1))))
+	{
+		LOG_WARNING("D3D11.1 is not available, uniform buffer ranges can not be bound");
+		pDeviceContext1 = nullptr;
+	}
+
 	IDXGIDevice* pDXGIDevice;
 	HR(pDevice->QueryInterface(__uuidof(IDXGIDevice), (void **)&pDXGIDevice));
 
@@ -70,6 +79,20 @@ bool DX11Device::Create(const RenderInfo& info)
 
 	HR(pIDXGIFactory->MakeWindowAssociation(windowHandle, DXGI_MWA_NO_WINDOW_CHANGES));
 
+	// frame slots are fenced with event queries, the GPU signals one when it reaches it in the command stream
+	framesInFlight = glm::clamp(info.framesInFlight, 1u, static_cast<uint32>(DS_MAX_FRAMES_IN_FLIGHT));
+
+	D3D11_QUERY_DESC queryDesc;
+	queryDesc.Query = D3D11_QUERY_EVENT;
+	queryDesc.MiscFlags = 0;
+
+	for (uint32 f = 0; f < DS_MAX_FRAMES_IN_FLIGHT; f++)
+	{
+		HR(pDevice->CreateQuery(&queryDesc, &frameQueries[f]));
+	}
+
+	ApplyFrameLatency();
+
 	// get the swap chain's back buffer
 	LOG("Getting swapchain backbuffer.");
 
@@ -114,16 +137,10 @@ void DX11Device::Initialize()
 
 	// Setup default Blend state
 
-	// Setup default Rasterizer state
-	D3D11_RASTERIZER_DESC desc;
-	ZeroMemory(&desc, sizeof(desc));
-	desc.FillMode = D3D11_FILL_SOLID;
-	desc.CullMode = D3D11_CULL_NONE;
-	desc.ScissorEnable = true;
-	desc.DepthClipEnable = false;
-	pDevice->CreateRasterizerState(&desc, &pRasterizerState);
-
-	pDeviceContext->RSSetState(pRasterizerState);
+	// Setup default Rasterizer state, no culling with scissor testing enabled
+	RasterizerStateDesc defaultRasterizerDesc;
+	defaultRasterizerState = static_cast<RasterizerStateD3D11*>(CreateRasterizerState(defaultRasterizerDesc));
+	SetRasterizerState(defaultRasterizerState);
 
 	// Setup the viewport
 	SetViewport(0, 0, renderInfo.resolutionX, renderInfo.resolutionY);
@@ -139,8 +156,65 @@ void DX11Device::Destroy()
 {
 	if (pDeviceContext) pDeviceContext->ClearState();
 
+	// shaders still compiling are owned by the caller and stay pending
+	StopCompileThreads();
+	shaderVariants.clear();
+	shaderPreprocessor.Clear();
+	curShader = nullptr;
+
+	textureUploads.clear();
+
+	// readbacks still in flight are dropped without calling back
+	for (ReadbackD3D11 &readback : readbacks)
+	{
+		if (readback.pStagingTexture)
+		{
+			readback.pStagingTexture->Release();
+			readback.pStagingTexture = nullptr;
+		}
+
+		readback.callback = nullptr;
+	}
+
+	pendingReadbacks = 0;
+
+	for (uint32 f = 0; f < DS_MAX_FRAMES_IN_FLIGHT; f++)
+	{
+		if (frameQueries[f])
+		{
+			frameQueries[f]->Release();
+			frameQueries[f] = nullptr;
+		}
+
+		framePending[f] = false;
+	}
+
+	// release every resource still held by a handle
+	for (D3D11Mesh &mesh : meshes)
+		DeleteMeshObjects(&mesh);
+
+	for (D3D11Shader &shader : shaders)
+		DeleteShaderObjects(&shader);
+
+	for (D3D11Texture &texture : textures)
+		DeleteTextureObjects(&texture);
+
+	for (DX11Buffer &buffer : buffers)
+		buffer.pBuffer->Release();
+
+	meshes.Clear();
+	shaders.Clear();
+	textures.Clear();
+	buffers.Clear();
+
+	// release every cached state object
+	blendStates.Clear([](DX11BlendState* state) { state->blendState->Release(); delete state; });
+	depthStencilStates.Clear([](DepthStencilStateD3D11* state) { state->pDepthStencilState->Release(); delete state; });
+	rasterizerStates.Clear([](RasterizerStateD3D11* state) { state->pRasterizerState->Release(); delete state; });
+
 	if (pRenderTargetView) pRenderTargetView->Release();
 	if (pSwapChain) pSwapChain->Release();
+	if (pDeviceContext1) pDeviceContext1->Release();
 	if (pDeviceContext) pDeviceContext->Release();
 	if (pDevice) pDevice->Release();
 
@@ -159,7 +233,14 @@ void DX11Device::Clear()
 
 void DX11Device::Present()
 {
+	ProcessShaderCompiles();
+	ProcessTextureUploads();
+
 	pSwapChain->Present(syncInterval, 0);
+
+	CompleteReadbacks(false);
+
+	AdvanceFrame();
 }
 
 void DX11Device::SetVSync(bool enabled)
@@ -174,14 +255,41 @@ void DX11Device::SetVSync(bool enabled)
 	}
 }
 
+void DX11Device::SetFramesInFlight(uint32 count)
+{
+	count = glm::clamp(count, 1u, static_cast<uint32>(DS_MAX_FRAMES_IN_FLIGHT));
+
+	if (count == framesInFlight)
+		return;
+
+	// slots are renumbered, so no frame may still be using one
+	for (uint32 f = 0; f < DS_MAX_FRAMES_IN_FLIGHT; f++)
+	{
+		WaitForFrameSlot(f);
+	}
+
+	framesInFlight = count;
+	frameSlot = 0;
+
+	ApplyFrameLatency();
+
+	LOG("Frames in flight set to %u", framesInFlight);
+}
+
 void DX11Device::SetShader(Shader* shader)
 {
 	D3D11Shader* dxShader = static_cast<D3D11Shader*>(shader);
 
 	if (dxShader)
 	{
-		pDeviceContext->VSSetShader(dxShader->pVertexShader, nullptr, 0);
-		pDeviceContext->PSSetShader(dxShader->pPixelShader, nullptr, 0);
+		curShader = dxShader;
+
+		// a shader that is still compiling is set once it has been created
+		if (!dxShader->compilePending)
+		{
+			pDeviceContext->VSSetShader(dxShader->pVertexShader, nullptr, 0);
+			pDeviceContext->PSSetShader(dxShader->pPixelShader, nullptr, 0);
+		}
 	}
 }
 
@@ -200,7 +308,7 @@ void DX11Device::DrawMesh(Mesh* mesh)
 {
 	D3D11Mesh* dxMesh = static_cast<D3D11Mesh*>(mesh);
 
-	if (dxMesh)
+	if (dxMesh && IsCurrentShaderReady())
 	{
 		pDeviceContext->IASetInputLayout(dxMesh->pInputLayout->inputLayout);
 		pDeviceContext->IASetVertexBuffers(0, 1, &dxMesh->vertexBuffer->pBuffer, &dxMesh->pInputLayout->stride, &dxMesh->offset);
@@ -210,11 +318,11 @@ void DX11Device::DrawMesh(Mesh* mesh)
 	}
 }
 
-void DX11Device::DrawMeshIndexed(Mesh* mesh, uint32 elementCount, uint32 vertexOffset, uint16 indexOffset)
+void DX11Device::DrawMeshIndexed(Mesh* mesh, uint32 elementCount, uint32 vertexOffset, uint32 indexOffset)
 {
 	D3D11Mesh* dxMesh = static_cast<D3D11Mesh*>(mesh);
 
-	if (dxMesh)
+	if (dxMesh && IsCurrentShaderReady())
 	{
 		if (elementCount == 0)
 		{
@@ -223,13 +331,48 @@ void DX11Device::DrawMeshIndexed(Mesh* mesh, uint32 elementCount, uint32 vertexO
 
 		pDeviceContext->IASetInputLayout(dxMesh->pInputLayout->inputLayout);
 		pDeviceContext->IASetVertexBuffers(0, 1, &dxMesh->vertexBuffer->pBuffer, &dxMesh->pInputLayout->stride, &dxMesh->offset);
-		pDeviceContext->IASetIndexBuffer(dxMesh->indexBuffer->pBuffer, DXGI_FORMAT_R16_UINT, 0);
+		pDeviceContext->IASetIndexBuffer(dxMesh->indexBuffer->pBuffer, D3D11IndexFormatMap[static_cast<int32>(dxMesh->indexFormat)], 0);
 		pDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 		pDeviceContext->DrawIndexed(elementCount, indexOffset, vertexOffset);
 	}
 }
 
+void DX11Device::DrawMeshIndexedInstanced(Mesh* mesh, Buffer* instanceBuffer, VertexAttributes instanceAttributeFlags, uint32 instanceCount,
+										  uint32 firstInstance, uint32 elementCount, uint32 vertexOffset, uint32 indexOffset)
+{
+	D3D11Mesh* dxMesh = static_cast<D3D11Mesh*>(mesh);
+	DX11Buffer* dxInstanceBuffer = static_cast<DX11Buffer*>(instanceBuffer);
+
+	if (dxMesh && dxInstanceBuffer && IsCurrentShaderReady())
+	{
+		if (elementCount == 0)
+		{
+			elementCount = dxMesh->indexCount;
+		}
+
+		// the mesh layout only describes the vertex stream, get the layout for both streams
+		CachedInputLayout* pLayout = GetInputLayout(dxMesh->pInputLayout->attributeFlags | instanceAttributeFlags);
+
+		if (pLayout == nullptr || pLayout->instanceStride == 0)
+		{
+			LOG_ERROR("DrawMeshIndexedInstanced requires at least one per instance attribute");
+			return;
+		}
+
+		ID3D11Buffer* pBuffers[] = { dxMesh->vertexBuffer->pBuffer, dxInstanceBuffer->pBuffer };
+		UINT strides[] = { pLayout->stride, pLayout->instanceStride };
+		UINT offsets[] = { dxMesh->offset, 0 };
+
+		pDeviceContext->IASetInputLayout(pLayout->inputLayout);
+		pDeviceContext->IASetVertexBuffers(0, 2, pBuffers, strides, offsets);
+		pDeviceContext->IASetIndexBuffer(dxMesh->indexBuffer->pBuffer, D3D11IndexFormatMap[static_cast<int32>(dxMesh->indexFormat)], 0);
+		pDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+		pDeviceContext->DrawIndexedInstanced(elementCount, instanceCount, indexOffset, vertexOffset, firstInstance);
+	}
+}
+
 Mesh* DX11Device::CreateMesh(const MeshData &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage)
 {
 	// Get input layout for mesh
@@ -240,11 +383,15 @@ Mesh* DX11Device::CreateMesh(const MeshData &meshData, VertexAttributes vertexAt
 											meshData.vertexCount * pLayout->stride,
 											BufferTarget::Vertex, usage);
 
-	DX11Buffer* indexBuffer = CreateBuffer(meshData.indexData,
-										   meshData.indexCount * sizeof(uint16),
+	// 32 bit indices are narrowed to 16 bit when the mesh is small enough
+	IndexFormat indexFormat = GetDeviceIndexFormat(meshData.indexFormat, meshData.vertexCount);
+	const void* indexData = ConvertIndices(meshData.indexData, meshData.indexCount, meshData.indexFormat, indexFormat, indexScratch);
+
+	DX11Buffer* indexBuffer = CreateBuffer(indexData,
+										   meshData.indexCount * DS_INDEX_SIZE(indexFormat),
 										   BufferTarget::Index, usage);
 
-	return new D3D11Mesh(vertexBuffer, indexBuffer, meshData.vertexCount, meshData.indexCount, pLayout);
+	return new D3D11Mesh(vertexBuffer, indexBuffer, meshData.vertexCount, meshData.indexCount, indexFormat, pLayout);
 }
 
 Mesh* DX11Device::CreateMesh(const MeshDataList &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage)
@@ -258,10 +405,10 @@ Mesh* DX11Device::CreateMesh(const MeshDataList &meshData, VertexAttributes vert
 											BufferTarget::Vertex, usage);
 
 	DX11Buffer* indexBuffer = CreateBuffer(meshData.indices, meshData.dataCount,
-										   meshData.indexCount * sizeof(uint16),
+										   meshData.indexCount * DS_INDEX_SIZE(meshData.indexFormat),
 										   BufferTarget::Index, usage);
 
-	return new D3D11Mesh(vertexBuffer, indexBuffer, meshData.vertexCount, meshData.indexCount, pLayout);
+	return new D3D11Mesh(vertexBuffer, indexBuffer, meshData.vertexCount, meshData.indexCount, meshData.indexFormat, pLayout);
 }
 
 void DX11Device::UpdateMesh(Mesh* mesh, const MeshData &meshData)
@@ -269,10 +416,13 @@ void DX11Device::UpdateMesh(Mesh* mesh, const MeshData &meshData)
 	D3D11Mesh* dxMesh = static_cast<D3D11Mesh*>(mesh);
 
 	UpdateBuffer(dxMesh->vertexBuffer, meshData.vertexData, meshData.vertexCount * dxMesh->pInputLayout->stride);
-	UpdateBuffer(dxMesh->indexBuffer, meshData.indexData, meshData.indexCount * sizeof(uint16));
+	IndexFormat indexFormat = GetDeviceIndexFormat(meshData.indexFormat, meshData.vertexCount);
+	const void* indexData = ConvertIndices(meshData.indexData, meshData.indexCount, meshData.indexFormat, indexFormat, indexScratch);
+	UpdateBuffer(dxMesh->indexBuffer, indexData, meshData.indexCount * DS_INDEX_SIZE(indexFormat));
 
 	dxMesh->vertexCount = meshData.vertexCount;
 	dxMesh->indexCount = meshData.indexCount;
+	dxMesh->indexFormat = indexFormat;
 }
 
 void DX11Device::UpdateMesh(Mesh* mesh, const MeshDataList &meshData)
@@ -280,10 +430,11 @@ void DX11Device::UpdateMesh(Mesh* mesh, const MeshDataList &meshData)
 	D3D11Mesh* dxMesh = static_cast<D3D11Mesh*>(mesh);
 
 	UpdateBuffer(dxMesh->vertexBuffer, meshData.vertices, meshData.dataCount, meshData.vertexCount * dxMesh->pInputLayout->stride);
-	UpdateBuffer(dxMesh->indexBuffer, meshData.indices, meshData.dataCount, meshData.indexCount * sizeof(uint16));
+	UpdateBuffer(dxMesh->indexBuffer, meshData.indices, meshData.dataCount, meshData.indexCount * DS_INDEX_SIZE(meshData.indexFormat));
 
 	dxMesh->vertexCount = meshData.vertexCount;
 	dxMesh->indexCount = meshData.indexCount;
+	dxMesh->indexFormat = meshData.indexFormat;
 }
 
 void DX11Device::ReleaseMesh(Mesh* mesh)
@@ -293,65 +444,178 @@ void DX11Device::ReleaseMesh(Mesh* mesh)
 	if (dxMesh == nullptr)
 		return;
 
-	ReleaseBuffer(dxMesh->vertexBuffer);
-	ReleaseBuffer(dxMesh->indexBuffer);
+	DeleteMeshObjects(dxMesh);
 
 	delete dxMesh;
 }
 
-Shader* DX11Device::CreateShader(const std::string &name)
+void DX11Device::SetMeshArenasEnabled(bool enabled)
 {
-	HRESULT compileResult;
-	D3D11Shader* newShader = new D3D11Shader();
+	if (enabled)
+	{
+		LOG_WARNING("Mesh arenas are not supported by D3D11, meshes keep their own buffers");
+	}
+}
 
-	std::string fileName = DX11_SHADER_LOC + name + ".fx";
-	std::wstring wfileName(fileName.begin(), fileName.end());
+void DX11Device::DefragmentMeshArenas()
+{
+}
 
-	// compile vertex shader
-	ID3DBlob* pVSBlob = nullptr;
-	compileResult = CompileShaderFromFile(wfileName, "VS", "vs_4_0", &pVSBlob);
+MeshArenaStats DX11Device::GetMeshArenaStats()
+{
+	return MeshArenaStats();
+}
 
-	if (FAILED(compileResult))
+Shader* DX11Device::CreateShader(const std::string &name, ShaderFeatures features)
+{
+	std::string variantName = ShaderPreprocessor::GetVariantName(name, features);
+
+	// only variants that are asked for are ever compiled, and each of them once
+	auto variant = shaderVariants.find(variantName);
+
+	if (variant != shaderVariants.end())
 	{
-		// Make Default shader and return
-		LOG_DX_ERROR("Failed compiling vertex shader", compileResult);
+		// a variant still compiling for CreateShaderAsync is waited for, this shader is expected to be ready
+		if (variant->second->compilePending)
+		{
+			FinishQueuedShaderCompile(variant->second);
+		}
+
+		variant->second->refCount++;
+		return variant->second;
+	}
+
+	D3D11Shader* newShader = CompileShader(name, features);
+
+	if (newShader == nullptr)
 		return nullptr;
+
+	newShader->variantName = variantName;
+	newShader->refCount = 1;
+	shaderVariants[variantName] = newShader;
+
+	return newShader;
+}
+
+void DX11Device::ReleaseShader(Shader* shader)
+{
+	D3D11Shader* dxShader = static_cast<D3D11Shader*>(shader);
+
+	if (dxShader == nullptr)
+		return;
+
+	// the variant stays alive while anything else created it
+	if (dxShader->refCount > 1)
+	{
+		dxShader->refCount--;
+		return;
 	}
 
-	// create vertex shader
-	HR(pDevice->CreateVertexShader(pVSBlob->GetBufferPointer(), pVSBlob->GetBufferSize(), nullptr, &newShader->pVertexShader));
+	shaderVariants.erase(dxShader->variantName);
 
-	// compile pixel shader
-	ID3DBlob* pPSBlob = nullptr;
-	compileResult = CompileShaderFromFile(wfileName, "PS", "ps_4_0", &pPSBlob);
+	// the worker can't be stopped, its compile is thrown away when it finishes
+	if (dxShader->compilePending)
+	{
+		for (ShaderCompileD3D11* compile : shaderCompiles)
+		{
+			if (compile->shader == dxShader)
+			{
+				compile->shader = nullptr;
+				break;
+			}
+		}
+	}
 
-	if (FAILED(compileResult))
+	if (curShader == dxShader)
 	{
-		LOG_DX_ERROR("Failed compiling pixel shader", compileResult);
+		curShader = nullptr;
+	}
+
+	DeleteShaderObjects(dxShader);
+
+	delete dxShader;
+}
+
+Shader* DX11Device::CreateShaderAsync(const std::string &name, ShaderFeatures features)
+{
+	std::string variantName = ShaderPreprocessor::GetVariantName(name, features);
+
+	// a variant that is already compiling is shared as it is, it becomes ready for every user at once
+	auto variant = shaderVariants.find(variantName);
+
+	if (variant != shaderVariants.end())
+	{
+		variant->second->refCount++;
+		return variant->second;
+	}
+
+	// the preprocessor shares its file cache with the main thread, so the worker is handed the finished source.
+	// a missing file is reported here and null returned straight away rather than by the worker
+	ShaderCompileD3D11* compile = new ShaderCompileD3D11();
+	compile->fileName = DX11_SHADER_LOC + name + ".fx";
+
+	if (!shaderPreprocessor.Process(compile->fileName, features, compile->source))
+	{
+		LOG_ERROR("Unable to create shader [%s], could not read its source", variantName.c_str());
+
+		delete compile;
 		return nullptr;
 	}
 
-	// create pixel shader
-	HR(pDevice->CreatePixelShader(pPSBlob->GetBufferPointer(), pPSBlob->GetBufferSize(), nullptr, &newShader->pPixelShader));
+	if (compileThreads.empty())
+	{
+		StartCompileThreads();
+	}
+
+	D3D11Shader* newShader = new D3D11Shader();
+	newShader->compilePending = true;
+	newShader->variantName = variantName;
+	newShader->refCount = 1;
+	shaderVariants[variantName] = newShader;
+
+	compile->shader = newShader;
+	shaderCompiles.push_back(compile);
+
+	{
+		std::lock_guard<std::mutex> lock(compileMutex);
+		compileQueue.push_back(compile);
+	}
+
+	compileCondition.notify_one();
 
 	return newShader;
 }
 
-void DX11Device::ReleaseShader(Shader* shader)
+bool DX11Device::IsShaderReady(Shader* shader)
 {
 	D3D11Shader* dxShader = static_cast<D3D11Shader*>(shader);
 
 	if (dxShader == nullptr)
-		return;
-	
-	dxShader->pPixelShader->Release();
-	dxShader->pVertexShader->Release();
+		return false;
 
-	delete dxShader;
+	// create the shader now rather than at the next Present if its worker is already done
+	if (dxShader->compilePending)
+	{
+		for (uint32 c = 0; c < shaderCompiles.size(); c++)
+		{
+			if (shaderCompiles[c]->shader == dxShader && shaderCompiles[c]->complete)
+			{
+				FinishShaderCompile(shaderCompiles[c]);
+
+				shaderCompiles[c] = shaderCompiles.back();
+				shaderCompiles.pop_back();
+				break;
+			}
+		}
+	}
+
+	return !dxShader->compilePending && dxShader->pVertexShader && dxShader->pPixelShader;
 }
 
 Texture* DX11Device::CreateTexture(uint8 *data, const TextureSettings &settings)
 {
+	DS_ASSERT(settings.arraySize > 0); // a texture needs at least one layer
+
 	D3D11Texture* newTexture = new D3D11Texture();
 
 	DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -359,22 +623,36 @@ Texture* DX11Device::CreateTexture(uint8 *data, const TextureSettings &settings)
 
 	newTexture->pTexture = CreateTexture2D_D3D(settings.width, settings.height, format,
 												D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET,
-												D3D11_RESOURCE_MISC_GENERATE_MIPS, mipCount);
+												D3D11_RESOURCE_MISC_GENERATE_MIPS, mipCount, settings.arraySize);
 
-	if (&newTexture->pTexture != nullptr)
+	if (newTexture->pTexture != nullptr)
 	{
+		D3D11_TEXTURE2D_DESC textureDesc;
+		newTexture->pTexture->GetDesc(&textureDesc);
+
+		newTexture->width = settings.width;
+		newTexture->height = settings.height;
+		newTexture->arraySize = settings.arraySize;
+		newTexture->mipLevels = textureDesc.MipLevels;
+		newTexture->mipMaps = settings.mipMaps;
+
 		D3D11_SHADER_RESOURCE_VIEW_DESC SRVDesc;
 		memset(&SRVDesc, 0, sizeof(SRVDesc));
 		SRVDesc.Format = format;
 
-		SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-		if (settings.mipMaps)
+		uint32 viewMipLevels = settings.mipMaps ? textureDesc.MipLevels : 1;
+
+		if (settings.arraySize > 1)
 		{
-			SRVDesc.Texture2D.MipLevels = mipCount <= 0 ? -1 : mipCount;
+			SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+			SRVDesc.Texture2DArray.MipLevels = viewMipLevels;
+			SRVDesc.Texture2DArray.FirstArraySlice = 0;
+			SRVDesc.Texture2DArray.ArraySize = settings.arraySize;
 		}
 		else
 		{
-			SRVDesc.Texture2D.MipLevels = 1;
+			SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+			SRVDesc.Texture2D.MipLevels = viewMipLevels;
 		}
 
 		HR(pDevice->CreateShaderResourceView(newTexture->pTexture, &SRVDesc, &newTexture->pTexResourceView));
@@ -382,24 +660,26 @@ Texture* DX11Device::CreateTexture(uint8 *data, const TextureSettings &settings)
 	else
 	{
 		LOG_ERROR("Failed creating Texture2D");
+		delete newTexture;
 		return nullptr;
 	}
 
-	uint32 bpp = 32;
-	uint32 rowBytes = (settings.width * bpp + 7) / 8;
-	uint32 numRows = settings.height;
-	uint32 numBytes = rowBytes * settings.height;
-
-	pDeviceContext->UpdateSubresource(newTexture->pTexture, 0, nullptr, data, rowBytes, numBytes);
-
-	if (settings.mipMaps)
+	// an array can be created empty and filled a layer at a time with UpdateTextureLayer
+	if (data)
 	{
-		pDeviceContext->GenerateMips(newTexture->pTexResourceView);
-	}
+		uint32 rowBytes = settings.width * 4;
+		uint32 layerBytes = rowBytes * settings.height;
 
-	if (newTexture->pTexture == nullptr)
-	{
-		newTexture->pTexture->Release();
+		for (uint32 layer = 0; layer < settings.arraySize; layer++)
+		{
+			uint32 subresource = D3D11CalcSubresource(0, layer, newTexture->mipLevels);
+			pDeviceContext->UpdateSubresource(newTexture->pTexture, subresource, nullptr, data + layer * layerBytes, rowBytes, layerBytes);
+		}
+
+		if (settings.mipMaps)
+		{
+			pDeviceContext->GenerateMips(newTexture->pTexResourceView);
+		}
 	}
 
 	// create sampler state
@@ -440,6 +720,25 @@ Texture* DX11Device::CreateTexture(uint8 *data, const TextureSettings &settings)
 	return newTexture;
 }
 
+void DX11Device::UpdateTextureLayer(Texture* texture, uint32 layer, const uint8* data)
+{
+	D3D11Texture* dxTexture = static_cast<D3D11Texture*>(texture);
+
+	DS_ASSERT(dxTexture && data);
+	DS_ASSERT(layer < dxTexture->arraySize); // layer must exist in the texture
+
+	uint32 rowBytes = dxTexture->width * 4;
+	uint32 subresource = D3D11CalcSubresource(0, layer, dxTexture->mipLevels);
+
+	pDeviceContext->UpdateSubresource(dxTexture->pTexture, subresource, nullptr, data, rowBytes, rowBytes * dxTexture->height);
+
+	// regenerates every layer, D3D11 has no per layer generate
+	if (dxTexture->mipMaps)
+	{
+		pDeviceContext->GenerateMips(dxTexture->pTexResourceView);
+	}
+}
+
 void DX11Device::ReleaseTexture(Texture* pTexture)
 {
 	D3D11Texture* dxTexture = static_cast<D3D11Texture*>(pTexture);
@@ -447,13 +746,64 @@ void DX11Device::ReleaseTexture(Texture* pTexture)
 	if (dxTexture == nullptr)
 		return;
 
-	dxTexture->pTexture->Release();
-	dxTexture->pTexResourceView->Release();
-	dxTexture->pSampler->Release();
+	if (dxTexture->uploadPending)
+	{
+		for (auto upload = textureUploads.begin(); upload != textureUploads.end(); ++upload)
+		{
+			if (upload->texture == dxTexture)
+			{
+				textureUploads.erase(upload);
+				break;
+			}
+		}
+	}
+
+	DeleteTextureObjects(dxTexture);
 
 	delete dxTexture;
 }
 
+Texture* DX11Device::CreateTextureAsync(const uint8* data, const TextureSettings &settings)
+{
+	if (data == nullptr)
+		return CreateTexture(nullptr, settings);
+
+	// only the texture is created here, the texels are copied in by ProcessTextureUploads
+	D3D11Texture* newTexture = static_cast<D3D11Texture*>(CreateTexture(nullptr, settings));
+
+	if (newTexture == nullptr)
+		return nullptr;
+
+	newTexture->uploadPending = true;
+
+	// textures are always created as RGBA, the same as CreateTexture expects its data
+	uint32 rowBytes = settings.width * 4;
+
+	TextureUploadD3D11 upload;
+	upload.texture = newTexture;
+	upload.data.assign(data, data + rowBytes * settings.height * settings.arraySize);
+	upload.rowBytes = rowBytes;
+	upload.nextRow = 0;
+
+	textureUploads.push_back(std::move(upload));
+
+	return newTexture;
+}
+
+bool DX11Device::IsTextureReady(Texture* texture)
+{
+	D3D11Texture* dxTexture = static_cast<D3D11Texture*>(texture);
+
+	return dxTexture != nullptr && !dxTexture->uploadPending;
+}
+
+void DX11Device::SetTextureUploadBudget(uint32 bytesPerFrame)
+{
+	DS_ASSERT(bytesPerFrame > 0); // uploads would never complete
+
+	textureUploadBudget = bytesPerFrame;
+}
+
 void DX11Device::SetUniformBuffer(uint32 slot, Buffer* buffer, ShaderStage stage)
 {
 	DX11Buffer *dxBuffer = static_cast<DX11Buffer*>(buffer);
@@ -471,6 +821,40 @@ void DX11Device::SetUniformBuffer(uint32 slot, Buffer* buffer, ShaderStage stage
 	}
 }
 
+void DX11Device::SetUniformBufferRange(uint32 slot, Buffer* buffer, uint32 offset, uint32 size, ShaderStage stage)
+{
+	DX11Buffer *dxBuffer = static_cast<DX11Buffer*>(buffer);
+
+	DS_ASSERT(dxBuffer);										// dxBuffer must not be null
+	DS_ASSERT(offset % DX11_CONSTANT_BUFFER_ALIGNMENT == 0);	// offset must be aligned
+	DS_ASSERT(offset + size <= dxBuffer->size);					// range must lie inside the buffer
+
+	if (pDeviceContext1 == nullptr)
+	{
+		LOG_ERROR("SetUniformBufferRange requires D3D11.1");
+		return;
+	}
+
+	// the constant count is rounded up, reading past the end of the buffer returns 0
+	UINT firstConstant = offset / DX11_CONSTANT_SIZE;
+	UINT numConstants = (size + DX11_CONSTANT_BUFFER_ALIGNMENT - 1) / DX11_CONSTANT_BUFFER_ALIGNMENT * (DX11_CONSTANT_BUFFER_ALIGNMENT / DX11_CONSTANT_SIZE);
+
+	if (CheckFlags(stage, ShaderStage::Vertex))
+	{
+		pDeviceContext1->VSSetConstantBuffers1(slot, 1, &dxBuffer->pBuffer, &firstConstant, &numConstants);
+	}
+
+	if (CheckFlags(stage, ShaderStage::Pixel))
+	{
+		pDeviceContext1->PSSetConstantBuffers1(slot, 1, &dxBuffer->pBuffer, &firstConstant, &numConstants);
+	}
+}
+
+uint32 DX11Device::GetUniformBufferAlignment()
+{
+	return DX11_CONSTANT_BUFFER_ALIGNMENT;
+}
+
 DX11Buffer* DX11Device::CreateBuffer(const void* data, uint32 size, BufferTarget target, BufferUsage usage)
 {
 	// setup properties of the new buffer to be created
@@ -575,6 +959,45 @@ void DX11Device::UpdateBuffer(Buffer* buffer, const std::vector<BufferData> &dat
 	pDeviceContext->Unmap(dxBuffer->pBuffer, 0);
 }
 
+void DX11Device::UpdateBufferRegion(Buffer* buffer, const void* data, uint32 offset, uint32 size)
+{
+	DX11Buffer* dxBuffer = static_cast<DX11Buffer*>(buffer);
+
+	DS_ASSERT(dxBuffer);									// dxBuffer must not be null
+	DS_ASSERT(dxBuffer->dxUsage != D3D11_USAGE_IMMUTABLE);	// Immutable buffers cannot be modified
+	DS_ASSERT(offset + size <= dxBuffer->size);				// region must lie inside the buffer
+
+	if (size == 0)
+		return;
+
+	bool constantBuffer = (dxBuffer->desc.BindFlags & D3D11_BIND_CONSTANT_BUFFER) != 0;
+
+	// D3D11.0 only allows constant buffers to be written in full
+	if (constantBuffer && (offset != 0 || size != dxBuffer->size))
+	{
+		LOG_ERROR("UpdateBufferRegion can not partially update a constant buffer");
+		return;
+	}
+
+	if (dxBuffer->dxUsage == D3D11_USAGE_DYNAMIC)
+	{
+		// no overwrite keeps the rest of the buffer, the region must not be in use by draws already issued
+		D3D11_MAP mapType = constantBuffer ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+
+		D3D11_MAPPED_SUBRESOURCE elementResource;
+		HR(pDeviceContext->Map(dxBuffer->pBuffer, 0, mapType, 0, &elementResource));
+
+		memcpy(static_cast<uint8*>(elementResource.pData) + offset, data, size);
+
+		pDeviceContext->Unmap(dxBuffer->pBuffer, 0);
+	}
+	else
+	{
+		D3D11_BOX region = { offset, 0, 0, offset + size, 1, 1 };
+		pDeviceContext->UpdateSubresource(dxBuffer->pBuffer, 0, constantBuffer ? nullptr : &region, data, 0, 0);
+	}
+}
+
 void DX11Device::ReleaseBuffer(Buffer* buffer)
 {
 	DX11Buffer *dxBuffer = static_cast<DX11Buffer*>(buffer);
@@ -586,9 +1009,432 @@ void DX11Device::ReleaseBuffer(Buffer* buffer)
 	}
 }
 
-void DX11Device::SetScissorRects(uint32 numRects, const DSRect* pRects)
+MeshHandle DX11Device::CreateMeshHandle(const MeshData &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage)
 {
-	if (!pRects)
+	D3D11Mesh* newMesh = static_cast<D3D11Mesh*>(CreateMesh(meshData, vertexAttributeFlags, usage));
+
+	if (newMesh == nullptr)
+		return MeshHandle();
+
+	// the D3D objects now belong to the copy held by the container
+	MeshHandle handle = meshes.CreateResource(*newMesh);
+	delete newMesh;
+
+	return handle;
+}
+
+void DX11Device::UpdateMesh(MeshHandle mesh, const MeshData &meshData)
+{
+	D3D11Mesh* dxMesh;
+	RESOLVE_HANDLE(dxMesh, meshes, mesh);
+
+	UpdateMesh(dxMesh, meshData);
+}
+
+void DX11Device::DrawMeshIndexed(MeshHandle mesh, uint32 elementCount, uint32 vertexOffset, uint32 indexOffset)
+{
+	D3D11Mesh* dxMesh;
+	RESOLVE_HANDLE(dxMesh, meshes, mesh);
+
+	DrawMeshIndexed(dxMesh, elementCount, vertexOffset, indexOffset);
+}
+
+void DX11Device::ReleaseMesh(MeshHandle mesh)
+{
+	D3D11Mesh* dxMesh;
+	RESOLVE_HANDLE(dxMesh, meshes, mesh);
+
+	DeleteMeshObjects(dxMesh);
+	meshes.ReleaseResource(mesh);
+}
+
+ShaderHandle DX11Device::CreateShaderHandle(const std::string &name)
+{
+	D3D11Shader* newShader = CompileShader(name, ShaderFeatures::None);
+
+	if (newShader == nullptr)
+		return ShaderHandle();
+
+	ShaderHandle handle = shaders.CreateResource(*newShader);
+	delete newShader;
+
+	return handle;
+}
+
+void DX11Device::SetShader(ShaderHandle shader)
+{
+	D3D11Shader* dxShader;
+	RESOLVE_HANDLE(dxShader, shaders, shader);
+
+	SetShader(dxShader);
+
+	// shaders created through handles are never pending, and the container may move them
+	curShader = nullptr;
+}
+
+void DX11Device::ReleaseShader(ShaderHandle shader)
+{
+	D3D11Shader* dxShader;
+	RESOLVE_HANDLE(dxShader, shaders, shader);
+
+	DeleteShaderObjects(dxShader);
+	shaders.ReleaseResource(shader);
+}
+
+TextureHandle DX11Device::CreateTextureHandle(uint8 *data, const TextureSettings &settings)
+{
+	D3D11Texture* newTexture = static_cast<D3D11Texture*>(CreateTexture(data, settings));
+
+	if (newTexture == nullptr)
+		return TextureHandle();
+
+	TextureHandle handle = textures.CreateResource(*newTexture);
+	delete newTexture;
+
+	return handle;
+}
+
+void DX11Device::SetTexture(TextureHandle texture, uint32 slot)
+{
+	D3D11Texture* dxTexture;
+	RESOLVE_HANDLE(dxTexture, textures, texture);
+
+	SetTexture(dxTexture, slot);
+}
+
+void DX11Device::ReleaseTexture(TextureHandle texture)
+{
+	D3D11Texture* dxTexture;
+	RESOLVE_HANDLE(dxTexture, textures, texture);
+
+	DeleteTextureObjects(dxTexture);
+	textures.ReleaseResource(texture);
+}
+
+BufferHandle DX11Device::CreateBufferHandle(const void* data, uint32 size, BufferTarget target, BufferUsage usage)
+{
+	DX11Buffer* newBuffer = CreateBuffer(data, size, target, usage);
+
+	if (newBuffer == nullptr)
+		return BufferHandle();
+
+	BufferHandle handle = buffers.CreateResource(*newBuffer);
+	delete newBuffer;
+
+	return handle;
+}
+
+void DX11Device::UpdateBuffer(BufferHandle buffer, const void* data, uint32 size)
+{
+	DX11Buffer* dxBuffer;
+	RESOLVE_HANDLE(dxBuffer, buffers, buffer);
+
+	UpdateBuffer(dxBuffer, data, size);
+}
+
+void DX11Device::UpdateBufferRegion(BufferHandle buffer, const void* data, uint32 offset, uint32 size)
+{
+	DX11Buffer* dxBuffer;
+	RESOLVE_HANDLE(dxBuffer, buffers, buffer);
+
+	UpdateBufferRegion(dxBuffer, data, offset, size);
+}
+
+void DX11Device::SetUniformBuffer(uint32 slot, BufferHandle buffer, ShaderStage stage)
+{
+	DX11Buffer* dxBuffer;
+	RESOLVE_HANDLE(dxBuffer, buffers, buffer);
+
+	SetUniformBuffer(slot, dxBuffer, stage);
+}
+
+void DX11Device::ReleaseBuffer(BufferHandle buffer)
+{
+	DX11Buffer* dxBuffer;
+	RESOLVE_HANDLE(dxBuffer, buffers, buffer);
+
+	dxBuffer->pBuffer->Release();
+	buffers.ReleaseResource(buffer);
+}
+
+RenderTarget* DX11Device::CreateRenderTarget(const RenderTargetDesc &desc)
+{
+	D3D11RenderTarget* newTarget = new D3D11RenderTarget(desc);
+	const RenderTargetFormatD3D11 &dxFormat = D3D11RenderTargetFormatMap[static_cast<int32>(desc.format)];
+
+	bool isDepth = IsDepthFormat(desc.format);
+
+	// lower the sample count until the format supports it
+	uint32 sampleCount = glm::max(desc.sampleCount, 1u);
+	UINT qualityLevels = 0;
+
+	while (sampleCount > 1 && (FAILED(pDevice->CheckMultisampleQualityLevels(dxFormat.textureFormat, sampleCount, &qualityLevels)) || qualityLevels == 0))
+	{
+		sampleCount >>= 1;
+	}
+
+	UINT bindFlags = isDepth ? D3D11_BIND_DEPTH_STENCIL : D3D11_BIND_RENDER_TARGET;
+
+	if (sampleCount == 1)
+	{
+		bindFlags |= D3D11_BIND_SHADER_RESOURCE;
+	}
+
+	D3D11Texture &texture = newTarget->sampleTexture;
+	texture.pTexture = CreateTexture2D_D3D(desc.width, desc.height, dxFormat.textureFormat, D3D11_USAGE_DEFAULT, bindFlags,
+										   0, 1, 1, sampleCount);
+
+	if (texture.pTexture == nullptr)
+	{
+		LOG_ERROR("Failed creating render target texture [%ux%u]", desc.width, desc.height);
+		delete newTarget;
+		return nullptr;
+	}
+
+	HRESULT result;
+
+	if (isDepth)
+	{
+		D3D11_DEPTH_STENCIL_VIEW_DESC descDSV;
+		ZeroMemory(&descDSV, sizeof(D3D11_DEPTH_STENCIL_VIEW_DESC));
+		descDSV.Format = dxFormat.viewFormat;
+		descDSV.ViewDimension = (sampleCount > 1) ? D3D11_DSV_DIMENSION_TEXTURE2DMS : D3D11_DSV_DIMENSION_TEXTURE2D;
+
+		result = pDevice->CreateDepthStencilView(texture.pTexture, &descDSV, &newTarget->pDepthStencilView);
+	}
+	else
+	{
+		D3D11_RENDER_TARGET_VIEW_DESC descRTV;
+		ZeroMemory(&descRTV, sizeof(D3D11_RENDER_TARGET_VIEW_DESC));
+		descRTV.Format = dxFormat.viewFormat;
+		descRTV.ViewDimension = (sampleCount > 1) ? D3D11_RTV_DIMENSION_TEXTURE2DMS : D3D11_RTV_DIMENSION_TEXTURE2D;
+
+		result = pDevice->CreateRenderTargetView(texture.pTexture, &descRTV, &newTarget->pRenderTargetView);
+	}
+
+	if (FAILED(result))
+	{
+		LOG_DX_ERROR("Failed creating render target view", result);
+		texture.pTexture->Release();
+		delete newTarget;
+		return nullptr;
+	}
+
+	if (sampleCount == 1)
+	{
+		D3D11_SHADER_RESOURCE_VIEW_DESC SRVDesc;
+		ZeroMemory(&SRVDesc, sizeof(SRVDesc));
+		SRVDesc.Format = dxFormat.resourceFormat;
+		SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+		SRVDesc.Texture2D.MipLevels = 1;
+
+		HR(pDevice->CreateShaderResourceView(texture.pTexture, &SRVDesc, &texture.pTexResourceView));
+
+		// depth is not filtered
+		D3D11_SAMPLER_DESC samplerDesc;
+		ZeroMemory(&samplerDesc, sizeof(samplerDesc));
+		samplerDesc.Filter = isDepth ? D3D11_FILTER_MIN_MAG_MIP_POINT : D3D11_FILTER_MIN_MAG_LINEAR_MIP_POINT;
+		samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+		samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+		samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+		samplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+		samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+
+		HR(pDevice->CreateSamplerState(&samplerDesc, &texture.pSampler));
+	}
+
+	return newTarget;
+}
+
+void DX11Device::ReleaseRenderTarget(RenderTarget* target)
+{
+	D3D11RenderTarget* dxTarget = static_cast<D3D11RenderTarget*>(target);
+
+	if (dxTarget == nullptr)
+		return;
+
+	// a bound target is replaced by the back buffer before it is released
+	bool bound = (curDepthTarget == dxTarget);
+
+	for (uint32 t = 0; t < numCurColorTargets; t++)
+	{
+		bound |= (curColorTargets[t] == dxTarget);
+	}
+
+	if (bound)
+	{
+		numCurColorTargets = 0;
+		curDepthTarget = nullptr;
+
+		BindRenderTargets();
+	}
+
+	if (dxTarget->pRenderTargetView) dxTarget->pRenderTargetView->Release();
+	if (dxTarget->pDepthStencilView) dxTarget->pDepthStencilView->Release();
+
+	D3D11Texture &texture = dxTarget->sampleTexture;
+
+	if (texture.pTexResourceView) texture.pTexResourceView->Release();
+	if (texture.pSampler) texture.pSampler->Release();
+	if (texture.pTexture) texture.pTexture->Release();
+
+	delete dxTarget;
+}
+
+void DX11Device::SetRenderTargets(uint32 numColorTargets, RenderTarget* const* pColorTargets, RenderTarget* depthTarget)
+{
+	DS_ASSERT(numColorTargets <= DS_MAX_RENDER_TARGETS);
+
+	numCurColorTargets = glm::min(numColorTargets, static_cast<uint32>(DS_MAX_RENDER_TARGETS));
+
+	for (uint32 t = 0; t < numCurColorTargets; t++)
+	{
+		curColorTargets[t] = static_cast<D3D11RenderTarget*>(pColorTargets[t]);
+	}
+
+	curDepthTarget = static_cast<D3D11RenderTarget*>(depthTarget);
+
+	BindRenderTargets();
+}
+
+void DX11Device::ClearRenderTarget(RenderTarget* target, const vec4 &color, float depth, uint8 stencil)
+{
+	D3D11RenderTarget* dxTarget = static_cast<D3D11RenderTarget*>(target);
+
+	if (dxTarget == nullptr)
+		return;
+
+	// clears ignore the scissor rect and write masks, so the target does not have to be bound
+	if (dxTarget->pDepthStencilView)
+	{
+		UINT clearFlags = D3D11_CLEAR_DEPTH;
+
+		if (dxTarget->GetDesc().format == RenderTargetFormat::Depth24Stencil8)
+		{
+			clearFlags |= D3D11_CLEAR_STENCIL;
+		}
+
+		pDeviceContext->ClearDepthStencilView(dxTarget->pDepthStencilView, clearFlags, depth, stencil);
+	}
+	else
+	{
+		pDeviceContext->ClearRenderTargetView(dxTarget->pRenderTargetView, (const float*)&color);
+	}
+}
+
+void DX11Device::ResolveRenderTarget(RenderTarget* source, RenderTarget* destination)
+{
+	D3D11RenderTarget* dxSource = static_cast<D3D11RenderTarget*>(source);
+	D3D11RenderTarget* dxDestination = static_cast<D3D11RenderTarget*>(destination);
+
+	if (dxSource == nullptr || dxDestination == nullptr)
+		return;
+
+	if (IsDepthFormat(dxSource->GetDesc().format))
+	{
+		LOG_ERROR("DX11 can not resolve depth render targets");
+		return;
+	}
+
+	DXGI_FORMAT format = D3D11RenderTargetFormatMap[static_cast<int32>(dxSource->GetDesc().format)].viewFormat;
+
+	pDeviceContext->ResolveSubresource(dxDestination->sampleTexture.pTexture, 0, dxSource->sampleTexture.pTexture, 0, format);
+}
+
+void DX11Device::RequestReadback(RenderTarget* target, ReadbackCallback callback)
+{
+	D3D11RenderTarget* dxTarget = static_cast<D3D11RenderTarget*>(target);
+
+	ID3D11Texture2D* pSource = nullptr;
+	uint32 width = renderInfo.resolutionX;
+	uint32 height = renderInfo.resolutionY;
+
+	if (dxTarget)
+	{
+		const RenderTargetDesc &desc = dxTarget->GetDesc();
+
+		if (desc.format != RenderTargetFormat::RGBA8 || desc.sampleCount > 1)
+		{
+			LOG_ERROR("Readback requires a single sampled RGBA8 target");
+			return;
+		}
+
+		pSource = dxTarget->sampleTexture.pTexture;
+		pSource->AddRef();
+
+		width = desc.width;
+		height = desc.height;
+	}
+	else
+	{
+		HR(pSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&pSource)));
+
+		if (pSource == nullptr)
+			return;
+	}
+
+	if (pendingReadbacks == DX11_READBACK_BUFFER_COUNT)
+	{
+		LOG_WARNING("All %u readbacks are in flight, waiting on the oldest", DX11_READBACK_BUFFER_COUNT);
+		CompleteReadbacks(true);
+	}
+
+	ReadbackD3D11 &readback = readbacks[nextReadback];
+
+	// the staging texture is kept for the next readback of the same size
+	if (readback.pStagingTexture && (readback.width != width || readback.height != height))
+	{
+		readback.pStagingTexture->Release();
+		readback.pStagingTexture = nullptr;
+	}
+
+	if (readback.pStagingTexture == nullptr)
+	{
+		readback.pStagingTexture = CreateTexture2D_D3D(width, height, DXGI_FORMAT_R8G8B8A8_UNORM, D3D11_USAGE_STAGING, 0,
+													   0, 1, 1, 1, 0, D3D11_CPU_ACCESS_READ);
+
+		if (readback.pStagingTexture == nullptr)
+		{
+			LOG_ERROR("Failed creating readback texture [%ux%u]", width, height);
+			pSource->Release();
+			return;
+		}
+	}
+
+	// queued on the GPU, the staging texture can be mapped without waiting once the copy has executed
+	pDeviceContext->CopyResource(readback.pStagingTexture, pSource);
+	pSource->Release();
+
+	readback.width = width;
+	readback.height = height;
+	readback.callback = std::move(callback);
+
+	nextReadback = (nextReadback + 1) % DX11_READBACK_BUFFER_COUNT;
+	pendingReadbacks++;
+}
+
+void DX11Device::BindRenderTargets()
+{
+	if (numCurColorTargets == 0 && curDepthTarget == nullptr)
+	{
+		pDeviceContext->OMSetRenderTargets(1, &pRenderTargetView, pDepthStencilView);
+		return;
+	}
+
+	ID3D11RenderTargetView* renderTargetViews[DS_MAX_RENDER_TARGETS];
+
+	for (uint32 t = 0; t < numCurColorTargets; t++)
+	{
+		renderTargetViews[t] = curColorTargets[t]->pRenderTargetView;
+	}
+
+	// a target can not be bound for output while it is bound as a shader resource, D3D unbinds the resource
+	pDeviceContext->OMSetRenderTargets(numCurColorTargets, renderTargetViews, curDepthTarget ? curDepthTarget->pDepthStencilView : nullptr);
+}
+
+void DX11Device::SetScissorRects(uint32 numRects, const DSRect* pRects)
+{
+	if (!pRects)
 		return;
 
 	D3D11_RECT rects[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
@@ -627,6 +1473,13 @@ void DX11Device::GetScissorRects(uint32* pNumRects, DSRect* pRects)
 
 BlendState* DX11Device::CreateBlendState(BlendProperties properties)
 {
+	// return the existing state if one was already created with the same properties
+	uint32 key = properties.CalculateKey();
+	DX11BlendState* cachedState = blendStates.Find(key, properties);
+
+	if (cachedState != nullptr)
+		return cachedState;
+
 	D3D11_BLEND_DESC blendDesc;
 	ZeroMemory(&blendDesc, sizeof(blendDesc));
 
@@ -640,27 +1493,38 @@ BlendState* DX11Device::CreateBlendState(BlendProperties properties)
 	blendDesc.RenderTarget[0].SrcBlendAlpha = GET_D3D11_BLEND(properties.srcBlendAlpha);
 	blendDesc.RenderTarget[0].DestBlendAlpha = GET_D3D11_BLEND(properties.dstBlendAlpha);
 	blendDesc.RenderTarget[0].BlendOpAlpha = GET_D3D11_BLEND_OP(properties.blendOpAlpha);
-	blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+	blendDesc.RenderTarget[0].RenderTargetWriteMask = properties.colorMask; // ColorMask matches D3D11_COLOR_WRITE_ENABLE
 
 	DX11BlendState* dxBlendState = new DX11BlendState();
-	pDevice->CreateBlendState(&blendDesc, &dxBlendState->blendState);
+	dxBlendState->properties = properties;
+	HR(pDevice->CreateBlendState(&blendDesc, &dxBlendState->blendState));
 
-	return dxBlendState;
+	return blendStates.Add(key, properties, dxBlendState);
 }
 
 void DX11Device::SetBlendState(BlendState* state)
 {
 	DX11BlendState* dxBlendState = static_cast<DX11BlendState*>(state);
 
-	if (dxBlendState == nullptr)
+	// states are unique per descriptor, the same pointer means the same state
+	if (dxBlendState == nullptr || dxBlendState == curBlendState)
 		return;
 
 	const float blend_factor[4] = { 0.f, 0.f, 0.f, 0.f };
 	pDeviceContext->OMSetBlendState(dxBlendState->blendState, blend_factor, 0xffffffff);
+
+	curBlendState = dxBlendState;
 }
 
 DepthStencilStateD3D11* DX11Device::CreateDepthStencilState(DepthStencilStateDesc& desc)
 {
+	// return the existing state if one was already created with the same descriptor
+	uint32 key = desc.CalculateKey();
+	DepthStencilStateD3D11* cachedState = depthStencilStates.Find(key, desc);
+
+	if (cachedState != nullptr)
+		return cachedState;
+
 	// Depth Stencil State
 	D3D11_DEPTH_STENCIL_DESC dsDesc;
 
@@ -671,8 +1535,8 @@ DepthStencilStateD3D11* DX11Device::CreateDepthStencilState(DepthStencilStateDes
 
 	// Stencil test parameters
 	dsDesc.StencilEnable = desc.stencilEnabled;
-	dsDesc.StencilReadMask = desc.stencilRead ? 0xFF : 0x00;
-	dsDesc.StencilWriteMask = desc.stencilWrite ? 0xFF : 0x00;
+	dsDesc.StencilReadMask = desc.stencilRead;
+	dsDesc.StencilWriteMask = desc.stencilWrite;
 
 	// Stencil operations if pixel is front-facing
 	dsDesc.FrontFace.StencilFailOp = GET_D3D11_STENCIL_OP(desc.frontFace.stencilfailOp);
@@ -689,7 +1553,7 @@ DepthStencilStateD3D11* DX11Device::CreateDepthStencilState(DepthStencilStateDes
 	ID3D11DepthStencilState* newDepthStencilState;
 	HR(pDevice->CreateDepthStencilState(&dsDesc, &newDepthStencilState));
 
-	return new DepthStencilStateD3D11(newDepthStencilState);
+	return depthStencilStates.Add(key, desc, new DepthStencilStateD3D11(newDepthStencilState));
 }
 
 DepthStencilState* DX11Device::GetCurrentDepthStencilState()
@@ -700,6 +1564,10 @@ DepthStencilState* DX11Device::GetCurrentDepthStencilState()
 void DX11Device::SetDepthStencilState(DepthStencilState* state)
 {
 	DepthStencilStateD3D11* dxDepthStencilState = static_cast<DepthStencilStateD3D11*>(state);
+
+	if (dxDepthStencilState == curDepthStencilState)
+		return;
+
 	curDepthStencilState = dxDepthStencilState;
 
 	if (dxDepthStencilState == nullptr)
@@ -708,6 +1576,49 @@ void DX11Device::SetDepthStencilState(DepthStencilState* state)
 	pDeviceContext->OMSetDepthStencilState(dxDepthStencilState->pDepthStencilState, 1);
 }
 
+RasterizerState* DX11Device::CreateRasterizerState(const RasterizerStateDesc &desc)
+{
+	// return the existing state if one was already created with the same descriptor
+	uint32 key = desc.CalculateKey();
+	RasterizerStateD3D11* cachedState = rasterizerStates.Find(key, desc);
+
+	if (cachedState != nullptr)
+		return cachedState;
+
+	D3D11_RASTERIZER_DESC rsDesc;
+	ZeroMemory(&rsDesc, sizeof(rsDesc));
+
+	rsDesc.FillMode = GET_D3D11_FILL_MODE(desc.fillMode);
+	rsDesc.CullMode = GET_D3D11_CULL_MODE(desc.cullMode);
+	rsDesc.FrontCounterClockwise = desc.frontCounterClockwise;
+	rsDesc.DepthBias = desc.depthBias;
+	rsDesc.SlopeScaledDepthBias = desc.slopeScaledDepthBias;
+	rsDesc.ScissorEnable = desc.scissorEnabled;
+	rsDesc.DepthClipEnable = false;
+
+	ID3D11RasterizerState* newRasterizerState;
+	HR(pDevice->CreateRasterizerState(&rsDesc, &newRasterizerState));
+
+	RasterizerStateD3D11* dxRasterizerState = new RasterizerStateD3D11(newRasterizerState);
+	dxRasterizerState->desc = desc;
+
+	return rasterizerStates.Add(key, desc, dxRasterizerState);
+}
+
+void DX11Device::SetRasterizerState(RasterizerState* state)
+{
+	RasterizerStateD3D11* dxRasterizerState = static_cast<RasterizerStateD3D11*>(state);
+
+	if (dxRasterizerState == nullptr)
+		dxRasterizerState = defaultRasterizerState;
+
+	if (dxRasterizerState == curRasterizerState)
+		return;
+
+	pDeviceContext->RSSetState(dxRasterizerState->pRasterizerState);
+	curRasterizerState = dxRasterizerState;
+}
+
 bool DX11Device::CreateDepthStencil(uint32 width, uint32 height)
 {
 	LOG("Creating Depth/Stencil : [%ux%u]", width, height);
@@ -783,8 +1694,8 @@ void DX11Device::OnResolutionChanged(uint32 width, uint32 height)
 	// Recreate depth stencil 
 	CreateDepthStencil(renderInfo.resolutionX, renderInfo.resolutionY);
 
-	// Bind render target view
-	pDeviceContext->OMSetRenderTargets(1, &pRenderTargetView, pDepthStencilView);
+	// Bind render target view, offscreen targets stay bound across a resize
+	BindRenderTargets();
 
 	// Setup the viewport
 	SetViewport(0, 0, renderInfo.resolutionX, renderInfo.resolutionY);
@@ -793,7 +1704,57 @@ void DX11Device::OnResolutionChanged(uint32 width, uint32 height)
 	SetScissorRects(1, &defaultRect);
 }
 
-HRESULT DX11Device::CompileShaderFromFile(const std::wstring &fileName, LPCSTR szEntryPoint, LPCSTR szShaderModel, ID3DBlob** ppBlobOut)
+D3D11Shader* DX11Device::CompileShader(const std::string &name, ShaderFeatures features)
+{
+	std::string fileName = DX11_SHADER_LOC + name + ".fx";
+	std::string source;
+
+	if (!shaderPreprocessor.Process(fileName, features, source))
+	{
+		LOG_ERROR("Unable to create shader [%s], could not read its source", ShaderPreprocessor::GetVariantName(name, features).c_str());
+		return nullptr;
+	}
+
+	HRESULT compileResult;
+	D3D11Shader* newShader = new D3D11Shader();
+
+	// compile vertex shader
+	ID3DBlob* pVSBlob = nullptr;
+	compileResult = CompileShaderSource(fileName, source, "VS", "vs_4_0", &pVSBlob);
+
+	if (FAILED(compileResult))
+	{
+		LOG_DX_ERROR("Failed compiling vertex shader", compileResult);
+
+		delete newShader;
+		return nullptr;
+	}
+
+	// create vertex shader
+	HR(pDevice->CreateVertexShader(pVSBlob->GetBufferPointer(), pVSBlob->GetBufferSize(), nullptr, &newShader->pVertexShader));
+	pVSBlob->Release();
+
+	// compile pixel shader
+	ID3DBlob* pPSBlob = nullptr;
+	compileResult = CompileShaderSource(fileName, source, "PS", "ps_4_0", &pPSBlob);
+
+	if (FAILED(compileResult))
+	{
+		LOG_DX_ERROR("Failed compiling pixel shader", compileResult);
+
+		DeleteShaderObjects(newShader);
+		delete newShader;
+		return nullptr;
+	}
+
+	// create pixel shader
+	HR(pDevice->CreatePixelShader(pPSBlob->GetBufferPointer(), pPSBlob->GetBufferSize(), nullptr, &newShader->pPixelShader));
+	pPSBlob->Release();
+
+	return newShader;
+}
+
+HRESULT DX11Device::CompileShaderSource(const std::string &fileName, const std::string &source, LPCSTR szEntryPoint, LPCSTR szShaderModel, ID3DBlob** ppBlobOut)
 {
 	HRESULT result = S_OK;
 
@@ -804,7 +1765,8 @@ HRESULT DX11Device::CompileShaderFromFile(const std::wstring &fileName, LPCSTR s
 #endif
 
 	ID3DBlob* pErrorBlob = nullptr;
-	result = D3DCompileFromFile(fileName.c_str(), nullptr, nullptr, szEntryPoint, szShaderModel, shaderFlags, 0, ppBlobOut, &pErrorBlob);
+	// includes were resolved by the preprocessor, so no include handler is needed
+	result = D3DCompile(source.data(), source.size(), fileName.c_str(), nullptr, nullptr, szEntryPoint, szShaderModel, shaderFlags, 0, ppBlobOut, &pErrorBlob);
 
 	if (FAILED(result))
 	{
@@ -824,6 +1786,344 @@ HRESULT DX11Device::CompileShaderFromFile(const std::wstring &fileName, LPCSTR s
 	return S_OK;
 }
 
+void DX11Device::DeleteMeshObjects(D3D11Mesh* mesh)
+{
+	ReleaseBuffer(mesh->vertexBuffer);
+	ReleaseBuffer(mesh->indexBuffer);
+}
+
+void DX11Device::DeleteShaderObjects(D3D11Shader* shader)
+{
+	// shaders that are compiling or failed to compile have no objects
+	if (shader->pPixelShader) shader->pPixelShader->Release();
+	if (shader->pVertexShader) shader->pVertexShader->Release();
+}
+
+void DX11Device::ProcessShaderCompiles()
+{
+	for (uint32 c = 0; c < shaderCompiles.size();)
+	{
+		if (shaderCompiles[c]->complete)
+		{
+			FinishShaderCompile(shaderCompiles[c]);
+
+			shaderCompiles[c] = shaderCompiles.back();
+			shaderCompiles.pop_back();
+		}
+		else
+		{
+			c++;
+		}
+	}
+}
+
+void DX11Device::FinishShaderCompile(ShaderCompileD3D11* compile)
+{
+	D3D11Shader* shader = compile->shader;
+
+	if (shader != nullptr)
+	{
+		shader->compilePending = false;
+
+		if (FAILED(compile->vsResult))
+		{
+			LOG_DX_ERROR("Failed compiling vertex shader", compile->vsResult);
+		}
+		else if (FAILED(compile->psResult))
+		{
+			LOG_DX_ERROR("Failed compiling pixel shader", compile->psResult);
+		}
+		else
+		{
+			HR(pDevice->CreateVertexShader(compile->pVSBlob->GetBufferPointer(), compile->pVSBlob->GetBufferSize(), nullptr, &shader->pVertexShader));
+			HR(pDevice->CreatePixelShader(compile->pPSBlob->GetBufferPointer(), compile->pPSBlob->GetBufferSize(), nullptr, &shader->pPixelShader));
+
+			// the shader may have been set while it was compiling
+			if (curShader == shader)
+			{
+				SetShader(shader);
+			}
+		}
+	}
+
+	if (compile->pVSBlob) compile->pVSBlob->Release();
+	if (compile->pPSBlob) compile->pPSBlob->Release();
+
+	delete compile;
+}
+
+void DX11Device::StartCompileThreads()
+{
+	// leave a core for the thread submitting frames
+	uint32 threadCount = std::thread::hardware_concurrency();
+	threadCount = (threadCount > 1) ? threadCount - 1 : 1;
+
+	stopCompileThreads = false;
+
+	for (uint32 t = 0; t < threadCount; t++)
+	{
+		compileThreads.emplace_back(&DX11Device::CompileThreadMain, this);
+	}
+
+	LOG("Compiling shaders on %u threads", threadCount);
+}
+
+void DX11Device::StopCompileThreads()
+{
+	{
+		std::lock_guard<std::mutex> lock(compileMutex);
+		stopCompileThreads = true;
+		compileQueue.clear();
+	}
+
+	compileCondition.notify_all();
+
+	for (std::thread &thread : compileThreads)
+	{
+		thread.join();
+	}
+
+	compileThreads.clear();
+
+	// every worker has stopped, unfinished compiles are dropped
+	for (ShaderCompileD3D11* compile : shaderCompiles)
+	{
+		compile->shader = nullptr;
+		FinishShaderCompile(compile);
+	}
+
+	shaderCompiles.clear();
+}
+
+void DX11Device::CompileThreadMain()
+{
+	for (;;)
+	{
+		ShaderCompileD3D11* compile;
+
+		{
+			std::unique_lock<std::mutex> lock(compileMutex);
+			compileCondition.wait(lock, [this] { return stopCompileThreads || !compileQueue.empty(); });
+
+			if (stopCompileThreads)
+				return;
+
+			compile = compileQueue.front();
+			compileQueue.pop_front();
+		}
+
+		RunShaderCompile(compile);
+	}
+}
+
+void DX11Device::RunShaderCompile(ShaderCompileD3D11* compile)
+{
+	compile->vsResult = CompileShaderSource(compile->fileName, compile->source, "VS", "vs_4_0", &compile->pVSBlob);
+
+	if (SUCCEEDED(compile->vsResult))
+	{
+		compile->psResult = CompileShaderSource(compile->fileName, compile->source, "PS", "ps_4_0", &compile->pPSBlob);
+	}
+
+	compile->complete = true;
+}
+
+void DX11Device::FinishQueuedShaderCompile(D3D11Shader* shader)
+{
+	for (uint32 c = 0; c < shaderCompiles.size(); c++)
+	{
+		ShaderCompileD3D11* compile = shaderCompiles[c];
+
+		if (compile->shader != shader)
+			continue;
+
+		// a compile no worker has picked up yet is taken off the queue and compiled here instead of waiting for it
+		bool queued = false;
+
+		{
+			std::lock_guard<std::mutex> lock(compileMutex);
+
+			auto queuedCompile = std::find(compileQueue.begin(), compileQueue.end(), compile);
+
+			if (queuedCompile != compileQueue.end())
+			{
+				compileQueue.erase(queuedCompile);
+				queued = true;
+			}
+		}
+
+		if (queued)
+		{
+			RunShaderCompile(compile);
+		}
+
+		while (!compile->complete)
+		{
+			std::this_thread::yield();
+		}
+
+		FinishShaderCompile(compile);
+
+		shaderCompiles[c] = shaderCompiles.back();
+		shaderCompiles.pop_back();
+		return;
+	}
+}
+
+void DX11Device::ProcessTextureUploads()
+{
+	uint32 budget = textureUploadBudget;
+
+	while (!textureUploads.empty() && budget > 0)
+	{
+		TextureUploadD3D11 &upload = textureUploads.front();
+		D3D11Texture* texture = upload.texture;
+
+		uint32 layer = upload.nextRow / texture->height;
+		uint32 y = upload.nextRow % texture->height;
+
+		// a chunk is whole rows of one layer, a budget smaller than a row still copies one row a frame
+		uint32 rows = glm::min(budget / upload.rowBytes, texture->height - y);
+
+		if (rows == 0)
+		{
+			if (budget != textureUploadBudget)
+				break;
+
+			rows = 1;
+		}
+
+		D3D11_BOX box;
+		box.left = 0;
+		box.right = texture->width;
+		box.top = y;
+		box.bottom = y + rows;
+		box.front = 0;
+		box.back = 1;
+
+		uint32 bytes = rows * upload.rowBytes;
+		uint32 subresource = D3D11CalcSubresource(0, layer, texture->mipLevels);
+
+		// the runtime copies the chunk in to its own staging memory, so only the chunk is paid for this frame
+		pDeviceContext->UpdateSubresource(texture->pTexture, subresource, &box, &upload.data[upload.nextRow * upload.rowBytes], upload.rowBytes, bytes);
+
+		upload.nextRow += rows;
+		budget -= glm::min(budget, bytes);
+
+		if (upload.nextRow == texture->height * texture->arraySize)
+		{
+			if (texture->mipMaps)
+			{
+				pDeviceContext->GenerateMips(texture->pTexResourceView);
+			}
+
+			texture->uploadPending = false;
+			textureUploads.pop_front();
+		}
+	}
+}
+
+void DX11Device::CompleteReadbacks(bool waitForOldest)
+{
+	while (pendingReadbacks > 0)
+	{
+		uint32 oldest = (nextReadback + DX11_READBACK_BUFFER_COUNT - pendingReadbacks) % DX11_READBACK_BUFFER_COUNT;
+		ReadbackD3D11 &readback = readbacks[oldest];
+
+		D3D11_MAPPED_SUBRESOURCE mapped;
+		HRESULT result = pDeviceContext->Map(readback.pStagingTexture, 0, D3D11_MAP_READ, waitForOldest ? 0 : D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+
+		if (result == DXGI_ERROR_WAS_STILL_DRAWING)
+			return;
+
+		waitForOldest = false;
+
+		// the slot is free before the callback is made, so the callback can request another readback
+		ReadbackCallback callback = std::move(readback.callback);
+		readback.callback = nullptr;
+		pendingReadbacks--;
+
+		if (FAILED(result))
+		{
+			LOG_DX_ERROR("Failed mapping readback texture", result);
+			continue;
+		}
+
+		// mapped rows may be padded, they are packed so every device returns rows with no padding
+		uint32 rowBytes = readback.width * 4;
+		readbackScratch.resize(rowBytes * readback.height);
+
+		const uint8* pixels = static_cast<const uint8*>(mapped.pData);
+
+		for (uint32 y = 0; y < readback.height; y++)
+		{
+			memcpy(&readbackScratch[y * rowBytes], pixels + y * mapped.RowPitch, rowBytes);
+		}
+
+		pDeviceContext->Unmap(readback.pStagingTexture, 0);
+
+		ReadbackData data;
+		data.pixels = readbackScratch.data();
+		data.width = readback.width;
+		data.height = readback.height;
+
+		callback(data);
+	}
+}
+
+void DX11Device::AdvanceFrame()
+{
+	pDeviceContext->End(frameQueries[frameSlot]);
+	framePending[frameSlot] = true;
+
+	frameSlot = (frameSlot + 1) % framesInFlight;
+
+	// the next frame reuses the slot recorded framesInFlight frames ago, only wait if the GPU is still executing it
+	WaitForFrameSlot(frameSlot);
+}
+
+void DX11Device::WaitForFrameSlot(uint32 slot)
+{
+	if (!framePending[slot])
+		return;
+
+	// GetData without D3D11_ASYNC_GETDATA_DONOTFLUSH submits the queued commands, so the query is always reached
+	HRESULT result;
+
+	while ((result = pDeviceContext->GetData(frameQueries[slot], nullptr, 0, 0)) == S_FALSE)
+	{
+		std::this_thread::yield();
+	}
+
+	if (FAILED(result))
+	{
+		LOG_DX_ERROR("Failed waiting on frame query", result);
+	}
+
+	framePending[slot] = false;
+}
+
+void DX11Device::ApplyFrameLatency()
+{
+	IDXGIDevice1* pDXGIDevice1 = nullptr;
+
+	if (FAILED(pDevice->QueryInterface(__uuidof(IDXGIDevice1), reinterpret_cast<void**>(&pDXGIDevice1))))
+	{
+		LOG_WARNING("IDXGIDevice1 is not available, frame latency is left to the driver");
+		return;
+	}
+
+	HR(pDXGIDevice1->SetMaximumFrameLatency(framesInFlight));
+	pDXGIDevice1->Release();
+}
+
+void DX11Device::DeleteTextureObjects(D3D11Texture* texture)
+{
+	texture->pTexture->Release();
+	texture->pTexResourceView->Release();
+	texture->pSampler->Release();
+}
+
 CachedInputLayout* DX11Device::GetInputLayout(VertexAttributes vertexAttributeFlags)
 {
 	DS_ASSERT(vertexAttributeFlags != VertexAttributes::None);	// must have at least 1 vertex attribute
@@ -837,19 +2137,33 @@ CachedInputLayout* DX11Device::GetInputLayout(VertexAttributes vertexAttributeFl
 	}
 
 	// add each flagged vertex attribute to layout list
+	// per instance attributes are read from a second input slot, attributes wider than 4 components
+	// are split in to one element per 4 components with increasing semantic indices
 	uint32 stride = 0;
+	uint32 instanceStride = 0;
 	std::vector<D3D11_INPUT_ELEMENT_DESC> layout;
 
 	for (uint32 mask = ToIntegral(vertexAttributeFlags); mask; mask &= mask - 1)
 	{
 		uint32 index = Bit::LeastSignifcantBit(mask);
 		const AttributeProperties &properties = attributeProperties[index];
-		uint32 typeIndex = static_cast<uint32>(properties.type);
+		uint32 slotComponents = properties.components / properties.slotCount;
 
-		DXGI_FORMAT format = GetDXGIFormat(properties.type, properties.components, properties.normalized);
-		layout.push_back({ D3D11InputElementName[index], 0, format, 0, stride, D3D11_INPUT_PER_VERTEX_DATA, 0 });
+		DXGI_FORMAT format = GetDXGIFormat(properties.type, slotComponents, properties.normalized);
 
-		stride += properties.components * properties.typeSizeBytes;
+		for (uint32 slot = 0; slot < properties.slotCount; slot++)
+		{
+			if (properties.perInstance)
+			{
+				layout.push_back({ D3D11InputElementName[index], slot, format, 1, instanceStride, D3D11_INPUT_PER_INSTANCE_DATA, 1 });
+				instanceStride += properties.sizeBytes / properties.slotCount;
+			}
+			else
+			{
+				layout.push_back({ D3D11InputElementName[index], slot, format, 0, stride, D3D11_INPUT_PER_VERTEX_DATA, 0 });
+				stride += properties.sizeBytes / properties.slotCount;
+			}
+		}
 	}
 
 	// get dummy shader for given input layout
@@ -872,7 +2186,7 @@ CachedInputLayout* DX11Device::GetInputLayout(VertexAttributes vertexAttributeFl
 		LOG_DX_ERROR("Failed creating input layout", result);
 	}
 
-	CachedInputLayout* newLayout = new CachedInputLayout(pVertexLayout, stride);
+	CachedInputLayout* newLayout = new CachedInputLayout(pVertexLayout, vertexAttributeFlags, stride, instanceStride);
 	inputLayouts[ToIntegral(vertexAttributeFlags)] = newLayout;
 
 	return newLayout;
@@ -882,7 +2196,8 @@ HRESULT DX11Device::GetDummyLayoutShader(VertexAttributes vertexAttributeFlags,
 {
 	std::string dummySource ="struct VS_INPUT {";
 
-	if (CheckFlags(vertexAttributeFlags, VertexAttributes::Position))
+	if (CheckFlags(vertexAttributeFlags, VertexAttributes::Position) ||
+		CheckFlags(vertexAttributeFlags, VertexAttributes::PositionHalf))
 	{
 		dummySource += "float4 Pos : POSITION;";
 	}
@@ -892,7 +2207,9 @@ HRESULT DX11Device::GetDummyLayoutShader(VertexAttributes vertexAttributeFlags,
 		dummySource += "float2 Pos : POSITION;";
 	}
 
-	if (CheckFlags(vertexAttributeFlags, VertexAttributes::TexCoord))
+	if (CheckFlags(vertexAttributeFlags, VertexAttributes::TexCoord) ||
+		CheckFlags(vertexAttributeFlags, VertexAttributes::TexCoordHalf) ||
+		CheckFlags(vertexAttributeFlags, VertexAttributes::TexCoordUNorm16))
 	{
 		dummySource += "float2 Tex : TEXCOORD0;";
 	}
@@ -902,6 +2219,29 @@ HRESULT DX11Device::GetDummyLayoutShader(VertexAttributes vertexAttributeFlags,
 		dummySource += "float4 Col : COLOR0;";
 	}
 
+	if (CheckFlags(vertexAttributeFlags, VertexAttributes::Normal) ||
+		CheckFlags(vertexAttributeFlags, VertexAttributes::NormalSNorm16) ||
+		CheckFlags(vertexAttributeFlags, VertexAttributes::NormalPacked))
+	{
+		dummySource += "float4 Norm : NORMAL;";
+	}
+
+	if (CheckFlags(vertexAttributeFlags, VertexAttributes::InstanceWorld))
+	{
+		dummySource += "float4 World0 : INSTANCE_WORLD0; float4 World1 : INSTANCE_WORLD1;";
+		dummySource += "float4 World2 : INSTANCE_WORLD2; float4 World3 : INSTANCE_WORLD3;";
+	}
+
+	if (CheckFlags(vertexAttributeFlags, VertexAttributes::InstanceColor32))
+	{
+		dummySource += "float4 InstCol : INSTANCE_COLOR;";
+	}
+
+	if (CheckFlags(vertexAttributeFlags, VertexAttributes::InstanceMaterial))
+	{
+		dummySource += "float InstMat : INSTANCE_MATERIAL;";
+	}
+
 	dummySource += "};";
 
 	dummySource += "struct PS_INPUT { float4 Pos : SV_POSITION; };";
@@ -3,20 +3,34 @@
 
 #include "IGraphicsDevice.h"
 #include "DX11Definitions.h"
+#include "ShaderPreprocessor.h"
+#include "utility/StateCache.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 struct CachedInputLayout
 {
-	CachedInputLayout(ID3D11InputLayout* layout, uint32 strideSize)
+	CachedInputLayout(ID3D11InputLayout* layout, VertexAttributes attributes, uint32 strideSize, uint32 instanceStrideSize)
 	{
 		inputLayout = layout;
+		attributeFlags = attributes;
 		stride = strideSize;
+		instanceStride = instanceStrideSize;
 	}
 
 	ID3D11InputLayout* inputLayout = nullptr;
+	VertexAttributes attributeFlags = VertexAttributes::None;
+
+	// per vertex attributes are read from input slot 0, per instance attributes from slot 1
 	uint32 stride = 0;
+	uint32 instanceStride = 0;
 };
 
 class D3D11Shader : public Shader
@@ -25,6 +39,13 @@ public:
 
 	ID3D11VertexShader*	pVertexShader = nullptr;
 	ID3D11PixelShader*	pPixelShader = nullptr;
+
+	// set while the shader created by CreateShaderAsync is compiling on a worker thread
+	bool compilePending = false;
+
+	// shaders created through CreateShader are shared by every request for the same variant
+	std::string variantName;
+	uint32 refCount = 0;
 };
 
 struct D3D11Buffer
@@ -44,12 +65,13 @@ class D3D11Mesh : public Mesh
 public:
 
 	D3D11Mesh(DX11Buffer* vertexBuffer, DX11Buffer* indexBuffer,
-			  uint32 vertexCount, uint32 indexCount,
+			  uint32 vertexCount, uint32 indexCount, IndexFormat indexFormat,
 			  CachedInputLayout* pInputLayout) :
 		vertexBuffer(vertexBuffer),
 		indexBuffer(indexBuffer),
 		vertexCount(vertexCount),
 		indexCount(indexCount),
+		indexFormat(indexFormat),
 		pInputLayout(pInputLayout)
 	{}
 
@@ -57,6 +79,7 @@ public:
 	DX11Buffer* indexBuffer;
 	uint32 vertexCount = 0;
 	uint32 indexCount = 0;
+	IndexFormat indexFormat = IndexFormat::UInt16;
 	CachedInputLayout* pInputLayout = nullptr;
 
 	uint32 offset = 0;
@@ -69,6 +92,77 @@ public:
 	ID3D11ShaderResourceView* pTexResourceView = nullptr;
 	ID3D11Texture2D* pTexture = nullptr;
 	ID3D11SamplerState* pSampler = nullptr;
+
+	// kept so single layers of an array can be updated
+	uint32 width = 0;
+	uint32 height = 0;
+	uint32 arraySize = 1;
+	uint32 mipLevels = 1;
+	bool mipMaps = false;
+
+	// set while the data of a texture created with CreateTextureAsync is still being streamed
+	bool uploadPending = false;
+};
+
+// texels of a texture created with CreateTextureAsync, copied in to the texture a chunk of rows at a time
+struct TextureUploadD3D11
+{
+	D3D11Texture* texture;
+
+	// the rows of every layer one after another
+	std::vector<uint8> data;
+	uint32 rowBytes;
+	uint32 nextRow;
+};
+
+// a shader created with CreateShaderAsync, compiled to bytecode by a worker thread and created on the device in Present
+struct ShaderCompileD3D11
+{
+	// null once the shader has been released, the compile can't be stopped so its results are thrown away
+	D3D11Shader* shader = nullptr;
+
+	// preprocessed on the main thread, the worker only compiles
+	std::string fileName;
+	std::string source;
+
+	// written by the worker, only read once complete is set
+	ID3DBlob* pVSBlob = nullptr;
+	ID3DBlob* pPSBlob = nullptr;
+	HRESULT vsResult = S_OK;
+	HRESULT psResult = S_OK;
+
+	std::atomic<bool> complete { false };
+};
+
+// staging texture a readback is copied in to, the pixels are read out once it can be mapped without waiting
+struct ReadbackD3D11
+{
+	ID3D11Texture2D* pStagingTexture = nullptr;
+
+	uint32 width = 0;
+	uint32 height = 0;
+	ReadbackCallback callback;
+};
+
+class D3D11RenderTarget : public RenderTarget
+{
+public:
+
+	D3D11RenderTarget(const RenderTargetDesc &desc) :
+		RenderTarget(desc)
+	{
+		if (desc.sampleCount <= 1)
+		{
+			texture = &sampleTexture;
+		}
+	}
+
+	// only one of the views is created, depending on whether the format is a depth format
+	ID3D11RenderTargetView* pRenderTargetView = nullptr;
+	ID3D11DepthStencilView* pDepthStencilView = nullptr;
+
+	// owns the D3D texture, the resource view and sampler are only created for single sampled targets
+	D3D11Texture sampleTexture;
 };
 
 class D3D11UniformBuffer : public UniformBuffer
@@ -96,6 +190,12 @@ public:
 
 	void SetVSync(bool enabled);
 
+	void SetFramesInFlight(uint32 count);
+
+	uint32 GetFramesInFlight() { return framesInFlight; }
+
+	uint32 GetFrameSlot() { return frameSlot; }
+
 	void SetShader(Shader* shader);
 
 	void SetTexture(Texture* texture, uint32 slot);
@@ -107,7 +207,10 @@ public:
 	void OnResolutionChanged(uint32 width, uint32 height);
 
 	void DrawMesh(Mesh* mesh);
-	void DrawMeshIndexed(Mesh* mesh, uint32 elementCount = 0, uint32 vertexOffset = 0, uint16 indexOffset = 0);
+	void DrawMeshIndexed(Mesh* mesh, uint32 elementCount = 0, uint32 vertexOffset = 0, uint32 indexOffset = 0);
+
+	void DrawMeshIndexedInstanced(Mesh* mesh, Buffer* instanceBuffer, VertexAttributes instanceAttributeFlags, uint32 instanceCount,
+								  uint32 firstInstance = 0, uint32 elementCount = 0, uint32 vertexOffset = 0, uint32 indexOffset = 0);
 
 	Mesh* CreateMesh(const MeshData &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage);
 	Mesh* CreateMesh(const MeshDataList &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage);
@@ -117,14 +220,33 @@ public:
 
 	void ReleaseMesh(Mesh* mesh);
 
-	Shader* CreateShader(const std::string &name);
+	// Mesh Arenas
+	void SetMeshArenasEnabled(bool enabled);
+	void DefragmentMeshArenas();
+	MeshArenaStats GetMeshArenaStats();
+
+	Shader* CreateShader(const std::string &name, ShaderFeatures features = ShaderFeatures::None);
 	void ReleaseShader(Shader* shader);
 
+	Shader* CreateShaderAsync(const std::string &name, ShaderFeatures features = ShaderFeatures::None);
+
+	bool IsShaderReady(Shader* shader);
+
 	Texture* CreateTexture(uint8 *data, const TextureSettings &settings);
 	void ReleaseTexture(Texture* pTexture);
+	void UpdateTextureLayer(Texture* texture, uint32 layer, const uint8* data);
+
+	Texture* CreateTextureAsync(const uint8* data, const TextureSettings &settings);
+
+	bool IsTextureReady(Texture* texture);
+
+	void SetTextureUploadBudget(uint32 bytesPerFrame);
 
 	// Uniform Buffer Resource Handling
 	void SetUniformBuffer(uint32 slot, Buffer* buffer, ShaderStage stage) ;
+	void SetUniformBufferRange(uint32 slot, Buffer* buffer, uint32 offset, uint32 size, ShaderStage stage);
+
+	uint32 GetUniformBufferAlignment();
 
 	// Buffer Resource Handling
 	DX11Buffer* CreateBuffer(const void* data, uint32 size, BufferTarget target, BufferUsage usage);
@@ -133,8 +255,42 @@ public:
 	void UpdateBuffer(Buffer* buffer, const void* data, uint32 size);
 	void UpdateBuffer(Buffer* buffer, const std::vector<BufferData> &data, uint32 dataCount, uint32 bufferSize);
 
+	void UpdateBufferRegion(Buffer* buffer, const void* data, uint32 offset, uint32 size);
+
 	void ReleaseBuffer(Buffer* buffer);
 
+	// Handle Resources
+	MeshHandle CreateMeshHandle(const MeshData &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage);
+	void UpdateMesh(MeshHandle mesh, const MeshData &meshData);
+	void DrawMeshIndexed(MeshHandle mesh, uint32 elementCount = 0, uint32 vertexOffset = 0, uint32 indexOffset = 0);
+	void ReleaseMesh(MeshHandle mesh);
+
+	ShaderHandle CreateShaderHandle(const std::string &name);
+	void SetShader(ShaderHandle shader);
+	void ReleaseShader(ShaderHandle shader);
+
+	TextureHandle CreateTextureHandle(uint8 *data, const TextureSettings &settings);
+	void SetTexture(TextureHandle texture, uint32 slot);
+	void ReleaseTexture(TextureHandle texture);
+
+	BufferHandle CreateBufferHandle(const void* data, uint32 size, BufferTarget target, BufferUsage usage);
+	void UpdateBuffer(BufferHandle buffer, const void* data, uint32 size);
+	void UpdateBufferRegion(BufferHandle buffer, const void* data, uint32 offset, uint32 size);
+	void SetUniformBuffer(uint32 slot, BufferHandle buffer, ShaderStage stage);
+	void ReleaseBuffer(BufferHandle buffer);
+
+	// Render Targets
+	RenderTarget* CreateRenderTarget(const RenderTargetDesc &desc);
+	void ReleaseRenderTarget(RenderTarget* target);
+
+	void SetRenderTargets(uint32 numColorTargets, RenderTarget* const* pColorTargets, RenderTarget* depthTarget);
+
+	void ClearRenderTarget(RenderTarget* target, const vec4 &color, float depth = 1.0f, uint8 stencil = 0);
+
+	void ResolveRenderTarget(RenderTarget* source, RenderTarget* destination);
+
+	void RequestReadback(RenderTarget* target, ReadbackCallback callback);
+
 	// Scissor
 	void SetScissorRects(uint32 numRects, const DSRect* pRects);
 
@@ -152,15 +308,65 @@ public:
 
 	void SetDepthStencilState(DepthStencilState* state);
 
+	// Rasterizer State
+	RasterizerState* CreateRasterizerState(const RasterizerStateDesc &desc);
+
+	void SetRasterizerState(RasterizerState* state);
+
 private:
 
 	bool CreateDepthStencil(uint32 width, uint32 height);
 
-	// helper method for compiling shaders
-	HRESULT CompileShaderFromFile(const std::wstring &fileName, LPCSTR szEntryPoint, LPCSTR szShaderModel, ID3DBlob** ppBlobOut);
+	// helper method for compiling shaders, source has already been through the preprocessor. fileName is only used in errors
+	HRESULT CompileShaderSource(const std::string &fileName, const std::string &source, LPCSTR szEntryPoint, LPCSTR szShaderModel, ID3DBlob** ppBlobOut);
+
+	// compiles a variant outside of the variant cache, used by shader handles which own their shader
+	D3D11Shader* CompileShader(const std::string &name, ShaderFeatures features);
 
 	CachedInputLayout* GetInputLayout(VertexAttributes vertexAttributeFlags);
 
+	// release the D3D objects owned by a resource, the resource itself is deleted or removed from its container by the caller
+	void DeleteMeshObjects(D3D11Mesh* mesh);
+	void DeleteShaderObjects(D3D11Shader* shader);
+	void DeleteTextureObjects(D3D11Texture* texture);
+
+	// binds the targets selected with SetRenderTargets, or the back buffer when there are none
+	void BindRenderTargets();
+
+	// Shader Compilation
+	// creates the shaders of every finished compile, a compile that failed leaves its shader never ready
+	void ProcessShaderCompiles();
+	void FinishShaderCompile(ShaderCompileD3D11* compile);
+
+	// finishes a shader queued by CreateShaderAsync, waiting on its worker or compiling it here if none has started it
+	void FinishQueuedShaderCompile(D3D11Shader* shader);
+
+	// the workers are started with the first asynchronous shader and run until the device is destroyed
+	void StartCompileThreads();
+	void StopCompileThreads();
+	void CompileThreadMain();
+
+	// compiles both stages of a queued shader, run by the workers and by FinishQueuedShaderCompile
+	void RunShaderCompile(ShaderCompileD3D11* compile);
+
+	// draws are skipped while the shader set through SetShader is compiling or failed to compile
+	bool IsCurrentShaderReady() const { return curShader == nullptr || (curShader->pVertexShader && curShader->pPixelShader); }
+
+	// copies up to the upload budget of pending texture data in to the textures
+	void ProcessTextureUploads();
+
+	// calls back every readback whose copy has finished, oldest first. waitForOldest blocks until the oldest is done
+	void CompleteReadbacks(bool waitForOldest);
+
+	// ends the event query of the frame just submitted and waits for the GPU to finish the last frame that used the next slot
+	void AdvanceFrame();
+
+	// blocks until the event query of the slot has been signalled
+	void WaitForFrameSlot(uint32 slot);
+
+	// limits how many frames DXGI queues ahead of the display to the frames in flight
+	void ApplyFrameLatency();
+
 	HRESULT GetDummyLayoutShader(VertexAttributes vertexAttributeFlags, LPCSTR szEntryPoint, LPCSTR szShaderModel, ID3DBlob** ppBlobOut);
 
 	// helper function to create and reisze buffers
@@ -201,6 +407,49 @@ private:
 	// map of cached input layouts
 	std::map<int32, CachedInputLayout*> inputLayouts;
 
+	// resources created through handles
+	ResourceContainer<D3D11Mesh, MeshHandle> meshes;
+	ResourceContainer<D3D11Shader, ShaderHandle> shaders;
+	ResourceContainer<D3D11Texture, TextureHandle> textures;
+	ResourceContainer<DX11Buffer, BufferHandle> buffers;
+
+	// D3DCompile runs on the CPU, so asynchronous shaders are compiled by a pool of workers
+	std::vector<ShaderCompileD3D11*> shaderCompiles;
+	std::deque<ShaderCompileD3D11*> compileQueue;
+	std::vector<std::thread> compileThreads;
+	std::mutex compileMutex;
+	std::condition_variable compileCondition;
+	bool stopCompileThreads = false;
+
+	// shader set with SetShader, draws are skipped while it is compiling
+	D3D11Shader* curShader = nullptr;
+
+	// resolves includes and feature defines, variants created through CreateShader by variant name
+	ShaderPreprocessor shaderPreprocessor;
+	std::unordered_map<std::string, D3D11Shader*> shaderVariants;
+
+	// textures created with CreateTextureAsync waiting on their data, completed in order
+	std::deque<TextureUploadD3D11> textureUploads;
+	uint32 textureUploadBudget = DS_DEFAULT_TEXTURE_UPLOAD_BUDGET;
+
+	// ring of readbacks, pendingReadbacks are in flight and end at nextReadback
+	ReadbackD3D11 readbacks[DX11_READBACK_BUFFER_COUNT];
+	uint32 nextReadback = 0;
+	uint32 pendingReadbacks = 0;
+
+	// an event query per frame slot, ended after the last command of the frame recorded in to it.
+	// framePending is set while the GPU may still be executing that frame
+	ID3D11Query* frameQueries[DS_MAX_FRAMES_IN_FLIGHT] = {};
+	bool framePending[DS_MAX_FRAMES_IN_FLIGHT] = {};
+	uint32 framesInFlight = DS_MAX_FRAMES_IN_FLIGHT;
+	uint32 frameSlot = 0;
+
+	// rows of a readback without the padding of the mapped texture
+	std::vector<uint8> readbackScratch;
+
+	// holds 32 bit indices narrowed to 16 bit while they are uploaded
+	std::vector<uint16> indexScratch;
+
 	RenderInfo renderInfo;
 
 	// handles to window
@@ -208,18 +457,30 @@ private:
 	HWND windowHandle;
 
 	// States
-	DepthStencilStateD3D11* defaultDepthStencilState;
-	DepthStencilStateD3D11* curDepthStencilState;
+	DepthStencilStateD3D11* defaultDepthStencilState = nullptr;
+	DepthStencilStateD3D11* curDepthStencilState = nullptr;
+	DX11BlendState* curBlendState = nullptr;
+	RasterizerStateD3D11* defaultRasterizerState = nullptr;
+	RasterizerStateD3D11* curRasterizerState = nullptr;
+
+	// every state object created is kept here, identical descriptors share one object
+	StateCache<BlendProperties, DX11BlendState> blendStates;
+	StateCache<DepthStencilStateDesc, DepthStencilStateD3D11> depthStencilStates;
+	StateCache<RasterizerStateDesc, RasterizerStateD3D11> rasterizerStates;
 
 	// pointers to DirectX objects 
 	ID3D11Device*           pDevice			  = nullptr;
 	ID3D11DeviceContext*	pDeviceContext	  = nullptr;
+	ID3D11DeviceContext1*	pDeviceContext1	  = nullptr;
 	IDXGISwapChain*         pSwapChain		  = nullptr;
 	ID3D11RenderTargetView* pRenderTargetView = nullptr;
 	ID3D11Texture2D*		pDepthStencil	  = nullptr;
 	ID3D11DepthStencilView* pDepthStencilView = nullptr;
 
-	ID3D11RasterizerState*	 pRasterizerState	= nullptr;
+	// offscreen targets selected with SetRenderTargets, the back buffer is used when there are none
+	D3D11RenderTarget* curColorTargets[DS_MAX_RENDER_TARGETS] = {};
+	uint32 numCurColorTargets = 0;
+	D3D11RenderTarget* curDepthTarget = nullptr;
 
 	// DirectX state
 	uint32 syncInterval = 1;
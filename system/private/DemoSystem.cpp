@@ -2,8 +2,12 @@
 #include "IGraphicsDevice.h"
 
 #include "Demo.h"
+#if defined(_WIN32)
 #include "DX11Device.h"
+#endif
 #include "GL3Device.h"
+#include "NullDevice.h"
+#include "SoftwareDevice.h"
 
 #include "UIManager.h"
 
@@ -11,7 +15,10 @@
 #include "stb_image.h"
 
 //#include <SOIL.h>
-#include <glm\gtc\matrix_transform.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// room for 4096 draws with 256 bytes of uniforms each per frame
+#define UNIFORM_ALLOCATOR_CAPACITY (1024 * 1024)
 
 DemoSystem::DemoSystem()
 {
@@ -29,9 +36,14 @@ DemoSystem::~DemoSystem()
 
 void DemoSystem::Initialize()
 {
-	// initialize all SDL subsystems
+	// initialize all SDL subsystems, machines without a display only get events and can only run headless
 	if (SDL_Init(SDL_INIT_EVERYTHING) < 0)
-		return;
+	{
+		LOG_WARNING("Failed initializing SDL, only headless rendering is available : %s", SDL_GetError());
+
+		if (SDL_Init(SDL_INIT_EVENTS | SDL_INIT_TIMER) < 0)
+			return;
+	}
 
 	SDL_GetDesktopDisplayMode(0, &displayMode);
 
@@ -48,6 +60,8 @@ void DemoSystem::Initialize()
 
 	Time::Start();
 	UIManager::Initialize(this);
+
+	jobs.Initialize();
 }
 
 void DemoSystem::Update()
@@ -90,7 +104,13 @@ void DemoSystem::Update()
 	perFrameUniform.viewProjection = viewProjection;
 	perFrameUniform.uiOrthoProjection = glm::ortho(0.0f, resX, resY, 0.0f);
 
-	curGraphicsDevice->UpdateBuffer(perFrameBuffer, &perFrameUniform, sizeof(PerFrameUniforms));
+	if (curGraphicsDevice != nullptr)
+	{
+		curGraphicsDevice->UpdateBuffer(perFrameBuffer, &perFrameUniform, sizeof(PerFrameUniforms));
+	}
+
+	// slices from the last frame have been drawn
+	uniformAllocator.Reset();
 
 	if (curDemo != nullptr)
 	{
@@ -98,8 +118,20 @@ void DemoSystem::Update()
 
 		if (curGraphicsDevice != nullptr)
 		{
-			// do demo rendering
-			curDemo->Draw(curGraphicsDevice);
+			// upload the buffer writes and uniforms made during Update
+			bufferUpdates.Submit(curGraphicsDevice);
+			bufferUpdates.Reset();
+			uniformAllocator.Flush(curGraphicsDevice);
+
+			// do demo rendering, the graph culls and orders the demos passes and places its targets
+			renderGraph.Reset();
+
+			RenderGraphResource backBuffer = renderGraph.ImportBackBuffer(curDisplaySettings.width, curDisplaySettings.height);
+			curDemo->BuildRenderGraph(renderGraph, backBuffer);
+
+			// items pushed by a pass are drawn before the next pass binds its targets
+			renderGraph.Compile();
+			renderGraph.Execute(curGraphicsDevice, renderTargetPool, [this](IGraphicsDevice* device) { SubmitPass(device); });
 
 			// Draw default demo system UI, must be done after demo Update, in case the demo changes the rendering API
 			DrawBaseUI();
@@ -107,6 +139,17 @@ void DemoSystem::Update()
 	}
 }
 
+void DemoSystem::SubmitPass(IGraphicsDevice* device)
+{
+	bufferUpdates.Submit(device);
+	bufferUpdates.Reset();
+	uniformAllocator.Flush(device);
+
+	// items pushed by the pass are sorted and drawn in one go, in to the targets of the pass
+	renderQueue.Submit(device);
+	renderQueue.Reset();
+}
+
 void DemoSystem::DrawBaseUI()
 {
 	UIManager::StartFrame();
@@ -129,6 +172,8 @@ void DemoSystem::Destroy()
 	}
 
 	UIManager::Destroy();
+
+	jobs.Destroy();
 }
 
 void DemoSystem::SetDemo(Demo* newDemo)
@@ -167,28 +212,67 @@ void DemoSystem::SetGraphicsAPI(GraphicsAPIOptions api)
 	// create and initialize the given API choice
 	switch (curAPIOption)
 	{
+#if defined(_WIN32)
 		case GraphicsAPIOptions::DirectX11:
 			curGraphicsDevice = new DX11Device();
 		break;
+#endif
 		case GraphicsAPIOptions::OpenGL3:
 			curGraphicsDevice = new GL3Device();
 		break;
+		case GraphicsAPIOptions::Null:
+			curGraphicsDevice = new NullDevice();
+		break;
+		case GraphicsAPIOptions::Software:
+			curGraphicsDevice = new SoftwareDevice();
+		break;
+		// DirectX is only built on Windows
+		default:
+			LOG_ERROR("Graphics API is not supported on this platform");
+		break;
+	}
+
+	if (curGraphicsDevice == nullptr)
+	{
+		curAPIOption = GraphicsAPIOptions::None;
+		return;
 	}
 
 	RenderInfo renderInfo;
 
 	renderInfo.resolutionX	= curDisplaySettings.width;
 	renderInfo.resolutionY	= curDisplaySettings.height;
-	renderInfo.wndPointer	= (void*)&sdlInfo.info.win.hdc;
+	renderInfo.headless		= curDisplaySettings.headless;
+	renderInfo.framesInFlight = curDisplaySettings.framesInFlight;
+
+#if defined(_WIN32)
+	if (sdlWindow != nullptr)
+	{
+		renderInfo.wndPointer = (void*)&sdlInfo.info.win.hdc;
+	}
+#endif
+
+	if (!curGraphicsDevice->Create(renderInfo))
+	{
+		LOG_ERROR("Failed creating %s device", curGraphicsDevice->GetAPIName().c_str());
+
+		delete curGraphicsDevice;
+		curGraphicsDevice = nullptr;
+		curAPIOption = GraphicsAPIOptions::None;
+		return;
+	}
 
-	curGraphicsDevice->Create(renderInfo);
 	curGraphicsDevice->Initialize();
 
 	curGraphicsDevice->SetVSync(curDisplaySettings.vsync);
 	curGraphicsDevice->SetClearColor(vec4(0.1f, 0.1f, 0.1f, 1.0f));
 
-	std::string windowTitle = curDisplaySettings.windowTitle + " - " + curGraphicsDevice->GetAPIName();
-	SDL_SetWindowTitle(sdlWindow, windowTitle.c_str());
+	// the null device may be used without ever creating a window
+	if (sdlWindow != nullptr)
+	{
+		std::string windowTitle = curDisplaySettings.windowTitle + " - " + curGraphicsDevice->GetAPIName();
+		SDL_SetWindowTitle(sdlWindow, windowTitle.c_str());
+	}
 
 	CreateResources();
 }
@@ -211,6 +295,8 @@ void DemoSystem::Present()
 	if (curGraphicsDevice == nullptr)
 		return;
 
+	renderTargetPool.EndFrame(curGraphicsDevice);
+
 	curGraphicsDevice->Present();
 }
 
@@ -218,6 +304,10 @@ void DemoSystem::MakeWindow(const DisplaySettings &newSettings)
 {
 	curDisplaySettings = newSettings;
 
+	// headless devices render offscreen, there is nothing to show
+	if (curDisplaySettings.headless)
+		return;
+
 	uint32 wndFlags = 0;
 	int32 wndX = 0;
 	int32 wndY = 0;
@@ -255,6 +345,11 @@ void DemoSystem::SetDisplaySettings(const DisplaySettings &newSettings)
 		curGraphicsDevice->SetVSync(newSettings.vsync);
 	}
 
+	if (curDisplaySettings.framesInFlight != newSettings.framesInFlight && curGraphicsDevice)
+	{
+		curGraphicsDevice->SetFramesInFlight(newSettings.framesInFlight);
+	}
+
 	if (curDisplaySettings.width != newSettings.width ||
 		curDisplaySettings.height != newSettings.height ||
 		curDisplaySettings.refreshRate != newSettings.refreshRate)
@@ -359,7 +454,7 @@ const char* DemoSystem::GetClipboardText()
 	return SDL_GetClipboardText();
 }
 
-Texture* DemoSystem::LoadTexture(std::string fileName)
+Texture* DemoSystem::LoadTexture(std::string fileName, bool async)
 {
 	// load image from file
 	int32 texWidth, texHeight, texDepth;
@@ -379,13 +474,99 @@ Texture* DemoSystem::LoadTexture(std::string fileName)
 	settings.filterMode = TextureFilterMode::Trilinear;
 	settings.mipMaps = true;
 
-	Texture* newTexture = curGraphicsDevice->CreateTexture(imageData, settings);
+	Texture* newTexture;
+
+	if (async)
+	{
+		newTexture = curGraphicsDevice->CreateTextureAsync(imageData, settings);
+	}
+	else
+	{
+		newTexture = curGraphicsDevice->CreateTexture(imageData, settings);
+	}
 
 	stbi_image_free(imageData);
 
 	return newTexture;
 }
 
+std::vector<Texture*> DemoSystem::LoadTextures(const std::vector<std::string> &fileNames, bool async)
+{
+	struct DecodedImage
+	{
+		uint8* imageData;
+		int32 width;
+		int32 height;
+	};
+
+	std::vector<DecodedImage> images(fileNames.size());
+
+	// decoding is the slow part and stb_image decodes on any thread, one image per job
+	jobs.ParallelFor(static_cast<uint32>(fileNames.size()), 1, [&](uint32 i)
+	{
+		int32 texDepth;
+		images[i].imageData = stbi_load(fileNames[i].c_str(), &images[i].width, &images[i].height, &texDepth, 4);
+	});
+
+	std::vector<Texture*> textures(fileNames.size(), nullptr);
+
+	for (size_t i = 0; i < fileNames.size(); i++)
+	{
+		// the failure reason of stb_image is shared by every thread, it would not belong to this image
+		if (images[i].imageData == nullptr)
+		{
+			LOG_ERROR("Could not load texture [%s]", fileNames[i].c_str());
+			continue;
+		}
+
+		TextureSettings settings;
+		settings.width = images[i].width;
+		settings.height = images[i].height;
+		settings.filterMode = TextureFilterMode::Trilinear;
+		settings.mipMaps = true;
+
+		if (async)
+		{
+			textures[i] = curGraphicsDevice->CreateTextureAsync(images[i].imageData, settings);
+		}
+		else
+		{
+			textures[i] = curGraphicsDevice->CreateTexture(images[i].imageData, settings);
+		}
+
+		stbi_image_free(images[i].imageData);
+	}
+
+	return textures;
+}
+
+uint32 DemoSystem::LoadMaterial(MaterialTable &table, std::string fileName)
+{
+	int32 texWidth, texHeight, texDepth;
+	uint8* imageData = stbi_load(fileName.c_str(), &texWidth, &texHeight, &texDepth, 4);
+
+	if (imageData == nullptr)
+	{
+		const char *result = stbi_failure_reason();
+		LOG_ERROR("Could not load material [%s] : %s", fileName.c_str(), result);
+		return DS_INVALID_MATERIAL;
+	}
+
+	// every layer of the array has the same size, images are not resized to fit
+	if (static_cast<uint32>(texWidth) != table.GetWidth() || static_cast<uint32>(texHeight) != table.GetHeight())
+	{
+		LOG_ERROR("Material [%s] is %ix%i, the material table is %ux%u", fileName.c_str(), texWidth, texHeight, table.GetWidth(), table.GetHeight());
+		stbi_image_free(imageData);
+		return DS_INVALID_MATERIAL;
+	}
+
+	uint32 materialID = table.AddMaterial(curGraphicsDevice, imageData);
+
+	stbi_image_free(imageData);
+
+	return materialID;
+}
+
 bool DemoSystem::IsRunning()
 {
 	return running;
@@ -405,6 +586,8 @@ void DemoSystem::CreateResources()
 												BufferTarget::Uniform, BufferUsage::Stream);
 	curGraphicsDevice->SetUniformBuffer(0, perFrameBuffer, ShaderStage::Vertex);
 
+	uniformAllocator.Create(curGraphicsDevice, UNIFORM_ALLOCATOR_CAPACITY);
+
 	// ================
 
 	// if we have an active demo tell it to recreate its graphics in the new API
@@ -419,6 +602,8 @@ void DemoSystem::ReleaseResources()
 	// Release resources created by the demo system
 	UIManager::ReleaseGraphics();
 	if (perFrameBuffer) { curGraphicsDevice->ReleaseBuffer(perFrameBuffer); perFrameBuffer = nullptr; }
+	uniformAllocator.Release(curGraphicsDevice);
+	renderTargetPool.Clear(curGraphicsDevice);
 
 	// tell any active demo to release its resources
 	if (curDemo != nullptr)
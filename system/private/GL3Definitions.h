@@ -1,8 +1,17 @@
 #ifndef _GL3_DEFINITIONS_H
 #define _GL3_DEFINITIONS_H
 
-#include <GL\glew.h>
-#include <GL\wglew.h>
+#include <GL/glew.h>
+
+#if defined(_WIN32)
+#include <GL/wglew.h>
+#endif
+
+// headless contexts are created through EGL, GLEW has to be built with GLEW_EGL to load through it
+#if defined(DS_GL3_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
 
 #include "DemoCommon.h"
 
@@ -17,9 +26,6 @@
 // maps ZPFaceCullMode to OpenGL equivalent
 //static const GLenum GL3CullModeMap[] = { GL_BACK, GL_FRONT, GL_BACK, GL_FRONT_AND_BACK }; // CULL_NONE is mapped to GL_BACK but it should never be actually used
 
-// maps ZPFillMode to OpenGL equivalent
-//static const GLenum GL3FillModeMap[] = { GL_FILL, GL_LINE, GL_POINT };
-
 // maps TextureWrapMode to OpenGL equivalent
 static const GLint GL3WrapMode[] = { GL_REPEAT, GL_CLAMP_TO_EDGE };
 
@@ -36,6 +42,19 @@ static const GLenum GL3TargetMap[] = { GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER,
 // maps BufferUsage to OpenGL equivalent
 static const GLenum GL3UsageMap[] = { GL_STATIC_DRAW, GL_DYNAMIC_DRAW, GL_STREAM_DRAW };
 
+// maps IndexFormat to OpenGL equivalent
+static const GLenum GL3IndexFormatMap[] = { GL_UNSIGNED_SHORT, GL_UNSIGNED_INT };
+
+// smallest per frame region allocated for a stream buffer, avoids growing small buffers every few frames
+#define GL3_STREAM_MIN_REGION_SIZE 4096
+
+// nanoseconds to wait on a frame fence before logging that the GPU is still busy and waiting again
+#define GL3_FRAME_FENCE_TIMEOUT 1000000000
+
+// vertices and indices a mesh arena is created with, an arena at least doubles when a mesh does not fit
+#define GL3_MESH_ARENA_VERTEX_COUNT 65536
+#define GL3_MESH_ARENA_INDEX_COUNT 196608
+
 class BufferGL3 : public Buffer
 {
 public:
@@ -54,10 +73,66 @@ public:
 
 	uint32 size;
 	BufferUsage usage;
+
+	// byte offset of the most recently written data, only stream buffers write at offsets other than 0
+	uint32 dataOffset = 0;
+
+	// Stream buffers
+	// the buffer is split in to regionCount regions of regionSize bytes, one per frame in flight, every write during
+	// a frame is placed after the last one in that frames region. mappedData is null when orphaning is used
+	uint8* mappedData = nullptr;
+	uint32 regionSize = 0;
+	uint32 regionCount = 0;
+	uint32 writeOffset = 0;
+	uint32 writeAlignment = 4;
+	uint64 writeFrame = 0;
 };
 
 // ==============================================
 
+// ==============================================
+// Blend State
+// ==============================================
+
+// maps BlendFactor to OpenGL equivalent
+static const GLenum GL3BlendFactorMap[] =
+{
+	GL_ZERO,
+	GL_ONE,
+	GL_SRC_COLOR,
+	GL_ONE_MINUS_SRC_COLOR,
+	GL_SRC_ALPHA,
+	GL_ONE_MINUS_SRC_ALPHA,
+	GL_DST_ALPHA,
+	GL_ONE_MINUS_DST_ALPHA,
+	GL_DST_COLOR,
+	GL_ONE_MINUS_DST_COLOR,
+	GL_SRC_ALPHA_SATURATE,
+	GL_CONSTANT_COLOR,
+	GL_ONE_MINUS_CONSTANT_COLOR
+};
+
+// maps BlendOperation to OpenGL equivalent
+static const GLenum GL3BlendOpMap[] = { GL_FUNC_ADD, GL_FUNC_SUBTRACT, GL_FUNC_REVERSE_SUBTRACT, GL_MIN, GL_MAX };
+
+class BlendStateGL3 : public BlendState
+{
+public:
+
+	GLenum glSrcBlend;
+	GLenum glDstBlend;
+	GLenum glBlendOp;
+	GLenum glSrcBlendAlpha;
+	GLenum glDstBlendAlpha;
+	GLenum glBlendOpAlpha;
+};
+
+// helper macros
+#define GET_GL3_BLEND(blend) GL3BlendFactorMap[static_cast<int32>(blend)]
+#define GET_GL3_BLEND_OP(blendOp) GL3BlendOpMap[static_cast<int32>(blendOp)]
+
+// ==============================================
+
 // ==============================================
 // Depth/Stencil State
 // ==============================================
@@ -118,6 +193,241 @@ public:
 
 // ==============================================
 
+// ==============================================
+// Rasterizer State
+// ==============================================
+
+// maps FillMode to OpenGL equivalent
+static const GLenum GL3FillModeMap[] = { GL_FILL, GL_LINE };
+
+class RasterizerStateGL3 : public RasterizerState
+{
+public:
+
+	bool cullEnabled;
+	GLenum glCullFace;
+	GLenum glFrontFace;
+	GLenum glPolygonMode;
+};
+
+// ==============================================
+
+// ==============================================
+// GL3 Render Targets
+// ==============================================
+
+struct RenderTargetFormatGL3
+{
+	GLenum internalFormat;
+	GLenum format;
+	GLenum type;
+	GLenum attachment;
+};
+
+// maps RenderTargetFormat to OpenGL equivalent, color formats are attached at GL_COLOR_ATTACHMENT0 plus their slot
+static const RenderTargetFormatGL3 GL3RenderTargetFormatMap[] =
+{
+	{ GL_RGBA8,					GL_RGBA,			GL_UNSIGNED_BYTE,		GL_COLOR_ATTACHMENT0 },
+	{ GL_RGBA16F,				GL_RGBA,			GL_HALF_FLOAT,			GL_COLOR_ATTACHMENT0 },
+	{ GL_RGBA32F,				GL_RGBA,			GL_FLOAT,				GL_COLOR_ATTACHMENT0 },
+	{ GL_R32F,					GL_RED,				GL_FLOAT,				GL_COLOR_ATTACHMENT0 },
+	{ GL_DEPTH24_STENCIL8,		GL_DEPTH_STENCIL,	GL_UNSIGNED_INT_24_8,	GL_DEPTH_STENCIL_ATTACHMENT },
+	{ GL_DEPTH_COMPONENT32F,	GL_DEPTH_COMPONENT,	GL_FLOAT,				GL_DEPTH_ATTACHMENT }
+};
+
+// ==============================================
+
+// ==============================================
+// GL3 Texture Streaming
+// ==============================================
+
+// size of each pixel unpack buffer asynchronous texture data is copied through, uploads are split in to chunks of
+// whole rows no larger than this
+#define GL3_STAGING_BUFFER_SIZE (1024 * 1024)
+
+// a staging buffer is reused once the GPU has finished copying out of it, so at most this many chunks are in flight
+#define GL3_STAGING_BUFFER_COUNT 4
+
+struct StagingBufferGL3
+{
+	GLuint bufferID = 0;
+
+	// signalled when the GPU has finished copying out of the buffer, null while the buffer is unused
+	GLsync fence = nullptr;
+};
+
+// ==============================================
+
+// ==============================================
+// GL3 Readback
+// ==============================================
+
+// readbacks that can be in flight, requesting another waits for the oldest to finish
+#define GL3_READBACK_BUFFER_COUNT 4
+
+// ==============================================
+
+// ==============================================
+// GL3 Program Binary Cache
+// ==============================================
+
+// linked programs are saved next to their sources with this extension and loaded instead of compiling
+#define GL3_PROGRAM_BINARY_EXT ".bin"
+
+#define GL3_PROGRAM_BINARY_MAGIC 0x42505344 // "DSPB"
+
+// bump when the file layout or anything else baked in to a binary changes, every cached file is then rebuilt
+#define GL3_PROGRAM_BINARY_VERSION 1
+
+struct ProgramBinaryHeaderGL3
+{
+	uint32 magic;
+	uint32 version;
+
+	// hash of both sources and the driver, a binary built from different sources or by another driver is stale
+	uint64 key;
+
+	GLenum format;
+	uint32 size;
+};
+
+// ==============================================
+
+// ==============================================
+// State Cache
+// ==============================================
+
+#define GL3_MAX_TEXTURE_UNITS 16
+#define GL3_MAX_UNIFORM_BUFFER_SLOTS 16
+
+// per instance attributes are bound from this location upwards, after the per vertex attributes
+#define GL3_INSTANCE_ATTRIBUTE_LOCATION 8
+#define GL3_MAX_INSTANCE_ATTRIBUTE_LOCATIONS 8
+
+// value stored in the cache when the GL state is not known, forcing the next set to reach the driver
+#define GL3_UNKNOWN_BINDING 0xFFFFFFFF
+
+// capabilities toggled with glEnable/glDisable that are shadowed by the state cache
+enum class GL3Capability : int32
+{
+	Blend		= 0,
+	DepthTest	= 1,
+	StencilTest = 2,
+	ScissorTest = 3,
+	CullFace	= 4,
+	Count		= 5
+};
+
+static const GLenum GL3CapabilityMap[] = { GL_BLEND, GL_DEPTH_TEST, GL_STENCIL_TEST, GL_SCISSOR_TEST, GL_CULL_FACE };
+
+// buffer targets shadowed by the state cache, GL_ELEMENT_ARRAY_BUFFER is part of the VAO so it is never cached
+enum class GL3BufferBinding : int32
+{
+	Array		= 0,
+	Uniform		= 1,
+	CopyWrite	= 2,
+	PixelUnpack	= 3,
+	PixelPack	= 4,
+	CopyRead	= 5,
+	Count		= 6
+};
+
+// the pixel buffers must be 0 outside of texture streaming and readback, other pixel transfers go through them
+static const GLenum GL3BufferBindingMap[] = { GL_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_COPY_WRITE_BUFFER, GL_PIXEL_UNPACK_BUFFER, GL_PIXEL_PACK_BUFFER, GL_COPY_READ_BUFFER };
+
+struct UniformBindingGL3
+{
+	GLuint bufferID;
+	GLintptr offset;
+	GLsizeiptr size;
+};
+
+// shadow copy of the GL state last sent to the driver
+struct GL3StateCache
+{
+	GL3StateCache()
+	{
+		Invalidate();
+	}
+
+	// marks every value as unknown, used when the context is created or modified outside of the cache
+	void Invalidate()
+	{
+		programID = GL3_UNKNOWN_BINDING;
+		vertexArrayID = GL3_UNKNOWN_BINDING;
+		framebufferID = GL3_UNKNOWN_BINDING;
+		activeTextureUnit = GL3_UNKNOWN_BINDING;
+
+		for (uint32 t = 0; t < GL3_MAX_TEXTURE_UNITS; t++)
+		{
+			textureIDs[t] = GL3_UNKNOWN_BINDING;
+			textureTargets[t] = GL_TEXTURE_2D;
+		}
+
+		for (uint32 b = 0; b < static_cast<uint32>(GL3BufferBinding::Count); b++)
+		{
+			bufferIDs[b] = GL3_UNKNOWN_BINDING;
+		}
+
+		for (uint32 s = 0; s < GL3_MAX_UNIFORM_BUFFER_SLOTS; s++)
+		{
+			uniformBindings[s].bufferID = GL3_UNKNOWN_BINDING;
+			uniformBindings[s].offset = 0;
+			uniformBindings[s].size = 0;
+		}
+
+		for (uint32 c = 0; c < static_cast<uint32>(GL3Capability::Count); c++)
+		{
+			capabilities[c] = -1;
+		}
+
+		for (uint32 i = 0; i < 4; i++)
+		{
+			scissorBox[i] = -1;
+			viewport[i] = -1;
+		}
+
+		blendSrcRGB = GL3_UNKNOWN_BINDING;
+		blendDstRGB = GL3_UNKNOWN_BINDING;
+		blendSrcAlpha = GL3_UNKNOWN_BINDING;
+		blendDstAlpha = GL3_UNKNOWN_BINDING;
+		blendEquationRGB = GL3_UNKNOWN_BINDING;
+		blendEquationAlpha = GL3_UNKNOWN_BINDING;
+		colorMask = GL3_UNKNOWN_BINDING;
+	}
+
+	GLuint programID;
+	GLuint vertexArrayID;
+
+	// bound to GL_FRAMEBUFFER, so both the read and draw framebuffer
+	GLuint framebufferID;
+
+	GLuint activeTextureUnit;
+	GLuint textureIDs[GL3_MAX_TEXTURE_UNITS];
+
+	// target each unit's texture is bound to, array textures use GL_TEXTURE_2D_ARRAY
+	GLenum textureTargets[GL3_MAX_TEXTURE_UNITS];
+
+	GLuint bufferIDs[static_cast<int32>(GL3BufferBinding::Count)];
+	UniformBindingGL3 uniformBindings[GL3_MAX_UNIFORM_BUFFER_SLOTS];
+
+	// -1 unknown, 0 disabled, 1 enabled
+	int8 capabilities[static_cast<int32>(GL3Capability::Count)];
+
+	GLint scissorBox[4];
+	GLint viewport[4];
+
+	GLenum blendSrcRGB;
+	GLenum blendDstRGB;
+	GLenum blendSrcAlpha;
+	GLenum blendDstAlpha;
+	GLenum blendEquationRGB;
+	GLenum blendEquationAlpha;
+	uint32 colorMask;
+};
+
+// ==============================================
+
 static const GLenum GLBaseTypes[] =
 {
 	GL_BYTE,
@@ -127,7 +437,9 @@ static const GLenum GLBaseTypes[] =
 	GL_INT,
 	GL_UNSIGNED_INT,
 	GL_FLOAT,
-	GL_DOUBLE
+	GL_DOUBLE,
+	GL_HALF_FLOAT,
+	GL_UNSIGNED_INT_2_10_10_10_REV
 };
 
 static const char *getGLErrorString(GLenum err)
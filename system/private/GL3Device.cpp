@@ -1,5 +1,6 @@
 #include "GL3Device.h"
 
+#include <algorithm>
 #include <vector>
 
 std::string GL3Device::GetAPIName()
@@ -10,7 +11,86 @@ std::string GL3Device::GetAPIName()
 bool GL3Device::Create(const RenderInfo& info)
 {
 	renderInfo = info;
+	framesInFlight = glm::clamp(info.framesInFlight, 1u, static_cast<uint32>(DS_MAX_FRAMES_IN_FLIGHT));
 
+	bool contextCreated = info.headless ? CreateHeadlessContext() : CreateWindowContext(info);
+
+	if (!contextCreated)
+		return false;
+
+	int major, minor;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+	LOG("Created OpenGL Context = %i.%i", major, minor);
+
+	// persistent mapping lets stream buffers be written directly without the driver copying or synchronizing
+	persistentMapping = (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) ? true : false;
+
+	if (persistentMapping)
+	{
+		LOG("Stream buffers using persistent mapping");
+	}
+	else
+	{
+		LOG("ARB_buffer_storage not supported, stream buffers using orphaning");
+	}
+
+	// the driver compiles and links on its own threads, shaders are polled for completion instead of waited on
+	parallelShaderCompile = GLEW_ARB_parallel_shader_compile ? true : false;
+
+	if (parallelShaderCompile)
+	{
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+		LOG("Compiling shaders in parallel");
+	}
+
+	// programs linked on an earlier run are loaded from their binaries instead of being compiled again
+	GLint numBinaryFormats = 0;
+
+	if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+	{
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numBinaryFormats);
+	}
+
+	programBinaries = numBinaryFormats > 0;
+
+	if (programBinaries)
+	{
+		// binaries are only valid for the driver that produced them
+		const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+		programBinaryDriverHash = FNV1A_64_OFFSET_BASIS;
+
+		for (GLenum name : driverStrings)
+		{
+			const char* str = reinterpret_cast<const char*>(glGetString(name));
+			programBinaryDriverHash = Hash::FNV1a64(str, strlen(str), programBinaryDriverHash);
+		}
+
+		LOG("Caching linked program binaries");
+	}
+	else
+	{
+		LOG("Program binaries not supported, shaders are compiled every run");
+	}
+
+	if (info.headless)
+	{
+		if (!CreateBackBuffer(info.resolutionX, info.resolutionY))
+		{
+			DestroyContext();
+			return false;
+		}
+
+		curFramebufferID = backBufferFramebufferID;
+	}
+
+	return true;
+}
+
+bool GL3Device::CreateWindowContext(const RenderInfo& info)
+{
+#if defined(_WIN32)
 	// check that a valid window pointer was passed
 	if (!info.wndPointer)
 	{
@@ -103,31 +183,265 @@ bool GL3Device::Create(const RenderInfo& info)
 		return false;
 	}
 
-	int major, minor;
-	glGetIntegerv(GL_MAJOR_VERSION, &major);
-	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	return true;
+#else
+	LOG_ERROR("Could not create OpenGL context, window contexts are only supported on Windows, use a headless context");
+	return false;
+#endif
+}
 
-	LOG("Created OpenGL Context = %i.%i", major, minor);
+bool GL3Device::CreateHeadlessContext()
+{
+#if defined(DS_GL3_EGL)
+	// Mesa's surfaceless platform needs no display server, other drivers fall back to the default display
+	const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+	if (clientExtensions && strstr(clientExtensions, "EGL_MESA_platform_surfaceless") && getPlatformDisplay)
+	{
+		eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+
+	if (eglDisplay == EGL_NO_DISPLAY)
+	{
+		eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint eglMajor, eglMinor;
+	if (eglDisplay == EGL_NO_DISPLAY || eglInitialize(eglDisplay, &eglMajor, &eglMinor) == EGL_FALSE)
+	{
+		LOG_ERROR("Failed initializing EGL display : Error 0x%x", eglGetError());
+		eglDisplay = EGL_NO_DISPLAY;
+		return false;
+	}
+
+	LOG("Initialized EGL %i.%i : %s", eglMajor, eglMinor, eglQueryString(eglDisplay, EGL_VENDOR));
+
+	if (eglBindAPI(EGL_OPENGL_API) == EGL_FALSE)
+	{
+		LOG_ERROR("EGL does not support desktop OpenGL");
+		DestroyContext();
+		return false;
+	}
+
+	// the config only matters for the pbuffer fallback, the back buffer is always a framebuffer object
+	const EGLint configAttributes[] =
+	{
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_NONE
+	};
+
+	EGLConfig config;
+	EGLint numConfigs = 0;
+	if (eglChooseConfig(eglDisplay, configAttributes, &config, 1, &numConfigs) == EGL_FALSE || numConfigs == 0)
+	{
+		LOG_ERROR("No EGL config supports OpenGL pbuffers");
+		DestroyContext();
+		return false;
+	}
+
+#ifdef _DEBUG
+	EGLint contextFlags = EGL_CONTEXT_OPENGL_DEBUG_BIT_KHR;
+#else
+	EGLint contextFlags = EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE_BIT_KHR;
+#endif
+
+	const EGLint contextAttributes[] =
+	{
+		EGL_CONTEXT_MAJOR_VERSION_KHR, GL3_MAJOR,
+		EGL_CONTEXT_MINOR_VERSION_KHR, GL3_MINOR,
+		EGL_CONTEXT_FLAGS_KHR, contextFlags,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+		EGL_NONE
+	};
+
+	if ((eglContext = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttributes)) == EGL_NO_CONTEXT)
+	{
+		LOG_ERROR("eglCreateContext Failed : Error 0x%x", eglGetError());
+		DestroyContext();
+		return false;
+	}
+
+	// without surfaceless support the context is made current on a 1x1 pbuffer that is never drawn to
+	const char* displayExtensions = eglQueryString(eglDisplay, EGL_EXTENSIONS);
+
+	if (!displayExtensions || !strstr(displayExtensions, "EGL_KHR_surfaceless_context"))
+	{
+		const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+
+		if ((eglSurface = eglCreatePbufferSurface(eglDisplay, config, pbufferAttributes)) == EGL_NO_SURFACE)
+		{
+			LOG_ERROR("eglCreatePbufferSurface Failed : Error 0x%x", eglGetError());
+			DestroyContext();
+			return false;
+		}
+	}
+
+	if (eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext) == EGL_FALSE)
+	{
+		LOG_ERROR("eglMakeCurrent Failed : Error 0x%x", eglGetError());
+		DestroyContext();
+		return false;
+	}
+
+	LOG("Created headless context %s", (eglSurface == EGL_NO_SURFACE) ? "without a surface" : "on a pbuffer");
+
+	// core profiles don't list extensions the way GLEW expects without this
+	glewExperimental = GL_TRUE;
+
+	GLenum glew_err = glewInit();
+	if (GLEW_OK != glew_err)
+	{
+		std::string error_string = reinterpret_cast<const char*>(glewGetErrorString(glew_err));
+		LOG_ERROR("Unable to initliaze GLEW : %s", error_string.c_str());
+		DestroyContext();
+		return false;
+	}
+
+	// glewInit queries GL_EXTENSIONS which is invalid in a core profile, the error is expected
+	glGetError();
+
+	LOG("Successfully Initialized GLEW!");
+
+	return true;
+#else
+	LOG_ERROR("Could not create headless OpenGL context, the library was built without EGL");
+	return false;
+#endif
+}
+
+void GL3Device::DestroyContext()
+{
+#if defined(DS_GL3_EGL)
+	if (eglDisplay != EGL_NO_DISPLAY)
+	{
+		eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+		if (eglSurface != EGL_NO_SURFACE)
+			eglDestroySurface(eglDisplay, eglSurface);
+
+		if (eglContext != EGL_NO_CONTEXT)
+			eglDestroyContext(eglDisplay, eglContext);
+
+		eglTerminate(eglDisplay);
+
+		eglDisplay = EGL_NO_DISPLAY;
+		eglContext = EGL_NO_CONTEXT;
+		eglSurface = EGL_NO_SURFACE;
+	}
+#endif
+
+#if defined(_WIN32)
+	if (glContextHandle)
+	{
+		wglMakeCurrent(NULL, NULL);
+		wglDeleteContext(glContextHandle);
+		glContextHandle = nullptr;
+	}
+#endif
+}
+
+bool GL3Device::CreateBackBuffer(uint32 width, uint32 height)
+{
+	if (backBufferFramebufferID == 0)
+	{
+		glGenFramebuffers(1, &backBufferFramebufferID);
+		glGenRenderbuffers(1, &backBufferColorID);
+		glGenRenderbuffers(1, &backBufferDepthID);
+	}
+
+	// storage is respecified on a resolution change, the framebuffer keeps its attachments
+	glBindRenderbuffer(GL_RENDERBUFFER, backBufferColorID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, backBufferDepthID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, backBufferFramebufferID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, backBufferColorID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, backBufferDepthID);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+	// the state cache isn't set up yet when called from Create, so the binding is made directly and marked unknown
+	stateCache.framebufferID = GL3_UNKNOWN_BINDING;
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		LOG_ERROR("GL3 : Failed creating headless back buffer, status 0x%x", status);
+		DestroyBackBuffer();
+		return false;
+	}
 
 	return true;
 }
 
+void GL3Device::DestroyBackBuffer()
+{
+	if (backBufferFramebufferID == 0)
+		return;
+
+	glDeleteFramebuffers(1, &backBufferFramebufferID);
+	OnFramebufferDeleted(backBufferFramebufferID);
+
+	glDeleteRenderbuffers(1, &backBufferColorID);
+	glDeleteRenderbuffers(1, &backBufferDepthID);
+
+	if (curFramebufferID == backBufferFramebufferID)
+	{
+		curFramebufferID = 0;
+	}
+
+	backBufferFramebufferID = 0;
+	backBufferColorID = 0;
+	backBufferDepthID = 0;
+}
+
 void GL3Device::Initialize()
 {
+	// nothing is known about the state of a new context
+	stateCache.Invalidate();
+
 	// Create depth/stencil state
 	DepthStencilStateDesc defaultDepthStencilDesc;
 	defaultDepthStencilState = CreateDepthStencilState(defaultDepthStencilDesc);
 	SetDepthStencilState(defaultDepthStencilState);
 
-	glDisable(GL_CULL_FACE);
+	// Create blend state, alpha blending is enabled by default
+	BlendProperties defaultBlend;
+	defaultBlend.enabled = true;
+	defaultBlend.srcBlend = BlendFactor::SrcAlpha;
+	defaultBlend.dstBlend = BlendFactor::InvSrcAlpha;
+	defaultBlend.srcBlendAlpha = BlendFactor::SrcAlpha;
+	defaultBlend.dstBlendAlpha = BlendFactor::InvSrcAlpha;
+
+	defaultBlendState = static_cast<BlendStateGL3*>(CreateBlendState(defaultBlend));
+	SetBlendState(defaultBlendState);
+
+	// Create rasterizer state, no culling with scissor testing enabled
+	RasterizerStateDesc defaultRasterizerDesc;
+	defaultRasterizerState = static_cast<RasterizerStateGL3*>(CreateRasterizerState(defaultRasterizerDesc));
+	SetRasterizerState(defaultRasterizerState);
+
+	SetCapability(GL3Capability::DepthTest, false);
 
-	glEnable(GL_BLEND);
-	glBlendEquation(GL_FUNC_ADD);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glDisable(GL_CULL_FACE);
-	glDisable(GL_DEPTH_TEST);
-	glEnable(GL_SCISSOR_TEST);
 	glActiveTexture(GL_TEXTURE0);
+	stateCache.activeTextureUnit = 0;
+
+	// uniform data written in to stream buffers has to start at a multiple of this
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformBufferAlignment);
+
+	// multisampled render targets are clamped to this
+	glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+
+	BindFramebuffer(backBufferFramebufferID);
 
 	//glEnable(GL_CULL_FACE);
 	//glEnable(GL_DEPTH_TEST);
@@ -137,7 +451,102 @@ void GL3Device::Initialize()
 
 void GL3Device::Destroy()
 {
-	wglDeleteContext(glContextHandle);
+	for (uint32 f = 0; f < DS_MAX_FRAMES_IN_FLIGHT; f++)
+	{
+		if (frameFences[f])
+		{
+			glDeleteSync(frameFences[f]);
+			frameFences[f] = nullptr;
+		}
+	}
+
+	for (StagingBufferGL3 &staging : stagingBuffers)
+	{
+		if (staging.fence)
+		{
+			glDeleteSync(staging.fence);
+			staging.fence = nullptr;
+		}
+
+		if (staging.bufferID)
+		{
+			glDeleteBuffers(1, &staging.bufferID);
+			OnBufferDeleted(staging.bufferID);
+			staging.bufferID = 0;
+		}
+	}
+
+	textureUploads.clear();
+
+	// shaders still compiling are owned by the caller, only the record of them is dropped
+	shaderCompiles.clear();
+	shaderVariants.clear();
+	shaderPreprocessor.Clear();
+	curShader = nullptr;
+
+	// readbacks still in flight are dropped without calling back
+	for (ReadbackGL3 &readback : readbacks)
+	{
+		if (readback.fence)
+		{
+			glDeleteSync(readback.fence);
+			readback.fence = nullptr;
+		}
+
+		if (readback.bufferID)
+		{
+			glDeleteBuffers(1, &readback.bufferID);
+			OnBufferDeleted(readback.bufferID);
+			readback.bufferID = 0;
+			readback.bufferSize = 0;
+		}
+
+		readback.callback = nullptr;
+	}
+
+	pendingReadbacks = 0;
+
+	// release every resource still held by a handle
+	for (MeshGL3 &mesh : meshes)
+		DeleteMeshObjects(&mesh);
+
+	for (GL3Shader &shader : shaders)
+		DeleteShaderObjects(&shader);
+
+	for (GL3Texture &texture : textures)
+		DeleteTextureObjects(&texture);
+
+	for (BufferGL3 &buffer : buffers)
+		DeleteBufferObjects(&buffer);
+
+	meshes.Clear();
+	shaders.Clear();
+	textures.Clear();
+	buffers.Clear();
+
+	// arenas go after the meshes, whose ranges are given back to them above
+	for (MeshArenaGL3* arena : meshArenas)
+		DeleteMeshArena(arena);
+
+	meshArenas.clear();
+
+	// render targets are released by their owners, only the framebuffers combining them belong to the device
+	for (FramebufferGL3 &framebuffer : framebuffers)
+		glDeleteFramebuffers(1, &framebuffer.framebufferID);
+
+	framebuffers.clear();
+
+	// release every cached state object
+	blendStates.Clear([](BlendStateGL3* state) { delete state; });
+	depthStencilStates.Clear([](DepthStencilStateGL3* state) { delete state; });
+	rasterizerStates.Clear([](RasterizerStateGL3* state) { delete state; });
+
+	defaultBlendState = curBlendState = nullptr;
+	defaultDepthStencilState = curDepthStencilState = nullptr;
+	defaultRasterizerState = curRasterizerState = nullptr;
+
+	DestroyBackBuffer();
+	DestroyContext();
 }
 
 void GL3Device::Clear()
@@ -147,11 +556,36 @@ void GL3Device::Clear()
 
 void GL3Device::Present()
 {
-	SwapBuffers(windowContext);
+	ProcessShaderCompiles();
+	ProcessTextureUploads();
+
+	// a headless frame has nothing to swap, flushing keeps the queued work moving without waiting on it
+	if (renderInfo.headless)
+	{
+		glFlush();
+	}
+	else
+	{
+#if defined(_WIN32)
+		SwapBuffers(windowContext);
+#endif
+	}
+
+	CompleteReadbacks(false);
+
+	AdvanceFrame();
+
+	lastFrameStats = curFrameStats;
+	curFrameStats.Reset();
 }
 
 void GL3Device::SetVSync(bool enabled)
 {
+	// headless frames are never presented, they always run uncapped
+	if (renderInfo.headless)
+		return;
+
+#if defined(_WIN32)
 	if (enabled)
 	{
 		wglSwapIntervalEXT(1);
@@ -160,6 +594,23 @@ void GL3Device::SetVSync(bool enabled)
 	{
 		wglSwapIntervalEXT(0);
 	}
+#endif
+}
+
+void GL3Device::SetFramesInFlight(uint32 count)
+{
+	count = glm::clamp(count, 1u, static_cast<uint32>(DS_MAX_FRAMES_IN_FLIGHT));
+
+	if (count == framesInFlight)
+		return;
+
+	// slots are renumbered, so no frame may still be using one. stream buffers are resized on their next write
+	WaitForFrames();
+
+	framesInFlight = count;
+	frameSlot = 0;
+
+	LOG("Frames in flight set to %u", framesInFlight);
 }
 
 void GL3Device::SetShader(Shader* shader)
@@ -168,7 +619,13 @@ void GL3Device::SetShader(Shader* shader)
 
 	if (gl3Shader != nullptr)
 	{
-		glUseProgram(gl3Shader->programID);
+		curShader = gl3Shader;
+
+		// using a program that is still linking would wait for it, it is bound once it has finished instead
+		if (!gl3Shader->compilePending)
+		{
+			BindProgram(gl3Shader->programID);
+		}
 	}
 }
 
@@ -178,8 +635,7 @@ void GL3Device::SetTexture(Texture* texture, uint32 slot)
 
 	if (texture)
 	{
-		glActiveTexture(GL_TEXTURE0 + slot);
-		glBindTexture(GL_TEXTURE_2D, gl3Texture->textureID);
+		BindTexture(slot, gl3Texture->textureID, gl3Texture->glTarget);
 	}
 }
 
@@ -187,120 +643,231 @@ void GL3Device::DrawMesh(Mesh* mesh)
 {
 	MeshGL3* glMesh = static_cast<MeshGL3*>(mesh);
 
-	if (glMesh != nullptr)
+	if (glMesh != nullptr && IsCurrentShaderReady())
 	{
-		glBindVertexArray(glMesh->vertexArrayID);
-		glDrawArrays(GL_TRIANGLES, 0, glMesh->vertexCount);
+		BindVertexArray(glMesh->vertexArrayID);
+
+		GLint firstVertex;
+		uintptr_t indexByteOffset;
+		GetMeshOffsets(glMesh, firstVertex, indexByteOffset);
+
+		glDrawArrays(GL_TRIANGLES, firstVertex, glMesh->vertexCount);
+
+		curFrameStats.drawCalls++;
+		curFrameStats.primitives += glMesh->vertexCount / 3;
 	}
 }
 
-void GL3Device::DrawMeshIndexed(Mesh* mesh, uint32 elementCount, uint32 vertexOffset, uint16 indexOffset)
+void GL3Device::DrawMeshIndexed(Mesh* mesh, uint32 elementCount, uint32 vertexOffset, uint32 indexOffset)
 {
 	MeshGL3* glMesh = static_cast<MeshGL3*>(mesh);
 
-	if (glMesh != nullptr)
+	if (glMesh != nullptr && IsCurrentShaderReady())
 	{
 		if (elementCount == 0)
 		{
 			elementCount = glMesh->indexCount;
 		}
 
-		glBindVertexArray(glMesh->vertexArrayID);
+		// the VAO is left bound, consecutive draws of the same mesh or of meshes in the same arena do not rebind it
+		BindVertexArray(glMesh->vertexArrayID);
+
+		GLint baseVertex;
+		uintptr_t indexByteOffset;
+		GetMeshOffsets(glMesh, baseVertex, indexByteOffset);
+
+		indexByteOffset += indexOffset * DS_INDEX_SIZE(glMesh->indexFormat);
+		baseVertex += vertexOffset;
+		GLenum indexType = GL3IndexFormatMap[static_cast<int32>(glMesh->indexFormat)];
 
-		glDrawElementsBaseVertex(GL_TRIANGLES, elementCount, GL_UNSIGNED_SHORT, (void*)(indexOffset * sizeof(GLushort)), vertexOffset);
+		glDrawElementsBaseVertex(GL_TRIANGLES, elementCount, indexType, (void*)indexByteOffset, baseVertex);
 
-		glBindVertexArray(0);
+		curFrameStats.drawCalls++;
+		curFrameStats.primitives += elementCount / 3;
 	}
 }
 
-Mesh* GL3Device::CreateMesh(const MeshData &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage)
+void GL3Device::DrawMeshIndexedInstanced(Mesh* mesh, Buffer* instanceBuffer, VertexAttributes instanceAttributeFlags, uint32 instanceCount,
+										 uint32 firstInstance, uint32 elementCount, uint32 vertexOffset, uint32 indexOffset)
 {
-	// clear binded vertex array object
-	glBindVertexArray(0);
+	MeshGL3* glMesh = static_cast<MeshGL3*>(mesh);
+	BufferGL3* glInstanceBuffer = static_cast<BufferGL3*>(instanceBuffer);
 
-	// create and bind a new VAO
-	GLuint vertexArrayID;
-	glGenVertexArrays(1, &vertexArrayID);
-	CHECK_GL(glBindVertexArray(vertexArrayID));
+	if (glMesh != nullptr && glInstanceBuffer != nullptr && IsCurrentShaderReady())
+	{
+		uint32 instanceStride = GetAttributeMaskSize(instanceAttributeFlags);
 
-	uint32 stride = GetAttributeMaskSize(vertexAttributeFlags);
+		if (instanceStride == 0)
+		{
+			LOG_ERROR("DrawMeshIndexedInstanced requires at least one per instance attribute");
+			return;
+		}
+
+		if (elementCount == 0)
+		{
+			elementCount = glMesh->indexCount;
+		}
 
-	// Create vertex and index buffers
-	BufferGL3* vertexBuffer = CreateBuffer(meshData.vertexData,
-										   meshData.vertexCount * stride,
-										   BufferTarget::Vertex, usage);
+		BindVertexArray(glMesh->vertexArrayID);
 
-	BufferGL3* indexBuffer = CreateBuffer(meshData.indexData,
-										  meshData.indexCount * sizeof(uint16),
-										  BufferTarget::Index, usage);
+		// GL 3.3 has no base instance, the first instance is selected by offsetting the attribute pointers instead
+		// the pointers are respecified every draw as the instance buffer of a stream may move between draws
+		uintptr_t instanceByteOffset = glInstanceBuffer->dataOffset + firstInstance * instanceStride;
 
-	// define generic vertex attribute data
-	SetVertexAttributes(vertexAttributeFlags, stride);
+		BindBuffer(GL3BufferBinding::Array, glInstanceBuffer->glID);
+		SetInstanceAttributes(instanceAttributeFlags, instanceStride, instanceByteOffset);
 
-	// reset bound vao so that it is not modified
-	glBindVertexArray(0);
+		GLint baseVertex;
+		uintptr_t indexByteOffset;
+		GetMeshOffsets(glMesh, baseVertex, indexByteOffset);
 
-	// reset
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		indexByteOffset += indexOffset * DS_INDEX_SIZE(glMesh->indexFormat);
+		baseVertex += vertexOffset;
+		GLenum indexType = GL3IndexFormatMap[static_cast<int32>(glMesh->indexFormat)];
 
-	return new MeshGL3(vertexArrayID, vertexBuffer, indexBuffer, meshData.vertexCount, meshData.indexCount, stride);
+		glDrawElementsInstancedBaseVertex(GL_TRIANGLES, elementCount, indexType, (void*)indexByteOffset, instanceCount, baseVertex);
+
+		// the VAO is shared with non instanced draws of the mesh, and with every mesh of an arena
+		ClearInstanceAttributes(instanceAttributeFlags);
+
+		curFrameStats.drawCalls++;
+		curFrameStats.primitives += (elementCount / 3) * instanceCount;
+	}
 }
 
-Mesh* GL3Device::CreateMesh(const MeshDataList &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage)
+Mesh* GL3Device::CreateMesh(const MeshData &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage)
 {
-	// clear binded vertex array object
-	glBindVertexArray(0);
-
-	// create and bind a new VAO
-	GLuint vertexArrayID;
-	glGenVertexArrays(1, &vertexArrayID);
-	CHECK_GL(glBindVertexArray(vertexArrayID));
+	// static meshes never change size, so they can be packed in to the shared buffers of their formats arena
+	if (meshArenasEnabled && usage == BufferUsage::Static)
+	{
+		return CreateArenaMesh(meshData, vertexAttributeFlags);
+	}
 
 	uint32 stride = GetAttributeMaskSize(vertexAttributeFlags);
 
-	// Create vertex and index buffers
-	BufferGL3* vertexBuffer = CreateBuffer(meshData.vertices, meshData.dataCount,
-										   meshData.vertexCount * stride,
-										   BufferTarget::Vertex, usage);
+	BufferGL3* vertexBuffer = nullptr;
 
-	BufferGL3* indexBuffer = CreateBuffer(meshData.indices, meshData.dataCount,
-										  meshData.indexCount * sizeof(uint16),
+	// stream vertex data must be written at offsets that are a multiple of the stride so it can be drawn with a base vertex
+	if (usage == BufferUsage::Stream)
+	{
+		vertexBuffer = CreateStreamBuffer(meshData.vertexCount * stride, stride, BufferTarget::Vertex);
+
+		if (meshData.vertexData)
+		{
+			UpdateBuffer(vertexBuffer, meshData.vertexData, meshData.vertexCount * stride);
+		}
+	}
+	else
+	{
+		vertexBuffer = CreateBuffer(meshData.vertexData,
+									meshData.vertexCount * stride,
+									BufferTarget::Vertex, usage);
+	}
+
+	// 32 bit indices are narrowed to 16 bit when the mesh is small enough
+	IndexFormat indexFormat = GetDeviceIndexFormat(meshData.indexFormat, meshData.vertexCount);
+	const void* indexData = ConvertIndices(meshData.indexData, meshData.indexCount, meshData.indexFormat, indexFormat, indexScratch);
+
+	BufferGL3* indexBuffer = CreateBuffer(indexData,
+										  meshData.indexCount * DS_INDEX_SIZE(indexFormat),
 										  BufferTarget::Index, usage);
 
-	// define generic vertex attribute data
-	SetVertexAttributes(vertexAttributeFlags, stride);
+	// create a new VAO, buffers are created through GL_COPY_WRITE_BUFFER so no other VAO is modified
+	GLuint vertexArrayID;
+	glGenVertexArrays(1, &vertexArrayID);
+
+	MeshGL3* newMesh = new MeshGL3(vertexArrayID, vertexBuffer, indexBuffer, meshData.vertexCount, meshData.indexCount, indexFormat, stride, vertexAttributeFlags);
+	BindMeshBuffers(newMesh);
+
+	return newMesh;
+}
 
-	// reset bound vao so that it is not modified
-	glBindVertexArray(0);
+Mesh* GL3Device::CreateMesh(const MeshDataList &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage)
+{
+	uint32 stride = GetAttributeMaskSize(vertexAttributeFlags);
+
+	BufferGL3* vertexBuffer = nullptr;
+
+	// stream vertex data must be written at offsets that are a multiple of the stride so it can be drawn with a base vertex
+	if (usage == BufferUsage::Stream)
+	{
+		vertexBuffer = CreateStreamBuffer(meshData.vertexCount * stride, stride, BufferTarget::Vertex);
+		UpdateBuffer(vertexBuffer, meshData.vertices, meshData.dataCount, meshData.vertexCount * stride);
+	}
+	else
+	{
+		vertexBuffer = CreateBuffer(meshData.vertices, meshData.dataCount,
+									meshData.vertexCount * stride,
+									BufferTarget::Vertex, usage);
+	}
+
+	BufferGL3* indexBuffer = CreateBuffer(meshData.indices, meshData.dataCount,
+										  meshData.indexCount * DS_INDEX_SIZE(meshData.indexFormat),
+										  BufferTarget::Index, usage);
+
+	// create a new VAO, buffers are created through GL_COPY_WRITE_BUFFER so no other VAO is modified
+	GLuint vertexArrayID;
+	glGenVertexArrays(1, &vertexArrayID);
 
-	// reset
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	MeshGL3* newMesh = new MeshGL3(vertexArrayID, vertexBuffer, indexBuffer, meshData.vertexCount, meshData.indexCount, meshData.indexFormat, stride, vertexAttributeFlags);
+	BindMeshBuffers(newMesh);
 
-	return new MeshGL3(vertexArrayID, vertexBuffer, indexBuffer, meshData.vertexCount, meshData.indexCount, stride);
+	return newMesh;
 }
 
 void GL3Device::UpdateMesh(Mesh* mesh, const MeshData &meshData)
 {
 	MeshGL3* glMesh = static_cast<MeshGL3*>(mesh);
 
+	DS_ASSERT(glMesh->arena == nullptr); // arena meshes are static and should not be modified
+
+	if (glMesh->arena != nullptr)
+		return;
+
+	GLuint vertexBufferID = glMesh->vertexBuffer->glID;
+	GLuint indexBufferID = glMesh->indexBuffer->glID;
+
 	UpdateBuffer(glMesh->vertexBuffer, meshData.vertexData, meshData.vertexCount * glMesh->stride);
-	UpdateBuffer(glMesh->indexBuffer, meshData.indexData, meshData.indexCount * sizeof(uint16));
+	IndexFormat indexFormat = GetDeviceIndexFormat(meshData.indexFormat, meshData.vertexCount);
+	const void* indexData = ConvertIndices(meshData.indexData, meshData.indexCount, meshData.indexFormat, indexFormat, indexScratch);
+	UpdateBuffer(glMesh->indexBuffer, indexData, meshData.indexCount * DS_INDEX_SIZE(indexFormat));
+
+	// stream buffers get a new GL buffer when they grow, the VAO has to be pointed at it
+	if (glMesh->vertexBuffer->glID != vertexBufferID || glMesh->indexBuffer->glID != indexBufferID)
+	{
+		BindMeshBuffers(glMesh);
+	}
 
 	glMesh->vertexCount = meshData.vertexCount;
 	glMesh->indexCount = meshData.indexCount;
+	glMesh->indexFormat = indexFormat;
 }
 
 void GL3Device::UpdateMesh(Mesh* mesh, const MeshDataList &meshData)
 {
 	MeshGL3* glMesh = static_cast<MeshGL3*>(mesh);
 
+	DS_ASSERT(glMesh->arena == nullptr); // arena meshes are static and should not be modified
+
+	if (glMesh->arena != nullptr)
+		return;
+
+	GLuint vertexBufferID = glMesh->vertexBuffer->glID;
+	GLuint indexBufferID = glMesh->indexBuffer->glID;
+
+	// stream buffers scatter each BufferData straight in to mapped memory
 	UpdateBuffer(glMesh->vertexBuffer, meshData.vertices, meshData.dataCount, meshData.vertexCount * glMesh->stride);
-	UpdateBuffer(glMesh->indexBuffer, meshData.indices, meshData.dataCount, meshData.indexCount * sizeof(uint16));
+	UpdateBuffer(glMesh->indexBuffer, meshData.indices, meshData.dataCount, meshData.indexCount * DS_INDEX_SIZE(meshData.indexFormat));
+
+	// stream buffers get a new GL buffer when they grow, the VAO has to be pointed at it
+	if (glMesh->vertexBuffer->glID != vertexBufferID || glMesh->indexBuffer->glID != indexBufferID)
+	{
+		BindMeshBuffers(glMesh);
+	}
 
 	glMesh->vertexCount = meshData.vertexCount;
 	glMesh->indexCount = meshData.indexCount;
+	glMesh->indexFormat = meshData.indexFormat;
 }
 
 void GL3Device::ReleaseMesh(Mesh* mesh)
@@ -310,106 +877,205 @@ void GL3Device::ReleaseMesh(Mesh* mesh)
 	if (glMesh == nullptr)
 		return;
 
-	ReleaseBuffer(glMesh->vertexBuffer);
-	ReleaseBuffer(glMesh->indexBuffer);
+	DeleteMeshObjects(glMesh);
 
 	delete glMesh;
 }
 
-Shader* GL3Device::CreateShader(const std::string &name)
+void GL3Device::SetMeshArenasEnabled(bool enabled)
 {
-	GL3Shader* newShader = new GL3Shader();
+	meshArenasEnabled = enabled;
+}
 
-	// create vertex shader
-	GLuint vertexShader = CompileShaderObject(GL3_SHADER_LOC + name + ".vert", GL_VERTEX_SHADER);
+void GL3Device::DefragmentMeshArenas()
+{
+	for (size_t a = 0; a < meshArenas.size();)
+	{
+		MeshArenaGL3* arena = meshArenas[a];
+
+		// an arena without meshes is released, it is made again if a mesh of its format is created
+		if (arena->meshCount == 0)
+		{
+			DeleteMeshArena(arena);
+			meshArenas.erase(meshArenas.begin() + a);
+			continue;
+		}
+
+		if (!arena->vertexRanges.IsCompact() || !arena->indexRanges.IsCompact())
+		{
+			ResizeMeshArena(arena, arena->vertexRanges.GetCapacity(), arena->indexRanges.GetCapacity(), true);
+		}
 
-	if(vertexShader == 0)
+		a++;
+	}
+}
+
+MeshArenaStats GL3Device::GetMeshArenaStats()
+{
+	MeshArenaStats stats;
+
+	for (const MeshArenaGL3* arena : meshArenas)
 	{
-		LOG_GL_ERROR("Unable to create shader, failed creating vertex shader");
-		return nullptr;
+		uint32 indexSize = DS_INDEX_SIZE(arena->indexFormat);
+
+		stats.arenaCount++;
+		stats.meshCount += arena->meshCount;
+		stats.bytesReserved += static_cast<uint64>(arena->vertexRanges.GetCapacity()) * arena->stride + static_cast<uint64>(arena->indexRanges.GetCapacity()) * indexSize;
+		stats.bytesUsed += static_cast<uint64>(arena->vertexRanges.GetUsedSize()) * arena->stride + static_cast<uint64>(arena->indexRanges.GetUsedSize()) * indexSize;
+		stats.freeRanges += arena->vertexRanges.GetFreeRangeCount() + arena->indexRanges.GetFreeRangeCount();
 	}
 
-	// create fragment shader
-	GLuint fragmentShader = CompileShaderObject(GL3_SHADER_LOC +  name + ".frag", GL_FRAGMENT_SHADER);
+	return stats;
+}
+
+Shader* GL3Device::CreateShader(const std::string &name, ShaderFeatures features)
+{
+	std::string variantName = ShaderPreprocessor::GetVariantName(name, features);
+
+	// only variants that are asked for are ever compiled, and each of them once
+	auto variant = shaderVariants.find(variantName);
 
-	if (fragmentShader == 0)
+	if (variant != shaderVariants.end())
 	{
-		LOG_GL_ERROR("Unable to create shader, failed creating fragment shader");
+		// a variant still compiling for CreateShaderAsync is waited for, this shader is expected to be ready
+		if (variant->second->compilePending)
+		{
+			FinishQueuedShaderCompile(variant->second);
+		}
+
+		variant->second->refCount++;
+		return variant->second;
+	}
+
+	GL3Shader* newShader = CompileShader(name, features);
+
+	if (newShader == nullptr)
 		return nullptr;
+
+	newShader->variantName = variantName;
+	newShader->refCount = 1;
+	shaderVariants[variantName] = newShader;
+
+	return newShader;
+}
+
+void GL3Device::ReleaseShader(Shader* shader)
+{
+	GL3Shader* gl3Shader = static_cast<GL3Shader*>(shader);
+
+	if (gl3Shader == nullptr)
+		return;
+
+	// the variant stays alive while anything else created it
+	if (gl3Shader->refCount > 1)
+	{
+		gl3Shader->refCount--;
+		return;
 	}
 
-	// create shader program
-	GLuint programID = glCreateProgram();
+	shaderVariants.erase(gl3Shader->variantName);
 
-	if (programID == 0)
+	if (gl3Shader->compilePending)
 	{
-		LOG_GL_ERROR("Error creating shader program, glCreateProgram returned 0");
-		return nullptr;
+		for (auto compile = shaderCompiles.begin(); compile != shaderCompiles.end(); ++compile)
+		{
+			if (compile->shader == gl3Shader)
+			{
+				shaderCompiles.erase(compile);
+				break;
+			}
+		}
 	}
 
-	// attach vertex and fragment shaders
-	glAttachShader(programID, vertexShader);
-	glAttachShader(programID, fragmentShader);
+	if (curShader == gl3Shader)
+	{
+		curShader = nullptr;
+	}
 
-	// link program
-	glLinkProgram(programID);
+	DeleteShaderObjects(gl3Shader);
 
-	// check shader program linked succesfully and is ready to use
-	GLint linkStatus = 0;
-	glGetProgramiv(programID, GL_LINK_STATUS, &linkStatus);
+	delete gl3Shader;
+}
 
-	if (linkStatus == GL_FALSE)
-	{
-		GLint info_length;
-		glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &info_length);
+Shader* GL3Device::CreateShaderAsync(const std::string &name, ShaderFeatures features)
+{
+	std::string variantName = ShaderPreprocessor::GetVariantName(name, features);
+
+	// a variant that is already compiling is shared as it is, it becomes ready for every user at once
+	auto variant = shaderVariants.find(variantName);
 
-		std::vector<char> errorMsg(glm::max(info_length, int(1)));
-		glGetProgramInfoLog(programID, info_length, NULL, &errorMsg[0]);
+	if (variant != shaderVariants.end())
+	{
+		variant->second->refCount++;
+		return variant->second;
+	}
 
-		LOG_GL_ERROR("Failed linking shader program");
-		LOG_ERROR(&errorMsg[0]);
+	ShaderCompileGL3 compile;
+	compile.name = name;
+	compile.features = features;
+	compile.shader = StartShaderCompile(name, features, compile.binaryKey);
 
+	if (compile.shader == nullptr)
 		return nullptr;
+
+	// shaders loaded from a cached binary are ready straight away
+	if (compile.shader->compilePending)
+	{
+		shaderCompiles.push_back(compile);
 	}
 
-	newShader->vertexShader = vertexShader;
-	newShader->fragmentShader = fragmentShader;
-	newShader->programID = programID;
+	compile.shader->variantName = variantName;
+	compile.shader->refCount = 1;
+	shaderVariants[variantName] = compile.shader;
 
-	return newShader;
+	return compile.shader;
 }
 
-void GL3Device::ReleaseShader(Shader* shader)
+bool GL3Device::IsShaderReady(Shader* shader)
 {
+	GL3Shader* gl3Shader = static_cast<GL3Shader*>(shader);
+
+	if (gl3Shader == nullptr)
+		return false;
+
+	// finish the shader now rather than at the next Present if the driver is already done with it
+	if (gl3Shader->compilePending && IsShaderCompileComplete(gl3Shader))
+	{
+		FinishQueuedShaderCompile(gl3Shader);
+	}
 
+	return !gl3Shader->compilePending && gl3Shader->programID != 0;
 }
 
 Texture* GL3Device::CreateTexture(uint8 *data, const TextureSettings &settings)
 {
+	DS_ASSERT(settings.arraySize > 0); // a texture needs at least one layer
+
 	CHECK_GL_ERROR("No Texture Error");
 	GL3Texture* newTexture = new GL3Texture(settings);
+	GLenum target = newTexture->glTarget;
 
 	// create and bind GL texture
 	glGenTextures(1, &newTexture->textureID);
 
-	// save bound texture before modifying it
-	GLint lastSampler = 0;
-	glGetIntegerv(GL_SAMPLER_BINDING, &lastSampler);
+	// save the texture bound to unit 0 before modifying it, restoring it leaves the cache valid
+	GLuint lastTexture = stateCache.textureIDs[0];
+	GLenum lastTarget = stateCache.textureTargets[0];
 
-	glBindTexture(GL_TEXTURE_2D, newTexture->textureID);
+	BindTexture(0, newTexture->textureID, target);
 	CHECK_GL_ERROR("Failed creating texture a");
 	// set texture wrapping mode
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, newTexture->glWrapMode);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, newTexture->glWrapMode);
+	glTexParameteri(target, GL_TEXTURE_WRAP_S, newTexture->glWrapMode);
+	glTexParameteri(target, GL_TEXTURE_WRAP_T, newTexture->glWrapMode);
 
 	// set texture filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, newTexture->glMinFilter);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, newTexture->glMagFilter);
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, newTexture->glMinFilter);
+	glTexParameteri(target, GL_TEXTURE_MAG_FILTER, newTexture->glMagFilter);
 	CHECK_GL_ERROR("Failed creating textureb");
 	// anisotropic filtering
 	if (settings.anisoLevel > 0.0f)
 	{
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, settings.anisoLevel);
+		glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY_EXT, settings.anisoLevel);
 	}
 	CHECK_GL_ERROR("Failed tex params");
 	// upload initial texture data
@@ -420,34 +1086,92 @@ Texture* GL3Device::CreateTexture(uint8 *data, const TextureSettings &settings)
 	// determine number of mip map levels and upload initial texture data
 	int32 numLevels = !settings.mipMaps ? 1 : static_cast<int32>(ceil(log2(glm::max(settings.width, settings.height)))) + 1;
 
-	glTexStorage2D(GL_TEXTURE_2D, numLevels, newTexture->glInternalFormat, settings.width, settings.height);
-	CHECK_GL_ERROR("Failed storage");
-	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, settings.width, settings.height, newTexture->glFormat, newTexture->glType, data);
+	if (target == GL_TEXTURE_2D_ARRAY)
+	{
+		glTexStorage3D(target, numLevels, newTexture->glInternalFormat, settings.width, settings.height, settings.arraySize);
+		CHECK_GL_ERROR("Failed storage");
+
+		// an array can be created empty and filled a layer at a time with UpdateTextureLayer
+		if (data)
+		{
+			glTexSubImage3D(target, 0, 0, 0, 0, settings.width, settings.height, settings.arraySize, newTexture->glFormat, newTexture->glType, data);
+		}
+	}
+	else
+	{
+		glTexStorage2D(target, numLevels, newTexture->glInternalFormat, settings.width, settings.height);
+		CHECK_GL_ERROR("Failed storage");
+
+		if (data)
+		{
+			glTexSubImage2D(target, 0, 0, 0, settings.width, settings.height, newTexture->glFormat, newTexture->glType, data);
+		}
+	}
 	CHECK_GL_ERROR("Failed sub image");
 	// TODO : refactor so that GL3Texture is only created after succesfully making a GL texture
 	if (CHECK_GL_ERROR("Failed creating texture"))
 	{
+		DeleteTextureObjects(newTexture);
 		delete newTexture;
 		newTexture = nullptr;
 
 		// restore state
-		glBindTexture(GL_TEXTURE_2D, lastSampler);
+		BindTexture(0, lastTexture != GL3_UNKNOWN_BINDING ? lastTexture : 0, lastTarget);
 
 		return nullptr;
 	}
 
 	// generate mip maps if they are enabled in the texture settings
-	if (settings.mipMaps)
+	if (settings.mipMaps && data)
 	{
-		glGenerateMipmap(GL_TEXTURE_2D);
+		glGenerateMipmap(target);
 	}
 
 	// restore state
-	glBindTexture(GL_TEXTURE_2D, lastSampler);
+	BindTexture(0, lastTexture != GL3_UNKNOWN_BINDING ? lastTexture : 0, lastTarget);
+
+	if (data)
+	{
+		curFrameStats.bytesUploaded += settings.width * settings.height * settings.arraySize * 4;
+	}
 
 	return newTexture;
 }
 
+void GL3Device::UpdateTextureLayer(Texture* texture, uint32 layer, const uint8* data)
+{
+	GL3Texture* glTexture = static_cast<GL3Texture*>(texture);
+
+	DS_ASSERT(glTexture && data);
+	DS_ASSERT(layer < glTexture->arraySize); // layer must exist in the texture
+
+	GLuint lastTexture = stateCache.textureIDs[0];
+	GLenum lastTarget = stateCache.textureTargets[0];
+
+	BindTexture(0, glTexture->textureID, glTexture->glTarget);
+
+	if (glTexture->glTarget == GL_TEXTURE_2D_ARRAY)
+	{
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, glTexture->width, glTexture->height, 1, glTexture->glFormat, glTexture->glType, data);
+	}
+	else
+	{
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, glTexture->width, glTexture->height, glTexture->glFormat, glTexture->glType, data);
+	}
+
+	// the mip chain of every layer is rebuilt, only the updated layer has changed but GL has no per layer generate
+	if (glTexture->mipMaps)
+	{
+		glGenerateMipmap(glTexture->glTarget);
+	}
+
+	CHECK_GL_ERROR("Failed updating texture layer");
+
+	BindTexture(0, lastTexture != GL3_UNKNOWN_BINDING ? lastTexture : 0, lastTarget);
+
+	curFrameStats.bytesUploaded += glTexture->width * glTexture->height * 4;
+}
+
 void GL3Device::ReleaseTexture(Texture* pTexture)
 {
 	GL3Texture* glTexture = static_cast<GL3Texture*>(pTexture);
@@ -455,11 +1179,64 @@ void GL3Device::ReleaseTexture(Texture* pTexture)
 	if (glTexture == nullptr)
 		return;
 
-	glDeleteTextures(1, &glTexture->textureID);
+	if (glTexture->uploadPending)
+	{
+		for (auto upload = textureUploads.begin(); upload != textureUploads.end(); ++upload)
+		{
+			if (upload->texture == glTexture)
+			{
+				textureUploads.erase(upload);
+				break;
+			}
+		}
+	}
+
+	DeleteTextureObjects(glTexture);
 
 	delete glTexture;
 }
 
+Texture* GL3Device::CreateTextureAsync(const uint8* data, const TextureSettings &settings)
+{
+	uint32 rowBytes = settings.width * GetTexelSize(settings.format);
+
+	// compressed formats and rows too wide for a staging buffer are uploaded straight away
+	if (data == nullptr || rowBytes == 0 || rowBytes > GL3_STAGING_BUFFER_SIZE)
+		return CreateTexture(const_cast<uint8*>(data), settings);
+
+	// only the storage is allocated here, the texels are copied in by ProcessTextureUploads
+	GL3Texture* newTexture = static_cast<GL3Texture*>(CreateTexture(nullptr, settings));
+
+	if (newTexture == nullptr)
+		return nullptr;
+
+	newTexture->uploadPending = true;
+
+	TextureUploadGL3 upload;
+	upload.texture = newTexture;
+	upload.data.assign(data, data + rowBytes * settings.height * settings.arraySize);
+	upload.rowBytes = rowBytes;
+	upload.nextRow = 0;
+
+	textureUploads.push_back(std::move(upload));
+
+	return newTexture;
+}
+
+bool GL3Device::IsTextureReady(Texture* texture)
+{
+	GL3Texture* glTexture = static_cast<GL3Texture*>(texture);
+
+	return glTexture != nullptr && !glTexture->uploadPending;
+}
+
+void GL3Device::SetTextureUploadBudget(uint32 bytesPerFrame)
+{
+	DS_ASSERT(bytesPerFrame > 0); // uploads would never complete
+
+	textureUploadBudget = bytesPerFrame;
+}
+
 void GL3Device::SetUniformBuffer(uint32 slot, Buffer* buffer, ShaderStage stage)
 {
 	BufferGL3* gl3Buffer = static_cast<BufferGL3*>(buffer);
@@ -467,11 +1244,44 @@ void GL3Device::SetUniformBuffer(uint32 slot, Buffer* buffer, ShaderStage stage)
 	DS_ASSERT(gl3Buffer);									// gl3Buffer must not be null
 	DS_ASSERT(gl3Buffer->glTarget == GL_UNIFORM_BUFFER);	// must be uniform buffer
 
-	CHECK_GL(glBindBufferRange(GL_UNIFORM_BUFFER, slot, gl3Buffer->glID, 0, gl3Buffer->size));
+	// stream buffers bind the range holding the most recently written data
+	BindUniformBuffer(slot, gl3Buffer->glID, gl3Buffer->dataOffset, gl3Buffer->size);
+}
+
+void GL3Device::SetUniformBufferRange(uint32 slot, Buffer* buffer, uint32 offset, uint32 size, ShaderStage stage)
+{
+	BufferGL3* gl3Buffer = static_cast<BufferGL3*>(buffer);
+
+	DS_ASSERT(gl3Buffer);									// gl3Buffer must not be null
+	DS_ASSERT(gl3Buffer->glTarget == GL_UNIFORM_BUFFER);	// must be uniform buffer
+	DS_ASSERT(offset % uniformBufferAlignment == 0);		// offset must be aligned
+	DS_ASSERT(offset + size <= gl3Buffer->size);			// range must lie inside the buffer
+
+	// stream buffers hold their most recent data at an offset in to the GL buffer
+	BindUniformBuffer(slot, gl3Buffer->glID, gl3Buffer->dataOffset + offset, size);
+}
+
+uint32 GL3Device::GetUniformBufferAlignment()
+{
+	return static_cast<uint32>(uniformBufferAlignment);
 }
 
 BufferGL3* GL3Device::CreateBuffer(const void* data, uint32 size, BufferTarget target, BufferUsage usage)
 {
+	if (usage == BufferUsage::Stream)
+	{
+		// uniform data has to be bound at aligned offsets, other data only needs to keep 4 byte alignment
+		uint32 alignment = (target == BufferTarget::Uniform) ? uniformBufferAlignment : 4;
+		BufferGL3* streamBuffer = CreateStreamBuffer(size, alignment, target);
+
+		if (data)
+		{
+			UpdateBuffer(streamBuffer, data, size);
+		}
+
+		return streamBuffer;
+	}
+
 	// generate new buffer
 	GLuint glBuffer;
 	glGenBuffers(1, &glBuffer);
@@ -480,27 +1290,37 @@ BufferGL3* GL3Device::CreateBuffer(const void* data, uint32 size, BufferTarget t
 	GLenum glUsage = GL3UsageMap[static_cast<int32>(usage)];
 	GLenum glTarget = GL3TargetMap[static_cast<int32>(target)];
 
-	CHECK_GL(glBindBuffer(glTarget, glBuffer));
+	// buffers are filled through the copy write target, binding to glTarget could modify the bound VAO
+	BindBuffer(GL3BufferBinding::CopyWrite, glBuffer);
 
 	// check if passed data is null
 	if (data)
 	{
 		// create the new buffer with initial data
-		CHECK_GL(glBufferData(glTarget, size, data, glUsage));
+		CHECK_GL(glBufferData(GL_COPY_WRITE_BUFFER, size, data, glUsage));
+		curFrameStats.bytesUploaded += size;
 	}
 	else
 	{
 		// if no data was passed create uninitialized buffer with the given size
-		CHECK_GL(glBufferData(glTarget, size, NULL, glUsage));
+		CHECK_GL(glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, glUsage));
 	}
 
-	// glBindBuffer(glTarget, 0);
-
 	return new BufferGL3(glBuffer, glUsage, glTarget, size, usage);
 }
 
 BufferGL3* GL3Device::CreateBuffer(const std::vector<BufferData> &data, uint32 dataCount, uint32 bufferSize, BufferTarget target, BufferUsage usage)
 {
+	if (usage == BufferUsage::Stream)
+	{
+		uint32 alignment = (target == BufferTarget::Uniform) ? uniformBufferAlignment : 4;
+		BufferGL3* streamBuffer = CreateStreamBuffer(bufferSize, alignment, target);
+
+		UpdateBuffer(streamBuffer, data, dataCount, bufferSize);
+
+		return streamBuffer;
+	}
+
 	// generate new buffer
 	GLuint glBuffer;
 	glGenBuffers(1, &glBuffer);
@@ -509,28 +1329,29 @@ BufferGL3* GL3Device::CreateBuffer(const std::vector<BufferData> &data, uint32 d
 	GLenum glUsage = GL3UsageMap[static_cast<int32>(usage)];
 	GLenum glTarget = GL3TargetMap[static_cast<int32>(target)];
 
-	CHECK_GL(glBindBuffer(glTarget, glBuffer));
+	// buffers are filled through the copy write target, binding to glTarget could modify the bound VAO
+	BindBuffer(GL3BufferBinding::CopyWrite, glBuffer);
 
 	// if we only have one BufferData, or if the mesh is static copy one chunk of data
 	if (usage == BufferUsage::Static || dataCount == 1)
 	{
-		CHECK_GL(glBufferData(glTarget, bufferSize, data[0].pData, glUsage));
+		CHECK_GL(glBufferData(GL_COPY_WRITE_BUFFER, bufferSize, data[0].pData, glUsage));
 	}
 	else
 	{
 		// Create buffer with unitialized data with the required size
-		CHECK_GL(glBufferData(glTarget, bufferSize, NULL, glUsage));
+		CHECK_GL(glBufferData(GL_COPY_WRITE_BUFFER, bufferSize, NULL, glUsage));
 
 		// copy data from each BufferData object in to our new buffer
 		uint32 bufferOffset = 0;
 		for (uint32 md = 0; md < dataCount; md++)
 		{
-			CHECK_GL(glBufferSubData(glTarget, bufferOffset, data[md].sizeBytes, data[md].pData));
+			CHECK_GL(glBufferSubData(GL_COPY_WRITE_BUFFER, bufferOffset, data[md].sizeBytes, data[md].pData));
 			bufferOffset += data[md].sizeBytes;
 		}
 	}
 
-	// glBindBuffer(glTarget, 0);
+	curFrameStats.bytesUploaded += bufferSize;
 
 	return new BufferGL3(glBuffer, glUsage, glTarget, bufferSize, usage);
 }
@@ -542,21 +1363,46 @@ void GL3Device::UpdateBuffer(Buffer* buffer, const void* data, uint32 size)
 	DS_ASSERT(gl3Buffer);								// gl3Buffer must not be null
 	DS_ASSERT(gl3Buffer->usage != BufferUsage::Static);	// Static buffers should not be modified
 
-	CHECK_GL(glBindBuffer(gl3Buffer->glTarget, gl3Buffer->glID));
+	if (gl3Buffer->usage == BufferUsage::Stream)
+	{
+		// nothing to write, a zero sized range can not be mapped
+		if (size == 0)
+			return;
+
+		uint8* dest = BeginStreamWrite(gl3Buffer, size);
+
+		if (dest == nullptr)
+		{
+			LOG_GL_ERROR("Failed mapping stream buffer");
+			return;
+		}
+
+		memcpy(dest, data, size);
+
+		EndStreamWrite(gl3Buffer);
+		OnStreamBufferWritten(gl3Buffer);
+
+		curFrameStats.bufferUpdates++;
+		curFrameStats.bytesUploaded += size;
+		return;
+	}
+
+	BindBuffer(GL3BufferBinding::CopyWrite, gl3Buffer->glID);
 
 	// if the buffer is too small to fit the new data reallocate the buffer to the required size
 	// otherwise copy data in to current buffer
 	if (size > gl3Buffer->size)
 	{
-		CHECK_GL(glBufferData(gl3Buffer->glTarget, size, data, gl3Buffer->glUsage));
+		CHECK_GL(glBufferData(GL_COPY_WRITE_BUFFER, size, data, gl3Buffer->glUsage));
 		gl3Buffer->size = size;
 	}
 	else
 	{
-		CHECK_GL(glBufferSubData(gl3Buffer->glTarget, 0, size, data));
+		CHECK_GL(glBufferSubData(GL_COPY_WRITE_BUFFER, 0, size, data));
 	}
 
-	glBindBuffer(gl3Buffer->glTarget, 0);
+	curFrameStats.bufferUpdates++;
+	curFrameStats.bytesUploaded += size;
 }
 
 void GL3Device::UpdateBuffer(Buffer* buffer, const std::vector<BufferData> &data, uint32 dataCount, uint32 bufferSize)
@@ -566,12 +1412,43 @@ void GL3Device::UpdateBuffer(Buffer* buffer, const std::vector<BufferData> &data
 	DS_ASSERT(gl3Buffer);								// gl3Buffer must not be null
 	DS_ASSERT(gl3Buffer->usage != BufferUsage::Static);	// Static buffers should not be modified
 
-	CHECK_GL(glBindBuffer(gl3Buffer->glTarget, gl3Buffer->glID));
+	if (gl3Buffer->usage == BufferUsage::Stream)
+	{
+		if (bufferSize == 0)
+			return;
+
+		uint8* dest = BeginStreamWrite(gl3Buffer, bufferSize);
+
+		if (dest == nullptr)
+		{
+			LOG_GL_ERROR("Failed mapping stream buffer");
+			return;
+		}
+
+		// scatter each BufferData directly in to the buffer, no intermediate copy is made
+		uint32 bufferOffset = 0;
+		for (uint32 md = 0; md < dataCount; md++)
+		{
+			DS_ASSERT(bufferOffset + data[md].sizeBytes <= bufferSize);
+
+			memcpy(dest + bufferOffset, data[md].pData, data[md].sizeBytes);
+			bufferOffset += data[md].sizeBytes;
+		}
+
+		EndStreamWrite(gl3Buffer);
+		OnStreamBufferWritten(gl3Buffer);
+
+		curFrameStats.bufferUpdates++;
+		curFrameStats.bytesUploaded += bufferOffset;
+		return;
+	}
+
+	BindBuffer(GL3BufferBinding::CopyWrite, gl3Buffer->glID);
 
 	// Expand buffer if it is not big enough to fit the new data
 	if (bufferSize > gl3Buffer->size)
 	{
-		CHECK_GL(glBufferData(gl3Buffer->glTarget, bufferSize, NULL, gl3Buffer->glUsage));
+		CHECK_GL(glBufferData(GL_COPY_WRITE_BUFFER, bufferSize, NULL, gl3Buffer->glUsage));
 		gl3Buffer->size = bufferSize;
 	}
 
@@ -579,11 +1456,36 @@ void GL3Device::UpdateBuffer(Buffer* buffer, const std::vector<BufferData> &data
 	uint32 bufferOffset = 0;
 	for (uint32 md = 0; md < dataCount; md++)
 	{
-		CHECK_GL(glBufferSubData(gl3Buffer->glTarget, bufferOffset, data[md].sizeBytes, data[md].pData));
+		CHECK_GL(glBufferSubData(GL_COPY_WRITE_BUFFER, bufferOffset, data[md].sizeBytes, data[md].pData));
 		bufferOffset += data[md].sizeBytes;
 	}
 
-	glBindBuffer(gl3Buffer->glTarget, 0);
+	curFrameStats.bufferUpdates++;
+	curFrameStats.bytesUploaded += bufferOffset;
+}
+
+void GL3Device::UpdateBufferRegion(Buffer* buffer, const void* data, uint32 offset, uint32 size)
+{
+	BufferGL3* gl3Buffer = static_cast<BufferGL3*>(buffer);
+
+	DS_ASSERT(gl3Buffer);								// gl3Buffer must not be null
+	DS_ASSERT(gl3Buffer->usage != BufferUsage::Static);	// Static buffers should not be modified
+	DS_ASSERT(offset + size <= gl3Buffer->size);		// region must lie inside the buffer
+
+	if (gl3Buffer->usage == BufferUsage::Stream)
+	{
+		LOG_ERROR("UpdateBufferRegion can not be used on stream buffers, use UpdateBuffer");
+		return;
+	}
+
+	if (size == 0)
+		return;
+
+	BindBuffer(GL3BufferBinding::CopyWrite, gl3Buffer->glID);
+	CHECK_GL(glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data));
+
+	curFrameStats.bufferUpdates++;
+	curFrameStats.bytesUploaded += size;
 }
 
 void GL3Device::ReleaseBuffer(Buffer* buffer)
@@ -592,53 +1494,534 @@ void GL3Device::ReleaseBuffer(Buffer* buffer)
 
 	DS_ASSERT(gl3Buffer); // gl3Buffer must not be null
 
-	CHECK_GL(glDeleteBuffers(1, &gl3Buffer->glID));
+	DeleteBufferObjects(gl3Buffer);
+
 	delete buffer;
 }
 
-void GL3Device::SetScissorRects(uint32 numRects, const DSRect* pRects)
+MeshHandle GL3Device::CreateMeshHandle(const MeshData &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage)
 {
-	if (pRects)
-	{
-		glScissor(pRects[0].left,
-				  renderInfo.resolutionY - pRects[0].bottom,
-				  pRects[0].right - pRects[0].left,
-				  pRects[0].bottom - pRects[0].top);
-	}
+	MeshGL3* newMesh = static_cast<MeshGL3*>(CreateMesh(meshData, vertexAttributeFlags, usage));
+
+	if (newMesh == nullptr)
+		return MeshHandle();
+
+	// the GL objects now belong to the copy held by the container
+	MeshHandle handle = meshes.CreateResource(*newMesh);
+	delete newMesh;
+
+	return handle;
 }
 
-void GL3Device::GetScissorRects(uint32* pNumRects, DSRect* pRects)
+void GL3Device::UpdateMesh(MeshHandle mesh, const MeshData &meshData)
 {
-	GLint box[4];
-	glGetIntegerv(GL_SCISSOR_BOX, box);
+	MeshGL3* glMesh;
+	RESOLVE_HANDLE(glMesh, meshes, mesh);
 
-	GLint x = box[0];
-	GLint y = box[1];
-	GLint width = box[2];
-	GLint height = box[3];
+	UpdateMesh(glMesh, meshData);
+}
+
+void GL3Device::DrawMeshIndexed(MeshHandle mesh, uint32 elementCount, uint32 vertexOffset, uint32 indexOffset)
+{
+	MeshGL3* glMesh;
+	RESOLVE_HANDLE(glMesh, meshes, mesh);
+
+	DrawMeshIndexed(glMesh, elementCount, vertexOffset, indexOffset);
+}
+
+void GL3Device::ReleaseMesh(MeshHandle mesh)
+{
+	MeshGL3* glMesh;
+	RESOLVE_HANDLE(glMesh, meshes, mesh);
+
+	DeleteMeshObjects(glMesh);
+	meshes.ReleaseResource(mesh);
+}
+
+ShaderHandle GL3Device::CreateShaderHandle(const std::string &name)
+{
+	GL3Shader* newShader = CompileShader(name, ShaderFeatures::None);
+
+	if (newShader == nullptr)
+		return ShaderHandle();
+
+	ShaderHandle handle = shaders.CreateResource(*newShader);
+	delete newShader;
+
+	return handle;
+}
+
+void GL3Device::SetShader(ShaderHandle shader)
+{
+	GL3Shader* gl3Shader;
+	RESOLVE_HANDLE(gl3Shader, shaders, shader);
+
+	curShader = nullptr;
+	BindProgram(gl3Shader->programID);
+}
+
+void GL3Device::ReleaseShader(ShaderHandle shader)
+{
+	GL3Shader* gl3Shader;
+	RESOLVE_HANDLE(gl3Shader, shaders, shader);
+
+	DeleteShaderObjects(gl3Shader);
+	shaders.ReleaseResource(shader);
+}
+
+TextureHandle GL3Device::CreateTextureHandle(uint8 *data, const TextureSettings &settings)
+{
+	GL3Texture* newTexture = static_cast<GL3Texture*>(CreateTexture(data, settings));
+
+	if (newTexture == nullptr)
+		return TextureHandle();
+
+	TextureHandle handle = textures.CreateResource(*newTexture);
+	delete newTexture;
+
+	return handle;
+}
+
+void GL3Device::SetTexture(TextureHandle texture, uint32 slot)
+{
+	GL3Texture* glTexture;
+	RESOLVE_HANDLE(glTexture, textures, texture);
+
+	BindTexture(slot, glTexture->textureID, glTexture->glTarget);
+}
+
+void GL3Device::ReleaseTexture(TextureHandle texture)
+{
+	GL3Texture* glTexture;
+	RESOLVE_HANDLE(glTexture, textures, texture);
+
+	DeleteTextureObjects(glTexture);
+	textures.ReleaseResource(texture);
+}
+
+BufferHandle GL3Device::CreateBufferHandle(const void* data, uint32 size, BufferTarget target, BufferUsage usage)
+{
+	BufferGL3* newBuffer = CreateBuffer(data, size, target, usage);
+
+	if (newBuffer == nullptr)
+		return BufferHandle();
+
+	BufferHandle handle = buffers.CreateResource(*newBuffer);
+	delete newBuffer;
+
+	return handle;
+}
+
+void GL3Device::UpdateBuffer(BufferHandle buffer, const void* data, uint32 size)
+{
+	BufferGL3* gl3Buffer;
+	RESOLVE_HANDLE(gl3Buffer, buffers, buffer);
+
+	UpdateBuffer(gl3Buffer, data, size);
+}
+
+void GL3Device::UpdateBufferRegion(BufferHandle buffer, const void* data, uint32 offset, uint32 size)
+{
+	BufferGL3* gl3Buffer;
+	RESOLVE_HANDLE(gl3Buffer, buffers, buffer);
+
+	UpdateBufferRegion(gl3Buffer, data, offset, size);
+}
+
+void GL3Device::SetUniformBuffer(uint32 slot, BufferHandle buffer, ShaderStage stage)
+{
+	BufferGL3* gl3Buffer;
+	RESOLVE_HANDLE(gl3Buffer, buffers, buffer);
+
+	SetUniformBuffer(slot, gl3Buffer, stage);
+}
+
+void GL3Device::ReleaseBuffer(BufferHandle buffer)
+{
+	BufferGL3* gl3Buffer;
+	RESOLVE_HANDLE(gl3Buffer, buffers, buffer);
+
+	DeleteBufferObjects(gl3Buffer);
+	buffers.ReleaseResource(buffer);
+}
+
+RenderTarget* GL3Device::CreateRenderTarget(const RenderTargetDesc &desc)
+{
+	CHECK_GL_ERROR("No Render Target Error");
+
+	GL3RenderTarget* newTarget = new GL3RenderTarget(desc);
+	const RenderTargetFormatGL3 &glFormat = GL3RenderTargetFormatMap[static_cast<int32>(desc.format)];
+
+	if (desc.sampleCount > 1)
+	{
+		GLsizei samples = glm::min(static_cast<GLint>(desc.sampleCount), maxSamples);
+
+		glGenRenderbuffers(1, &newTarget->renderbufferID);
+		glBindRenderbuffer(GL_RENDERBUFFER, newTarget->renderbufferID);
+		glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, glFormat.internalFormat, desc.width, desc.height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	}
+	else
+	{
+		GL3Texture &texture = newTarget->sampleTexture;
+
+		glGenTextures(1, &texture.textureID);
+
+		// save the texture bound to unit 0 before modifying it, restoring it leaves the cache valid
+		GLuint lastTexture = stateCache.textureIDs[0];
+		GLenum lastTarget = stateCache.textureTargets[0];
+
+		BindTexture(0, texture.textureID);
+
+		// depth is not filtered
+		GLint filter = IsDepthFormat(desc.format) ? GL_NEAREST : GL_LINEAR;
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+
+		glTexStorage2D(GL_TEXTURE_2D, 1, glFormat.internalFormat, desc.width, desc.height);
+
+		BindTexture(0, lastTexture != GL3_UNKNOWN_BINDING ? lastTexture : 0, lastTarget);
+	}
+
+	if (CHECK_GL_ERROR("Failed creating render target"))
+	{
+		ReleaseRenderTarget(newTarget);
+		return nullptr;
+	}
+
+	return newTarget;
+}
+
+void GL3Device::ReleaseRenderTarget(RenderTarget* target)
+{
+	GL3RenderTarget* glTarget = static_cast<GL3RenderTarget*>(target);
+
+	if (glTarget == nullptr)
+		return;
+
+	// every framebuffer the target is attached to goes with it, the back buffer is bound if one of them was in use
+	for (uint32 f = 0; f < framebuffers.size();)
+	{
+		if (framebuffers[f].Uses(glTarget))
+		{
+			if (curFramebufferID == framebuffers[f].framebufferID)
+			{
+				curFramebufferID = backBufferFramebufferID;
+				curTargetHeight = 0;
+			}
+
+			glDeleteFramebuffers(1, &framebuffers[f].framebufferID);
+			OnFramebufferDeleted(framebuffers[f].framebufferID);
+
+			framebuffers[f] = framebuffers.back();
+			framebuffers.pop_back();
+		}
+		else
+		{
+			f++;
+		}
+	}
+
+	BindFramebuffer(curFramebufferID);
+
+	if (glTarget->renderbufferID)
+	{
+		glDeleteRenderbuffers(1, &glTarget->renderbufferID);
+	}
+
+	if (glTarget->sampleTexture.textureID)
+	{
+		DeleteTextureObjects(&glTarget->sampleTexture);
+	}
+
+	delete glTarget;
+}
+
+void GL3Device::SetRenderTargets(uint32 numColorTargets, RenderTarget* const* pColorTargets, RenderTarget* depthTarget)
+{
+	DS_ASSERT(numColorTargets <= DS_MAX_RENDER_TARGETS);
+
+	if (numColorTargets == 0 && depthTarget == nullptr)
+	{
+		curFramebufferID = backBufferFramebufferID;
+		curTargetHeight = 0;
+	}
+	else
+	{
+		GLuint framebufferID = GetFramebuffer(numColorTargets, reinterpret_cast<GL3RenderTarget* const*>(pColorTargets),
+											  static_cast<GL3RenderTarget*>(depthTarget));
+
+		if (framebufferID == 0)
+			return;
+
+		curFramebufferID = framebufferID;
+		curTargetHeight = (numColorTargets > 0) ? pColorTargets[0]->GetDesc().height : depthTarget->GetDesc().height;
+	}
+
+	BindFramebuffer(curFramebufferID);
+}
+
+void GL3Device::ClearRenderTarget(RenderTarget* target, const vec4 &color, float depth, uint8 stencil)
+{
+	GL3RenderTarget* glTarget = static_cast<GL3RenderTarget*>(target);
+
+	if (glTarget == nullptr)
+		return;
+
+	bool isDepth = IsDepthFormat(glTarget->GetDesc().format);
+
+	GLuint framebufferID = isDepth ? GetFramebuffer(0, nullptr, glTarget) : GetFramebuffer(1, &glTarget, nullptr);
+
+	if (framebufferID == 0)
+		return;
+
+	BindFramebuffer(framebufferID);
+
+	// clears are limited by the scissor test and write masks, the whole target is cleared regardless of them
+	bool scissorEnabled = stateCache.capabilities[static_cast<int32>(GL3Capability::ScissorTest)] == 1;
+	SetCapability(GL3Capability::ScissorTest, false);
+
+	if (isDepth)
+	{
+		glDepthMask(GL_TRUE);
+		glStencilMask(0xFF);
+
+		if (glTarget->GetDesc().format == RenderTargetFormat::Depth24Stencil8)
+		{
+			glClearBufferfi(GL_DEPTH_STENCIL, 0, depth, stencil);
+		}
+		else
+		{
+			glClearBufferfv(GL_DEPTH, 0, &depth);
+		}
+
+		// masks are restored to the current depth/stencil state
+		glDepthMask(curDepthStencilState ? curDepthStencilState->glDepthWrite : GL_TRUE);
+		glStencilMask(curDepthStencilState ? curDepthStencilState->glStencilWriteMask : 0xFF);
+	}
+	else
+	{
+		uint32 colorMask = stateCache.colorMask;
+		SetColorMask(ToIntegral(ColorMask::All));
+
+		// glClearBuffer leaves the clear color set with SetClearColor untouched
+		glClearBufferfv(GL_COLOR, 0, &color[0]);
+
+		if (colorMask != GL3_UNKNOWN_BINDING)
+		{
+			SetColorMask(colorMask);
+		}
+	}
+
+	SetCapability(GL3Capability::ScissorTest, scissorEnabled);
+	BindFramebuffer(curFramebufferID);
+}
+
+void GL3Device::ResolveRenderTarget(RenderTarget* source, RenderTarget* destination)
+{
+	GL3RenderTarget* glSource = static_cast<GL3RenderTarget*>(source);
+	GL3RenderTarget* glDestination = static_cast<GL3RenderTarget*>(destination);
+
+	if (glSource == nullptr || glDestination == nullptr)
+		return;
+
+	const RenderTargetDesc &desc = glSource->GetDesc();
+	bool isDepth = IsDepthFormat(desc.format);
+
+	GLuint readFramebufferID = isDepth ? GetFramebuffer(0, nullptr, glSource) : GetFramebuffer(1, &glSource, nullptr);
+	GLuint drawFramebufferID = isDepth ? GetFramebuffer(0, nullptr, glDestination) : GetFramebuffer(1, &glDestination, nullptr);
+
+	if (readFramebufferID == 0 || drawFramebufferID == 0)
+		return;
+
+	// the blit is limited by the scissor test
+	bool scissorEnabled = stateCache.capabilities[static_cast<int32>(GL3Capability::ScissorTest)] == 1;
+	SetCapability(GL3Capability::ScissorTest, false);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebufferID);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebufferID);
+
+	glBlitFramebuffer(0, 0, desc.width, desc.height, 0, 0, desc.width, desc.height,
+					  isDepth ? (GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT) : GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+	CHECK_GL_ERROR("Failed resolving render target");
+
+	// the read and draw bindings now differ, the cached framebuffer no longer describes either of them
+	stateCache.framebufferID = GL3_UNKNOWN_BINDING;
+	BindFramebuffer(curFramebufferID);
+
+	SetCapability(GL3Capability::ScissorTest, scissorEnabled);
+}
+
+void GL3Device::RequestReadback(RenderTarget* target, ReadbackCallback callback)
+{
+	GL3RenderTarget* glTarget = static_cast<GL3RenderTarget*>(target);
+
+	GLuint framebufferID = backBufferFramebufferID;
+	uint32 width = renderInfo.resolutionX;
+	uint32 height = renderInfo.resolutionY;
+
+	if (glTarget)
+	{
+		const RenderTargetDesc &desc = glTarget->GetDesc();
+
+		if (desc.format != RenderTargetFormat::RGBA8 || desc.sampleCount > 1)
+		{
+			LOG_ERROR("Readback requires a single sampled RGBA8 target");
+			return;
+		}
+
+		framebufferID = GetFramebuffer(1, &glTarget, nullptr);
+		width = desc.width;
+		height = desc.height;
+
+		if (framebufferID == 0)
+			return;
+	}
+
+	if (pendingReadbacks == GL3_READBACK_BUFFER_COUNT)
+	{
+		LOG_WARNING("All %u readbacks are in flight, waiting on the oldest", GL3_READBACK_BUFFER_COUNT);
+		CompleteReadbacks(true);
+	}
+
+	ReadbackGL3 &readback = readbacks[nextReadback];
+	uint32 size = width * height * 4;
+
+	if (readback.bufferID == 0)
+	{
+		glGenBuffers(1, &readback.bufferID);
+	}
+
+	BindBuffer(GL3BufferBinding::PixelPack, readback.bufferID);
+
+	if (readback.bufferSize < size)
+	{
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+		readback.bufferSize = size;
+	}
+
+	// with a pixel pack buffer bound the copy is queued on the GPU and glReadPixels returns straight away
+	BindFramebuffer(framebufferID);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	BindFramebuffer(curFramebufferID);
+
+	BindBuffer(GL3BufferBinding::PixelPack, 0);
+
+	CHECK_GL_ERROR("Failed requesting readback");
+
+	readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readback.width = width;
+	readback.height = height;
+	readback.callback = std::move(callback);
+
+	nextReadback = (nextReadback + 1) % GL3_READBACK_BUFFER_COUNT;
+	pendingReadbacks++;
+}
+
+void GL3Device::SetScissorRects(uint32 numRects, const DSRect* pRects)
+{
+	if (pRects)
+	{
+		SetScissorBox(pRects[0].left,
+					  GetTargetHeight() - pRects[0].bottom,
+					  pRects[0].right - pRects[0].left,
+					  pRects[0].bottom - pRects[0].top);
+	}
+}
+
+void GL3Device::GetScissorRects(uint32* pNumRects, DSRect* pRects)
+{
+	// read the cached box when it is known, querying GL would stall on the driver
+	GLint box[4];
+
+	if (stateCache.scissorBox[0] == -1)
+	{
+		glGetIntegerv(GL_SCISSOR_BOX, box);
+	}
+	else
+	{
+		memcpy(box, stateCache.scissorBox, sizeof(box));
+	}
+
+	GLint x = box[0];
+	GLint y = box[1];
+	GLint width = box[2];
+	GLint height = box[3];
 
 	if (pNumRects)
 		*pNumRects = 1;
 
+	// convert from GL's bottom left origin back to the top left origin used by DSRect
 	if (pRects)
 	{
-		pRects[0] = DSRect(x, y, x + width, y + height);
+		GLint targetHeight = GetTargetHeight();
+		pRects[0] = DSRect(x, targetHeight - (y + height), x + width, targetHeight - y);
 	}
 }
 
 BlendState* GL3Device::CreateBlendState(BlendProperties properties)
 {
-	return nullptr;
+	// return the existing state if one was already created with the same properties
+	uint32 key = properties.CalculateKey();
+	BlendStateGL3* state = blendStates.Find(key, properties);
+
+	if (state != nullptr)
+		return state;
+
+	state = new BlendStateGL3();
+	state->properties = properties;
+
+	state->glSrcBlend = GET_GL3_BLEND(properties.srcBlend);
+	state->glDstBlend = GET_GL3_BLEND(properties.dstBlend);
+	state->glBlendOp = GET_GL3_BLEND_OP(properties.blendOp);
+	state->glSrcBlendAlpha = GET_GL3_BLEND(properties.srcBlendAlpha);
+	state->glDstBlendAlpha = GET_GL3_BLEND(properties.dstBlendAlpha);
+	state->glBlendOpAlpha = GET_GL3_BLEND_OP(properties.blendOpAlpha);
+
+	curFrameStats.resourcesCreated++;
+
+	return blendStates.Add(key, properties, state);
 }
 
 void GL3Device::SetBlendState(BlendState* state)
 {
+	BlendStateGL3* gl3State = static_cast<BlendStateGL3*>(state);
+
+	if (state == nullptr)
+	{
+		SetBlendState(defaultBlendState);
+		return;
+	}
+
+	// states are unique per descriptor, the same pointer means the same state
+	if (curBlendState == gl3State)
+	{
+		curFrameStats.stateChangesElided++;
+		return;
+	}
+
+	SetCapability(GL3Capability::Blend, gl3State->properties.enabled);
+	SetBlendEquation(gl3State->glBlendOp, gl3State->glBlendOpAlpha);
+	SetBlendFunc(gl3State->glSrcBlend, gl3State->glDstBlend, gl3State->glSrcBlendAlpha, gl3State->glDstBlendAlpha);
+	SetColorMask(gl3State->properties.colorMask);
 
+	curBlendState = gl3State;
 }
 
 DepthStencilStateGL3* GL3Device::CreateDepthStencilState(DepthStencilStateDesc& desc)
 {
-	DepthStencilStateGL3* state = new DepthStencilStateGL3();
+	// return the existing state if one was already created with the same descriptor
+	uint32 key = desc.CalculateKey();
+	DepthStencilStateGL3* state = depthStencilStates.Find(key, desc);
+
+	if (state != nullptr)
+		return state;
+
+	state = new DepthStencilStateGL3();
 
 	state->depthEnabled = desc.depthEnabled;
 	state->glDepthWrite = static_cast<GLboolean>(desc.depthWriteEnabled);
@@ -658,7 +2041,11 @@ DepthStencilStateGL3* GL3Device::CreateDepthStencilState(DepthStencilStateDesc&
 	state->backFace.glDepthFailOp = GET_GL3_STENCIL_OP(desc.backFace.depthFailOp);
 	state->backFace.glFunc = GET_GL3_COMPARISON(desc.backFace.stencilFunc);
 
-	return state;
+	state->desc = desc;
+
+	curFrameStats.resourcesCreated++;
+
+	return depthStencilStates.Add(key, desc, state);
 }
 
 DepthStencilState* GL3Device::GetCurrentDepthStencilState()
@@ -679,48 +2066,24 @@ void GL3Device::SetDepthStencilState(DepthStencilState* state)
 	// TODO : think of a better way of doing this
 	if (curDepthStencilState == nullptr)
 	{
-		if (gl3State->depthEnabled)
-		{
-			glEnable(GL_DEPTH_TEST);
-		}
-		else
-		{
-			glDisable(GL_DEPTH_TEST);
-		}
+		SetCapability(GL3Capability::DepthTest, gl3State->depthEnabled);
 
 		glDepthMask(gl3State->glDepthWrite);
 		CHECK_GL(glDepthFunc(gl3State->glDepthComparison));
 
-		if (gl3State->stencilEnabled)
-		{
-			glEnable(GL_STENCIL_TEST);
-		}
-		else
-		{
-			glDisable(GL_STENCIL_TEST);
-		}
+		SetCapability(GL3Capability::StencilTest, gl3State->stencilEnabled);
 
-		glStencilMask(gl3State->glStencilReadMask);
+		glStencilMask(gl3State->glStencilWriteMask);
 		CHECK_GL(glStencilOpSeparate(GL_FRONT, gl3State->frontFace.glStencilFailOp, gl3State->frontFace.glDepthFailOp, gl3State->frontFace.glStencilPassOp));
 		CHECK_GL(glStencilOpSeparate(GL_BACK, gl3State->backFace.glStencilFailOp, gl3State->backFace.glDepthFailOp, gl3State->backFace.glStencilPassOp));
 		CHECK_GL(glStencilFuncSeparate(GL_FRONT, gl3State->frontFace.glFunc, 0, gl3State->glStencilReadMask));
-		CHECK_GL(glStencilFuncSeparate(GL_FRONT, gl3State->backFace.glFunc, 0, gl3State->glStencilReadMask));
+		CHECK_GL(glStencilFuncSeparate(GL_BACK, gl3State->backFace.glFunc, 0, gl3State->glStencilReadMask));
 	}
 	else if (curDepthStencilState != gl3State)
 	{
 		// Depth State
-		// check if depth testing state has changed
-		if (curDepthStencilState->depthEnabled != gl3State->depthEnabled)
-		{
-			if (gl3State->depthEnabled)
-			{
-				glEnable(GL_DEPTH_TEST);
-			}
-			else
-			{
-				glDisable(GL_DEPTH_TEST);
-			}
-		}
+		// depth and stencil testing are compared against the cache, they can be toggled outside of depth/stencil states
+		SetCapability(GL3Capability::DepthTest, gl3State->depthEnabled);
 
 		// check if depth writing state has changed
 		if (curDepthStencilState->glDepthWrite != gl3State->glDepthWrite)
@@ -735,23 +2098,12 @@ void GL3Device::SetDepthStencilState(DepthStencilState* state)
 		}
 
 		// Stencil State
-		// check if stencil testing state has changed
-		if (curDepthStencilState->stencilEnabled != gl3State->stencilEnabled)
-		{
-			if (gl3State->stencilEnabled)
-			{
-				glEnable(GL_STENCIL_TEST);
-			}
-			else
-			{
-				glDisable(GL_STENCIL_TEST);
-			}
-		}
+		SetCapability(GL3Capability::StencilTest, gl3State->stencilEnabled);
 
 		// check if stencil write mask has changed
 		if (curDepthStencilState->glStencilWriteMask != gl3State->glStencilWriteMask)
 		{
-			glStencilMask(gl3State->glStencilReadMask);
+			glStencilMask(gl3State->glStencilWriteMask);
 		}
 
 		// check if the stencil operation has changed for the front face
@@ -786,9 +2138,95 @@ void GL3Device::SetDepthStencilState(DepthStencilState* state)
 		{
 			CHECK_GL(glStencilFuncSeparate(GL_BACK, gl3State->backFace.glFunc, 0, gl3State->glStencilReadMask));
 		}
-	}
 
-	curDepthStencilState = gl3State;
+		curFrameStats.stateChanges++;
+	}
+	else
+	{
+		curFrameStats.stateChangesElided++;
+	}
+
+	curDepthStencilState = gl3State;
+}
+
+RasterizerState* GL3Device::CreateRasterizerState(const RasterizerStateDesc &desc)
+{
+	// return the existing state if one was already created with the same descriptor
+	uint32 key = desc.CalculateKey();
+	RasterizerStateGL3* state = rasterizerStates.Find(key, desc);
+
+	if (state != nullptr)
+		return state;
+
+	state = new RasterizerStateGL3();
+	state->desc = desc;
+
+	state->cullEnabled = desc.cullMode != CullMode::None;
+	state->glCullFace = (desc.cullMode == CullMode::Front) ? GL_FRONT : GL_BACK;
+	state->glFrontFace = desc.frontCounterClockwise ? GL_CCW : GL_CW;
+	state->glPolygonMode = GL3FillModeMap[static_cast<int32>(desc.fillMode)];
+
+	curFrameStats.resourcesCreated++;
+
+	return rasterizerStates.Add(key, desc, state);
+}
+
+void GL3Device::SetRasterizerState(RasterizerState* state)
+{
+	RasterizerStateGL3* gl3State = static_cast<RasterizerStateGL3*>(state);
+
+	if (state == nullptr)
+	{
+		SetRasterizerState(defaultRasterizerState);
+		return;
+	}
+
+	if (curRasterizerState == gl3State)
+	{
+		curFrameStats.stateChangesElided++;
+		return;
+	}
+
+	const RasterizerStateDesc &desc = gl3State->desc;
+
+	SetCapability(GL3Capability::CullFace, gl3State->cullEnabled);
+	SetCapability(GL3Capability::ScissorTest, desc.scissorEnabled);
+
+	// only send the values that differ from the current state
+	if (curRasterizerState == nullptr || curRasterizerState->glCullFace != gl3State->glCullFace)
+	{
+		CHECK_GL(glCullFace(gl3State->glCullFace));
+	}
+
+	if (curRasterizerState == nullptr || curRasterizerState->glFrontFace != gl3State->glFrontFace)
+	{
+		CHECK_GL(glFrontFace(gl3State->glFrontFace));
+	}
+
+	if (curRasterizerState == nullptr || curRasterizerState->glPolygonMode != gl3State->glPolygonMode)
+	{
+		CHECK_GL(glPolygonMode(GL_FRONT_AND_BACK, gl3State->glPolygonMode));
+	}
+
+	if (curRasterizerState == nullptr ||
+		curRasterizerState->desc.depthBias != desc.depthBias ||
+		curRasterizerState->desc.slopeScaledDepthBias != desc.slopeScaledDepthBias)
+	{
+		bool biasEnabled = desc.depthBias != 0 || desc.slopeScaledDepthBias != 0.0f;
+
+		if (biasEnabled)
+		{
+			glEnable(GL_POLYGON_OFFSET_FILL);
+			CHECK_GL(glPolygonOffset(desc.slopeScaledDepthBias, static_cast<float>(desc.depthBias)));
+		}
+		else
+		{
+			glDisable(GL_POLYGON_OFFSET_FILL);
+		}
+	}
+
+	curRasterizerState = gl3State;
+	curFrameStats.stateChanges++;
 }
 
 void GL3Device::SetClearColor(const vec4 &color)
@@ -798,17 +2236,214 @@ void GL3Device::SetClearColor(const vec4 &color)
 
 void GL3Device::SetViewport(int32 x, int32 y, int32 width, int32 height)
 {
-	glViewport(x, y, width, height);
-	glScissor(x, y, width, height);
+	SetViewportBox(x, y, width, height);
+	SetScissorBox(x, y, width, height);
 }
 
 void GL3Device::OnResolutionChanged(uint32 width, uint32 height)
 {
-	
+	// scissor rects are flipped using the resolution, so it has to be kept up to date
+	renderInfo.resolutionX = width;
+	renderInfo.resolutionY = height;
+
+	if (renderInfo.headless)
+	{
+		CreateBackBuffer(width, height);
+		BindFramebuffer(curFramebufferID);
+	}
+
 	SetViewport(0, 0, width, height);
 }
 
-GLuint GL3Device::CompileShaderObject(const std::string &fileName, GLenum shaderType)
+GraphicsStats GL3Device::GetFrameStats()
+{
+	return lastFrameStats;
+}
+
+GL3Shader* GL3Device::CompileShader(const std::string &name, ShaderFeatures features)
+{
+	uint64 binaryKey = 0;
+	GL3Shader* newShader = StartShaderCompile(name, features, binaryKey);
+
+	if (newShader == nullptr)
+		return nullptr;
+
+	if (newShader->compilePending && !FinishShaderCompile(newShader, name, features, binaryKey))
+	{
+		delete newShader;
+		return nullptr;
+	}
+
+	return newShader;
+}
+
+GL3Shader* GL3Device::StartShaderCompile(const std::string &name, ShaderFeatures features, uint64 &binaryKey)
+{
+	std::string vertexFile = GL3_SHADER_LOC + name + ".vert";
+	std::string fragmentFile = GL3_SHADER_LOC + name + ".frag";
+
+	std::string vertexSource, fragmentSource;
+
+	if (!shaderPreprocessor.Process(vertexFile, features, vertexSource) ||
+		!shaderPreprocessor.Process(fragmentFile, features, fragmentSource))
+	{
+		LOG_ERROR("Unable to create shader [%s], could not read its sources", name.c_str());
+		return nullptr;
+	}
+
+	// a binary cached from the same sources on the same driver skips compiling and linking entirely. the sources are
+	// hashed after preprocessing, so an edited include or a different set of features never matches an old binary
+	binaryKey = 0;
+
+	if (programBinaries)
+	{
+		binaryKey = Hash::FNV1a64(vertexSource.data(), vertexSource.size(), programBinaryDriverHash);
+		binaryKey = Hash::FNV1a64(fragmentSource.data(), fragmentSource.size(), binaryKey);
+
+		GLuint programID = LoadProgramBinary(ShaderPreprocessor::GetVariantName(name, features), binaryKey);
+
+		if (programID != 0)
+		{
+			GL3Shader* newShader = new GL3Shader();
+			newShader->programID = programID;
+
+			return newShader;
+		}
+	}
+
+	GL3Shader* newShader = new GL3Shader();
+	newShader->vertexShader = CompileShaderObject(vertexFile, vertexSource, GL_VERTEX_SHADER);
+	newShader->fragmentShader = CompileShaderObject(fragmentFile, fragmentSource, GL_FRAGMENT_SHADER);
+	newShader->programID = glCreateProgram();
+
+	if (newShader->vertexShader == 0 || newShader->fragmentShader == 0 || newShader->programID == 0)
+	{
+		LOG_GL_ERROR("Unable to create shader, failed creating its shader objects");
+
+		DeleteShaderObjects(newShader);
+		delete newShader;
+
+		return nullptr;
+	}
+
+	// attach vertex and fragment shaders
+	glAttachShader(newShader->programID, newShader->vertexShader);
+	glAttachShader(newShader->programID, newShader->fragmentShader);
+
+	// the binary can only be retrieved if the driver is told before linking
+	if (programBinaries)
+	{
+		glProgramParameteri(newShader->programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
+	// the link is queued behind the compiles, nothing is checked until FinishShaderCompile
+	glLinkProgram(newShader->programID);
+
+	newShader->compilePending = true;
+
+	return newShader;
+}
+
+void GL3Device::FinishQueuedShaderCompile(GL3Shader* shader)
+{
+	for (auto compile = shaderCompiles.begin(); compile != shaderCompiles.end(); ++compile)
+	{
+		if (compile->shader == shader)
+		{
+			FinishShaderCompile(shader, compile->name, compile->features, compile->binaryKey);
+			shaderCompiles.erase(compile);
+			return;
+		}
+	}
+}
+
+bool GL3Device::FinishShaderCompile(GL3Shader* shader, const std::string &name, ShaderFeatures features, uint64 binaryKey)
+{
+	shader->compilePending = false;
+
+	// both objects are checked so every compile error is logged
+	bool vertexCompiled = CheckShaderObject(GL3_SHADER_LOC + name + ".vert", shader->vertexShader);
+	bool fragmentCompiled = CheckShaderObject(GL3_SHADER_LOC + name + ".frag", shader->fragmentShader);
+
+	// check shader program linked succesfully and is ready to use
+	GLint linkStatus = GL_FALSE;
+
+	if (vertexCompiled && fragmentCompiled)
+	{
+		glGetProgramiv(shader->programID, GL_LINK_STATUS, &linkStatus);
+
+		if (linkStatus == GL_FALSE)
+		{
+			GLint info_length;
+			glGetProgramiv(shader->programID, GL_INFO_LOG_LENGTH, &info_length);
+
+			std::vector<char> errorMsg(glm::max(info_length, int(1)));
+			glGetProgramInfoLog(shader->programID, info_length, NULL, &errorMsg[0]);
+
+			LOG_GL_ERROR("Failed linking shader program");
+			LOG_ERROR(&errorMsg[0]);
+		}
+	}
+
+	// a failed shader keeps no GL objects and is never ready
+	if (linkStatus == GL_FALSE)
+	{
+		LOG_ERROR("Unable to create shader [%s]", ShaderPreprocessor::GetVariantName(name, features).c_str());
+
+		DeleteShaderObjects(shader);
+		shader->vertexShader = 0;
+		shader->fragmentShader = 0;
+		shader->programID = 0;
+
+		return false;
+	}
+
+	if (programBinaries)
+	{
+		SaveProgramBinary(ShaderPreprocessor::GetVariantName(name, features), binaryKey, shader->programID);
+	}
+
+	// the shader may have been set while it was compiling
+	if (curShader == shader)
+	{
+		BindProgram(shader->programID);
+	}
+
+	return true;
+}
+
+bool GL3Device::IsShaderCompileComplete(GL3Shader* shader)
+{
+	// without parallel compile there is nothing to poll, the status queries in FinishShaderCompile wait on the driver
+	if (!parallelShaderCompile)
+		return true;
+
+	GLint complete = GL_FALSE;
+	glGetProgramiv(shader->programID, GL_COMPLETION_STATUS_ARB, &complete);
+
+	return complete == GL_TRUE;
+}
+
+void GL3Device::ProcessShaderCompiles()
+{
+	for (uint32 c = 0; c < shaderCompiles.size();)
+	{
+		if (IsShaderCompileComplete(shaderCompiles[c].shader))
+		{
+			ShaderCompileGL3 &compile = shaderCompiles[c];
+			FinishShaderCompile(compile.shader, compile.name, compile.features, compile.binaryKey);
+
+			shaderCompiles[c] = shaderCompiles.back();
+			shaderCompiles.pop_back();
+		}
+		else
+		{
+			c++;
+		}
+	}
+}
+
+GLuint GL3Device::CompileShaderObject(const std::string &fileName, const std::string &source, GLenum shaderType)
 {
 	// create new shader object of the given type
 	GLuint shaderID = glCreateShader(shaderType);
@@ -820,25 +2455,18 @@ GLuint GL3Device::CompileShaderObject(const std::string &fileName, GLenum shader
 		return 0;
 	}
 
-	// load shader from file
-	int32 dataSize = 0;
-	char* fileData = FileReadAll(fileName, dataSize);
-
-	if (fileData == nullptr)
-	{
-		LOG_ERROR("Unable to compile shader [%s] could not open source file.", fileName.c_str());
-		return 0;
-	}
-
-	std::string shaderStr = std::string(fileData, dataSize);
-
 	// set shader object source code
-	const GLchar* shaderSource = (const GLchar*)shaderStr.c_str();
+	const GLchar* shaderSource = (const GLchar*)source.c_str();
 	glShaderSource(shaderID, 1, &shaderSource, nullptr);
 
-	// compile the shader object
+	// compile the shader object, the result isn't queried here as that would wait for the compile to finish
 	glCompileShader(shaderID);
 
+	return shaderID;
+}
+
+bool GL3Device::CheckShaderObject(const std::string &fileName, GLuint shaderID)
+{
 	// check the result of the shaders compilation
 	GLint result = GL_FALSE;
 	GLint infoLength = 0;
@@ -863,10 +2491,93 @@ GLuint GL3Device::CompileShaderObject(const std::string &fileName, GLenum shader
 	if (result == GL_FALSE)
 	{
 		LOG_ERROR("Failed compiling shader [%s]", fileName.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+GLuint GL3Device::LoadProgramBinary(const std::string &name, uint64 key)
+{
+	std::string fileName = GL3_SHADER_LOC + name + GL3_PROGRAM_BINARY_EXT;
+
+	// no binary is expected the first time a shader is created
+	FILE* file = fopen(fileName.c_str(), "rb");
+
+	if (file == nullptr)
+		return 0;
+
+	ProgramBinaryHeaderGL3 header;
+	std::vector<uint8> binary;
+
+	bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+				 header.magic == GL3_PROGRAM_BINARY_MAGIC &&
+				 header.version == GL3_PROGRAM_BINARY_VERSION &&
+				 header.key == key &&
+				 header.size > 0;
+
+	if (valid)
+	{
+		binary.resize(header.size);
+		valid = fread(binary.data(), 1, header.size, file) == header.size;
+	}
+
+	fclose(file);
+
+	if (!valid)
+	{
+		LOG("Program binary [%s] is stale, compiling from source", fileName.c_str());
 		return 0;
 	}
 
-	return shaderID;
+	GLuint programID = glCreateProgram();
+	glProgramBinary(programID, header.format, binary.data(), header.size);
+
+	// the driver may still reject a binary it produced, e.g. after an update that kept the version string
+	GLint linkStatus = GL_FALSE;
+	glGetProgramiv(programID, GL_LINK_STATUS, &linkStatus);
+
+	if (linkStatus == GL_FALSE)
+	{
+		LOG("Program binary [%s] was rejected by the driver, compiling from source", fileName.c_str());
+		glDeleteProgram(programID);
+		return 0;
+	}
+
+	return programID;
+}
+
+void GL3Device::SaveProgramBinary(const std::string &name, uint64 key, GLuint programID)
+{
+	GLint binarySize = 0;
+	glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+
+	if (binarySize <= 0)
+		return;
+
+	ProgramBinaryHeaderGL3 header;
+	header.magic = GL3_PROGRAM_BINARY_MAGIC;
+	header.version = GL3_PROGRAM_BINARY_VERSION;
+	header.key = key;
+	header.size = static_cast<uint32>(binarySize);
+
+	std::vector<uint8> binary(binarySize);
+	glGetProgramBinary(programID, binarySize, nullptr, &header.format, binary.data());
+
+	std::string fileName = GL3_SHADER_LOC + name + GL3_PROGRAM_BINARY_EXT;
+
+	// the cache is only an optimization, shaders still work when it can't be written
+	FILE* file = fopen(fileName.c_str(), "wb");
+
+	if (file == nullptr)
+	{
+		LOG_WARNING("Unable to write program binary [%s]", fileName.c_str());
+		return;
+	}
+
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(binary.data(), 1, binary.size(), file);
+	fclose(file);
 }
 
 void GL3Device::SetVertexAttributes(VertexAttributes vertexAttributeFlags, uint32 stride)
@@ -885,7 +2596,1145 @@ void GL3Device::SetVertexAttributes(VertexAttributes vertexAttributeFlags, uint3
 		CHECK_GL(glEnableVertexAttribArray(attribIndex));
 		CHECK_GL(glVertexAttribPointer(attribIndex, properties.components, glType, properties.normalized, stride, (GLvoid*)offset));
 
-		offset += properties.components * properties.typeSizeBytes;
+		offset += properties.sizeBytes;
 		attribIndex++;
 	}
-}
\ No newline at end of file
+}
+
+void GL3Device::SetInstanceAttributes(VertexAttributes instanceAttributeFlags, uint32 stride, uintptr_t offset)
+{
+	// same as SetVertexAttributes, but attributes advance once per instance and wide attributes such as
+	// matrices are split over consecutive locations, one for each 4 components
+	uint32 attribIndex = GL3_INSTANCE_ATTRIBUTE_LOCATION;
+	for (uint32 mask = ToIntegral(instanceAttributeFlags); mask; mask &= mask - 1)
+	{
+		uint32 index = Bit::LeastSignifcantBit(mask);
+
+		const AttributeProperties &properties = attributeProperties[index];
+		GLenum glType = GLBaseTypes[static_cast<int32>(properties.type)];
+		uint32 slotComponents = properties.components / properties.slotCount;
+
+		DS_ASSERT(properties.perInstance);
+
+		for (uint32 slot = 0; slot < properties.slotCount; slot++)
+		{
+			CHECK_GL(glEnableVertexAttribArray(attribIndex));
+			CHECK_GL(glVertexAttribPointer(attribIndex, slotComponents, glType, properties.normalized, stride, (GLvoid*)offset));
+			CHECK_GL(glVertexAttribDivisor(attribIndex, 1));
+
+			offset += properties.sizeBytes / properties.slotCount;
+			attribIndex++;
+		}
+	}
+}
+
+void GL3Device::ClearInstanceAttributes(VertexAttributes instanceAttributeFlags)
+{
+	uint32 locationCount = 0;
+	for (uint32 mask = ToIntegral(instanceAttributeFlags); mask; mask &= mask - 1)
+	{
+		locationCount += attributeProperties[Bit::LeastSignifcantBit(mask)].slotCount;
+	}
+
+	for (uint32 attribIndex = GL3_INSTANCE_ATTRIBUTE_LOCATION; attribIndex < GL3_INSTANCE_ATTRIBUTE_LOCATION + locationCount; attribIndex++)
+	{
+		CHECK_GL(glDisableVertexAttribArray(attribIndex));
+	}
+}
+
+void GL3Device::DeleteMeshObjects(MeshGL3* mesh)
+{
+	// the buffers and VAO of an arena mesh are shared, only its ranges are given back
+	if (mesh->arena != nullptr)
+	{
+		FreeFromMeshArena(mesh->arena, mesh->arenaSlot);
+		return;
+	}
+
+	ReleaseBuffer(mesh->vertexBuffer);
+	ReleaseBuffer(mesh->indexBuffer);
+
+	glDeleteVertexArrays(1, &mesh->vertexArrayID);
+	OnVertexArrayDeleted(mesh->vertexArrayID);
+}
+
+void GL3Device::DeleteShaderObjects(GL3Shader* shader)
+{
+	// GL only deletes a program once it is no longer current, unbind it so the cache never holds a reused id
+	if (stateCache.programID == shader->programID)
+	{
+		BindProgram(0);
+	}
+
+	glDeleteProgram(shader->programID);
+	glDeleteShader(shader->vertexShader);
+	glDeleteShader(shader->fragmentShader);
+}
+
+void GL3Device::DeleteTextureObjects(GL3Texture* texture)
+{
+	glDeleteTextures(1, &texture->textureID);
+	OnTextureDeleted(texture->textureID);
+}
+
+void GL3Device::DeleteBufferObjects(BufferGL3* buffer)
+{
+	// deleting a persistently mapped buffer also unmaps it
+	CHECK_GL(glDeleteBuffers(1, &buffer->glID));
+	OnBufferDeleted(buffer->glID);
+}
+
+void GL3Device::BindMeshBuffers(MeshGL3* mesh)
+{
+	BindVertexArray(mesh->vertexArrayID);
+
+	// the index buffer binding is stored in the VAO
+	BindBuffer(GL3BufferBinding::Array, mesh->vertexBuffer->glID);
+	CHECK_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer->glID));
+
+	// define generic vertex attribute data
+	SetVertexAttributes(mesh->vertexAttributeFlags, mesh->stride);
+}
+
+void GL3Device::GetMeshOffsets(const MeshGL3* mesh, GLint &baseVertex, uintptr_t &indexByteOffset)
+{
+	// stream buffers place the vertices and indices at an offset in to their buffers
+	baseVertex = mesh->vertexBuffer->dataOffset / mesh->stride;
+	indexByteOffset = mesh->indexBuffer->dataOffset;
+
+	// arena meshes start at their ranges of the shared buffers
+	if (mesh->arena != nullptr)
+	{
+		const MeshArenaAllocationGL3 &allocation = mesh->arena->allocations[mesh->arenaSlot];
+
+		baseVertex += allocation.vertexOffset;
+		indexByteOffset += allocation.indexOffset * DS_INDEX_SIZE(mesh->indexFormat);
+	}
+}
+
+// ==============================================
+// Mesh Arenas
+// ==============================================
+
+MeshGL3* GL3Device::CreateArenaMesh(const MeshData &meshData, VertexAttributes vertexAttributeFlags)
+{
+	// 32 bit indices are narrowed to 16 bit when the mesh is small enough, narrowed meshes share the 16 bit arena
+	IndexFormat indexFormat = GetDeviceIndexFormat(meshData.indexFormat, meshData.vertexCount);
+	const void* indexData = ConvertIndices(meshData.indexData, meshData.indexCount, meshData.indexFormat, indexFormat, indexScratch);
+
+	MeshArenaGL3* arena = GetMeshArena(vertexAttributeFlags, indexFormat);
+	uint32 slot = AllocateFromMeshArena(arena, meshData.vertexCount, meshData.indexCount);
+	const MeshArenaAllocationGL3 &allocation = arena->allocations[slot];
+
+	uint32 vertexBytes = meshData.vertexCount * arena->stride;
+	uint32 indexBytes = meshData.indexCount * DS_INDEX_SIZE(indexFormat);
+
+	// only the new ranges are written, the GPU may still be reading the rest of the buffers
+	if (meshData.vertexData && vertexBytes > 0)
+	{
+		BindBuffer(GL3BufferBinding::CopyWrite, arena->vertexBuffer->glID);
+		CHECK_GL(glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.vertexOffset * arena->stride, vertexBytes, meshData.vertexData));
+		curFrameStats.bytesUploaded += vertexBytes;
+	}
+
+	if (indexData && indexBytes > 0)
+	{
+		BindBuffer(GL3BufferBinding::CopyWrite, arena->indexBuffer->glID);
+		CHECK_GL(glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.indexOffset * DS_INDEX_SIZE(indexFormat), indexBytes, indexData));
+		curFrameStats.bytesUploaded += indexBytes;
+	}
+
+	MeshGL3* newMesh = new MeshGL3(arena->vertexArrayID, arena->vertexBuffer, arena->indexBuffer, meshData.vertexCount, meshData.indexCount, indexFormat, arena->stride, vertexAttributeFlags);
+	newMesh->arena = arena;
+	newMesh->arenaSlot = slot;
+
+	return newMesh;
+}
+
+MeshArenaGL3* GL3Device::GetMeshArena(VertexAttributes vertexAttributeFlags, IndexFormat indexFormat)
+{
+	for (MeshArenaGL3* arena : meshArenas)
+	{
+		if (arena->vertexAttributeFlags == vertexAttributeFlags && arena->indexFormat == indexFormat)
+			return arena;
+	}
+
+	MeshArenaGL3* arena = new MeshArenaGL3();
+	arena->vertexAttributeFlags = vertexAttributeFlags;
+	arena->indexFormat = indexFormat;
+	arena->stride = GetAttributeMaskSize(vertexAttributeFlags);
+
+	glGenVertexArrays(1, &arena->vertexArrayID);
+
+	GLenum glUsage = GL3UsageMap[static_cast<int32>(BufferUsage::Static)];
+	arena->vertexBuffer = new BufferGL3(0, glUsage, GL_ARRAY_BUFFER, 0, BufferUsage::Static);
+	arena->indexBuffer = new BufferGL3(0, glUsage, GL_ELEMENT_ARRAY_BUFFER, 0, BufferUsage::Static);
+
+	ResizeMeshArena(arena, GL3_MESH_ARENA_VERTEX_COUNT, GL3_MESH_ARENA_INDEX_COUNT, false);
+
+	meshArenas.push_back(arena);
+
+	return arena;
+}
+
+uint32 GL3Device::AllocateFromMeshArena(MeshArenaGL3* arena, uint32 vertexCount, uint32 indexCount)
+{
+	uint32 vertexCapacity = arena->vertexRanges.GetCapacity();
+	uint32 indexCapacity = arena->indexRanges.GetCapacity();
+
+	// the space added when growing is one free range at the end, it is made large enough for the mesh on its own
+	if (arena->vertexRanges.GetLargestFreeRange() < vertexCount)
+	{
+		vertexCapacity = glm::max(vertexCapacity * 2, vertexCapacity + vertexCount);
+	}
+
+	if (arena->indexRanges.GetLargestFreeRange() < indexCount)
+	{
+		indexCapacity = glm::max(indexCapacity * 2, indexCapacity + indexCount);
+	}
+
+	if (vertexCapacity != arena->vertexRanges.GetCapacity() || indexCapacity != arena->indexRanges.GetCapacity())
+	{
+		ResizeMeshArena(arena, vertexCapacity, indexCapacity, false);
+
+		LOG("Mesh arena grew to %u vertices and %u indices", vertexCapacity, indexCapacity);
+	}
+
+	MeshArenaAllocationGL3 allocation;
+	allocation.vertexOffset = arena->vertexRanges.Allocate(vertexCount);
+	allocation.vertexCount = vertexCount;
+	allocation.indexOffset = arena->indexRanges.Allocate(indexCount);
+	allocation.indexCount = indexCount;
+	allocation.used = true;
+
+	DS_ASSERT(allocation.vertexOffset != RangeAllocator::InvalidOffset && allocation.indexOffset != RangeAllocator::InvalidOffset);
+
+	uint32 slot;
+
+	if (!arena->freeSlots.empty())
+	{
+		slot = arena->freeSlots.back();
+		arena->freeSlots.pop_back();
+		arena->allocations[slot] = allocation;
+	}
+	else
+	{
+		slot = static_cast<uint32>(arena->allocations.size());
+		arena->allocations.push_back(allocation);
+	}
+
+	arena->meshCount++;
+
+	return slot;
+}
+
+void GL3Device::FreeFromMeshArena(MeshArenaGL3* arena, uint32 slot)
+{
+	MeshArenaAllocationGL3 &allocation = arena->allocations[slot];
+
+	DS_ASSERT(allocation.used); // slot was already freed
+
+	arena->vertexRanges.Free(allocation.vertexOffset, allocation.vertexCount);
+	arena->indexRanges.Free(allocation.indexOffset, allocation.indexCount);
+
+	allocation = MeshArenaAllocationGL3();
+	arena->freeSlots.push_back(slot);
+	arena->meshCount--;
+}
+
+void GL3Device::ResizeMeshArena(MeshArenaGL3* arena, uint32 vertexCapacity, uint32 indexCapacity, bool compact)
+{
+	uint32 indexSize = DS_INDEX_SIZE(arena->indexFormat);
+
+	GLuint previousVertexID = arena->vertexBuffer->glID;
+	GLuint previousIndexID = arena->indexBuffer->glID;
+
+	// the new buffers are filled from the old ones on the GPU, draws already issued keep reading the old storage
+	GLuint vertexBufferID, indexBufferID;
+	glGenBuffers(1, &vertexBufferID);
+	glGenBuffers(1, &indexBufferID);
+
+	BindBuffer(GL3BufferBinding::CopyWrite, vertexBufferID);
+	CHECK_GL(glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity * arena->stride, NULL, arena->vertexBuffer->glUsage));
+
+	BindBuffer(GL3BufferBinding::CopyWrite, indexBufferID);
+	CHECK_GL(glBufferData(GL_COPY_WRITE_BUFFER, indexCapacity * indexSize, NULL, arena->indexBuffer->glUsage));
+
+	if (compact)
+	{
+		uint32 usedVertices = CompactMeshArenaRanges(arena, &MeshArenaAllocationGL3::vertexOffset, &MeshArenaAllocationGL3::vertexCount,
+													 previousVertexID, vertexBufferID, arena->stride);
+		uint32 usedIndices = CompactMeshArenaRanges(arena, &MeshArenaAllocationGL3::indexOffset, &MeshArenaAllocationGL3::indexCount,
+													previousIndexID, indexBufferID, indexSize);
+
+		// every allocation now lies in one range at the start
+		arena->vertexRanges.Reset(vertexCapacity);
+		arena->vertexRanges.Allocate(usedVertices);
+		arena->indexRanges.Reset(indexCapacity);
+		arena->indexRanges.Allocate(usedIndices);
+	}
+	else
+	{
+		CopyBufferRange(previousVertexID, vertexBufferID, 0, 0, arena->vertexRanges.GetCapacity() * arena->stride);
+		CopyBufferRange(previousIndexID, indexBufferID, 0, 0, arena->indexRanges.GetCapacity() * indexSize);
+
+		arena->vertexRanges.Grow(vertexCapacity);
+		arena->indexRanges.Grow(indexCapacity);
+	}
+
+	// GL keeps the old storage alive until the GPU has finished with it
+	if (previousVertexID != 0)
+	{
+		CHECK_GL(glDeleteBuffers(1, &previousVertexID));
+		OnBufferDeleted(previousVertexID);
+	}
+
+	if (previousIndexID != 0)
+	{
+		CHECK_GL(glDeleteBuffers(1, &previousIndexID));
+		OnBufferDeleted(previousIndexID);
+	}
+
+	// meshes share these objects, so they follow the arena to its new buffers
+	arena->vertexBuffer->glID = vertexBufferID;
+	arena->vertexBuffer->size = vertexCapacity * arena->stride;
+	arena->indexBuffer->glID = indexBufferID;
+	arena->indexBuffer->size = indexCapacity * indexSize;
+
+	BindVertexArray(arena->vertexArrayID);
+
+	BindBuffer(GL3BufferBinding::Array, vertexBufferID);
+	CHECK_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID));
+
+	SetVertexAttributes(arena->vertexAttributeFlags, arena->stride);
+}
+
+uint32 GL3Device::CompactMeshArenaRanges(MeshArenaGL3* arena, uint32 MeshArenaAllocationGL3::*offset, uint32 MeshArenaAllocationGL3::*count,
+										 GLuint srcID, GLuint dstID, uint32 elementSize)
+{
+	std::vector<uint32> order;
+	order.reserve(arena->meshCount);
+
+	for (uint32 slot = 0; slot < arena->allocations.size(); slot++)
+	{
+		if (arena->allocations[slot].used && arena->allocations[slot].*count > 0)
+		{
+			order.push_back(slot);
+		}
+	}
+
+	// moving allocations in offset order keeps neighbours together, each run of them is copied at once
+	std::sort(order.begin(), order.end(), [&](uint32 a, uint32 b) { return arena->allocations[a].*offset < arena->allocations[b].*offset; });
+
+	uint32 packed = 0;
+	uint32 runSrc = 0;
+	uint32 runDst = 0;
+	uint32 runSize = 0;
+
+	for (uint32 slot : order)
+	{
+		MeshArenaAllocationGL3 &allocation = arena->allocations[slot];
+
+		if (runSize > 0 && allocation.*offset != runSrc + runSize)
+		{
+			CopyBufferRange(srcID, dstID, runSrc * elementSize, runDst * elementSize, runSize * elementSize);
+			runSize = 0;
+		}
+
+		if (runSize == 0)
+		{
+			runSrc = allocation.*offset;
+			runDst = packed;
+		}
+
+		runSize += allocation.*count;
+
+		allocation.*offset = packed;
+		packed += allocation.*count;
+	}
+
+	if (runSize > 0)
+	{
+		CopyBufferRange(srcID, dstID, runSrc * elementSize, runDst * elementSize, runSize * elementSize);
+	}
+
+	return packed;
+}
+
+void GL3Device::DeleteMeshArena(MeshArenaGL3* arena)
+{
+	DeleteBufferObjects(arena->vertexBuffer);
+	DeleteBufferObjects(arena->indexBuffer);
+
+	glDeleteVertexArrays(1, &arena->vertexArrayID);
+	OnVertexArrayDeleted(arena->vertexArrayID);
+
+	delete arena->vertexBuffer;
+	delete arena->indexBuffer;
+	delete arena;
+}
+
+void GL3Device::CopyBufferRange(GLuint srcID, GLuint dstID, GLintptr srcOffset, GLintptr dstOffset, GLsizeiptr size)
+{
+	// a buffer that was never created has nothing to copy
+	if (srcID == 0 || size == 0)
+		return;
+
+	BindBuffer(GL3BufferBinding::CopyRead, srcID);
+	BindBuffer(GL3BufferBinding::CopyWrite, dstID);
+
+	CHECK_GL(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, srcOffset, dstOffset, size));
+}
+
+// ==============================================
+// Stream Buffers
+// ==============================================
+
+BufferGL3* GL3Device::CreateStreamBuffer(uint32 size, uint32 alignment, BufferTarget target)
+{
+	GLenum glUsage = GL3UsageMap[static_cast<int32>(BufferUsage::Stream)];
+	GLenum glTarget = GL3TargetMap[static_cast<int32>(target)];
+
+	BufferGL3* buffer = new BufferGL3(0, glUsage, glTarget, size, BufferUsage::Stream);
+	buffer->writeAlignment = glm::max(alignment, 1u);
+
+	CreateStreamStorage(buffer, size);
+
+	return buffer;
+}
+
+void GL3Device::CreateStreamStorage(BufferGL3* buffer, uint32 regionSize)
+{
+	// leave room to align the first write of the frame
+	regionSize = glm::max(regionSize + buffer->writeAlignment, static_cast<uint32>(GL3_STREAM_MIN_REGION_SIZE));
+
+	GLuint previousID = buffer->glID;
+
+	glGenBuffers(1, &buffer->glID);
+	BindBuffer(GL3BufferBinding::CopyWrite, buffer->glID);
+
+	if (persistentMapping)
+	{
+		// immutable storage holding one region per frame in flight, mapped once for the lifetime of the buffer
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GLsizeiptr storageSize = static_cast<GLsizeiptr>(regionSize) * framesInFlight;
+
+		CHECK_GL(glBufferStorage(GL_COPY_WRITE_BUFFER, storageSize, NULL, flags));
+		buffer->mappedData = static_cast<uint8*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, storageSize, flags));
+
+		if (buffer->mappedData == nullptr)
+		{
+			LOG_GL_ERROR("Failed persistently mapping stream buffer");
+		}
+	}
+	else
+	{
+		CHECK_GL(glBufferData(GL_COPY_WRITE_BUFFER, regionSize, NULL, buffer->glUsage));
+		buffer->mappedData = nullptr;
+	}
+
+	buffer->regionSize = regionSize;
+	buffer->regionCount = framesInFlight;
+
+	if (previousID != 0)
+	{
+		// move uniform slots over to the new buffer before the old one is deleted and dropped from the cache
+		for (uint32 s = 0; s < GL3_MAX_UNIFORM_BUFFER_SLOTS; s++)
+		{
+			const UniformBindingGL3 &binding = stateCache.uniformBindings[s];
+
+			if (binding.bufferID == previousID)
+			{
+				BindUniformBuffer(s, buffer->glID, 0, binding.size);
+			}
+		}
+
+		// GL keeps the old storage alive until the GPU has finished with it
+		CHECK_GL(glDeleteBuffers(1, &previousID));
+		OnBufferDeleted(previousID);
+	}
+
+	// writes for the rest of this frame continue from the start of its region in the new storage
+	buffer->writeFrame = frameNumber;
+	buffer->writeOffset = frameSlot * regionSize;
+}
+
+uint8* GL3Device::BeginStreamWrite(BufferGL3* buffer, uint32 size)
+{
+	if (!persistentMapping)
+	{
+		BindBuffer(GL3BufferBinding::CopyWrite, buffer->glID);
+
+		// orphan the storage, the driver hands out new memory while the GPU keeps reading the old copy
+		buffer->regionSize = glm::max(buffer->regionSize, size);
+		CHECK_GL(glBufferData(GL_COPY_WRITE_BUFFER, buffer->regionSize, NULL, buffer->glUsage));
+
+		buffer->dataOffset = 0;
+		buffer->size = size;
+
+		return static_cast<uint8*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+	}
+
+	// storage made for a different number of frames in flight has the wrong number of regions
+	if (buffer->regionCount != framesInFlight)
+	{
+		CreateStreamStorage(buffer, buffer->regionSize - buffer->writeAlignment);
+	}
+
+	// the first write of a frame starts at the beginning of that frames region, which the GPU is done with
+	if (buffer->writeFrame != frameNumber)
+	{
+		buffer->writeFrame = frameNumber;
+		buffer->writeOffset = frameSlot * buffer->regionSize;
+	}
+
+	uint32 alignment = buffer->writeAlignment;
+	uint32 offset = ((buffer->writeOffset + alignment - 1) / alignment) * alignment;
+
+	// grow the buffer when this frames writes no longer fit in its region
+	if (offset + size > (frameSlot + 1) * buffer->regionSize)
+	{
+		CreateStreamStorage(buffer, glm::max(buffer->regionSize * 2, size));
+		offset = ((buffer->writeOffset + alignment - 1) / alignment) * alignment;
+
+		LOG_WARNING("Stream buffer grew to %u bytes per frame", buffer->regionSize);
+	}
+
+	if (buffer->mappedData == nullptr)
+		return nullptr;
+
+	buffer->writeOffset = offset + size;
+	buffer->dataOffset = offset;
+	buffer->size = size;
+
+	return buffer->mappedData + offset;
+}
+
+void GL3Device::EndStreamWrite(BufferGL3* buffer)
+{
+	// persistent mappings are coherent, writes become visible to the GPU without flushing or unmapping
+	if (!persistentMapping)
+	{
+		BindBuffer(GL3BufferBinding::CopyWrite, buffer->glID);
+		CHECK_GL(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+	}
+}
+
+void GL3Device::OnStreamBufferWritten(BufferGL3* buffer)
+{
+	if (buffer->glTarget != GL_UNIFORM_BUFFER)
+		return;
+
+	// uniform buffers are usually bound once and updated every frame, the binding has to follow the data
+	for (uint32 s = 0; s < GL3_MAX_UNIFORM_BUFFER_SLOTS; s++)
+	{
+		if (stateCache.uniformBindings[s].bufferID == buffer->glID)
+		{
+			BindUniformBuffer(s, buffer->glID, buffer->dataOffset, buffer->size);
+		}
+	}
+}
+
+void GL3Device::AdvanceFrame()
+{
+	// signalled once the GPU has executed every command of the frame just submitted
+	frameFences[frameSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	frameNumber++;
+	frameSlot = (frameSlot + 1) % framesInFlight;
+
+	GLsync fence = frameFences[frameSlot];
+
+	if (fence == nullptr)
+		return;
+
+	// the next frame reuses the slot written framesInFlight frames ago, only wait if the GPU is still reading it
+	GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+	if (result == GL_TIMEOUT_EXPIRED)
+	{
+		curFrameStats.frameWaits++;
+		result = glClientWaitSync(fence, 0, GL3_FRAME_FENCE_TIMEOUT);
+	}
+
+	while (result == GL_TIMEOUT_EXPIRED)
+	{
+		LOG_WARNING("Waiting on GPU to finish frame slot %u", frameSlot);
+		result = glClientWaitSync(fence, 0, GL3_FRAME_FENCE_TIMEOUT);
+	}
+
+	if (result == GL_WAIT_FAILED)
+	{
+		LOG_GL_ERROR("glClientWaitSync failed waiting on frame fence");
+	}
+
+	glDeleteSync(fence);
+	frameFences[frameSlot] = nullptr;
+}
+
+void GL3Device::WaitForFrames()
+{
+	for (uint32 f = 0; f < DS_MAX_FRAMES_IN_FLIGHT; f++)
+	{
+		if (frameFences[f] == nullptr)
+			continue;
+
+		GLenum result = glClientWaitSync(frameFences[f], GL_SYNC_FLUSH_COMMANDS_BIT, GL3_FRAME_FENCE_TIMEOUT);
+
+		while (result == GL_TIMEOUT_EXPIRED)
+		{
+			LOG_WARNING("Waiting on GPU to finish frames in flight");
+			result = glClientWaitSync(frameFences[f], 0, GL3_FRAME_FENCE_TIMEOUT);
+		}
+
+		glDeleteSync(frameFences[f]);
+		frameFences[f] = nullptr;
+	}
+}
+
+// ==============================================
+
+GLuint GL3Device::GetFramebuffer(uint32 numColorTargets, GL3RenderTarget* const* colorTargets, GL3RenderTarget* depthTarget)
+{
+	for (const FramebufferGL3 &framebuffer : framebuffers)
+	{
+		if (framebuffer.numColorTargets != numColorTargets || framebuffer.depthTarget != depthTarget)
+			continue;
+
+		if (std::equal(colorTargets, colorTargets + numColorTargets, framebuffer.colorTargets))
+			return framebuffer.framebufferID;
+	}
+
+	FramebufferGL3 framebuffer = {};
+	framebuffer.numColorTargets = numColorTargets;
+	framebuffer.depthTarget = depthTarget;
+
+	glGenFramebuffers(1, &framebuffer.framebufferID);
+	BindFramebuffer(framebuffer.framebufferID);
+
+	GLenum drawBuffers[DS_MAX_RENDER_TARGETS];
+
+	for (uint32 t = 0; t < numColorTargets; t++)
+	{
+		GL3RenderTarget* target = colorTargets[t];
+		framebuffer.colorTargets[t] = target;
+		drawBuffers[t] = GL_COLOR_ATTACHMENT0 + t;
+
+		if (target->renderbufferID)
+		{
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, drawBuffers[t], GL_RENDERBUFFER, target->renderbufferID);
+		}
+		else
+		{
+			glFramebufferTexture2D(GL_FRAMEBUFFER, drawBuffers[t], GL_TEXTURE_2D, target->sampleTexture.textureID, 0);
+		}
+	}
+
+	if (depthTarget)
+	{
+		GLenum attachment = GL3RenderTargetFormatMap[static_cast<int32>(depthTarget->GetDesc().format)].attachment;
+
+		if (depthTarget->renderbufferID)
+		{
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, depthTarget->renderbufferID);
+		}
+		else
+		{
+			glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, depthTarget->sampleTexture.textureID, 0);
+		}
+	}
+
+	// depth only framebuffers have no color buffer to draw to or read from
+	if (numColorTargets > 0)
+	{
+		glDrawBuffers(numColorTargets, drawBuffers);
+	}
+	else
+	{
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+	}
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		LOG_ERROR("GL3 : Failed creating framebuffer, status 0x%x", status);
+
+		glDeleteFramebuffers(1, &framebuffer.framebufferID);
+		OnFramebufferDeleted(framebuffer.framebufferID);
+		BindFramebuffer(curFramebufferID);
+
+		return 0;
+	}
+
+	framebuffers.push_back(framebuffer);
+
+	return framebuffer.framebufferID;
+}
+
+// ==============================================
+// Texture Streaming
+// ==============================================
+
+void GL3Device::ProcessTextureUploads()
+{
+	if (textureUploads.empty())
+		return;
+
+	GLuint lastTexture = stateCache.textureIDs[0];
+	GLenum lastTarget = stateCache.textureTargets[0];
+
+	uint32 budget = textureUploadBudget;
+
+	while (!textureUploads.empty() && budget > 0)
+	{
+		TextureUploadGL3 &upload = textureUploads.front();
+		GL3Texture* texture = upload.texture;
+
+		uint32 layer = upload.nextRow / texture->height;
+		uint32 y = upload.nextRow % texture->height;
+
+		// a chunk is whole rows of one layer, so it is copied in with a single call
+		uint32 chunkBytes = glm::min(budget, static_cast<uint32>(GL3_STAGING_BUFFER_SIZE));
+		uint32 rows = glm::min(chunkBytes / upload.rowBytes, texture->height - y);
+
+		// a budget smaller than a row still copies one row a frame so the upload completes
+		if (rows == 0)
+		{
+			if (budget != textureUploadBudget)
+				break;
+
+			rows = 1;
+		}
+
+		StagingBufferGL3* staging = AcquireStagingBuffer();
+
+		// every staging buffer is still being read by the GPU, the upload carries on next frame
+		if (staging == nullptr)
+			break;
+
+		uint32 bytes = rows * upload.rowBytes;
+
+		BindBuffer(GL3BufferBinding::PixelUnpack, staging->bufferID);
+
+		// the buffers fence has been signalled, so it is written without waiting on the GPU
+		void* dest = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+		if (dest == nullptr)
+		{
+			LOG_GL_ERROR("Failed mapping texture staging buffer");
+			break;
+		}
+
+		memcpy(dest, &upload.data[upload.nextRow * upload.rowBytes], bytes);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+		BindTexture(0, texture->textureID, texture->glTarget);
+
+		// with a pixel unpack buffer bound the data pointer is an offset in to the buffer
+		if (texture->glTarget == GL_TEXTURE_2D_ARRAY)
+		{
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, y, layer, texture->width, rows, 1, texture->glFormat, texture->glType, nullptr);
+		}
+		else
+		{
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, texture->width, rows, texture->glFormat, texture->glType, nullptr);
+		}
+
+		staging->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		upload.nextRow += rows;
+		budget -= glm::min(budget, bytes);
+
+		curFrameStats.bytesUploaded += bytes;
+
+		if (upload.nextRow == texture->height * texture->arraySize)
+		{
+			if (texture->mipMaps)
+			{
+				glGenerateMipmap(texture->glTarget);
+			}
+
+			texture->uploadPending = false;
+			textureUploads.pop_front();
+		}
+	}
+
+	// uploads from client memory read through the pixel unpack binding, it must be left unbound
+	BindBuffer(GL3BufferBinding::PixelUnpack, 0);
+	BindTexture(0, lastTexture != GL3_UNKNOWN_BINDING ? lastTexture : 0, lastTarget);
+
+	CHECK_GL_ERROR("Failed streaming texture data");
+}
+
+StagingBufferGL3* GL3Device::AcquireStagingBuffer()
+{
+	// buffers are used in turn, so the next buffer is always the one handed to the GPU longest ago
+	StagingBufferGL3 &staging = stagingBuffers[nextStagingBuffer];
+
+	if (staging.fence)
+	{
+		if (glClientWaitSync(staging.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+			return nullptr;
+
+		glDeleteSync(staging.fence);
+		staging.fence = nullptr;
+	}
+
+	if (staging.bufferID == 0)
+	{
+		glGenBuffers(1, &staging.bufferID);
+		BindBuffer(GL3BufferBinding::PixelUnpack, staging.bufferID);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, GL3_STAGING_BUFFER_SIZE, nullptr, GL_STREAM_DRAW);
+	}
+
+	nextStagingBuffer = (nextStagingBuffer + 1) % GL3_STAGING_BUFFER_COUNT;
+
+	return &staging;
+}
+
+// ==============================================
+// Readback
+// ==============================================
+
+void GL3Device::CompleteReadbacks(bool waitForOldest)
+{
+	while (pendingReadbacks > 0)
+	{
+		uint32 oldest = (nextReadback + GL3_READBACK_BUFFER_COUNT - pendingReadbacks) % GL3_READBACK_BUFFER_COUNT;
+		ReadbackGL3 &readback = readbacks[oldest];
+
+		GLenum result = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, waitForOldest ? GL3_FRAME_FENCE_TIMEOUT : 0);
+
+		if (result == GL_TIMEOUT_EXPIRED)
+		{
+			if (!waitForOldest)
+				return;
+
+			LOG_WARNING("Waiting on GPU to finish readback");
+			continue;
+		}
+
+		if (result == GL_WAIT_FAILED)
+		{
+			LOG_GL_ERROR("glClientWaitSync failed waiting on readback fence");
+		}
+
+		waitForOldest = false;
+
+		glDeleteSync(readback.fence);
+		readback.fence = nullptr;
+
+		// the slot is free before the callback is made, so the callback can request another readback
+		ReadbackCallback callback = std::move(readback.callback);
+		readback.callback = nullptr;
+		pendingReadbacks--;
+
+		uint32 rowBytes = readback.width * 4;
+
+		BindBuffer(GL3BufferBinding::PixelPack, readback.bufferID);
+		const uint8* pixels = static_cast<const uint8*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, rowBytes * readback.height, GL_MAP_READ_BIT));
+
+		if (pixels == nullptr)
+		{
+			LOG_GL_ERROR("Failed mapping readback buffer");
+			BindBuffer(GL3BufferBinding::PixelPack, 0);
+			continue;
+		}
+
+		// GL rows start at the bottom, they are flipped so every device returns rows from the top
+		readbackScratch.resize(rowBytes * readback.height);
+
+		for (uint32 y = 0; y < readback.height; y++)
+		{
+			memcpy(&readbackScratch[y * rowBytes], pixels + (readback.height - 1 - y) * rowBytes, rowBytes);
+		}
+
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		BindBuffer(GL3BufferBinding::PixelPack, 0);
+
+		ReadbackData data;
+		data.pixels = readbackScratch.data();
+		data.width = readback.width;
+		data.height = readback.height;
+
+		callback(data);
+	}
+}
+
+// ==============================================
+// State Cache
+// ==============================================
+
+void GL3Device::BindProgram(GLuint programID)
+{
+	if (stateCache.programID == programID)
+	{
+		curFrameStats.stateChangesElided++;
+		return;
+	}
+
+	glUseProgram(programID);
+	stateCache.programID = programID;
+
+	curFrameStats.stateChanges++;
+}
+
+void GL3Device::BindTexture(uint32 unit, GLuint textureID, GLenum target)
+{
+	DS_ASSERT(unit < GL3_MAX_TEXTURE_UNITS);
+
+	if (stateCache.textureIDs[unit] == textureID && stateCache.textureTargets[unit] == target)
+	{
+		curFrameStats.stateChangesElided++;
+		return;
+	}
+
+	// the active unit only has to change when binding to a different unit
+	if (stateCache.activeTextureUnit != unit)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		stateCache.activeTextureUnit = unit;
+	}
+
+	// the unit's other target keeps its texture, samplers only read the target matching their type
+	glBindTexture(target, textureID);
+	stateCache.textureIDs[unit] = textureID;
+	stateCache.textureTargets[unit] = target;
+
+	curFrameStats.stateChanges++;
+}
+
+void GL3Device::BindVertexArray(GLuint vertexArrayID)
+{
+	if (stateCache.vertexArrayID == vertexArrayID)
+	{
+		curFrameStats.stateChangesElided++;
+		return;
+	}
+
+	CHECK_GL(glBindVertexArray(vertexArrayID));
+	stateCache.vertexArrayID = vertexArrayID;
+
+	curFrameStats.stateChanges++;
+}
+
+void GL3Device::BindFramebuffer(GLuint framebufferID)
+{
+	if (stateCache.framebufferID == framebufferID)
+	{
+		curFrameStats.stateChangesElided++;
+		return;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebufferID);
+	stateCache.framebufferID = framebufferID;
+
+	curFrameStats.stateChanges++;
+}
+
+void GL3Device::BindBuffer(GL3BufferBinding binding, GLuint bufferID)
+{
+	GLuint &cachedID = stateCache.bufferIDs[static_cast<int32>(binding)];
+
+	if (cachedID == bufferID)
+	{
+		curFrameStats.stateChangesElided++;
+		return;
+	}
+
+	CHECK_GL(glBindBuffer(GL3BufferBindingMap[static_cast<int32>(binding)], bufferID));
+	cachedID = bufferID;
+
+	curFrameStats.stateChanges++;
+}
+
+void GL3Device::BindUniformBuffer(uint32 slot, GLuint bufferID, GLintptr offset, GLsizeiptr size)
+{
+	DS_ASSERT(slot < GL3_MAX_UNIFORM_BUFFER_SLOTS);
+
+	UniformBindingGL3 &binding = stateCache.uniformBindings[slot];
+
+	if (binding.bufferID == bufferID && binding.offset == offset && binding.size == size)
+	{
+		curFrameStats.stateChangesElided++;
+		return;
+	}
+
+	CHECK_GL(glBindBufferRange(GL_UNIFORM_BUFFER, slot, bufferID, offset, size));
+
+	binding.bufferID = bufferID;
+	binding.offset = offset;
+	binding.size = size;
+
+	// glBindBufferRange also binds the buffer to the generic GL_UNIFORM_BUFFER target
+	stateCache.bufferIDs[static_cast<int32>(GL3BufferBinding::Uniform)] = bufferID;
+
+	curFrameStats.stateChanges++;
+}
+
+void GL3Device::SetCapability(GL3Capability capability, bool enabled)
+{
+	int8 &cached = stateCache.capabilities[static_cast<int32>(capability)];
+
+	if (cached == static_cast<int8>(enabled))
+	{
+		curFrameStats.stateChangesElided++;
+		return;
+	}
+
+	if (enabled)
+	{
+		glEnable(GL3CapabilityMap[static_cast<int32>(capability)]);
+	}
+	else
+	{
+		glDisable(GL3CapabilityMap[static_cast<int32>(capability)]);
+	}
+
+	cached = static_cast<int8>(enabled);
+
+	curFrameStats.stateChanges++;
+}
+
+void GL3Device::SetScissorBox(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	GLint* box = stateCache.scissorBox;
+
+	if (box[0] == x && box[1] == y && box[2] == width && box[3] == height)
+	{
+		curFrameStats.stateChangesElided++;
+		return;
+	}
+
+	glScissor(x, y, width, height);
+
+	box[0] = x;
+	box[1] = y;
+	box[2] = width;
+	box[3] = height;
+
+	curFrameStats.stateChanges++;
+}
+
+void GL3Device::SetViewportBox(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	GLint* box = stateCache.viewport;
+
+	if (box[0] == x && box[1] == y && box[2] == width && box[3] == height)
+	{
+		curFrameStats.stateChangesElided++;
+		return;
+	}
+
+	glViewport(x, y, width, height);
+
+	box[0] = x;
+	box[1] = y;
+	box[2] = width;
+	box[3] = height;
+
+	curFrameStats.stateChanges++;
+}
+
+void GL3Device::SetBlendFunc(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha)
+{
+	if (stateCache.blendSrcRGB == srcRGB && stateCache.blendDstRGB == dstRGB &&
+		stateCache.blendSrcAlpha == srcAlpha && stateCache.blendDstAlpha == dstAlpha)
+	{
+		curFrameStats.stateChangesElided++;
+		return;
+	}
+
+	glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+
+	stateCache.blendSrcRGB = srcRGB;
+	stateCache.blendDstRGB = dstRGB;
+	stateCache.blendSrcAlpha = srcAlpha;
+	stateCache.blendDstAlpha = dstAlpha;
+
+	curFrameStats.stateChanges++;
+}
+
+void GL3Device::SetBlendEquation(GLenum modeRGB, GLenum modeAlpha)
+{
+	if (stateCache.blendEquationRGB == modeRGB && stateCache.blendEquationAlpha == modeAlpha)
+	{
+		curFrameStats.stateChangesElided++;
+		return;
+	}
+
+	glBlendEquationSeparate(modeRGB, modeAlpha);
+
+	stateCache.blendEquationRGB = modeRGB;
+	stateCache.blendEquationAlpha = modeAlpha;
+
+	curFrameStats.stateChanges++;
+}
+
+void GL3Device::SetColorMask(uint32 colorMask)
+{
+	if (stateCache.colorMask == colorMask)
+	{
+		curFrameStats.stateChangesElided++;
+		return;
+	}
+
+	glColorMask((colorMask & static_cast<uint32>(ColorMask::Red)) ? GL_TRUE : GL_FALSE,
+				(colorMask & static_cast<uint32>(ColorMask::Green)) ? GL_TRUE : GL_FALSE,
+				(colorMask & static_cast<uint32>(ColorMask::Blue)) ? GL_TRUE : GL_FALSE,
+				(colorMask & static_cast<uint32>(ColorMask::Alpha)) ? GL_TRUE : GL_FALSE);
+
+	stateCache.colorMask = colorMask;
+
+	curFrameStats.stateChanges++;
+}
+
+void GL3Device::OnBufferDeleted(GLuint bufferID)
+{
+	for (uint32 b = 0; b < static_cast<uint32>(GL3BufferBinding::Count); b++)
+	{
+		if (stateCache.bufferIDs[b] == bufferID)
+		{
+			stateCache.bufferIDs[b] = 0;
+		}
+	}
+
+	for (uint32 s = 0; s < GL3_MAX_UNIFORM_BUFFER_SLOTS; s++)
+	{
+		if (stateCache.uniformBindings[s].bufferID == bufferID)
+		{
+			stateCache.uniformBindings[s].bufferID = 0;
+		}
+	}
+}
+
+void GL3Device::OnTextureDeleted(GLuint textureID)
+{
+	for (uint32 t = 0; t < GL3_MAX_TEXTURE_UNITS; t++)
+	{
+		if (stateCache.textureIDs[t] == textureID)
+		{
+			stateCache.textureIDs[t] = 0;
+		}
+	}
+}
+
+void GL3Device::OnVertexArrayDeleted(GLuint vertexArrayID)
+{
+	if (stateCache.vertexArrayID == vertexArrayID)
+	{
+		stateCache.vertexArrayID = 0;
+	}
+}
+
+void GL3Device::OnFramebufferDeleted(GLuint framebufferID)
+{
+	if (stateCache.framebufferID == framebufferID)
+	{
+		stateCache.framebufferID = 0;
+	}
+}
+
+// ==============================================
\ No newline at end of file
@@ -3,28 +3,74 @@
 
 #include "IGraphicsDevice.h"
 #include "GL3Definitions.h"
+#include "ShaderPreprocessor.h"
+#include "utility/RangeAllocator.h"
+#include "utility/StateCache.h"
+
+#include <deque>
+#include <unordered_map>
 
 class GL3Shader : public Shader
 {
 public:
 
-	GLuint vertexShader;
-	GLuint fragmentShader;
-	GLuint programID;
+	GLuint vertexShader = 0;
+	GLuint fragmentShader = 0;
+	GLuint programID = 0;
+
+	// set while the program created by CreateShaderAsync is compiling and linking
+	bool compilePending = false;
+
+	// shaders created through CreateShader are shared by every request for the same variant
+	std::string variantName;
+	uint32 refCount = 0;
 
 };
 
+// the ranges of an arenas vertex and index buffers owned by one mesh, in vertices and indices
+struct MeshArenaAllocationGL3
+{
+	uint32 vertexOffset = 0;
+	uint32 vertexCount = 0;
+	uint32 indexOffset = 0;
+	uint32 indexCount = 0;
+	bool used = false;
+};
+
+// static meshes of one vertex format and index format sub-allocated from shared vertex and index buffers, all drawn
+// through one VAO. meshes refer to their allocation by slot, so defragmenting only has to rewrite the allocations
+struct MeshArenaGL3
+{
+	VertexAttributes vertexAttributeFlags;
+	IndexFormat indexFormat;
+	uint32 stride = 0;
+
+	GLuint vertexArrayID = 0;
+	BufferGL3* vertexBuffer = nullptr;
+	BufferGL3* indexBuffer = nullptr;
+
+	RangeAllocator vertexRanges;
+	RangeAllocator indexRanges;
+
+	// slots no mesh is using are listed in freeSlots and reused first
+	std::vector<MeshArenaAllocationGL3> allocations;
+	std::vector<uint32> freeSlots;
+	uint32 meshCount = 0;
+};
+
 class MeshGL3 : public Mesh
 {
 public:
 
-	MeshGL3(GLuint vertexArrayID, BufferGL3* vertexBuffer, BufferGL3* indexBuffer, uint32 vertexCount, uint32 indexCount, uint32 stride) :
+	MeshGL3(GLuint vertexArrayID, BufferGL3* vertexBuffer, BufferGL3* indexBuffer, uint32 vertexCount, uint32 indexCount, IndexFormat indexFormat, uint32 stride, VertexAttributes vertexAttributeFlags) :
 		vertexArrayID(vertexArrayID),
 		vertexBuffer(vertexBuffer),
 		indexBuffer(indexBuffer),
 		vertexCount(vertexCount),
 		indexCount(indexCount),
-		stride(stride)
+		indexFormat(indexFormat),
+		stride(stride),
+		vertexAttributeFlags(vertexAttributeFlags)
 	{}
 
 	GLuint vertexArrayID;
@@ -33,8 +79,16 @@ public:
 
 	uint32 vertexCount;
 	uint32 indexCount;
+	IndexFormat indexFormat;
 
 	uint32 stride;
+
+	// kept so the VAO can be rebuilt when a stream buffer is reallocated
+	VertexAttributes vertexAttributeFlags;
+
+	// set for meshes stored in a mesh arena, the VAO and buffers are then the arenas
+	MeshArenaGL3* arena = nullptr;
+	uint32 arenaSlot = 0;
 };
 
 class GL3Texture : public Texture
@@ -43,6 +97,13 @@ public:
 
 	GL3Texture(TextureSettings settings)
 	{
+		textureID = 0;
+		glTarget = settings.arraySize > 1 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+		width = settings.width;
+		height = settings.height;
+		arraySize = settings.arraySize;
+		mipMaps = settings.mipMaps;
+
 		SetTextureFormat(settings.format);
 		SetFilterMode(settings.filterMode, settings.mipMaps);
 		glWrapMode = GL3WrapMode[static_cast<int32>(settings.wrapMode)];
@@ -104,6 +165,16 @@ public:
 	}
 
 	GLuint textureID;
+	GLenum glTarget;
+
+	// kept so single layers of an array can be updated
+	uint32 width;
+	uint32 height;
+	uint32 arraySize;
+	bool mipMaps;
+
+	// set while the data of a texture created with CreateTextureAsync is still being streamed
+	bool uploadPending = false;
 
 	GLint glWrapMode;
 	GLint glInternalFormat;
@@ -114,6 +185,89 @@ public:
 
 };
 
+// texels of a texture created with CreateTextureAsync, copied in to the texture a chunk of rows at a time
+struct TextureUploadGL3
+{
+	GL3Texture* texture;
+
+	// the rows of every layer one after another
+	std::vector<uint8> data;
+	uint32 rowBytes;
+	uint32 nextRow;
+};
+
+// a shader created with CreateShaderAsync whose program the driver is still compiling and linking
+struct ShaderCompileGL3
+{
+	GL3Shader* shader = nullptr;
+	std::string name;
+	ShaderFeatures features = ShaderFeatures::None;
+
+	// the program binary is saved under this key once it has linked
+	uint64 binaryKey = 0;
+};
+
+// pixel pack buffer a readback is copied in to, the pixels are read out once its fence is signalled
+struct ReadbackGL3
+{
+	GLuint bufferID = 0;
+	uint32 bufferSize = 0;
+
+	// set while the copy is in flight
+	GLsync fence = nullptr;
+
+	uint32 width = 0;
+	uint32 height = 0;
+	ReadbackCallback callback;
+};
+
+class GL3RenderTarget : public RenderTarget
+{
+public:
+
+	GL3RenderTarget(const RenderTargetDesc &desc) :
+		RenderTarget(desc),
+		sampleTexture(TextureSettings(desc.width, desc.height, TextureFormat::RGBA, TextureWrapMode::Clamp, TextureFilterMode::Bilinear, 0.0f, false))
+	{
+		const RenderTargetFormatGL3 &glFormat = GL3RenderTargetFormatMap[static_cast<int32>(desc.format)];
+
+		sampleTexture.glInternalFormat = glFormat.internalFormat;
+		sampleTexture.glFormat = glFormat.format;
+		sampleTexture.glType = glFormat.type;
+		sampleTexture.textureID = 0;
+
+		if (desc.sampleCount <= 1)
+		{
+			texture = &sampleTexture;
+		}
+	}
+
+	// multisampled targets are stored in a renderbuffer, all others in the texture so they can be sampled
+	GLuint renderbufferID = 0;
+	GL3Texture sampleTexture;
+};
+
+// a framebuffer object is created for each combination of targets bound together and kept until one of them is released
+struct FramebufferGL3
+{
+	GL3RenderTarget* colorTargets[DS_MAX_RENDER_TARGETS];
+	uint32 numColorTargets;
+	GL3RenderTarget* depthTarget;
+
+	GLuint framebufferID;
+
+	bool Uses(const GL3RenderTarget* target) const
+	{
+		for (uint32 t = 0; t < numColorTargets; t++)
+		{
+			if (colorTargets[t] == target)
+				return true;
+		}
+
+		return depthTarget == target;
+	}
+};
+
 class GL3UniformBuffer : public UniformBuffer
 {
 public:
@@ -138,6 +292,12 @@ public:
 
 	void SetVSync(bool enabled);
 
+	void SetFramesInFlight(uint32 count);
+
+	uint32 GetFramesInFlight() { return framesInFlight; }
+
+	uint32 GetFrameSlot() { return frameSlot; }
+
 	void SetShader(Shader* shader);
 
 	void SetTexture(Texture* texture, uint32 slot);
@@ -149,7 +309,10 @@ public:
 	void OnResolutionChanged(uint32 width, uint32 height);
 
 	void DrawMesh(Mesh* mesh);
-	void DrawMeshIndexed(Mesh* mesh, uint32 elementCount, uint32 vertexOffset = 0, uint16 indexOffset = 0);
+	void DrawMeshIndexed(Mesh* mesh, uint32 elementCount, uint32 vertexOffset = 0, uint32 indexOffset = 0);
+
+	void DrawMeshIndexedInstanced(Mesh* mesh, Buffer* instanceBuffer, VertexAttributes instanceAttributeFlags, uint32 instanceCount,
+								  uint32 firstInstance = 0, uint32 elementCount = 0, uint32 vertexOffset = 0, uint32 indexOffset = 0);
 
 	// Mesh Resource Handling
 	Mesh* CreateMesh(const MeshData &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage);
@@ -162,14 +325,33 @@ public:
 
 	void ReleaseMesh(Mesh* mesh);
 
-	Shader* CreateShader(const std::string &name);
+	// Mesh Arenas
+	void SetMeshArenasEnabled(bool enabled);
+	void DefragmentMeshArenas();
+	MeshArenaStats GetMeshArenaStats();
+
+	Shader* CreateShader(const std::string &name, ShaderFeatures features = ShaderFeatures::None);
 	void ReleaseShader(Shader* shader);
 
+	Shader* CreateShaderAsync(const std::string &name, ShaderFeatures features = ShaderFeatures::None);
+
+	bool IsShaderReady(Shader* shader);
+
 	Texture* CreateTexture(uint8 *data, const TextureSettings &settings);
 	void ReleaseTexture(Texture* pTexture);
+	void UpdateTextureLayer(Texture* texture, uint32 layer, const uint8* data);
+
+	Texture* CreateTextureAsync(const uint8* data, const TextureSettings &settings);
+
+	bool IsTextureReady(Texture* texture);
+
+	void SetTextureUploadBudget(uint32 bytesPerFrame);
 
 	// Uniform Buffer Resource Handling
 	void SetUniformBuffer(uint32 slot, Buffer* buffer, ShaderStage stage);
+	void SetUniformBufferRange(uint32 slot, Buffer* buffer, uint32 offset, uint32 size, ShaderStage stage);
+
+	uint32 GetUniformBufferAlignment();
 
 	// Buffer Resource Handling
 	BufferGL3* CreateBuffer(const void* data, uint32 size, BufferTarget target, BufferUsage usage);
@@ -178,8 +360,42 @@ public:
 	void UpdateBuffer(Buffer* buffer, const void* data, uint32 size);
 	void UpdateBuffer(Buffer* buffer, const std::vector<BufferData> &data, uint32 dataCount, uint32 bufferSize);
 
+	void UpdateBufferRegion(Buffer* buffer, const void* data, uint32 offset, uint32 size);
+
 	void ReleaseBuffer(Buffer* buffer);
 
+	// Handle Resources
+	MeshHandle CreateMeshHandle(const MeshData &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage);
+	void UpdateMesh(MeshHandle mesh, const MeshData &meshData);
+	void DrawMeshIndexed(MeshHandle mesh, uint32 elementCount = 0, uint32 vertexOffset = 0, uint32 indexOffset = 0);
+	void ReleaseMesh(MeshHandle mesh);
+
+	ShaderHandle CreateShaderHandle(const std::string &name);
+	void SetShader(ShaderHandle shader);
+	void ReleaseShader(ShaderHandle shader);
+
+	TextureHandle CreateTextureHandle(uint8 *data, const TextureSettings &settings);
+	void SetTexture(TextureHandle texture, uint32 slot);
+	void ReleaseTexture(TextureHandle texture);
+
+	BufferHandle CreateBufferHandle(const void* data, uint32 size, BufferTarget target, BufferUsage usage);
+	void UpdateBuffer(BufferHandle buffer, const void* data, uint32 size);
+	void UpdateBufferRegion(BufferHandle buffer, const void* data, uint32 offset, uint32 size);
+	void SetUniformBuffer(uint32 slot, BufferHandle buffer, ShaderStage stage);
+	void ReleaseBuffer(BufferHandle buffer);
+
+	// Render Targets
+	RenderTarget* CreateRenderTarget(const RenderTargetDesc &desc);
+	void ReleaseRenderTarget(RenderTarget* target);
+
+	void SetRenderTargets(uint32 numColorTargets, RenderTarget* const* pColorTargets, RenderTarget* depthTarget);
+
+	void ClearRenderTarget(RenderTarget* target, const vec4 &color, float depth = 1.0f, uint8 stencil = 0);
+
+	void ResolveRenderTarget(RenderTarget* source, RenderTarget* destination);
+
+	void RequestReadback(RenderTarget* target, ReadbackCallback callback);
+
 	// Scissor
 	void SetScissorRects(uint32 numRects, const DSRect* pRects);
 
@@ -197,20 +413,259 @@ public:
 
 	void SetDepthStencilState(DepthStencilState* state);
 
+	// Rasterizer State
+	RasterizerState* CreateRasterizerState(const RasterizerStateDesc &desc);
+
+	void SetRasterizerState(RasterizerState* state);
+
+	// Statistics
+	GraphicsStats GetFrameStats();
+
 private:
 
-	GLuint CompileShaderObject(const std::string &fileName, GLenum shaderType);
+	// Context
+	// the window context is created with WGL, headless contexts with EGL. both leave the new context current
+	bool CreateWindowContext(const RenderInfo& info);
+	bool CreateHeadlessContext();
+	void DestroyContext();
+
+	// headless contexts have no default framebuffer, the back buffer is an offscreen framebuffer of the resolution
+	bool CreateBackBuffer(uint32 width, uint32 height);
+	void DestroyBackBuffer();
+
+	// Shaders
+	// compiles a variant outside of the variant cache and waits for it, used by shader handles which own their shader
+	GL3Shader* CompileShader(const std::string &name, ShaderFeatures features);
+
+	// queues the compiles and link of a variant's program without waiting on any of them, returns null if the sources can't
+	// be read. a shader loaded from its cached binary is returned ready, otherwise it is pending until FinishShaderCompile
+	GL3Shader* StartShaderCompile(const std::string &name, ShaderFeatures features, uint64 &binaryKey);
+
+	// checks the results of a pending shader, waiting on the driver if it hasn't finished. a failed shader keeps no GL objects
+	bool FinishShaderCompile(GL3Shader* shader, const std::string &name, ShaderFeatures features, uint64 binaryKey);
+
+	// finishes a shader queued by CreateShaderAsync and takes it off the queue
+	void FinishQueuedShaderCompile(GL3Shader* shader);
+
+	// polled without waiting when the driver compiles in parallel, otherwise always true
+	bool IsShaderCompileComplete(GL3Shader* shader);
+
+	// finishes every pending shader the driver is done with
+	void ProcessShaderCompiles();
+
+	// draws are skipped while the shader set through SetShader is compiling or failed to compile
+	bool IsCurrentShaderReady() const { return curShader == nullptr || (!curShader->compilePending && curShader->programID != 0); }
+
+	GLuint CompileShaderObject(const std::string &fileName, const std::string &source, GLenum shaderType);
+	bool CheckShaderObject(const std::string &fileName, GLuint shaderID);
+
+	// Program Binary Cache
+	// returns a program created from the binary cached for name, 0 if there is none or it no longer matches key
+	GLuint LoadProgramBinary(const std::string &name, uint64 key);
+	void SaveProgramBinary(const std::string &name, uint64 key, GLuint programID);
 
 	void SetVertexAttributes(VertexAttributes vertexAttributeFlags, uint32 stride);
 
+	// binds the per instance attributes of the currently bound array buffer in to the bound VAO
+	void SetInstanceAttributes(VertexAttributes instanceAttributeFlags, uint32 stride, uintptr_t offset);
+
+	// disables the locations SetInstanceAttributes enabled, so later draws of the VAO only read per vertex data
+	void ClearInstanceAttributes(VertexAttributes instanceAttributeFlags);
+
+	// free the GL objects owned by a resource, the resource itself is deleted or removed from its container by the caller
+	void DeleteMeshObjects(MeshGL3* mesh);
+	void DeleteShaderObjects(GL3Shader* shader);
+	void DeleteTextureObjects(GL3Texture* texture);
+	void DeleteBufferObjects(BufferGL3* buffer);
+
+	// binds the meshes buffers to its VAO and sets up the vertex attributes
+	void BindMeshBuffers(MeshGL3* mesh);
+
+	// first vertex and byte offset of the first index of the mesh in the buffers bound by its VAO
+	void GetMeshOffsets(const MeshGL3* mesh, GLint &baseVertex, uintptr_t &indexByteOffset);
+
+	// Mesh Arenas
+	MeshGL3* CreateArenaMesh(const MeshData &meshData, VertexAttributes vertexAttributeFlags);
+
+	// returns the arena of the formats, creating it on first use
+	MeshArenaGL3* GetMeshArena(VertexAttributes vertexAttributeFlags, IndexFormat indexFormat);
+
+	// reserves the ranges of a mesh in the arena, growing it when no free range is large enough. returns the slot
+	uint32 AllocateFromMeshArena(MeshArenaGL3* arena, uint32 vertexCount, uint32 indexCount);
+	void FreeFromMeshArena(MeshArenaGL3* arena, uint32 slot);
+
+	// moves the arena in to new buffers with the given capacities. the data is copied as is when growing, or with
+	// every allocation moved to the start of the buffers in offset order when compacting
+	void ResizeMeshArena(MeshArenaGL3* arena, uint32 vertexCapacity, uint32 indexCapacity, bool compact);
+
+	// copies the ranges of every allocation from srcID to the start of dstID, merging neighbours in to one copy.
+	// offset and count select the vertex or index range of the allocations, returns the number of elements copied
+	uint32 CompactMeshArenaRanges(MeshArenaGL3* arena, uint32 MeshArenaAllocationGL3::*offset, uint32 MeshArenaAllocationGL3::*count,
+								  GLuint srcID, GLuint dstID, uint32 elementSize);
+
+	void DeleteMeshArena(MeshArenaGL3* arena);
+
+	// copies size bytes between buffers on the GPU
+	void CopyBufferRange(GLuint srcID, GLuint dstID, GLintptr srcOffset, GLintptr dstOffset, GLsizeiptr size);
+
+	// Render Targets
+	// returns the framebuffer with exactly these targets attached, creating it the first time they are bound together
+	GLuint GetFramebuffer(uint32 numColorTargets, GL3RenderTarget* const* colorTargets, GL3RenderTarget* depthTarget);
+
+	// height of the bound target, scissor rects are flipped to GL's bottom left origin with it
+	uint32 GetTargetHeight() const { return curTargetHeight > 0 ? curTargetHeight : renderInfo.resolutionY; }
+
+	// Stream Buffers
+	// creates an empty stream buffer, every write is placed at an offset that is a multiple of alignment
+	BufferGL3* CreateStreamBuffer(uint32 size, uint32 alignment, BufferTarget target);
+
+	// (re)creates the GL buffer backing a stream buffer with room for regionSize bytes per frame
+	void CreateStreamStorage(BufferGL3* buffer, uint32 regionSize);
+
+	// returns a pointer to size bytes of writable memory for the buffer and moves dataOffset to it
+	uint8* BeginStreamWrite(BufferGL3* buffer, uint32 size);
+	void EndStreamWrite(BufferGL3* buffer);
+
+	// moves uniform slots bound to the buffer on to the range that was just written
+	void OnStreamBufferWritten(BufferGL3* buffer);
+
+	// fences the frame that was just submitted and waits for the GPU to finish the last frame that used the next slot
+	void AdvanceFrame();
+
+	// waits for the GPU to finish every frame in flight and deletes their fences
+	void WaitForFrames();
+
+	// Texture Streaming
+	// copies up to the upload budget of pending texture data through the staging buffers
+	void ProcessTextureUploads();
+
+	// returns a staging buffer the GPU has finished with, or nullptr when every buffer is still in use
+	StagingBufferGL3* AcquireStagingBuffer();
+
+	// Readback
+	// calls back every readback whose copy has finished, oldest first. waitForOldest blocks until the oldest is done
+	void CompleteReadbacks(bool waitForOldest);
+
+	// State Cache
+	// each function only calls in to GL when the value differs from the one in stateCache
+	void BindProgram(GLuint programID);
+	void BindTexture(uint32 unit, GLuint textureID, GLenum target = GL_TEXTURE_2D);
+	void BindVertexArray(GLuint vertexArrayID);
+	void BindFramebuffer(GLuint framebufferID);
+	void BindBuffer(GL3BufferBinding binding, GLuint bufferID);
+	void BindUniformBuffer(uint32 slot, GLuint bufferID, GLintptr offset, GLsizeiptr size);
+	void SetCapability(GL3Capability capability, bool enabled);
+	void SetScissorBox(GLint x, GLint y, GLsizei width, GLsizei height);
+	void SetViewportBox(GLint x, GLint y, GLsizei width, GLsizei height);
+	void SetBlendFunc(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha);
+	void SetBlendEquation(GLenum modeRGB, GLenum modeAlpha);
+	void SetColorMask(uint32 colorMask);
+
+	// removes a deleted object from the cache, GL unbinds deleted objects from the context
+	void OnBufferDeleted(GLuint bufferID);
+	void OnTextureDeleted(GLuint textureID);
+	void OnVertexArrayDeleted(GLuint vertexArrayID);
+	void OnFramebufferDeleted(GLuint framebufferID);
+
 	RenderInfo renderInfo;
 
-	HDC windowContext;
-	HGLRC glContextHandle;
+#if defined(_WIN32)
+	HDC windowContext = nullptr;
+	HGLRC glContextHandle = nullptr;
+#endif
+
+#if defined(DS_GL3_EGL)
+	// the surface is only created when the driver can't make a context current without one
+	EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+	EGLContext eglContext = EGL_NO_CONTEXT;
+	EGLSurface eglSurface = EGL_NO_SURFACE;
+#endif
+
+	// offscreen back buffer of a headless context, 0 when rendering to a window
+	GLuint backBufferFramebufferID = 0;
+	GLuint backBufferColorID = 0;
+	GLuint backBufferDepthID = 0;
 
 	// States
+	BlendStateGL3* defaultBlendState = nullptr;
+	BlendStateGL3* curBlendState = nullptr;
 	DepthStencilStateGL3* defaultDepthStencilState = nullptr;
 	DepthStencilStateGL3* curDepthStencilState = nullptr;
+	RasterizerStateGL3* defaultRasterizerState = nullptr;
+	RasterizerStateGL3* curRasterizerState = nullptr;
+
+	// every state object created is kept here, identical descriptors share one object
+	StateCache<BlendProperties, BlendStateGL3> blendStates;
+	StateCache<DepthStencilStateDesc, DepthStencilStateGL3> depthStencilStates;
+	StateCache<RasterizerStateDesc, RasterizerStateGL3> rasterizerStates;
+
+	GL3StateCache stateCache;
+
+	// resources created through handles
+	ResourceContainer<MeshGL3, MeshHandle> meshes;
+	ResourceContainer<GL3Shader, ShaderHandle> shaders;
+	ResourceContainer<GL3Texture, TextureHandle> textures;
+	ResourceContainer<BufferGL3, BufferHandle> buffers;
+
+	// static meshes are created in arenas while enabled, one arena per vertex and index format combination
+	bool meshArenasEnabled = false;
+	std::vector<MeshArenaGL3*> meshArenas;
+
+	// stream buffers are persistently mapped when ARB_buffer_storage is supported, otherwise they are orphaned
+	bool persistentMapping = false;
+	GLint uniformBufferAlignment = 256;
+
+	GLint maxSamples = 1;
+
+	// shaders created with CreateShaderAsync that are still compiling, finished in Present or when polled
+	std::vector<ShaderCompileGL3> shaderCompiles;
+	bool parallelShaderCompile = false;
+
+	// shader set with SetShader, null when a shader handle is set as those are never pending
+	GL3Shader* curShader = nullptr;
+
+	// resolves includes and feature defines, variants created through CreateShader by variant name
+	ShaderPreprocessor shaderPreprocessor;
+	std::unordered_map<std::string, GL3Shader*> shaderVariants;
+
+	// linked programs are cached on disk when the driver can return them, keyed with the driver so an update invalidates them
+	bool programBinaries = false;
+	uint64 programBinaryDriverHash = 0;
+
+	// framebuffer objects for the target combinations bound so far
+	std::vector<FramebufferGL3> framebuffers;
+
+	// framebuffer selected with SetRenderTargets, backBufferFramebufferID is the back buffer
+	GLuint curFramebufferID = 0;
+	uint32 curTargetHeight = 0;
+
+	// one fence per frame slot, signalled when the GPU has finished the frame last recorded in to that slot.
+	// frameNumber counts presented frames, frameSlot cycles through the first framesInFlight slots
+	GLsync frameFences[DS_MAX_FRAMES_IN_FLIGHT] = {};
+	uint32 framesInFlight = DS_MAX_FRAMES_IN_FLIGHT;
+	uint32 frameSlot = 0;
+	uint64 frameNumber = 0;
+
+	// textures created with CreateTextureAsync waiting on their data, completed in order
+	std::deque<TextureUploadGL3> textureUploads;
+	StagingBufferGL3 stagingBuffers[GL3_STAGING_BUFFER_COUNT];
+	uint32 nextStagingBuffer = 0;
+	uint32 textureUploadBudget = DS_DEFAULT_TEXTURE_UPLOAD_BUDGET;
+
+	// ring of readbacks, pendingReadbacks are in flight and end at nextReadback
+	ReadbackGL3 readbacks[GL3_READBACK_BUFFER_COUNT];
+	uint32 nextReadback = 0;
+	uint32 pendingReadbacks = 0;
+
+	// rows of a readback flipped to top to bottom
+	std::vector<uint8> readbackScratch;
+
+	// holds 32 bit indices narrowed to 16 bit while they are uploaded
+	std::vector<uint16> indexScratch;
+
+	// counters for the frame currently being recorded and the last presented frame
+	GraphicsStats curFrameStats;
+	GraphicsStats lastFrameStats;
 
 };
 
@@ -0,0 +1,311 @@
+#include "JobSystem.h"
+
+// queue of the calling thread, threads the job system did not start share the queue of the thread that initialized it
+static thread_local const JobSystem* threadJobSystem = nullptr;
+static thread_local uint32 threadQueueIndex = 0;
+
+JobSystem::JobSystem() :
+	sleepingWorkers(0),
+	queuedJobs(0)
+{
+}
+
+JobSystem::~JobSystem()
+{
+	Destroy();
+}
+
+void JobSystem::Initialize(uint32 threadCount)
+{
+	DS_ASSERT(queues.empty()); // already initialized
+
+	if (threadCount == 0)
+	{
+		threadCount = std::thread::hardware_concurrency();
+		threadCount = threadCount > 0 ? threadCount : 1;
+	}
+
+	for (uint32 t = 0; t < threadCount; t++)
+	{
+		queues.push_back(std::unique_ptr<JobQueue>(new JobQueue()));
+	}
+
+	quit = false;
+
+	threadJobSystem = this;
+	threadQueueIndex = 0;
+
+	for (uint32 t = 1; t < threadCount; t++)
+	{
+		workers.push_back(std::thread(&JobSystem::WorkerLoop, this, t));
+	}
+
+	LOG("Job system using %u threads", threadCount);
+}
+
+void JobSystem::Destroy()
+{
+	if (queues.empty())
+		return;
+
+	// queued jobs are still run, anything waiting on their counters would never return otherwise
+	Job job;
+	while (Pop(job))
+	{
+		Execute(job);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		quit = true;
+	}
+
+	sleepCondition.notify_all();
+
+	// workers only leave once every queue is empty, including jobs queued by the jobs they were running
+	for (std::thread &worker : workers)
+	{
+		worker.join();
+	}
+
+	workers.clear();
+	queues.clear();
+
+	if (threadJobSystem == this)
+	{
+		threadJobSystem = nullptr;
+	}
+}
+
+void JobSystem::Run(JobFunction job, JobCounter* counter)
+{
+	if (counter != nullptr)
+	{
+		counter->count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	Job newJob;
+	newJob.function = std::move(job);
+	newJob.counter = counter;
+
+	// before Initialize there is nobody to run it later
+	if (queues.empty())
+	{
+		Execute(newJob);
+		return;
+	}
+
+	Push(std::move(newJob));
+}
+
+void JobSystem::RunAfter(JobCounter &dependency, JobFunction job, JobCounter* counter)
+{
+	// raised now so waiting on counter also waits for jobs that have not started yet
+	if (counter != nullptr)
+	{
+		counter->count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(dependency.continuationMutex);
+
+		if (dependency.count.load(std::memory_order_acquire) > 0)
+		{
+			dependency.continuations.push_back(std::make_pair(std::move(job), counter));
+			return;
+		}
+	}
+
+	Job newJob;
+	newJob.function = std::move(job);
+	newJob.counter = counter;
+
+	if (queues.empty())
+	{
+		Execute(newJob);
+		return;
+	}
+
+	Push(std::move(newJob));
+}
+
+void JobSystem::Wait(JobCounter &counter)
+{
+	Job job;
+
+	// the waiting thread helps with whatever is queued, not only the jobs of this counter
+	while (!counter.IsDone())
+	{
+		if (Pop(job))
+		{
+			Execute(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// the job that lowered the count may still hold the counter, it can be destroyed once that job lets go of it
+	std::lock_guard<std::mutex> lock(counter.continuationMutex);
+}
+
+void JobSystem::ParallelForRange(uint32 count, uint32 minBatchSize, const std::function<void(uint32 begin, uint32 end)> &func)
+{
+	if (count == 0)
+		return;
+
+	// a few ranges per thread even out ranges that take longer than others
+	uint32 rangeCount = GetThreadCount() * 4;
+	uint32 batchSize = (count + rangeCount - 1) / rangeCount;
+
+	batchSize = batchSize > minBatchSize ? batchSize : minBatchSize;
+	batchSize = batchSize > 0 ? batchSize : 1;
+
+	if (batchSize >= count)
+	{
+		func(0, count);
+		return;
+	}
+
+	JobCounter counter;
+
+	for (uint32 begin = batchSize; begin < count; begin += batchSize)
+	{
+		uint32 end = count - begin > batchSize ? begin + batchSize : count;
+
+		Run([&func, begin, end]() { func(begin, end); }, &counter);
+	}
+
+	// the calling thread takes the first range instead of waiting idle for a worker to pick it up
+	func(0, batchSize);
+
+	Wait(counter);
+}
+
+void JobSystem::Push(Job job)
+{
+	uint32 queueIndex = threadJobSystem == this ? threadQueueIndex : 0;
+
+	// counted first so a worker never takes a job that isn't counted yet
+	queuedJobs.fetch_add(1);
+
+	{
+		JobQueue &queue = *queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		queue.jobs.push_back(std::move(job));
+	}
+
+	// a worker going to sleep counts itself before checking for jobs, so one of the two always sees the other
+	if (sleepingWorkers.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		sleepCondition.notify_one();
+	}
+}
+
+bool JobSystem::Pop(Job &job)
+{
+	if (queuedJobs.load() == 0)
+		return false;
+
+	uint32 queueCount = static_cast<uint32>(queues.size());
+	uint32 ownIndex = threadJobSystem == this ? threadQueueIndex : 0;
+
+	// the newest job of the threads own queue is the most likely to find its data still in the cache
+	{
+		JobQueue &queue = *queues[ownIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (!queue.jobs.empty())
+		{
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+			queuedJobs.fetch_sub(1);
+			return true;
+		}
+	}
+
+	// steal the oldest job of another thread, starting with the next thread so thieves spread over the queues
+	for (uint32 q = 1; q < queueCount; q++)
+	{
+		JobQueue &queue = *queues[(ownIndex + q) % queueCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (!queue.jobs.empty())
+		{
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			queuedJobs.fetch_sub(1);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void JobSystem::Execute(Job &job)
+{
+	job.function();
+	job.function = nullptr;
+
+	JobCounter* counter = job.counter;
+
+	if (counter == nullptr)
+		return;
+
+	std::vector<std::pair<JobFunction, JobCounter*>> ready;
+
+	{
+		std::lock_guard<std::mutex> lock(counter->continuationMutex);
+
+		// the last job of the group starts the jobs that depend on it
+		if (counter->count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			ready.swap(counter->continuations);
+		}
+	}
+
+	for (auto &continuation : ready)
+	{
+		Job newJob;
+		newJob.function = std::move(continuation.first);
+		newJob.counter = continuation.second;
+
+		if (queues.empty())
+		{
+			Execute(newJob);
+		}
+		else
+		{
+			Push(std::move(newJob));
+		}
+	}
+}
+
+void JobSystem::WorkerLoop(uint32 queueIndex)
+{
+	threadJobSystem = this;
+	threadQueueIndex = queueIndex;
+
+	Job job;
+
+	while (true)
+	{
+		if (Pop(job))
+		{
+			Execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+
+		if (quit)
+			break;
+
+		sleepingWorkers.fetch_add(1);
+		sleepCondition.wait(lock, [this] { return quit || queuedJobs.load() > 0; });
+		sleepingWorkers.fetch_sub(1);
+	}
+}
@@ -0,0 +1,131 @@
+#include "MaterialTable.h"
+#include "IGraphicsDevice.h"
+
+MaterialTable::MaterialTable()
+{
+	texture = nullptr;
+	width = 0;
+	height = 0;
+	capacity = 0;
+	materialCount = 0;
+	nextLayer = 0;
+}
+
+bool MaterialTable::Create(IGraphicsDevice* device, uint32 width, uint32 height, uint32 capacity,
+						   TextureFilterMode filterMode, bool mipMaps)
+{
+	DS_ASSERT(texture == nullptr); // table must be released before it is created again
+	DS_ASSERT(capacity > 0); // table must hold at least one material
+
+	// shaders sample the table as an array, which a single layer texture is not
+	capacity = glm::max(capacity, 2u);
+
+	TextureSettings settings(width, height, TextureFormat::RGBA, TextureWrapMode::Repeat, filterMode,
+							 0.0f, mipMaps, false, capacity);
+
+	// the layers are left empty until materials are added
+	texture = device->CreateTexture(nullptr, settings);
+
+	if (texture == nullptr)
+	{
+		LOG_ERROR("Failed creating material table [%ux%u] with %u layers", width, height, capacity);
+		return false;
+	}
+
+	this->width = width;
+	this->height = height;
+	this->capacity = capacity;
+
+	return true;
+}
+
+void MaterialTable::Release(IGraphicsDevice* device)
+{
+	if (texture)
+	{
+		device->ReleaseTexture(texture);
+		texture = nullptr;
+	}
+
+	materialLayers.clear();
+	freeMaterials.clear();
+	freeLayers.clear();
+
+	materialCount = 0;
+	nextLayer = 0;
+}
+
+uint32 MaterialTable::AddMaterial(IGraphicsDevice* device, const uint8* data)
+{
+	DS_ASSERT(data); // material data must not be null
+
+	if (texture == nullptr)
+		return DS_INVALID_MATERIAL;
+
+	uint32 layer;
+
+	if (!freeLayers.empty())
+	{
+		layer = freeLayers.back();
+		freeLayers.pop_back();
+	}
+	else if (nextLayer < capacity)
+	{
+		layer = nextLayer++;
+	}
+	else
+	{
+		LOG_WARNING("Material table is full, %u materials", capacity);
+		return DS_INVALID_MATERIAL;
+	}
+
+	uint32 materialID;
+
+	if (!freeMaterials.empty())
+	{
+		materialID = freeMaterials.back();
+		freeMaterials.pop_back();
+		materialLayers[materialID] = layer;
+	}
+	else
+	{
+		materialID = static_cast<uint32>(materialLayers.size());
+		materialLayers.push_back(layer);
+	}
+
+	device->UpdateTextureLayer(texture, layer, data);
+	materialCount++;
+
+	return materialID;
+}
+
+void MaterialTable::UpdateMaterial(IGraphicsDevice* device, uint32 materialID, const uint8* data)
+{
+	DS_ASSERT(IsValid(materialID)); // material must be in the table
+
+	device->UpdateTextureLayer(texture, materialLayers[materialID], data);
+}
+
+void MaterialTable::RemoveMaterial(uint32 materialID)
+{
+	if (!IsValid(materialID))
+		return;
+
+	freeLayers.push_back(materialLayers[materialID]);
+	freeMaterials.push_back(materialID);
+
+	materialLayers[materialID] = DS_INVALID_MATERIAL;
+	materialCount--;
+}
+
+bool MaterialTable::IsValid(uint32 materialID) const
+{
+	return materialID < materialLayers.size() && materialLayers[materialID] != DS_INVALID_MATERIAL;
+}
+
+float MaterialTable::GetLayer(uint32 materialID) const
+{
+	DS_ASSERT(IsValid(materialID)); // material must be in the table
+
+	return static_cast<float>(materialLayers[materialID]);
+}
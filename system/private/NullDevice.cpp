@@ -0,0 +1,832 @@
+#include "NullDevice.h"
+
+std::string NullDevice::GetAPIName()
+{
+	return "Null";
+}
+
+bool NullDevice::Create(const RenderInfo& info)
+{
+	// the null device has no context, so there is nothing that can fail here
+	renderInfo = info;
+	framesInFlight = glm::clamp(info.framesInFlight, 1u, static_cast<uint32>(DS_MAX_FRAMES_IN_FLIGHT));
+
+	LOG("Created Null device : [%ux%u]", renderInfo.resolutionX, renderInfo.resolutionY);
+
+	return true;
+}
+
+void NullDevice::Initialize()
+{
+	// Create depth/stencil state
+	DepthStencilStateDesc defaultDepthStencilDesc;
+	defaultDepthStencilState = CreateDepthStencilState(defaultDepthStencilDesc);
+	SetDepthStencilState(defaultDepthStencilState);
+
+	SetViewport(0, 0, renderInfo.resolutionX, renderInfo.resolutionY);
+
+	DSRect defaultRect = DSRect(0, 0, renderInfo.resolutionX, renderInfo.resolutionY);
+	SetScissorRects(1, &defaultRect);
+}
+
+void NullDevice::Destroy()
+{
+	// readbacks still waiting on a Present are dropped without calling back
+	pendingReadbacks.clear();
+
+	// release every resource still held by a handle, meshes own their buffers
+	for (MeshNull &mesh : meshes)
+	{
+		delete mesh.vertexBuffer;
+		delete mesh.indexBuffer;
+	}
+
+	meshes.Clear();
+	shaders.Clear();
+	textures.Clear();
+	buffers.Clear();
+
+	// release every cached state object
+	blendStates.Clear([](BlendStateNull* state) { delete state; });
+	depthStencilStates.Clear([](DepthStencilStateNull* state) { delete state; });
+	rasterizerStates.Clear([](RasterizerStateNull* state) { delete state; });
+
+	defaultDepthStencilState = nullptr;
+	curDepthStencilState = nullptr;
+	curBlendState = nullptr;
+	curRasterizerState = nullptr;
+}
+
+void NullDevice::Clear()
+{
+
+}
+
+void NullDevice::Present()
+{
+	// move the counters of the finished frame in to the last frame and start counting a new frame
+	totalStats.Accumulate(curFrameStats);
+	lastFrameStats = curFrameStats;
+	curFrameStats.Reset();
+
+	frameCount++;
+	frameSlot = (frameSlot + 1) % framesInFlight;
+
+	// callbacks requesting more readbacks queue them for the next frame
+	std::vector<ReadbackNull> readbacks;
+	readbacks.swap(pendingReadbacks);
+
+	for (ReadbackNull &readback : readbacks)
+	{
+		readbackPixels.assign(readback.width * readback.height * 4, 0);
+
+		ReadbackData data;
+		data.pixels = readbackPixels.data();
+		data.width = readback.width;
+		data.height = readback.height;
+
+		readback.callback(data);
+	}
+}
+
+void NullDevice::SetVSync(bool enabled)
+{
+	// there is no display to sync to, frames are always presented immediately
+}
+
+void NullDevice::SetFramesInFlight(uint32 count)
+{
+	// nothing is ever in flight, the count only changes how slots cycle
+	framesInFlight = glm::clamp(count, 1u, static_cast<uint32>(DS_MAX_FRAMES_IN_FLIGHT));
+	frameSlot = 0;
+}
+
+void NullDevice::SetShader(Shader* shader)
+{
+	if (shader != nullptr)
+	{
+		curShader = shader;
+		curFrameStats.stateChanges++;
+	}
+}
+
+void NullDevice::SetTexture(Texture* texture, uint32 slot)
+{
+	if (texture != nullptr)
+	{
+		curFrameStats.stateChanges++;
+	}
+}
+
+void NullDevice::DrawMesh(Mesh* mesh)
+{
+	MeshNull* nullMesh = static_cast<MeshNull*>(mesh);
+
+	if (nullMesh != nullptr)
+	{
+		curFrameStats.drawCalls++;
+		curFrameStats.primitives += nullMesh->vertexCount / 3;
+	}
+}
+
+void NullDevice::DrawMeshIndexed(Mesh* mesh, uint32 elementCount, uint32 vertexOffset, uint32 indexOffset)
+{
+	MeshNull* nullMesh = static_cast<MeshNull*>(mesh);
+
+	if (nullMesh != nullptr)
+	{
+		if (elementCount == 0)
+		{
+			elementCount = nullMesh->indexCount;
+		}
+
+		curFrameStats.drawCalls++;
+		curFrameStats.primitives += elementCount / 3;
+	}
+}
+
+void NullDevice::DrawMeshIndexedInstanced(Mesh* mesh, Buffer* instanceBuffer, VertexAttributes instanceAttributeFlags, uint32 instanceCount,
+										  uint32 firstInstance, uint32 elementCount, uint32 vertexOffset, uint32 indexOffset)
+{
+	MeshNull* nullMesh = static_cast<MeshNull*>(mesh);
+	BufferNull* nullInstanceBuffer = static_cast<BufferNull*>(instanceBuffer);
+
+	if (nullMesh != nullptr && nullInstanceBuffer != nullptr)
+	{
+		uint32 instanceStride = GetAttributeMaskSize(instanceAttributeFlags);
+
+		if (instanceStride == 0 || (firstInstance + instanceCount) * instanceStride > nullInstanceBuffer->size)
+		{
+			LOG_ERROR("DrawMeshIndexedInstanced reads past the end of the instance buffer");
+			return;
+		}
+
+		if (elementCount == 0)
+		{
+			elementCount = nullMesh->indexCount;
+		}
+
+		curFrameStats.drawCalls++;
+		curFrameStats.primitives += (elementCount / 3) * instanceCount;
+	}
+}
+
+Mesh* NullDevice::CreateMesh(const MeshData &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage)
+{
+	uint32 stride = GetAttributeMaskSize(vertexAttributeFlags);
+
+	// Create vertex and index buffers
+	BufferNull* vertexBuffer = CreateBuffer(meshData.vertexData,
+											meshData.vertexCount * stride,
+											BufferTarget::Vertex, usage);
+
+	// sized the way the other devices store the indices, the null device never reads the data so it isn't converted
+	IndexFormat indexFormat = GetDeviceIndexFormat(meshData.indexFormat, meshData.vertexCount);
+
+	BufferNull* indexBuffer = CreateBuffer(meshData.indexData,
+										   meshData.indexCount * DS_INDEX_SIZE(indexFormat),
+										   BufferTarget::Index, usage);
+
+	curFrameStats.resourcesCreated++;
+
+	return new MeshNull(vertexBuffer, indexBuffer, meshData.vertexCount, meshData.indexCount, indexFormat, stride);
+}
+
+Mesh* NullDevice::CreateMesh(const MeshDataList &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage)
+{
+	uint32 stride = GetAttributeMaskSize(vertexAttributeFlags);
+
+	// Create vertex and index buffers
+	BufferNull* vertexBuffer = CreateBuffer(meshData.vertices, meshData.dataCount,
+											meshData.vertexCount * stride,
+											BufferTarget::Vertex, usage);
+
+	BufferNull* indexBuffer = CreateBuffer(meshData.indices, meshData.dataCount,
+										   meshData.indexCount * DS_INDEX_SIZE(meshData.indexFormat),
+										   BufferTarget::Index, usage);
+
+	curFrameStats.resourcesCreated++;
+
+	return new MeshNull(vertexBuffer, indexBuffer, meshData.vertexCount, meshData.indexCount, meshData.indexFormat, stride);
+}
+
+void NullDevice::UpdateMesh(Mesh* mesh, const MeshData &meshData)
+{
+	MeshNull* nullMesh = static_cast<MeshNull*>(mesh);
+
+	UpdateBuffer(nullMesh->vertexBuffer, meshData.vertexData, meshData.vertexCount * nullMesh->stride);
+	IndexFormat indexFormat = GetDeviceIndexFormat(meshData.indexFormat, meshData.vertexCount);
+	UpdateBuffer(nullMesh->indexBuffer, meshData.indexData, meshData.indexCount * DS_INDEX_SIZE(indexFormat));
+
+	nullMesh->vertexCount = meshData.vertexCount;
+	nullMesh->indexCount = meshData.indexCount;
+	nullMesh->indexFormat = indexFormat;
+}
+
+void NullDevice::UpdateMesh(Mesh* mesh, const MeshDataList &meshData)
+{
+	MeshNull* nullMesh = static_cast<MeshNull*>(mesh);
+
+	UpdateBuffer(nullMesh->vertexBuffer, meshData.vertices, meshData.dataCount, meshData.vertexCount * nullMesh->stride);
+	UpdateBuffer(nullMesh->indexBuffer, meshData.indices, meshData.dataCount, meshData.indexCount * DS_INDEX_SIZE(meshData.indexFormat));
+
+	nullMesh->vertexCount = meshData.vertexCount;
+	nullMesh->indexCount = meshData.indexCount;
+	nullMesh->indexFormat = meshData.indexFormat;
+}
+
+void NullDevice::ReleaseMesh(Mesh* mesh)
+{
+	MeshNull* nullMesh = static_cast<MeshNull*>(mesh);
+
+	if (nullMesh == nullptr)
+		return;
+
+	ReleaseBuffer(nullMesh->vertexBuffer);
+	ReleaseBuffer(nullMesh->indexBuffer);
+
+	curFrameStats.resourcesReleased++;
+
+	delete nullMesh;
+}
+
+void NullDevice::SetMeshArenasEnabled(bool enabled)
+{
+	// meshes own no GPU memory, there is nothing to share
+}
+
+void NullDevice::DefragmentMeshArenas()
+{
+}
+
+MeshArenaStats NullDevice::GetMeshArenaStats()
+{
+	return MeshArenaStats();
+}
+
+Shader* NullDevice::CreateShader(const std::string &name, ShaderFeatures features)
+{
+	// no source is compiled, every variant is just a name
+	curFrameStats.resourcesCreated++;
+
+	return new ShaderNull(name);
+}
+
+void NullDevice::ReleaseShader(Shader* shader)
+{
+	ShaderNull* nullShader = static_cast<ShaderNull*>(shader);
+
+	if (nullShader == nullptr)
+		return;
+
+	if (curShader == shader)
+	{
+		curShader = nullptr;
+	}
+
+	curFrameStats.resourcesReleased++;
+
+	delete nullShader;
+}
+
+Texture* NullDevice::CreateTexture(uint8 *data, const TextureSettings &settings)
+{
+	DS_ASSERT(settings.arraySize > 0); // texture must have at least one layer
+
+	// count the bytes of the top level of every layer, assuming 4 bytes per texel as the other devices do
+	curFrameStats.resourcesCreated++;
+	curFrameStats.bytesUploaded += settings.width * settings.height * 4 * settings.arraySize;
+
+	return new TextureNull(settings);
+}
+
+void NullDevice::UpdateTextureLayer(Texture* texture, uint32 layer, const uint8* data)
+{
+	TextureNull* nullTexture = static_cast<TextureNull*>(texture);
+
+	DS_ASSERT(nullTexture && data);							// texture and data must not be null
+	DS_ASSERT(layer < nullTexture->settings.arraySize);		// layer must be inside the array
+
+	curFrameStats.bytesUploaded += nullTexture->settings.width * nullTexture->settings.height * 4;
+}
+
+void NullDevice::ReleaseTexture(Texture* pTexture)
+{
+	TextureNull* nullTexture = static_cast<TextureNull*>(pTexture);
+
+	if (nullTexture == nullptr)
+		return;
+
+	curFrameStats.resourcesReleased++;
+
+	delete nullTexture;
+}
+
+Shader* NullDevice::CreateShaderAsync(const std::string &name, ShaderFeatures features)
+{
+	// nothing is compiled, so the shader is ready as soon as it is created
+	return CreateShader(name, features);
+}
+
+bool NullDevice::IsShaderReady(Shader* shader)
+{
+	DS_ASSERT(shader); // shader must not be null
+
+	return true;
+}
+
+Texture* NullDevice::CreateTextureAsync(const uint8* data, const TextureSettings &settings)
+{
+	// nothing is uploaded, so the texture is ready as soon as it is created
+	return CreateTexture(const_cast<uint8*>(data), settings);
+}
+
+bool NullDevice::IsTextureReady(Texture* texture)
+{
+	DS_ASSERT(texture); // texture must not be null
+
+	return true;
+}
+
+void NullDevice::SetTextureUploadBudget(uint32 bytesPerFrame)
+{
+	DS_ASSERT(bytesPerFrame > 0); // uploads would never complete
+}
+
+void NullDevice::SetUniformBuffer(uint32 slot, Buffer* buffer, ShaderStage stage)
+{
+	BufferNull* nullBuffer = static_cast<BufferNull*>(buffer);
+
+	DS_ASSERT(nullBuffer);									// nullBuffer must not be null
+	DS_ASSERT(nullBuffer->target == BufferTarget::Uniform);	// must be uniform buffer
+
+	curFrameStats.stateChanges++;
+}
+
+void NullDevice::SetUniformBufferRange(uint32 slot, Buffer* buffer, uint32 offset, uint32 size, ShaderStage stage)
+{
+	BufferNull* nullBuffer = static_cast<BufferNull*>(buffer);
+
+	DS_ASSERT(nullBuffer);										// nullBuffer must not be null
+	DS_ASSERT(nullBuffer->target == BufferTarget::Uniform);		// must be uniform buffer
+	DS_ASSERT(offset % NULL_UNIFORM_BUFFER_ALIGNMENT == 0);		// offset must be aligned
+	DS_ASSERT(offset + size <= nullBuffer->size);				// range must lie inside the buffer
+
+	curFrameStats.stateChanges++;
+}
+
+uint32 NullDevice::GetUniformBufferAlignment()
+{
+	return NULL_UNIFORM_BUFFER_ALIGNMENT;
+}
+
+BufferNull* NullDevice::CreateBuffer(const void* data, uint32 size, BufferTarget target, BufferUsage usage)
+{
+	curFrameStats.resourcesCreated++;
+
+	if (data)
+	{
+		curFrameStats.bytesUploaded += size;
+	}
+
+	return new BufferNull(size, target, usage);
+}
+
+BufferNull* NullDevice::CreateBuffer(const std::vector<BufferData> &data, uint32 dataCount, uint32 bufferSize, BufferTarget target, BufferUsage usage)
+{
+	curFrameStats.resourcesCreated++;
+
+	for (uint32 md = 0; md < dataCount; md++)
+	{
+		curFrameStats.bytesUploaded += data[md].sizeBytes;
+	}
+
+	return new BufferNull(bufferSize, target, usage);
+}
+
+void NullDevice::UpdateBuffer(Buffer* buffer, const void* data, uint32 size)
+{
+	BufferNull* nullBuffer = static_cast<BufferNull*>(buffer);
+
+	DS_ASSERT(nullBuffer);								// nullBuffer must not be null
+	DS_ASSERT(nullBuffer->usage != BufferUsage::Static);	// Static buffers should not be modified
+
+	// grow the buffer the same way the other devices do so that the recorded size matches
+	if (size > nullBuffer->size)
+	{
+		nullBuffer->size = size;
+	}
+
+	curFrameStats.bufferUpdates++;
+	curFrameStats.bytesUploaded += size;
+}
+
+void NullDevice::UpdateBuffer(Buffer* buffer, const std::vector<BufferData> &data, uint32 dataCount, uint32 bufferSize)
+{
+	BufferNull* nullBuffer = static_cast<BufferNull*>(buffer);
+
+	DS_ASSERT(nullBuffer);								// nullBuffer must not be null
+	DS_ASSERT(nullBuffer->usage != BufferUsage::Static);	// Static buffers should not be modified
+
+	if (bufferSize > nullBuffer->size)
+	{
+		nullBuffer->size = bufferSize;
+	}
+
+	for (uint32 md = 0; md < dataCount; md++)
+	{
+		curFrameStats.bytesUploaded += data[md].sizeBytes;
+	}
+
+	curFrameStats.bufferUpdates++;
+}
+
+void NullDevice::UpdateBufferRegion(Buffer* buffer, const void* data, uint32 offset, uint32 size)
+{
+	BufferNull* nullBuffer = static_cast<BufferNull*>(buffer);
+
+	DS_ASSERT(nullBuffer);									// nullBuffer must not be null
+	DS_ASSERT(nullBuffer->usage != BufferUsage::Static);	// Static buffers should not be modified
+	DS_ASSERT(nullBuffer->usage != BufferUsage::Stream);	// Stream buffers are written in full
+	DS_ASSERT(offset + size <= nullBuffer->size);			// region must lie inside the buffer
+
+	curFrameStats.bufferUpdates++;
+	curFrameStats.bytesUploaded += size;
+}
+
+void NullDevice::ReleaseBuffer(Buffer* buffer)
+{
+	BufferNull* nullBuffer = static_cast<BufferNull*>(buffer);
+
+	DS_ASSERT(nullBuffer); // nullBuffer must not be null
+
+	curFrameStats.resourcesReleased++;
+
+	delete nullBuffer;
+}
+
+MeshHandle NullDevice::CreateMeshHandle(const MeshData &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage)
+{
+	MeshNull* newMesh = static_cast<MeshNull*>(CreateMesh(meshData, vertexAttributeFlags, usage));
+
+	if (newMesh == nullptr)
+		return MeshHandle();
+
+	// the buffers now belong to the copy held by the container
+	MeshHandle handle = meshes.CreateResource(*newMesh);
+	delete newMesh;
+
+	return handle;
+}
+
+void NullDevice::UpdateMesh(MeshHandle mesh, const MeshData &meshData)
+{
+	MeshNull* nullMesh;
+	RESOLVE_HANDLE(nullMesh, meshes, mesh);
+
+	UpdateMesh(nullMesh, meshData);
+}
+
+void NullDevice::DrawMeshIndexed(MeshHandle mesh, uint32 elementCount, uint32 vertexOffset, uint32 indexOffset)
+{
+	MeshNull* nullMesh;
+	RESOLVE_HANDLE(nullMesh, meshes, mesh);
+
+	DrawMeshIndexed(nullMesh, elementCount, vertexOffset, indexOffset);
+}
+
+void NullDevice::ReleaseMesh(MeshHandle mesh)
+{
+	MeshNull* nullMesh;
+	RESOLVE_HANDLE(nullMesh, meshes, mesh);
+
+	ReleaseBuffer(nullMesh->vertexBuffer);
+	ReleaseBuffer(nullMesh->indexBuffer);
+
+	curFrameStats.resourcesReleased++;
+
+	meshes.ReleaseResource(mesh);
+}
+
+ShaderHandle NullDevice::CreateShaderHandle(const std::string &name)
+{
+	ShaderNull* newShader = static_cast<ShaderNull*>(CreateShader(name));
+
+	ShaderHandle handle = shaders.CreateResource(*newShader);
+	delete newShader;
+
+	return handle;
+}
+
+void NullDevice::SetShader(ShaderHandle shader)
+{
+	ShaderNull* nullShader;
+	RESOLVE_HANDLE(nullShader, shaders, shader);
+
+	SetShader(nullShader);
+}
+
+void NullDevice::ReleaseShader(ShaderHandle shader)
+{
+	ShaderNull* nullShader;
+	RESOLVE_HANDLE(nullShader, shaders, shader);
+
+	if (curShader == nullShader)
+	{
+		curShader = nullptr;
+	}
+
+	curFrameStats.resourcesReleased++;
+
+	shaders.ReleaseResource(shader);
+}
+
+TextureHandle NullDevice::CreateTextureHandle(uint8 *data, const TextureSettings &settings)
+{
+	TextureNull* newTexture = static_cast<TextureNull*>(CreateTexture(data, settings));
+
+	TextureHandle handle = textures.CreateResource(*newTexture);
+	delete newTexture;
+
+	return handle;
+}
+
+void NullDevice::SetTexture(TextureHandle texture, uint32 slot)
+{
+	TextureNull* nullTexture;
+	RESOLVE_HANDLE(nullTexture, textures, texture);
+
+	SetTexture(nullTexture, slot);
+}
+
+void NullDevice::ReleaseTexture(TextureHandle texture)
+{
+	TextureNull* nullTexture;
+	RESOLVE_HANDLE(nullTexture, textures, texture);
+
+	curFrameStats.resourcesReleased++;
+
+	textures.ReleaseResource(texture);
+}
+
+BufferHandle NullDevice::CreateBufferHandle(const void* data, uint32 size, BufferTarget target, BufferUsage usage)
+{
+	BufferNull* newBuffer = CreateBuffer(data, size, target, usage);
+
+	BufferHandle handle = buffers.CreateResource(*newBuffer);
+	delete newBuffer;
+
+	return handle;
+}
+
+void NullDevice::UpdateBuffer(BufferHandle buffer, const void* data, uint32 size)
+{
+	BufferNull* nullBuffer;
+	RESOLVE_HANDLE(nullBuffer, buffers, buffer);
+
+	UpdateBuffer(nullBuffer, data, size);
+}
+
+void NullDevice::UpdateBufferRegion(BufferHandle buffer, const void* data, uint32 offset, uint32 size)
+{
+	BufferNull* nullBuffer;
+	RESOLVE_HANDLE(nullBuffer, buffers, buffer);
+
+	UpdateBufferRegion(nullBuffer, data, offset, size);
+}
+
+void NullDevice::SetUniformBuffer(uint32 slot, BufferHandle buffer, ShaderStage stage)
+{
+	BufferNull* nullBuffer;
+	RESOLVE_HANDLE(nullBuffer, buffers, buffer);
+
+	SetUniformBuffer(slot, nullBuffer, stage);
+}
+
+void NullDevice::ReleaseBuffer(BufferHandle buffer)
+{
+	BufferNull* nullBuffer;
+	RESOLVE_HANDLE(nullBuffer, buffers, buffer);
+
+	curFrameStats.resourcesReleased++;
+
+	buffers.ReleaseResource(buffer);
+}
+
+RenderTarget* NullDevice::CreateRenderTarget(const RenderTargetDesc &desc)
+{
+	DS_ASSERT(desc.width > 0 && desc.height > 0);	// target must not be empty
+	DS_ASSERT(desc.sampleCount > 0);				// at least one sample is required
+
+	curFrameStats.resourcesCreated++;
+
+	return new RenderTargetNull(desc);
+}
+
+void NullDevice::ReleaseRenderTarget(RenderTarget* target)
+{
+	RenderTargetNull* nullTarget = static_cast<RenderTargetNull*>(target);
+
+	if (nullTarget == nullptr)
+		return;
+
+	curFrameStats.resourcesReleased++;
+
+	delete nullTarget;
+}
+
+void NullDevice::SetRenderTargets(uint32 numColorTargets, RenderTarget* const* pColorTargets, RenderTarget* depthTarget)
+{
+	DS_ASSERT(numColorTargets <= DS_MAX_RENDER_TARGETS);
+	DS_ASSERT(depthTarget == nullptr || IsDepthFormat(depthTarget->GetDesc().format));
+
+	for (uint32 t = 0; t < numColorTargets; t++)
+	{
+		DS_ASSERT(!IsDepthFormat(pColorTargets[t]->GetDesc().format));
+	}
+
+	curFrameStats.stateChanges++;
+}
+
+void NullDevice::ClearRenderTarget(RenderTarget* target, const vec4 &color, float depth, uint8 stencil)
+{
+	DS_ASSERT(target); // target must not be null
+}
+
+void NullDevice::ResolveRenderTarget(RenderTarget* source, RenderTarget* destination)
+{
+	DS_ASSERT(source && destination);										// targets must not be null
+	DS_ASSERT(source->GetDesc().sampleCount > 1);							// source must be multisampled
+	DS_ASSERT(destination->GetDesc().sampleCount == 1);						// destination must be single sampled
+	DS_ASSERT(source->GetDesc().width == destination->GetDesc().width &&
+			  source->GetDesc().height == destination->GetDesc().height);	// targets must be the same size
+}
+
+void NullDevice::RequestReadback(RenderTarget* target, ReadbackCallback callback)
+{
+	DS_ASSERT(callback); // callback must be set
+
+	ReadbackNull readback;
+	readback.width = renderInfo.resolutionX;
+	readback.height = renderInfo.resolutionY;
+	readback.callback = std::move(callback);
+
+	if (target)
+	{
+		const RenderTargetDesc &desc = target->GetDesc();
+
+		DS_ASSERT(desc.format == RenderTargetFormat::RGBA8);	// only RGBA8 targets can be read back
+		DS_ASSERT(desc.sampleCount <= 1);						// multisampled targets must be resolved first
+
+		readback.width = desc.width;
+		readback.height = desc.height;
+	}
+
+	pendingReadbacks.push_back(std::move(readback));
+}
+
+void NullDevice::SetScissorRects(uint32 numRects, const DSRect* pRects)
+{
+	if (!pRects)
+		return;
+
+	numScissorRects = glm::min(numRects, static_cast<uint32>(NULL_MAX_SCISSOR_RECTS));
+
+	for (uint32 r = 0; r < numScissorRects; r++)
+	{
+		scissorRects[r] = pRects[r];
+	}
+
+	curFrameStats.stateChanges++;
+}
+
+void NullDevice::GetScissorRects(uint32* pNumRects, DSRect* pRects)
+{
+	if (pNumRects)
+		*pNumRects = numScissorRects;
+
+	if (pRects)
+	{
+		for (uint32 r = 0; r < numScissorRects; r++)
+		{
+			pRects[r] = scissorRects[r];
+		}
+	}
+}
+
+BlendState* NullDevice::CreateBlendState(BlendProperties properties)
+{
+	// return the existing state if one was already created with the same properties
+	uint32 key = properties.CalculateKey();
+	BlendStateNull* state = blendStates.Find(key, properties);
+
+	if (state != nullptr)
+		return state;
+
+	state = new BlendStateNull();
+	state->properties = properties;
+
+	curFrameStats.resourcesCreated++;
+
+	return blendStates.Add(key, properties, state);
+}
+
+void NullDevice::SetBlendState(BlendState* state)
+{
+	if (state == nullptr)
+		return;
+
+	if (curBlendState != state)
+	{
+		curBlendState = state;
+		curFrameStats.stateChanges++;
+	}
+}
+
+DepthStencilStateNull* NullDevice::CreateDepthStencilState(DepthStencilStateDesc& desc)
+{
+	// return the existing state if one was already created with the same descriptor
+	uint32 key = desc.CalculateKey();
+	DepthStencilStateNull* state = depthStencilStates.Find(key, desc);
+
+	if (state != nullptr)
+		return state;
+
+	curFrameStats.resourcesCreated++;
+
+	return depthStencilStates.Add(key, desc, new DepthStencilStateNull(desc));
+}
+
+DepthStencilState* NullDevice::GetCurrentDepthStencilState()
+{
+	return curDepthStencilState;
+}
+
+void NullDevice::SetDepthStencilState(DepthStencilState* state)
+{
+	DepthStencilStateNull* nullState = static_cast<DepthStencilStateNull*>(state);
+
+	if (state == nullptr)
+	{
+		SetDepthStencilState(defaultDepthStencilState);
+		return;
+	}
+
+	if (curDepthStencilState != nullState)
+	{
+		curDepthStencilState = nullState;
+		curFrameStats.stateChanges++;
+	}
+}
+
+RasterizerState* NullDevice::CreateRasterizerState(const RasterizerStateDesc &desc)
+{
+	// return the existing state if one was already created with the same descriptor
+	uint32 key = desc.CalculateKey();
+	RasterizerStateNull* state = rasterizerStates.Find(key, desc);
+
+	if (state != nullptr)
+		return state;
+
+	state = new RasterizerStateNull();
+	state->desc = desc;
+
+	curFrameStats.resourcesCreated++;
+
+	return rasterizerStates.Add(key, desc, state);
+}
+
+void NullDevice::SetRasterizerState(RasterizerState* state)
+{
+	if (state == nullptr)
+		return;
+
+	if (curRasterizerState != state)
+	{
+		curRasterizerState = state;
+		curFrameStats.stateChanges++;
+	}
+}
+
+GraphicsStats NullDevice::GetFrameStats()
+{
+	return lastFrameStats;
+}
+
+void NullDevice::SetClearColor(const vec4 &color)
+{
+	clearColor = color;
+}
+
+void NullDevice::SetViewport(int32 x, int32 y, int32 width, int32 height)
+{
+	curFrameStats.stateChanges++;
+}
+
+void NullDevice::OnResolutionChanged(uint32 width, uint32 height)
+{
+	renderInfo.resolutionX = width;
+	renderInfo.resolutionY = height;
+
+	SetViewport(0, 0, width, height);
+}
\ No newline at end of file
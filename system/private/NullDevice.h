@@ -0,0 +1,315 @@
+#ifndef _NULL_DEVICE_H
+#define _NULL_DEVICE_H
+
+#include "IGraphicsDevice.h"
+#include "utility/StateCache.h"
+
+#define NULL_MAX_SCISSOR_RECTS 16
+
+// matches the strictest alignment of the other devices so range offsets that work here work everywhere
+#define NULL_UNIFORM_BUFFER_ALIGNMENT 256
+
+// ==============================================
+// Null Resources
+// ==============================================
+
+// the null device keeps only the bookkeeping data of each resource, no vertex, index or texel data is stored
+
+class BufferNull : public Buffer
+{
+public:
+
+	BufferNull(uint32 size, BufferTarget target, BufferUsage usage) :
+		size(size),
+		target(target),
+		usage(usage)
+	{}
+
+	uint32 size;
+	BufferTarget target;
+	BufferUsage usage;
+};
+
+class MeshNull : public Mesh
+{
+public:
+
+	MeshNull(BufferNull* vertexBuffer, BufferNull* indexBuffer, uint32 vertexCount, uint32 indexCount, IndexFormat indexFormat, uint32 stride) :
+		vertexBuffer(vertexBuffer),
+		indexBuffer(indexBuffer),
+		vertexCount(vertexCount),
+		indexCount(indexCount),
+		indexFormat(indexFormat),
+		stride(stride)
+	{}
+
+	BufferNull* vertexBuffer;
+	BufferNull* indexBuffer;
+
+	uint32 vertexCount;
+	uint32 indexCount;
+	IndexFormat indexFormat;
+
+	uint32 stride;
+};
+
+class ShaderNull : public Shader
+{
+public:
+
+	ShaderNull(const std::string &name) :
+		name(name)
+	{}
+
+	std::string name;
+};
+
+class TextureNull : public Texture
+{
+public:
+
+	TextureNull(const TextureSettings &settings) :
+		settings(settings)
+	{}
+
+	TextureSettings settings;
+};
+
+class RenderTargetNull : public RenderTarget
+{
+public:
+
+	RenderTargetNull(const RenderTargetDesc &desc) :
+		RenderTarget(desc),
+		sampleTexture(TextureSettings(desc.width, desc.height, TextureFormat::RGBA, TextureWrapMode::Clamp, TextureFilterMode::Bilinear, 0.0f, false))
+	{
+		if (desc.sampleCount <= 1)
+		{
+			texture = &sampleTexture;
+		}
+	}
+
+	TextureNull sampleTexture;
+};
+
+// a readback waiting for the next Present, nothing is rendered so the callback is given zeroed pixels
+struct ReadbackNull
+{
+	uint32 width;
+	uint32 height;
+	ReadbackCallback callback;
+};
+
+class BlendStateNull : public BlendState {};
+
+class RasterizerStateNull : public RasterizerState {};
+
+class DepthStencilStateNull : public DepthStencilState
+{
+public:
+
+	DepthStencilStateNull(const DepthStencilStateDesc &desc) :
+		desc(desc)
+	{}
+
+	DepthStencilStateDesc desc;
+};
+
+// ==============================================
+
+// NullDevice implements IGraphicsDevice without a context or a window, every call is accepted and counted
+// allowing the CPU side cost of the demo system and demos to be measured on machines without a GPU
+class NullDevice : public IGraphicsDevice
+{
+public:
+
+	std::string GetAPIName();
+
+	bool Create(const RenderInfo& info);
+
+	void Initialize();
+	void Destroy();
+
+	void Clear();
+	void Present();
+
+	void SetVSync(bool enabled);
+
+	void SetFramesInFlight(uint32 count);
+
+	uint32 GetFramesInFlight() { return framesInFlight; }
+
+	uint32 GetFrameSlot() { return frameSlot; }
+
+	void SetShader(Shader* shader);
+
+	void SetTexture(Texture* texture, uint32 slot);
+
+	void SetClearColor(const vec4 &color);
+
+	void SetViewport(int32 x, int32 y, int32 width, int32 height);
+
+	void OnResolutionChanged(uint32 width, uint32 height);
+
+	void DrawMesh(Mesh* mesh);
+	void DrawMeshIndexed(Mesh* mesh, uint32 elementCount = 0, uint32 vertexOffset = 0, uint32 indexOffset = 0);
+
+	void DrawMeshIndexedInstanced(Mesh* mesh, Buffer* instanceBuffer, VertexAttributes instanceAttributeFlags, uint32 instanceCount,
+								  uint32 firstInstance = 0, uint32 elementCount = 0, uint32 vertexOffset = 0, uint32 indexOffset = 0);
+
+	// Mesh Resource Handling
+	Mesh* CreateMesh(const MeshData &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage);
+
+	Mesh* CreateMesh(const MeshDataList &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage);
+
+	void UpdateMesh(Mesh* mesh, const MeshData &meshData);
+
+	void UpdateMesh(Mesh* mesh, const MeshDataList &meshData);
+
+	void ReleaseMesh(Mesh* mesh);
+
+	// Mesh Arenas
+	void SetMeshArenasEnabled(bool enabled);
+	void DefragmentMeshArenas();
+	MeshArenaStats GetMeshArenaStats();
+
+	Shader* CreateShader(const std::string &name, ShaderFeatures features = ShaderFeatures::None);
+	void ReleaseShader(Shader* shader);
+
+	Shader* CreateShaderAsync(const std::string &name, ShaderFeatures features = ShaderFeatures::None);
+
+	bool IsShaderReady(Shader* shader);
+
+	Texture* CreateTexture(uint8 *data, const TextureSettings &settings);
+	void ReleaseTexture(Texture* pTexture);
+	void UpdateTextureLayer(Texture* texture, uint32 layer, const uint8* data);
+
+	Texture* CreateTextureAsync(const uint8* data, const TextureSettings &settings);
+
+	bool IsTextureReady(Texture* texture);
+
+	void SetTextureUploadBudget(uint32 bytesPerFrame);
+
+	// Uniform Buffer Resource Handling
+	void SetUniformBuffer(uint32 slot, Buffer* buffer, ShaderStage stage);
+	void SetUniformBufferRange(uint32 slot, Buffer* buffer, uint32 offset, uint32 size, ShaderStage stage);
+
+	uint32 GetUniformBufferAlignment();
+
+	// Buffer Resource Handling
+	BufferNull* CreateBuffer(const void* data, uint32 size, BufferTarget target, BufferUsage usage);
+	BufferNull* CreateBuffer(const std::vector<BufferData> &data, uint32 dataCount, uint32 bufferSize, BufferTarget target, BufferUsage usage);
+
+	void UpdateBuffer(Buffer* buffer, const void* data, uint32 size);
+	void UpdateBuffer(Buffer* buffer, const std::vector<BufferData> &data, uint32 dataCount, uint32 bufferSize);
+
+	void UpdateBufferRegion(Buffer* buffer, const void* data, uint32 offset, uint32 size);
+
+	void ReleaseBuffer(Buffer* buffer);
+
+	// Handle Resources
+	MeshHandle CreateMeshHandle(const MeshData &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage);
+	void UpdateMesh(MeshHandle mesh, const MeshData &meshData);
+	void DrawMeshIndexed(MeshHandle mesh, uint32 elementCount = 0, uint32 vertexOffset = 0, uint32 indexOffset = 0);
+	void ReleaseMesh(MeshHandle mesh);
+
+	ShaderHandle CreateShaderHandle(const std::string &name);
+	void SetShader(ShaderHandle shader);
+	void ReleaseShader(ShaderHandle shader);
+
+	TextureHandle CreateTextureHandle(uint8 *data, const TextureSettings &settings);
+	void SetTexture(TextureHandle texture, uint32 slot);
+	void ReleaseTexture(TextureHandle texture);
+
+	BufferHandle CreateBufferHandle(const void* data, uint32 size, BufferTarget target, BufferUsage usage);
+	void UpdateBuffer(BufferHandle buffer, const void* data, uint32 size);
+	void UpdateBufferRegion(BufferHandle buffer, const void* data, uint32 offset, uint32 size);
+	void SetUniformBuffer(uint32 slot, BufferHandle buffer, ShaderStage stage);
+	void ReleaseBuffer(BufferHandle buffer);
+
+	// Render Targets
+	RenderTarget* CreateRenderTarget(const RenderTargetDesc &desc);
+	void ReleaseRenderTarget(RenderTarget* target);
+
+	void SetRenderTargets(uint32 numColorTargets, RenderTarget* const* pColorTargets, RenderTarget* depthTarget);
+
+	void ClearRenderTarget(RenderTarget* target, const vec4 &color, float depth = 1.0f, uint8 stencil = 0);
+
+	void ResolveRenderTarget(RenderTarget* source, RenderTarget* destination);
+
+	void RequestReadback(RenderTarget* target, ReadbackCallback callback);
+
+	// Scissor
+	void SetScissorRects(uint32 numRects, const DSRect* pRects);
+
+	void GetScissorRects(uint32* pNumRects, DSRect* pRects);
+
+	// Blend State
+	BlendState* CreateBlendState(BlendProperties properties);
+
+	void SetBlendState(BlendState* state);
+
+	// Depth/Stencil State
+	DepthStencilStateNull* CreateDepthStencilState(DepthStencilStateDesc& desc);
+
+	DepthStencilState* GetCurrentDepthStencilState();
+
+	void SetDepthStencilState(DepthStencilState* state);
+
+	// Rasterizer State
+	RasterizerState* CreateRasterizerState(const RasterizerStateDesc &desc);
+
+	void SetRasterizerState(RasterizerState* state);
+
+	// Statistics
+	GraphicsStats GetFrameStats();
+
+	// returns the counters accumulated over every frame presented since the device was created
+	const GraphicsStats& GetTotalStats() { return totalStats; }
+
+	// returns the number of frames presented since the device was created
+	uint64 GetFrameCount() { return frameCount; }
+
+private:
+
+	RenderInfo renderInfo;
+
+	// counters for the frame currently being recorded, the last presented frame and all frames
+	GraphicsStats curFrameStats;
+	GraphicsStats lastFrameStats;
+	GraphicsStats totalStats;
+	uint64 frameCount = 0;
+
+	// frame slots are still cycled so code versioning resources by slot behaves as it does on the GPU devices
+	uint32 framesInFlight = DS_MAX_FRAMES_IN_FLIGHT;
+	uint32 frameSlot = 0;
+
+	// readbacks requested since the last Present and the zeroed pixels passed to their callbacks
+	std::vector<ReadbackNull> pendingReadbacks;
+	std::vector<uint8> readbackPixels;
+
+	// States
+	Shader* curShader = nullptr;
+	BlendState* curBlendState = nullptr;
+	DepthStencilStateNull* defaultDepthStencilState = nullptr;
+	DepthStencilStateNull* curDepthStencilState = nullptr;
+	RasterizerState* curRasterizerState = nullptr;
+
+	// every state object created is kept here, identical descriptors share one object
+	StateCache<BlendProperties, BlendStateNull> blendStates;
+	StateCache<DepthStencilStateDesc, DepthStencilStateNull> depthStencilStates;
+	StateCache<RasterizerStateDesc, RasterizerStateNull> rasterizerStates;
+
+	// resources created through handles
+	ResourceContainer<MeshNull, MeshHandle> meshes;
+	ResourceContainer<ShaderNull, ShaderHandle> shaders;
+	ResourceContainer<TextureNull, TextureHandle> textures;
+	ResourceContainer<BufferNull, BufferHandle> buffers;
+
+	DSRect scissorRects[NULL_MAX_SCISSOR_RECTS];
+	uint32 numScissorRects = 0;
+
+	vec4 clearColor;
+};
+
+#endif // _NULL_DEVICE_H
\ No newline at end of file
@@ -0,0 +1,475 @@
+#include "RenderGraph.h"
+#include "RenderTargetPool.h"
+#include "IGraphicsDevice.h"
+
+#include <algorithm>
+
+RenderGraphPassBuilder& RenderGraphPassBuilder::Read(RenderGraphResource resource)
+{
+	DS_ASSERT(resource.index < graph->resources.size()); // resource must belong to the graph
+
+	graph->passes[passIndex].reads.push_back(resource.index);
+
+	return *this;
+}
+
+RenderGraphPassBuilder& RenderGraphPassBuilder::Write(RenderGraphResource resource)
+{
+	DS_ASSERT(resource.index < graph->resources.size()); // resource must belong to the graph
+
+	graph->passes[passIndex].writes.push_back(resource.index);
+	graph->resources[resource.index].writers.push_back(passIndex);
+
+	return *this;
+}
+
+RenderGraphPassBuilder& RenderGraphPassBuilder::SideEffect()
+{
+	graph->passes[passIndex].sideEffect = true;
+
+	return *this;
+}
+
+void RenderGraph::Reset()
+{
+	resources.clear();
+	passes.clear();
+	order.clear();
+	targets.clear();
+
+	backBufferIndex = RENDER_GRAPH_INVALID_INDEX;
+	stats = RenderGraphStats();
+}
+
+RenderGraphResource RenderGraph::CreateTarget(const char* name, const RenderTargetDesc &desc)
+{
+	ResourceNode node;
+	node.name = name;
+	node.desc = desc;
+	node.imported = false;
+	node.readerCount = 0;
+	node.refCount = 0;
+	node.firstUse = RENDER_GRAPH_INVALID_INDEX;
+	node.lastUse = 0;
+	node.targetIndex = RENDER_GRAPH_INVALID_INDEX;
+
+	resources.push_back(node);
+
+	RenderGraphResource resource;
+	resource.index = static_cast<uint32>(resources.size()) - 1;
+
+	return resource;
+}
+
+RenderGraphResource RenderGraph::ImportBackBuffer(uint32 width, uint32 height)
+{
+	DS_ASSERT(backBufferIndex == RENDER_GRAPH_INVALID_INDEX); // the back buffer can only be imported once
+
+	RenderGraphResource resource = CreateTarget("BackBuffer", RenderTargetDesc(width, height));
+	resources[resource.index].imported = true;
+
+	backBufferIndex = resource.index;
+
+	return resource;
+}
+
+RenderGraphPassBuilder RenderGraph::AddPass(const char* name, RenderGraphExecute execute)
+{
+	PassNode pass;
+	pass.name = name;
+	pass.execute = execute;
+	pass.sideEffect = false;
+	pass.culled = false;
+	pass.refCount = 0;
+
+	passes.push_back(pass);
+
+	return RenderGraphPassBuilder(this, static_cast<uint32>(passes.size()) - 1);
+}
+
+void RenderGraph::Compile()
+{
+	CullPasses();
+	OrderPasses();
+	AssignTargets();
+
+	stats.passCount = static_cast<uint32>(passes.size());
+	stats.culledPassCount = stats.passCount - static_cast<uint32>(order.size());
+}
+
+void RenderGraph::CullPasses()
+{
+	// a pass is kept while something reads one of its outputs, the back buffer and side effects are always read
+	for (PassNode &pass : passes)
+	{
+		pass.refCount = static_cast<uint32>(pass.writes.size()) + (pass.sideEffect ? 1 : 0);
+		pass.culled = false;
+	}
+
+	// a pass reading a resource it also writes, such as blending on to it, does not keep itself alive
+	for (ResourceNode &resource : resources)
+	{
+		resource.readerCount = 0;
+	}
+
+	for (const PassNode &pass : passes)
+	{
+		for (uint32 read : pass.reads)
+		{
+			if (!Writes(pass, read))
+				resources[read].readerCount++;
+		}
+	}
+
+	std::vector<uint32> unreferenced;
+
+	for (uint32 r = 0; r < resources.size(); r++)
+	{
+		ResourceNode &resource = resources[r];
+		resource.refCount = resource.readerCount + (resource.imported ? 1 : 0);
+
+		if (resource.refCount == 0)
+		{
+			unreferenced.push_back(r);
+		}
+	}
+
+	// a pass that writes nothing and has no side effects has no results to keep it, it is culled straight away
+	for (PassNode &pass : passes)
+	{
+		if (pass.refCount > 0)
+			continue;
+
+		pass.culled = true;
+
+		for (uint32 read : pass.reads)
+		{
+			if (!Writes(pass, read) && --resources[read].refCount == 0)
+			{
+				unreferenced.push_back(read);
+			}
+		}
+	}
+
+	// culling a pass releases its reads, which can leave the passes writing them unreferenced in turn
+	while (!unreferenced.empty())
+	{
+		ResourceNode &resource = resources[unreferenced.back()];
+		unreferenced.pop_back();
+
+		for (uint32 writer : resource.writers)
+		{
+			PassNode &pass = passes[writer];
+
+			if (pass.culled || --pass.refCount > 0)
+				continue;
+
+			pass.culled = true;
+
+			for (uint32 read : pass.reads)
+			{
+				if (!Writes(pass, read) && --resources[read].refCount == 0)
+				{
+					unreferenced.push_back(read);
+				}
+			}
+		}
+	}
+}
+
+void RenderGraph::OrderPasses()
+{
+	uint32 passCount = static_cast<uint32>(passes.size());
+
+	// a pass runs after every pass writing a resource it only reads, and after the passes added before it that
+	// write the same resources. Passes that do not depend on each other keep the order they were added in
+	std::vector<std::vector<uint32>> dependencies(passCount);
+
+	for (uint32 p = 0; p < passCount; p++)
+	{
+		const PassNode &pass = passes[p];
+
+		if (pass.culled)
+			continue;
+
+		for (uint32 read : pass.reads)
+		{
+			if (Writes(pass, read))
+				continue;
+
+			if (resources[read].writers.empty() && !resources[read].imported)
+			{
+				LOG_WARNING("Render graph pass %s reads %s which no pass writes", pass.name, resources[read].name);
+			}
+
+			for (uint32 writer : resources[read].writers)
+			{
+				if (!passes[writer].culled)
+					dependencies[p].push_back(writer);
+			}
+		}
+
+		for (uint32 write : pass.writes)
+		{
+			for (uint32 writer : resources[write].writers)
+			{
+				if (writer < p)
+					dependencies[p].push_back(writer);
+			}
+		}
+	}
+
+	order.clear();
+
+	std::vector<bool> scheduled(passCount, false);
+	uint32 remaining = 0;
+
+	for (uint32 p = 0; p < passCount; p++)
+	{
+		remaining += passes[p].culled ? 0 : 1;
+	}
+
+	// there are few passes, the earliest added pass that is ready is found with a linear scan each time
+	while (remaining > 0)
+	{
+		uint32 next = RENDER_GRAPH_INVALID_INDEX;
+
+		for (uint32 p = 0; p < passCount && next == RENDER_GRAPH_INVALID_INDEX; p++)
+		{
+			if (passes[p].culled || scheduled[p])
+				continue;
+
+			bool ready = true;
+
+			for (uint32 dependency : dependencies[p])
+			{
+				ready &= scheduled[dependency];
+			}
+
+			if (ready)
+			{
+				next = p;
+			}
+		}
+
+		if (next == RENDER_GRAPH_INVALID_INDEX)
+		{
+			LOG_ERROR("Render graph has a cycle, the remaining passes run in the order they were added");
+
+			for (uint32 p = 0; p < passCount; p++)
+			{
+				if (!passes[p].culled && !scheduled[p])
+				{
+					order.push_back(p);
+				}
+			}
+
+			break;
+		}
+
+		scheduled[next] = true;
+		order.push_back(next);
+		remaining--;
+	}
+}
+
+void RenderGraph::AssignTargets()
+{
+	targets.clear();
+
+	// lifetimes in execution order
+	for (uint32 i = 0; i < order.size(); i++)
+	{
+		const PassNode &pass = passes[order[i]];
+
+		auto markUse = [this, i](uint32 r)
+		{
+			resources[r].firstUse = glm::min(resources[r].firstUse, i);
+			resources[r].lastUse = glm::max(resources[r].lastUse, i);
+		};
+
+		std::for_each(pass.reads.begin(), pass.reads.end(), markUse);
+		std::for_each(pass.writes.begin(), pass.writes.end(), markUse);
+	}
+
+	stats.resourceCount = 0;
+	stats.targetBytes = 0;
+	stats.unaliasedBytes = 0;
+
+	// resources are placed in the order they are first used, reusing a target whose last user runs before them
+	std::vector<uint32> placement;
+
+	for (uint32 r = 0; r < resources.size(); r++)
+	{
+		if (!resources[r].imported && resources[r].firstUse != RENDER_GRAPH_INVALID_INDEX)
+		{
+			placement.push_back(r);
+		}
+	}
+
+	std::sort(placement.begin(), placement.end(), [this](uint32 a, uint32 b)
+	{
+		return resources[a].firstUse < resources[b].firstUse;
+	});
+
+	for (uint32 r : placement)
+	{
+		ResourceNode &resource = resources[r];
+		const RenderTargetDesc &desc = resource.desc;
+
+		uint64 bytes = static_cast<uint64>(desc.width) * desc.height * GetFormatSize(desc.format) * glm::max(desc.sampleCount, 1u);
+
+		stats.resourceCount++;
+		stats.unaliasedBytes += bytes;
+
+		for (uint32 t = 0; t < targets.size(); t++)
+		{
+			if (targets[t].desc == desc && targets[t].lastUse < resource.firstUse)
+			{
+				resource.targetIndex = t;
+				break;
+			}
+		}
+
+		if (resource.targetIndex == RENDER_GRAPH_INVALID_INDEX)
+		{
+			TransientTarget target;
+			target.desc = desc;
+			target.firstUse = resource.firstUse;
+			target.target = nullptr;
+
+			resource.targetIndex = static_cast<uint32>(targets.size());
+			targets.push_back(target);
+
+			stats.targetBytes += bytes;
+		}
+
+		targets[resource.targetIndex].lastUse = resource.lastUse;
+	}
+
+	stats.targetCount = static_cast<uint32>(targets.size());
+}
+
+void RenderGraph::Execute(IGraphicsDevice* device, RenderTargetPool &pool, const RenderGraphPassEnd &passEnd)
+{
+	for (uint32 i = 0; i < order.size(); i++)
+	{
+		const PassNode &pass = passes[order[i]];
+
+		for (TransientTarget &target : targets)
+		{
+			if (target.firstUse == i)
+			{
+				target.target = pool.Acquire(device, target.desc);
+			}
+		}
+
+		BindPassTargets(device, pass);
+
+		if (pass.execute)
+		{
+			pass.execute(device, *this);
+		}
+
+		if (passEnd)
+		{
+			passEnd(device);
+		}
+
+		// returned straight away so later passes in the frame can reuse the target
+		for (TransientTarget &target : targets)
+		{
+			if (target.lastUse == i && target.target)
+			{
+				pool.Release(target.target);
+				target.target = nullptr;
+			}
+		}
+	}
+
+	device->SetRenderTargets(0, nullptr, nullptr);
+
+	if (backBufferIndex != RENDER_GRAPH_INVALID_INDEX)
+	{
+		const RenderTargetDesc &desc = resources[backBufferIndex].desc;
+		device->SetViewport(0, 0, desc.width, desc.height);
+	}
+}
+
+RenderTarget* RenderGraph::GetTarget(RenderGraphResource resource) const
+{
+	if (!resource.IsValid() || resources[resource.index].targetIndex == RENDER_GRAPH_INVALID_INDEX)
+		return nullptr;
+
+	return targets[resources[resource.index].targetIndex].target;
+}
+
+Texture* RenderGraph::GetTexture(RenderGraphResource resource) const
+{
+	RenderTarget* target = GetTarget(resource);
+
+	return target ? target->GetTexture() : nullptr;
+}
+
+void RenderGraph::BindPassTargets(IGraphicsDevice* device, const PassNode &pass)
+{
+	// side effect passes that write nothing get the back buffer rather than the targets of the previous pass
+	if (pass.writes.empty())
+	{
+		device->SetRenderTargets(0, nullptr, nullptr);
+
+		if (backBufferIndex != RENDER_GRAPH_INVALID_INDEX)
+		{
+			const RenderTargetDesc &desc = resources[backBufferIndex].desc;
+			device->SetViewport(0, 0, desc.width, desc.height);
+		}
+
+		return;
+	}
+
+	RenderTarget* colorTargets[DS_MAX_RENDER_TARGETS];
+	uint32 numColorTargets = 0;
+	RenderTarget* depthTarget = nullptr;
+
+	const RenderTargetDesc* viewportDesc = nullptr;
+
+	for (uint32 write : pass.writes)
+	{
+		const ResourceNode &resource = resources[write];
+
+		// a pass writing the back buffer renders to it with its own depth buffer
+		if (resource.imported)
+		{
+			device->SetRenderTargets(0, nullptr, nullptr);
+			device->SetViewport(0, 0, resource.desc.width, resource.desc.height);
+			return;
+		}
+
+		RenderTarget* target = targets[resource.targetIndex].target;
+
+		if (IsDepthFormat(resource.desc.format))
+		{
+			depthTarget = target;
+		}
+		else if (numColorTargets < DS_MAX_RENDER_TARGETS)
+		{
+			colorTargets[numColorTargets++] = target;
+		}
+
+		viewportDesc = &resource.desc;
+	}
+
+	device->SetRenderTargets(numColorTargets, colorTargets, depthTarget);
+	device->SetViewport(0, 0, viewportDesc->width, viewportDesc->height);
+}
+
+bool RenderGraph::Writes(const PassNode &pass, uint32 resourceIndex) const
+{
+	for (uint32 write : pass.writes)
+	{
+		if (write == resourceIndex)
+			return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,250 @@
+#include "RenderQueue.h"
+#include "IGraphicsDevice.h"
+
+// sort key layout, from the most significant bit
+// opaque		| 0 | shader 11 | state 14 | texture 14 | depth 24 |
+// transparent	| 1 | inverted depth 24 | shader 11 | state 14 | texture 14 |
+// state is the blend (5 bits), depth/stencil (5 bits) and rasterizer (4 bits) state ids
+// ids larger than their field wrap around, draws are still correct but may not be grouped as well
+
+#define KEY_SHADER_BITS 11
+#define KEY_BLEND_BITS 5
+#define KEY_DEPTH_STENCIL_BITS 5
+#define KEY_RASTERIZER_BITS 4
+#define KEY_STATE_BITS (KEY_BLEND_BITS + KEY_DEPTH_STENCIL_BITS + KEY_RASTERIZER_BITS)
+#define KEY_TEXTURE_BITS 14
+#define KEY_DEPTH_BITS 24
+
+#define KEY_MASK(_bits) ((1u << (_bits)) - 1)
+
+#define RADIX_BITS 8
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_PASSES (64 / RADIX_BITS)
+
+// the bits of a positive float increase with its value, the top 24 bits hold the exponent and 16 bits of mantissa
+static uint32 QuantizeDepth(float depth)
+{
+	// also catches NaN
+	if (!(depth > 0.0f))
+		return 0;
+
+	uint32 bits;
+	memcpy(&bits, &depth, sizeof(bits));
+
+	return bits >> (31 - KEY_DEPTH_BITS);
+}
+
+RenderQueue::RenderQueue(uint32 initialCapacity) :
+	sorted(true),
+	stateChanges(0)
+{
+	items.reserve(initialCapacity);
+	keys.reserve(initialCapacity);
+	tempKeys.reserve(initialCapacity);
+	sortedItems.reserve(initialCapacity);
+	tempItems.reserve(initialCapacity);
+}
+
+void RenderQueue::Reset()
+{
+	items.clear();
+	keys.clear();
+	sortedItems.clear();
+
+	sorted = true;
+}
+
+void RenderQueue::Push(const RenderItem &item)
+{
+	DS_ASSERT(item.mesh);
+
+	keys.push_back(CalculateKey(item));
+	sortedItems.push_back(static_cast<uint32>(items.size()));
+	items.push_back(item);
+
+	sorted = false;
+}
+
+uint64 RenderQueue::CalculateKey(const RenderItem &item) const
+{
+	uint64 shader = item.shader ? (item.shader->sortID & KEY_MASK(KEY_SHADER_BITS)) : 0;
+	uint64 texture = item.textures[0] ? (item.textures[0]->sortID & KEY_MASK(KEY_TEXTURE_BITS)) : 0;
+
+	uint64 state = 0;
+	state |= item.blendState ? (item.blendState->stateID & KEY_MASK(KEY_BLEND_BITS)) : 0;
+	state <<= KEY_DEPTH_STENCIL_BITS;
+	state |= item.depthStencilState ? (item.depthStencilState->stateID & KEY_MASK(KEY_DEPTH_STENCIL_BITS)) : 0;
+	state <<= KEY_RASTERIZER_BITS;
+	state |= item.rasterizerState ? (item.rasterizerState->stateID & KEY_MASK(KEY_RASTERIZER_BITS)) : 0;
+
+	uint64 depth = QuantizeDepth(item.viewDepth);
+
+	uint64 key = 0;
+
+	if (item.transparent)
+	{
+		// back to front, the furthest items get the smallest keys
+		key = 1;
+		key = (key << KEY_DEPTH_BITS) | (KEY_MASK(KEY_DEPTH_BITS) - depth);
+		key = (key << KEY_SHADER_BITS) | shader;
+		key = (key << KEY_STATE_BITS) | state;
+		key = (key << KEY_TEXTURE_BITS) | texture;
+	}
+	else
+	{
+		// grouped by state, then front to back within each group to reduce overdraw
+		key = (key << KEY_SHADER_BITS) | shader;
+		key = (key << KEY_STATE_BITS) | state;
+		key = (key << KEY_TEXTURE_BITS) | texture;
+		key = (key << KEY_DEPTH_BITS) | depth;
+	}
+
+	return key;
+}
+
+void RenderQueue::Sort()
+{
+	uint32 count = static_cast<uint32>(keys.size());
+
+	if (sorted || count < 2)
+	{
+		sorted = true;
+		return;
+	}
+
+	tempKeys.resize(count);
+	tempItems.resize(count);
+
+	// build the histograms of every pass with a single read of the keys
+	uint32 histograms[RADIX_PASSES][RADIX_SIZE];
+	memset(histograms, 0, sizeof(histograms));
+
+	for (uint32 i = 0; i < count; i++)
+	{
+		uint64 key = keys[i];
+
+		for (uint32 pass = 0; pass < RADIX_PASSES; pass++)
+		{
+			histograms[pass][(key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1)]++;
+		}
+	}
+
+	uint64* srcKeys = keys.data();
+	uint64* dstKeys = tempKeys.data();
+	uint32* srcItems = sortedItems.data();
+	uint32* dstItems = tempItems.data();
+
+	// least significant digit first, each pass is stable so items with equal keys keep the order they were pushed in
+	for (uint32 pass = 0; pass < RADIX_PASSES; pass++)
+	{
+		uint32* histogram = histograms[pass];
+		uint32 shift = pass * RADIX_BITS;
+
+		// skip passes where every key has the same digit, they would not change the order
+		if (histogram[(srcKeys[0] >> shift) & (RADIX_SIZE - 1)] == count)
+			continue;
+
+		// turn the counts in to the first output position of each digit
+		uint32 offset = 0;
+		for (uint32 d = 0; d < RADIX_SIZE; d++)
+		{
+			uint32 digitCount = histogram[d];
+			histogram[d] = offset;
+			offset += digitCount;
+		}
+
+		for (uint32 i = 0; i < count; i++)
+		{
+			uint32 position = histogram[(srcKeys[i] >> shift) & (RADIX_SIZE - 1)]++;
+
+			dstKeys[position] = srcKeys[i];
+			dstItems[position] = srcItems[i];
+		}
+
+		std::swap(srcKeys, dstKeys);
+		std::swap(srcItems, dstItems);
+	}
+
+	// an odd number of passes leaves the result in the temp arrays
+	if (srcKeys != keys.data())
+	{
+		keys.swap(tempKeys);
+		sortedItems.swap(tempItems);
+	}
+
+	sorted = true;
+}
+
+void RenderQueue::Submit(IGraphicsDevice* device)
+{
+	DS_ASSERT(device);
+
+	Sort();
+
+	stateChanges = 0;
+
+	// the first item always sets every state
+	Shader* curShader = nullptr;
+	Texture* curTextures[RENDER_QUEUE_MAX_TEXTURES] = {};
+	BlendState* curBlendState = nullptr;
+	DepthStencilState* curDepthStencilState = nullptr;
+	RasterizerState* curRasterizerState = nullptr;
+	UniformSlice curUniforms;
+	bool firstItem = true;
+
+	for (uint32 i = 0; i < static_cast<uint32>(sortedItems.size()); i++)
+	{
+		const RenderItem &item = items[sortedItems[i]];
+
+		if (item.shader != curShader && item.shader != nullptr)
+		{
+			device->SetShader(item.shader);
+			curShader = item.shader;
+			stateChanges++;
+		}
+
+		for (uint32 t = 0; t < RENDER_QUEUE_MAX_TEXTURES; t++)
+		{
+			if (item.textures[t] != curTextures[t] && item.textures[t] != nullptr)
+			{
+				device->SetTexture(item.textures[t], t);
+				curTextures[t] = item.textures[t];
+				stateChanges++;
+			}
+		}
+
+		if (item.blendState != curBlendState || firstItem)
+		{
+			device->SetBlendState(item.blendState);
+			curBlendState = item.blendState;
+			stateChanges++;
+		}
+
+		if (item.depthStencilState != curDepthStencilState || firstItem)
+		{
+			device->SetDepthStencilState(item.depthStencilState);
+			curDepthStencilState = item.depthStencilState;
+			stateChanges++;
+		}
+
+		if (item.rasterizerState != curRasterizerState || firstItem)
+		{
+			device->SetRasterizerState(item.rasterizerState);
+			curRasterizerState = item.rasterizerState;
+			stateChanges++;
+		}
+
+		const UniformSlice &uniforms = item.uniforms;
+
+		if (uniforms.buffer != nullptr && (uniforms.buffer != curUniforms.buffer || uniforms.offset != curUniforms.offset || uniforms.size != curUniforms.size))
+		{
+			device->SetUniformBufferRange(RENDER_QUEUE_UNIFORM_SLOT, uniforms.buffer, uniforms.offset, uniforms.size, ShaderStage::Vertex | ShaderStage::Pixel);
+			curUniforms = uniforms;
+			stateChanges++;
+		}
+
+		firstItem = false;
+
+		device->DrawMeshIndexed(item.mesh, item.elementCount, item.vertexOffset, item.indexOffset);
+	}
+}
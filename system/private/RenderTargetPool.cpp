@@ -0,0 +1,108 @@
+#include "RenderTargetPool.h"
+#include "IGraphicsDevice.h"
+
+RenderTargetPool::RenderTargetPool(uint32 maxUnusedFrames) :
+	maxUnusedFrames(maxUnusedFrames)
+{
+	frame = 0;
+	createdThisFrame = 0;
+	createdLastFrame = 0;
+}
+
+RenderTarget* RenderTargetPool::Acquire(IGraphicsDevice* device, const RenderTargetDesc &desc)
+{
+	// there are only ever a handful of targets, a linear search is cheaper than keeping them in a map
+	for (PooledTarget &pooled : targets)
+	{
+		if (!pooled.acquired && pooled.target->GetDesc() == desc)
+		{
+			pooled.acquired = true;
+			pooled.lastUsedFrame = frame;
+
+			return pooled.target;
+		}
+	}
+
+	RenderTarget* target = device->CreateRenderTarget(desc);
+
+	if (target == nullptr)
+	{
+		LOG_ERROR("Render target pool failed creating a [%ux%u] target", desc.width, desc.height);
+		return nullptr;
+	}
+
+	PooledTarget pooled;
+	pooled.target = target;
+	pooled.lastUsedFrame = frame;
+	pooled.acquired = true;
+
+	targets.push_back(pooled);
+	createdThisFrame++;
+
+	return target;
+}
+
+void RenderTargetPool::Release(RenderTarget* target)
+{
+	for (PooledTarget &pooled : targets)
+	{
+		if (pooled.target == target)
+		{
+			DS_ASSERT(pooled.acquired); // target must not be released twice
+			pooled.acquired = false;
+			return;
+		}
+	}
+
+	DS_ASSERT(false); // target was not acquired from this pool
+}
+
+void RenderTargetPool::EndFrame(IGraphicsDevice* device)
+{
+	for (uint32 t = 0; t < targets.size();)
+	{
+		PooledTarget &pooled = targets[t];
+		pooled.acquired = false;
+
+		if (frame - pooled.lastUsedFrame > maxUnusedFrames)
+		{
+			device->ReleaseRenderTarget(pooled.target);
+
+			// order does not matter, fill the hole with the last target
+			targets[t] = targets.back();
+			targets.pop_back();
+		}
+		else
+		{
+			t++;
+		}
+	}
+
+	createdLastFrame = createdThisFrame;
+	createdThisFrame = 0;
+
+	frame++;
+}
+
+void RenderTargetPool::Clear(IGraphicsDevice* device)
+{
+	for (PooledTarget &pooled : targets)
+	{
+		device->ReleaseRenderTarget(pooled.target);
+	}
+
+	targets.clear();
+}
+
+uint32 RenderTargetPool::GetAcquiredCount() const
+{
+	uint32 count = 0;
+
+	for (const PooledTarget &pooled : targets)
+	{
+		if (pooled.acquired)
+			count++;
+	}
+
+	return count;
+}
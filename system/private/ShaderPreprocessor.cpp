@@ -0,0 +1,193 @@
+#include "ShaderPreprocessor.h"
+
+#include <algorithm>
+
+// ==============================================
+// Helpers
+// ==============================================
+
+// directory part of a path including the trailing slash, empty when the path has none
+static std::string GetDirectory(const std::string &fileName)
+{
+	size_t slash = fileName.find_last_of("/\\");
+
+	return slash == std::string::npos ? std::string() : fileName.substr(0, slash + 1);
+}
+
+// if line is an #include "file" directive returns true and the file it names
+static bool ParseInclude(const std::string &line, std::string &includeName)
+{
+	size_t pos = line.find_first_not_of(" \t");
+
+	if (pos == std::string::npos || line[pos] != '#')
+		return false;
+
+	pos = line.find_first_not_of(" \t", pos + 1);
+
+	if (pos == std::string::npos || line.compare(pos, 7, "include") != 0)
+		return false;
+
+	size_t open = line.find('"', pos + 7);
+	size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+
+	if (close == std::string::npos)
+		return false;
+
+	includeName = line.substr(open + 1, close - open - 1);
+
+	return true;
+}
+
+// ==============================================
+// ShaderPreprocessor
+// ==============================================
+
+bool ShaderPreprocessor::Process(const std::string &fileName, ShaderFeatures features, std::string &source)
+{
+	includeStack.clear();
+	included.clear();
+
+	std::string expanded;
+
+	if (!Expand(fileName, expanded))
+		return false;
+
+	std::string defines;
+	uint32 featureMask = static_cast<uint32>(features);
+
+	for (uint32 f = 0; f < DS_SHADER_FEATURE_COUNT; f++)
+	{
+		if (featureMask & (1u << f))
+		{
+			defines += "#define ";
+			defines += ShaderFeatureDefines[f];
+			defines += " 1\n";
+		}
+	}
+
+	// nothing but comments and whitespace may come before #version, so the defines follow it
+	size_t insertAt = 0;
+	size_t version = expanded.find("#version");
+
+	if (version != std::string::npos && expanded.find_first_not_of(" \t\r\n") == version)
+	{
+		size_t lineEnd = expanded.find('\n', version);
+		insertAt = lineEnd == std::string::npos ? expanded.size() : lineEnd + 1;
+	}
+
+	source.clear();
+	source.reserve(expanded.size() + defines.size() + 1);
+	source.append(expanded, 0, insertAt);
+
+	// a #version line at the very end of the file has no newline to separate it from the defines
+	if (insertAt > 0 && source.back() != '\n')
+	{
+		source += '\n';
+	}
+
+	source += defines;
+	source.append(expanded, insertAt, std::string::npos);
+
+	return true;
+}
+
+void ShaderPreprocessor::Clear()
+{
+	files.clear();
+}
+
+std::string ShaderPreprocessor::GetVariantName(const std::string &name, ShaderFeatures features)
+{
+	if (features == ShaderFeatures::None)
+		return name;
+
+	char suffix[16];
+	snprintf(suffix, sizeof(suffix), "_%x", static_cast<uint32>(features));
+
+	return name + suffix;
+}
+
+const std::string* ShaderPreprocessor::ReadFile(const std::string &fileName)
+{
+	auto cached = files.find(fileName);
+
+	if (cached != files.end())
+		return &cached->second;
+
+	int32 dataSize = 0;
+	char* fileData = FileReadAll(fileName, dataSize);
+
+	if (fileData == nullptr)
+		return nullptr;
+
+	std::string &contents = files[fileName];
+	contents.assign(fileData, dataSize);
+	delete[] fileData;
+
+	return &contents;
+}
+
+bool ShaderPreprocessor::Expand(const std::string &fileName, std::string &source)
+{
+	if (std::find(includeStack.begin(), includeStack.end(), fileName) != includeStack.end())
+	{
+		LOG_ERROR("Circular include of [%s] from [%s]", fileName.c_str(), includeStack.back().c_str());
+		return false;
+	}
+
+	// every file is included once, later includes of the same file are dropped
+	if (std::find(included.begin(), included.end(), fileName) != included.end())
+		return true;
+
+	const std::string* contents = ReadFile(fileName);
+
+	if (contents == nullptr)
+	{
+		if (!includeStack.empty())
+		{
+			LOG_ERROR("Unable to include [%s] from [%s]", fileName.c_str(), includeStack.back().c_str());
+		}
+
+		return false;
+	}
+
+	includeStack.push_back(fileName);
+	included.push_back(fileName);
+
+	std::string directory = GetDirectory(fileName);
+	std::string includeName;
+	size_t lineStart = 0;
+
+	while (lineStart < contents->size())
+	{
+		size_t lineEnd = contents->find('\n', lineStart);
+		lineEnd = lineEnd == std::string::npos ? contents->size() : lineEnd + 1;
+
+		std::string line = contents->substr(lineStart, lineEnd - lineStart);
+
+		if (ParseInclude(line, includeName))
+		{
+			if (!Expand(directory + includeName, source))
+			{
+				includeStack.pop_back();
+				return false;
+			}
+
+			// keep the line structure of the including file intact if the included one doesn't end in a newline
+			if (!source.empty() && source.back() != '\n')
+			{
+				source += '\n';
+			}
+		}
+		else
+		{
+			source += line;
+		}
+
+		lineStart = lineEnd;
+	}
+
+	includeStack.pop_back();
+
+	return true;
+}
@@ -0,0 +1,40 @@
+#ifndef _SHADER_PREPROCESSOR_H
+#define _SHADER_PREPROCESSOR_H
+
+#include "GraphicsDefinitions.h"
+
+#include <unordered_map>
+
+// ShaderPreprocessor builds the source of a shader variant before it is handed to the compiler. #include "file"
+// directives are replaced by the file they name, found relative to the including file, and a #define is inserted
+// for every feature of the variant. a file is only included once per variant so shared headers need no guards.
+// files are read from disk once and kept, every variant of every shader reuses them
+class ShaderPreprocessor
+{
+public:
+
+	// expands fileName in to source with the defines of features, returns false if a file could not be read or
+	// includes itself. the defines go after a leading #version directive as GLSL requires, otherwise at the top
+	bool Process(const std::string &fileName, ShaderFeatures features, std::string &source);
+
+	// drops the cached files so edited sources are read again
+	void Clear();
+
+	// name a variant is cached under by the devices, the shader name when it has no features
+	static std::string GetVariantName(const std::string &name, ShaderFeatures features);
+
+private:
+
+	// returns the cached contents of fileName, reading it on first use. null if it can't be read
+	const std::string* ReadFile(const std::string &fileName);
+
+	bool Expand(const std::string &fileName, std::string &source);
+
+	std::unordered_map<std::string, std::string> files;
+
+	// files of the variant being processed, the stack is the chain of includes that led to the current file
+	std::vector<std::string> includeStack;
+	std::vector<std::string> included;
+};
+
+#endif // _SHADER_PREPROCESSOR_H
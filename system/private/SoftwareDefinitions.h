@@ -0,0 +1,330 @@
+#ifndef _SOFTWARE_DEFINITIONS_H
+#define _SOFTWARE_DEFINITIONS_H
+
+#include "IGraphicsDevice.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SW_USE_SSE2
+	#include <emmintrin.h>
+#endif
+
+// screen is divided in to square tiles, each tile is rasterized by a single thread
+#define SW_TILE_SIZE_SHIFT 6
+#define SW_TILE_SIZE (1 << SW_TILE_SIZE_SHIFT)
+
+// vertex positions are snapped to a fixed point grid with this many fractional bits
+#define SW_SUBPIXEL_BITS 4
+#define SW_SUBPIXEL_STEPS (1 << SW_SUBPIXEL_BITS)
+
+// vertices further than this many pixels from the viewport centre are clipped, this keeps
+// the fixed point edge function values within the range of 32 bit integers inside a tile
+#define SW_GUARD_BAND_PIXELS 8192.0f
+
+#define SW_MAX_VARYINGS 8
+#define SW_MAX_TEXTURE_SLOTS 4
+#define SW_MAX_UNIFORM_SLOTS 4
+#define SW_MAX_SCISSOR_RECTS 16
+
+// uniform ranges only need to keep the floats in a slice aligned for the shaders
+#define SW_UNIFORM_BUFFER_ALIGNMENT 16
+
+// number of vertex attribute types in VertexAttributes, including the per instance attributes
+#define SW_VERTEX_ATTRIBUTE_COUNT DS_VERTEX_ATTRIBUTE_COUNT
+
+// stores the byte offset of each attribute within an element of the stream, -1 if the attribute is not present
+inline void GetAttributeOffsets(VertexAttributes attributeFlags, int32* offsets)
+{
+	int32 offset = 0;
+	for (uint32 a = 0; a < SW_VERTEX_ATTRIBUTE_COUNT; a++)
+	{
+		offsets[a] = -1;
+
+		if (ToIntegral(attributeFlags) & (1 << a))
+		{
+			offsets[a] = offset;
+			offset += attributeProperties[a].sizeBytes;
+		}
+	}
+}
+
+// ==============================================
+// Software Buffers
+// ==============================================
+
+class BufferSoftware : public Buffer
+{
+public:
+
+	BufferSoftware(uint32 size, BufferTarget target, BufferUsage usage) :
+		data(size),
+		size(size),
+		target(target),
+		usage(usage)
+	{}
+
+	std::vector<uint8> data;
+
+	uint32 size;
+	BufferTarget target;
+	BufferUsage usage;
+};
+
+// ==============================================
+
+// ==============================================
+// Software Mesh
+// ==============================================
+
+class MeshSoftware : public Mesh
+{
+public:
+
+	MeshSoftware(BufferSoftware* vertexBuffer, BufferSoftware* indexBuffer, uint32 vertexCount, uint32 indexCount, IndexFormat indexFormat,
+				 uint32 stride, VertexAttributes vertexAttributeFlags) :
+		vertexBuffer(vertexBuffer),
+		indexBuffer(indexBuffer),
+		vertexCount(vertexCount),
+		indexCount(indexCount),
+		indexFormat(indexFormat),
+		stride(stride),
+		vertexAttributeFlags(vertexAttributeFlags)
+	{
+		GetAttributeOffsets(vertexAttributeFlags, attributeOffsets);
+	}
+
+	BufferSoftware* vertexBuffer;
+	BufferSoftware* indexBuffer;
+
+	uint32 vertexCount;
+	uint32 indexCount;
+	IndexFormat indexFormat;
+
+	uint32 stride;
+	VertexAttributes vertexAttributeFlags;
+	int32 attributeOffsets[SW_VERTEX_ATTRIBUTE_COUNT];
+};
+
+// per instance attribute stream of an instanced draw, element i is read from data + i * stride
+struct SoftwareInstanceStream
+{
+	SoftwareInstanceStream(const uint8* data, VertexAttributes instanceAttributeFlags) :
+		data(data),
+		stride(GetAttributeMaskSize(instanceAttributeFlags))
+	{
+		GetAttributeOffsets(instanceAttributeFlags, attributeOffsets);
+	}
+
+	const uint8* data;
+	uint32 stride;
+	int32 attributeOffsets[SW_VERTEX_ATTRIBUTE_COUNT];
+};
+
+// ==============================================
+
+// ==============================================
+// Software Textures
+// ==============================================
+
+class TextureSoftware : public Texture
+{
+public:
+
+	TextureSoftware(const TextureSettings &settings) :
+		width(settings.width),
+		height(settings.height),
+		arraySize(settings.arraySize),
+		format(settings.format),
+		texels(settings.width * settings.height * settings.arraySize),
+		wrapMode(settings.wrapMode),
+		filterMode(settings.filterMode)
+	{}
+
+	uint32 width;
+	uint32 height;
+	uint32 arraySize;
+
+	// format the texture was created with, layers are updated in this format
+	TextureFormat format;
+
+	// texels are stored as RGBA8, red in the lowest byte, with the layers of an array one after another
+	std::vector<uint32> texels;
+
+	TextureWrapMode wrapMode;
+	TextureFilterMode filterMode;
+};
+
+// ==============================================
+
+// ==============================================
+// Software Render Targets
+// ==============================================
+
+// color targets are rendered straight in to the texels of their texture so they can be sampled without a copy.
+// every color format is stored as RGBA8 and multisampled targets are created with a single sample
+class RenderTargetSoftware : public RenderTarget
+{
+public:
+
+	RenderTargetSoftware(const RenderTargetDesc &desc) :
+		RenderTarget(desc),
+		colorTexture(TextureSettings(desc.width, desc.height, TextureFormat::RGBA, TextureWrapMode::Clamp, TextureFilterMode::Bilinear, 0.0f, false))
+	{
+		if (IsDepthFormat(desc.format))
+		{
+			colorTexture.texels.clear();
+			depth.assign(desc.width * desc.height, 1.0f);
+			stencil.assign(desc.width * desc.height, 0);
+		}
+		else if (desc.sampleCount <= 1)
+		{
+			texture = &colorTexture;
+		}
+	}
+
+	uint32* GetColorBuffer() { return colorTexture.texels.empty() ? nullptr : colorTexture.texels.data(); }
+	float* GetDepthBuffer() { return depth.empty() ? nullptr : depth.data(); }
+	uint8* GetStencilBuffer() { return stencil.empty() ? nullptr : stencil.data(); }
+
+	TextureSoftware colorTexture;
+	std::vector<float> depth;
+	std::vector<uint8> stencil;
+};
+
+// pixels copied by RequestReadback, handed to the callback by the next Present
+struct ReadbackSoftware
+{
+	std::vector<uint8> pixels;
+	uint32 width;
+	uint32 height;
+	ReadbackCallback callback;
+};
+
+// ==============================================
+
+// ==============================================
+// Software Shaders
+// ==============================================
+
+// vertex attributes decoded from a vertex buffer, attributes not present in the mesh are left at their defaults
+struct SoftwareVertexInput
+{
+	vec3 position;
+	vec2 uiPosition;
+	vec2 texCoord;
+	vec4 color;
+	vec3 normal;
+
+	// per instance attributes, identity and white when the draw is not instanced
+	mat4 instanceWorld;
+	vec4 instanceColor;
+	float instanceMaterial;
+};
+
+// output of a vertex shader, clip space position and the values interpolated across the triangle
+struct SoftwareVertexOutput
+{
+	vec4 position;
+	float varyings[SW_MAX_VARYINGS];
+};
+
+// uniform buffers bound to the device when a draw was submitted
+struct SoftwareUniforms
+{
+	const uint8* slots[SW_MAX_UNIFORM_SLOTS];
+};
+
+// interpolated values for a single pixel and the textures bound when its triangle was drawn
+struct SoftwarePixelInput
+{
+	float varyings[SW_MAX_VARYINGS];
+	TextureSoftware* const* textures;
+};
+
+typedef void (*SoftwareVertexShader)(const SoftwareVertexInput &input, const SoftwareUniforms &uniforms, SoftwareVertexOutput &output);
+typedef vec4 (*SoftwarePixelShader)(const SoftwarePixelInput &input);
+
+// native C++ replica of a shader program in resources/shaders
+struct SoftwareShaderProgram
+{
+	const char* name;
+	SoftwareVertexShader vertexShader;
+	SoftwarePixelShader pixelShader;
+	uint32 varyingCount;
+};
+
+class ShaderSoftware : public Shader
+{
+public:
+
+	ShaderSoftware(const SoftwareShaderProgram* program) :
+		program(program)
+	{}
+
+	const SoftwareShaderProgram* program;
+};
+
+// ==============================================
+
+// ==============================================
+// Software States
+// ==============================================
+
+class BlendStateSoftware : public BlendState {};
+
+// cull mode, winding and scissor enable are applied, fill mode and depth bias are not supported
+class RasterizerStateSoftware : public RasterizerState {};
+
+class DepthStencilStateSoftware : public DepthStencilState
+{
+public:
+
+	DepthStencilStateSoftware(const DepthStencilStateDesc &desc) :
+		desc(desc)
+	{}
+
+	DepthStencilStateDesc desc;
+};
+
+// snapshot of the device state used by a group of triangles, taken each time a draw follows a state change
+struct SoftwareDrawState
+{
+	const SoftwareShaderProgram* program;
+	TextureSoftware* textures[SW_MAX_TEXTURE_SLOTS];
+
+	BlendProperties blend;
+	DepthStencilStateDesc depthStencil;
+	RasterizerStateDesc rasterizer;
+
+	// byte mask of the channels written, expanded from blend.colorMask when the state is added
+	uint32 colorWriteMask;
+};
+
+// ==============================================
+
+// ==============================================
+// Software Pixel Helpers
+// ==============================================
+
+inline uint32 PackColorRGBA8(const vec4 &color)
+{
+	vec4 c = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+
+	return static_cast<uint32>(c.r) |
+		  (static_cast<uint32>(c.g) << 8) |
+		  (static_cast<uint32>(c.b) << 16) |
+		  (static_cast<uint32>(c.a) << 24);
+}
+
+inline vec4 UnpackColorRGBA8(uint32 color)
+{
+	static const float inv255 = 1.0f / 255.0f;
+
+	return vec4(static_cast<float>(color & 0xFF) * inv255,
+				static_cast<float>((color >> 8) & 0xFF) * inv255,
+				static_cast<float>((color >> 16) & 0xFF) * inv255,
+				static_cast<float>(color >> 24) * inv255);
+}
+
+// ==============================================
+
+#endif // _SOFTWARE_DEFINITIONS_H
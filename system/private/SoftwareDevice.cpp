@@ -0,0 +1,1294 @@
+#include "SoftwareDevice.h"
+#include "SoftwareShaders.h"
+#include "VertexQuantization.h"
+
+std::string SoftwareDevice::GetAPIName()
+{
+	return "Software";
+}
+
+bool SoftwareDevice::Create(const RenderInfo& info)
+{
+	renderInfo = info;
+	framesInFlight = glm::clamp(info.framesInFlight, 1u, static_cast<uint32>(DS_MAX_FRAMES_IN_FLIGHT));
+
+	rasterizer.Initialize(renderInfo.resolutionX, renderInfo.resolutionY);
+
+	LOG("Created Software device : [%ux%u] %u threads", renderInfo.resolutionX, renderInfo.resolutionY, rasterizer.GetThreadCount());
+
+	return true;
+}
+
+void SoftwareDevice::Initialize()
+{
+	// Create depth/stencil state
+	DepthStencilStateDesc defaultDepthStencilDesc;
+	defaultDepthStencilState = CreateDepthStencilState(defaultDepthStencilDesc);
+	SetDepthStencilState(defaultDepthStencilState);
+
+	// alpha blending is enabled by default, matching GL3Device
+	BlendProperties defaultBlend;
+	defaultBlend.enabled = true;
+	defaultBlend.srcBlend = BlendFactor::SrcAlpha;
+	defaultBlend.dstBlend = BlendFactor::InvSrcAlpha;
+	defaultBlend.blendOp = BlendOperation::Add;
+	defaultBlend.srcBlendAlpha = BlendFactor::SrcAlpha;
+	defaultBlend.dstBlendAlpha = BlendFactor::InvSrcAlpha;
+	defaultBlend.blendOpAlpha = BlendOperation::Add;
+	defaultBlend.colorMask = ToIntegral(ColorMask::All);
+
+	defaultBlendState = static_cast<BlendStateSoftware*>(CreateBlendState(defaultBlend));
+	SetBlendState(defaultBlendState);
+
+	// Create rasterizer state, no culling with scissor testing enabled
+	RasterizerStateDesc defaultRasterizerDesc;
+	defaultRasterizerState = static_cast<RasterizerStateSoftware*>(CreateRasterizerState(defaultRasterizerDesc));
+	SetRasterizerState(defaultRasterizerState);
+
+	SetViewport(0, 0, renderInfo.resolutionX, renderInfo.resolutionY);
+
+	DSRect defaultRect = DSRect(0, 0, renderInfo.resolutionX, renderInfo.resolutionY);
+	SetScissorRects(1, &defaultRect);
+}
+
+void SoftwareDevice::Destroy()
+{
+	// readbacks still waiting on a Present are dropped without calling back
+	pendingReadbacks.clear();
+
+	// release every resource still held by a handle
+	for (MeshSoftware* mesh : meshes)
+		ReleaseMesh(mesh);
+
+	for (ShaderSoftware* shader : shaders)
+		ReleaseShader(shader);
+
+	for (TextureSoftware* texture : textures)
+		ReleaseTexture(texture);
+
+	for (BufferSoftware* buffer : buffers)
+		ReleaseBuffer(buffer);
+
+	meshes.Clear();
+	shaders.Clear();
+	textures.Clear();
+	buffers.Clear();
+
+	rasterizer.Destroy();
+
+	// release every cached state object
+	blendStates.Clear([](BlendStateSoftware* state) { delete state; });
+	depthStencilStates.Clear([](DepthStencilStateSoftware* state) { delete state; });
+	rasterizerStates.Clear([](RasterizerStateSoftware* state) { delete state; });
+
+	defaultDepthStencilState = curDepthStencilState = nullptr;
+	defaultBlendState = curBlendState = nullptr;
+	defaultRasterizerState = curRasterizerState = nullptr;
+}
+
+void SoftwareDevice::Clear()
+{
+	rasterizer.Clear(clearColor, 1.0f, 0);
+
+	InvalidateDrawState();
+}
+
+void SoftwareDevice::Present()
+{
+	rasterizer.Present();
+
+	InvalidateDrawState();
+
+	// the pixels were copied when they were requested, callbacks requesting more readbacks queue them for the next frame
+	std::vector<ReadbackSoftware> readbacks;
+	readbacks.swap(pendingReadbacks);
+
+	for (ReadbackSoftware &readback : readbacks)
+	{
+		ReadbackData data;
+		data.pixels = readback.pixels.data();
+		data.width = readback.width;
+		data.height = readback.height;
+
+		readback.callback(data);
+	}
+
+	frameSlot = (frameSlot + 1) % framesInFlight;
+
+	lastFrameStats = curFrameStats;
+	curFrameStats.Reset();
+}
+
+void SoftwareDevice::SetVSync(bool enabled)
+{
+	// frames are presented to memory, there is no display to sync to
+}
+
+void SoftwareDevice::SetFramesInFlight(uint32 count)
+{
+	// the rasterizer finishes every frame in Present, the count only changes how slots cycle
+	framesInFlight = glm::clamp(count, 1u, static_cast<uint32>(DS_MAX_FRAMES_IN_FLIGHT));
+	frameSlot = 0;
+}
+
+void SoftwareDevice::SetShader(Shader* shader)
+{
+	ShaderSoftware* swShader = static_cast<ShaderSoftware*>(shader);
+
+	if (swShader != nullptr && swShader != curShader)
+	{
+		curShader = swShader;
+		curFrameStats.stateChanges++;
+
+		InvalidateDrawState();
+	}
+}
+
+void SoftwareDevice::SetTexture(Texture* texture, uint32 slot)
+{
+	TextureSoftware* swTexture = static_cast<TextureSoftware*>(texture);
+
+	if (swTexture != nullptr && slot < SW_MAX_TEXTURE_SLOTS && curTextures[slot] != swTexture)
+	{
+		curTextures[slot] = swTexture;
+		curFrameStats.stateChanges++;
+
+		InvalidateDrawState();
+	}
+}
+
+void SoftwareDevice::DrawMesh(Mesh* mesh)
+{
+	MeshSoftware* swMesh = static_cast<MeshSoftware*>(mesh);
+
+	if (swMesh != nullptr)
+	{
+		DrawTriangles(swMesh, nullptr, IndexFormat::UInt16, swMesh->vertexCount, 0);
+	}
+}
+
+void SoftwareDevice::DrawMeshIndexed(Mesh* mesh, uint32 elementCount, uint32 vertexOffset, uint32 indexOffset)
+{
+	MeshSoftware* swMesh = static_cast<MeshSoftware*>(mesh);
+
+	if (swMesh != nullptr)
+	{
+		if (elementCount == 0)
+		{
+			elementCount = swMesh->indexCount;
+		}
+
+		uint32 indexSize = DS_INDEX_SIZE(swMesh->indexFormat);
+		uint32 indexCapacity = swMesh->indexBuffer->size / indexSize;
+
+		if (indexOffset + elementCount > indexCapacity)
+		{
+			LOG_ERROR("DrawMeshIndexed reads past the end of the index buffer");
+			return;
+		}
+
+		const uint8* indices = swMesh->indexBuffer->data.data() + indexOffset * indexSize;
+
+		DrawTriangles(swMesh, indices, swMesh->indexFormat, elementCount, vertexOffset);
+	}
+}
+
+void SoftwareDevice::DrawMeshIndexedInstanced(Mesh* mesh, Buffer* instanceBuffer, VertexAttributes instanceAttributeFlags, uint32 instanceCount,
+											  uint32 firstInstance, uint32 elementCount, uint32 vertexOffset, uint32 indexOffset)
+{
+	MeshSoftware* swMesh = static_cast<MeshSoftware*>(mesh);
+	BufferSoftware* swInstanceBuffer = static_cast<BufferSoftware*>(instanceBuffer);
+
+	if (swMesh != nullptr && swInstanceBuffer != nullptr)
+	{
+		if (elementCount == 0)
+		{
+			elementCount = swMesh->indexCount;
+		}
+
+		uint32 indexSize = DS_INDEX_SIZE(swMesh->indexFormat);
+		uint32 indexCapacity = swMesh->indexBuffer->size / indexSize;
+
+		if (indexOffset + elementCount > indexCapacity)
+		{
+			LOG_ERROR("DrawMeshIndexedInstanced reads past the end of the index buffer");
+			return;
+		}
+
+		SoftwareInstanceStream instances(swInstanceBuffer->data.data(), instanceAttributeFlags);
+
+		if (instances.stride == 0 || (firstInstance + instanceCount) * instances.stride > swInstanceBuffer->size)
+		{
+			LOG_ERROR("DrawMeshIndexedInstanced reads past the end of the instance buffer");
+			return;
+		}
+
+		instances.data += firstInstance * instances.stride;
+
+		const uint8* indices = swMesh->indexBuffer->data.data() + indexOffset * indexSize;
+
+		DrawTriangles(swMesh, indices, swMesh->indexFormat, elementCount, vertexOffset, &instances, instanceCount);
+	}
+}
+
+void SoftwareDevice::DrawTriangles(MeshSoftware* mesh, const uint8* indices, IndexFormat indexFormat, uint32 elementCount, uint32 vertexOffset,
+								   const SoftwareInstanceStream* instances, uint32 instanceCount)
+{
+	if (curShader == nullptr || mesh->stride == 0)
+		return;
+
+	const SoftwareShaderProgram* program = curShader->program;
+	uint32 stateIndex = GetDrawState();
+
+	SoftwareUniforms uniforms;
+	for (uint32 s = 0; s < SW_MAX_UNIFORM_SLOTS; s++)
+	{
+		uniforms.slots[s] = curUniformBuffers[s] ? curUniformBuffers[s]->data.data() + curUniformOffsets[s] : nullptr;
+	}
+
+	uint32 vertexCapacity = mesh->vertexBuffer->size / mesh->stride;
+
+	if (transformedVertices.size() < vertexCapacity)
+	{
+		transformedVertices.resize(vertexCapacity);
+		transformedStamps.resize(vertexCapacity, 0);
+	}
+
+	const SoftwareVertexOutput* triangle[3];
+	uint32 primitives = 0;
+
+	for (uint32 instance = 0; instance < instanceCount; instance++)
+	{
+		// a new stamp invalidates every vertex transformed by previous draws and instances
+		if (++drawStamp == 0)
+		{
+			std::fill(transformedStamps.begin(), transformedStamps.end(), 0);
+			drawStamp = 1;
+		}
+
+		for (uint32 i = 0; i < elementCount; i++)
+		{
+			uint32 vertexIndex = i;
+
+			if (indices != nullptr)
+			{
+				vertexIndex = indexFormat == IndexFormat::UInt32 ? reinterpret_cast<const uint32*>(indices)[i] :
+																   reinterpret_cast<const uint16*>(indices)[i];
+			}
+
+			vertexIndex += vertexOffset;
+
+			if (vertexIndex >= vertexCapacity)
+			{
+				LOG_ERROR("Draw reads past the end of the vertex buffer");
+				return;
+			}
+
+			// shade each vertex only once per instance, shared vertices reuse the cached result
+			if (transformedStamps[vertexIndex] != drawStamp)
+			{
+				SoftwareVertexInput input;
+				ReadVertex(mesh, vertexIndex, input);
+
+				if (instances != nullptr)
+				{
+					ReadInstance(*instances, instance, input);
+				}
+
+				program->vertexShader(input, uniforms, transformedVertices[vertexIndex]);
+				transformedStamps[vertexIndex] = drawStamp;
+			}
+
+			triangle[i % 3] = &transformedVertices[vertexIndex];
+
+			if (i % 3 == 2)
+			{
+				rasterizer.SubmitTriangle(*triangle[0], *triangle[1], *triangle[2], program->varyingCount, stateIndex);
+				primitives++;
+			}
+		}
+	}
+
+	curFrameStats.drawCalls++;
+	curFrameStats.primitives += primitives;
+}
+
+void SoftwareDevice::ReadVertex(const MeshSoftware* mesh, uint32 vertexIndex, SoftwareVertexInput &input)
+{
+	const uint8* vertex = mesh->vertexBuffer->data.data() + vertexIndex * mesh->stride;
+
+	// attributes missing from the mesh read as the GL defaults
+	input.position = vec3(0.0f);
+	input.uiPosition = vec2(0.0f);
+	input.texCoord = vec2(0.0f);
+	input.color = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	input.normal = vec3(0.0f);
+	input.instanceWorld = mat4(1.0f);
+	input.instanceColor = vec4(1.0f);
+	input.instanceMaterial = 0.0f;
+
+	const int32* offsets = mesh->attributeOffsets;
+
+	// full precision attributes are copied, compact ones are expanded
+	if (offsets[ATTR_POSITION] >= 0)
+		memcpy(&input.position, vertex + offsets[ATTR_POSITION], sizeof(vec3));
+	else if (offsets[ATTR_POSITION_HALF] >= 0)
+		input.position = vec3(ReadVertexAttribute(ATTR_POSITION_HALF, vertex + offsets[ATTR_POSITION_HALF]));
+
+	if (offsets[ATTR_UI_POSITION] >= 0)
+		memcpy(&input.uiPosition, vertex + offsets[ATTR_UI_POSITION], sizeof(vec2));
+
+	if (offsets[ATTR_TEXCOORD] >= 0)
+		memcpy(&input.texCoord, vertex + offsets[ATTR_TEXCOORD], sizeof(vec2));
+	else if (offsets[ATTR_TEXCOORD_HALF] >= 0)
+		input.texCoord = vec2(ReadVertexAttribute(ATTR_TEXCOORD_HALF, vertex + offsets[ATTR_TEXCOORD_HALF]));
+	else if (offsets[ATTR_TEXCOORD_UNORM16] >= 0)
+		input.texCoord = vec2(ReadVertexAttribute(ATTR_TEXCOORD_UNORM16, vertex + offsets[ATTR_TEXCOORD_UNORM16]));
+
+	if (offsets[ATTR_COLOR32] >= 0)
+	{
+		uint32 color;
+		memcpy(&color, vertex + offsets[ATTR_COLOR32], sizeof(uint32));
+		input.color = UnpackColorRGBA8(color);
+	}
+
+	if (offsets[ATTR_NORMAL] >= 0)
+		memcpy(&input.normal, vertex + offsets[ATTR_NORMAL], sizeof(vec3));
+	else if (offsets[ATTR_NORMAL_SNORM16] >= 0)
+		input.normal = vec3(ReadVertexAttribute(ATTR_NORMAL_SNORM16, vertex + offsets[ATTR_NORMAL_SNORM16]));
+	else if (offsets[ATTR_NORMAL_PACKED] >= 0)
+		input.normal = vec3(ReadVertexAttribute(ATTR_NORMAL_PACKED, vertex + offsets[ATTR_NORMAL_PACKED]));
+}
+
+void SoftwareDevice::ReadInstance(const SoftwareInstanceStream &instances, uint32 instanceIndex, SoftwareVertexInput &input)
+{
+	const uint8* instance = instances.data + instanceIndex * instances.stride;
+	const int32* offsets = instances.attributeOffsets;
+
+	if (offsets[ATTR_INSTANCE_WORLD] >= 0)
+		memcpy(&input.instanceWorld, instance + offsets[ATTR_INSTANCE_WORLD], sizeof(mat4));
+
+	if (offsets[ATTR_INSTANCE_COLOR32] >= 0)
+	{
+		uint32 color;
+		memcpy(&color, instance + offsets[ATTR_INSTANCE_COLOR32], sizeof(uint32));
+		input.instanceColor = UnpackColorRGBA8(color);
+	}
+
+	if (offsets[ATTR_INSTANCE_MATERIAL] >= 0)
+		memcpy(&input.instanceMaterial, instance + offsets[ATTR_INSTANCE_MATERIAL], sizeof(float));
+}
+
+uint32 SoftwareDevice::GetDrawState()
+{
+	if (drawStateValid)
+		return drawStateIndex;
+
+	SoftwareDrawState state;
+	state.program = curShader->program;
+
+	for (uint32 t = 0; t < SW_MAX_TEXTURE_SLOTS; t++)
+	{
+		state.textures[t] = curTextures[t];
+	}
+
+	state.blend = curBlendState->properties;
+	state.depthStencil = curDepthStencilState->desc;
+	state.rasterizer = curRasterizerState->desc;
+
+	drawStateIndex = rasterizer.AddDrawState(state);
+	drawStateValid = true;
+
+	return drawStateIndex;
+}
+
+Mesh* SoftwareDevice::CreateMesh(const MeshData &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage)
+{
+	uint32 stride = GetAttributeMaskSize(vertexAttributeFlags);
+
+	// Create vertex and index buffers
+	BufferSoftware* vertexBuffer = CreateBuffer(meshData.vertexData,
+												meshData.vertexCount * stride,
+												BufferTarget::Vertex, usage);
+
+	// 32 bit indices are narrowed to 16 bit when the mesh is small enough
+	IndexFormat indexFormat = GetDeviceIndexFormat(meshData.indexFormat, meshData.vertexCount);
+	const void* indexData = ConvertIndices(meshData.indexData, meshData.indexCount, meshData.indexFormat, indexFormat, indexScratch);
+
+	BufferSoftware* indexBuffer = CreateBuffer(indexData,
+											   meshData.indexCount * DS_INDEX_SIZE(indexFormat),
+											   BufferTarget::Index, usage);
+
+	return new MeshSoftware(vertexBuffer, indexBuffer, meshData.vertexCount, meshData.indexCount, indexFormat, stride, vertexAttributeFlags);
+}
+
+Mesh* SoftwareDevice::CreateMesh(const MeshDataList &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage)
+{
+	uint32 stride = GetAttributeMaskSize(vertexAttributeFlags);
+
+	// Create vertex and index buffers
+	BufferSoftware* vertexBuffer = CreateBuffer(meshData.vertices, meshData.dataCount,
+												meshData.vertexCount * stride,
+												BufferTarget::Vertex, usage);
+
+	BufferSoftware* indexBuffer = CreateBuffer(meshData.indices, meshData.dataCount,
+											   meshData.indexCount * DS_INDEX_SIZE(meshData.indexFormat),
+											   BufferTarget::Index, usage);
+
+	return new MeshSoftware(vertexBuffer, indexBuffer, meshData.vertexCount, meshData.indexCount, meshData.indexFormat, stride, vertexAttributeFlags);
+}
+
+void SoftwareDevice::UpdateMesh(Mesh* mesh, const MeshData &meshData)
+{
+	MeshSoftware* swMesh = static_cast<MeshSoftware*>(mesh);
+
+	UpdateBuffer(swMesh->vertexBuffer, meshData.vertexData, meshData.vertexCount * swMesh->stride);
+	IndexFormat indexFormat = GetDeviceIndexFormat(meshData.indexFormat, meshData.vertexCount);
+	const void* indexData = ConvertIndices(meshData.indexData, meshData.indexCount, meshData.indexFormat, indexFormat, indexScratch);
+	UpdateBuffer(swMesh->indexBuffer, indexData, meshData.indexCount * DS_INDEX_SIZE(indexFormat));
+
+	swMesh->vertexCount = meshData.vertexCount;
+	swMesh->indexCount = meshData.indexCount;
+	swMesh->indexFormat = indexFormat;
+}
+
+void SoftwareDevice::UpdateMesh(Mesh* mesh, const MeshDataList &meshData)
+{
+	MeshSoftware* swMesh = static_cast<MeshSoftware*>(mesh);
+
+	UpdateBuffer(swMesh->vertexBuffer, meshData.vertices, meshData.dataCount, meshData.vertexCount * swMesh->stride);
+	UpdateBuffer(swMesh->indexBuffer, meshData.indices, meshData.dataCount, meshData.indexCount * DS_INDEX_SIZE(meshData.indexFormat));
+
+	swMesh->vertexCount = meshData.vertexCount;
+	swMesh->indexCount = meshData.indexCount;
+	swMesh->indexFormat = meshData.indexFormat;
+}
+
+void SoftwareDevice::ReleaseMesh(Mesh* mesh)
+{
+	MeshSoftware* swMesh = static_cast<MeshSoftware*>(mesh);
+
+	if (swMesh == nullptr)
+		return;
+
+	ReleaseBuffer(swMesh->vertexBuffer);
+	ReleaseBuffer(swMesh->indexBuffer);
+
+	delete swMesh;
+}
+
+void SoftwareDevice::SetMeshArenasEnabled(bool enabled)
+{
+	// meshes are read straight from memory by the rasterizer, there are no buffer binds to save
+}
+
+void SoftwareDevice::DefragmentMeshArenas()
+{
+}
+
+MeshArenaStats SoftwareDevice::GetMeshArenaStats()
+{
+	return MeshArenaStats();
+}
+
+Shader* SoftwareDevice::CreateShader(const std::string &name, ShaderFeatures features)
+{
+	// programs are written in C++ per shader name, there are no variants to select with features
+	const SoftwareShaderProgram* program = FindSoftwareShaderProgram(name);
+
+	if (program == nullptr)
+	{
+		LOG_ERROR("Software device has no implementation of shader %s", name.c_str());
+		return nullptr;
+	}
+
+	curFrameStats.resourcesCreated++;
+
+	return new ShaderSoftware(program);
+}
+
+void SoftwareDevice::ReleaseShader(Shader* shader)
+{
+	ShaderSoftware* swShader = static_cast<ShaderSoftware*>(shader);
+
+	if (swShader == nullptr)
+		return;
+
+	if (curShader == swShader)
+	{
+		curShader = nullptr;
+		InvalidateDrawState();
+	}
+
+	curFrameStats.resourcesReleased++;
+
+	delete swShader;
+}
+
+Texture* SoftwareDevice::CreateTexture(uint8 *data, const TextureSettings &settings)
+{
+	TextureSoftware* texture = new TextureSoftware(settings);
+
+	curFrameStats.resourcesCreated++;
+
+	if (data == nullptr)
+		return texture;
+
+	// the layers of an array follow each other, so they are converted as one run of texels
+	uint32 texelCount = settings.width * settings.height * settings.arraySize;
+
+	if (!ConvertTexels(data, settings.format, texelCount, texture->texels.data()))
+	{
+		texture->texels.clear();
+	}
+
+	curFrameStats.bytesUploaded += texelCount * 4;
+
+	return texture;
+}
+
+void SoftwareDevice::UpdateTextureLayer(Texture* texture, uint32 layer, const uint8* data)
+{
+	TextureSoftware* swTexture = static_cast<TextureSoftware*>(texture);
+
+	if (swTexture == nullptr || data == nullptr || layer >= swTexture->arraySize || swTexture->texels.empty())
+	{
+		LOG_ERROR("Failed updating texture layer %u", layer);
+		return;
+	}
+
+	// triangles already binned may still sample the old texels
+	rasterizer.Flush();
+
+	uint32 layerTexels = swTexture->width * swTexture->height;
+	ConvertTexels(data, swTexture->format, layerTexels, swTexture->texels.data() + layer * layerTexels);
+
+	curFrameStats.bytesUploaded += layerTexels * 4;
+}
+
+bool SoftwareDevice::ConvertTexels(const uint8* data, TextureFormat format, uint32 texelCount, uint32* texels)
+{
+	// convert to RGBA8, compressed formats are left empty and sample as white
+	switch (format)
+	{
+		case TextureFormat::RGBA:
+			memcpy(texels, data, texelCount * 4);
+			break;
+
+		case TextureFormat::BGRA:
+			for (uint32 t = 0; t < texelCount; t++)
+			{
+				const uint8* src = data + t * 4;
+				texels[t] = src[2] | (src[1] << 8) | (src[0] << 16) | (src[3] << 24);
+			}
+			break;
+
+		case TextureFormat::RGB:
+			for (uint32 t = 0; t < texelCount; t++)
+			{
+				const uint8* src = data + t * 3;
+				texels[t] = src[0] | (src[1] << 8) | (src[2] << 16) | 0xFF000000;
+			}
+			break;
+
+		case TextureFormat::BGR:
+			for (uint32 t = 0; t < texelCount; t++)
+			{
+				const uint8* src = data + t * 3;
+				texels[t] = src[2] | (src[1] << 8) | (src[0] << 16) | 0xFF000000;
+			}
+			break;
+
+		default:
+			LOG_WARNING("Software device does not support compressed textures");
+			return false;
+	}
+
+	return true;
+}
+
+Shader* SoftwareDevice::CreateShaderAsync(const std::string &name, ShaderFeatures features)
+{
+	// shader programs are compiled in to the library, there is nothing to wait on
+	return CreateShader(name, features);
+}
+
+bool SoftwareDevice::IsShaderReady(Shader* shader)
+{
+	return shader != nullptr;
+}
+
+Texture* SoftwareDevice::CreateTextureAsync(const uint8* data, const TextureSettings &settings)
+{
+	// textures are sampled straight from system memory, there is no copy to a GPU to spread over frames
+	return CreateTexture(const_cast<uint8*>(data), settings);
+}
+
+bool SoftwareDevice::IsTextureReady(Texture* texture)
+{
+	return texture != nullptr;
+}
+
+void SoftwareDevice::SetTextureUploadBudget(uint32 bytesPerFrame)
+{
+	// textures are always uploaded when they are created
+}
+
+void SoftwareDevice::ReleaseTexture(Texture* pTexture)
+{
+	TextureSoftware* swTexture = static_cast<TextureSoftware*>(pTexture);
+
+	if (swTexture == nullptr)
+		return;
+
+	// triangles already binned may still sample the texture
+	rasterizer.Flush();
+	InvalidateDrawState();
+
+	for (uint32 t = 0; t < SW_MAX_TEXTURE_SLOTS; t++)
+	{
+		if (curTextures[t] == swTexture)
+		{
+			curTextures[t] = nullptr;
+		}
+	}
+
+	curFrameStats.resourcesReleased++;
+
+	delete swTexture;
+}
+
+void SoftwareDevice::SetUniformBuffer(uint32 slot, Buffer* buffer, ShaderStage stage)
+{
+	BufferSoftware* swBuffer = static_cast<BufferSoftware*>(buffer);
+
+	DS_ASSERT(swBuffer);									// swBuffer must not be null
+	DS_ASSERT(swBuffer->target == BufferTarget::Uniform);	// must be uniform buffer
+
+	if (slot < SW_MAX_UNIFORM_SLOTS)
+	{
+		curUniformBuffers[slot] = swBuffer;
+		curUniformOffsets[slot] = 0;
+		curFrameStats.stateChanges++;
+	}
+}
+
+void SoftwareDevice::SetUniformBufferRange(uint32 slot, Buffer* buffer, uint32 offset, uint32 size, ShaderStage stage)
+{
+	BufferSoftware* swBuffer = static_cast<BufferSoftware*>(buffer);
+
+	DS_ASSERT(swBuffer);									// swBuffer must not be null
+	DS_ASSERT(swBuffer->target == BufferTarget::Uniform);	// must be uniform buffer
+	DS_ASSERT(offset % SW_UNIFORM_BUFFER_ALIGNMENT == 0);	// offset must be aligned
+	DS_ASSERT(offset + size <= swBuffer->size);				// range must lie inside the buffer
+
+	if (slot < SW_MAX_UNIFORM_SLOTS)
+	{
+		curUniformBuffers[slot] = swBuffer;
+		curUniformOffsets[slot] = offset;
+		curFrameStats.stateChanges++;
+	}
+}
+
+uint32 SoftwareDevice::GetUniformBufferAlignment()
+{
+	return SW_UNIFORM_BUFFER_ALIGNMENT;
+}
+
+BufferSoftware* SoftwareDevice::CreateBuffer(const void* data, uint32 size, BufferTarget target, BufferUsage usage)
+{
+	BufferSoftware* buffer = new BufferSoftware(size, target, usage);
+
+	if (data)
+	{
+		memcpy(buffer->data.data(), data, size);
+		curFrameStats.bytesUploaded += size;
+	}
+
+	curFrameStats.resourcesCreated++;
+
+	return buffer;
+}
+
+BufferSoftware* SoftwareDevice::CreateBuffer(const std::vector<BufferData> &data, uint32 dataCount, uint32 bufferSize, BufferTarget target, BufferUsage usage)
+{
+	BufferSoftware* buffer = new BufferSoftware(bufferSize, target, usage);
+
+	uint32 offset = 0;
+	for (uint32 md = 0; md < dataCount; md++)
+	{
+		memcpy(buffer->data.data() + offset, data[md].pData, data[md].sizeBytes);
+		offset += data[md].sizeBytes;
+	}
+
+	curFrameStats.resourcesCreated++;
+	curFrameStats.bytesUploaded += offset;
+
+	return buffer;
+}
+
+void SoftwareDevice::UpdateBuffer(Buffer* buffer, const void* data, uint32 size)
+{
+	BufferSoftware* swBuffer = static_cast<BufferSoftware*>(buffer);
+
+	DS_ASSERT(swBuffer);								// swBuffer must not be null
+	DS_ASSERT(swBuffer->usage != BufferUsage::Static);	// Static buffers should not be modified
+
+	// vertices are shaded when drawn, so the data can be replaced without flushing the rasterizer
+	if (size > swBuffer->size)
+	{
+		swBuffer->data.resize(size);
+		swBuffer->size = size;
+	}
+
+	if (data)
+	{
+		memcpy(swBuffer->data.data(), data, size);
+	}
+
+	curFrameStats.bufferUpdates++;
+	curFrameStats.bytesUploaded += size;
+}
+
+void SoftwareDevice::UpdateBuffer(Buffer* buffer, const std::vector<BufferData> &data, uint32 dataCount, uint32 bufferSize)
+{
+	BufferSoftware* swBuffer = static_cast<BufferSoftware*>(buffer);
+
+	DS_ASSERT(swBuffer);								// swBuffer must not be null
+	DS_ASSERT(swBuffer->usage != BufferUsage::Static);	// Static buffers should not be modified
+
+	if (bufferSize > swBuffer->size)
+	{
+		swBuffer->data.resize(bufferSize);
+		swBuffer->size = bufferSize;
+	}
+
+	uint32 offset = 0;
+	for (uint32 md = 0; md < dataCount; md++)
+	{
+		memcpy(swBuffer->data.data() + offset, data[md].pData, data[md].sizeBytes);
+		offset += data[md].sizeBytes;
+	}
+
+	curFrameStats.bufferUpdates++;
+	curFrameStats.bytesUploaded += offset;
+}
+
+void SoftwareDevice::UpdateBufferRegion(Buffer* buffer, const void* data, uint32 offset, uint32 size)
+{
+	BufferSoftware* swBuffer = static_cast<BufferSoftware*>(buffer);
+
+	DS_ASSERT(swBuffer);								// swBuffer must not be null
+	DS_ASSERT(swBuffer->usage != BufferUsage::Static);	// Static buffers should not be modified
+	DS_ASSERT(swBuffer->usage != BufferUsage::Stream);	// Stream buffers are written in full
+	DS_ASSERT(offset + size <= swBuffer->size);			// region must lie inside the buffer
+
+	if (offset + size > swBuffer->size)
+		return;
+
+	if (data)
+	{
+		memcpy(swBuffer->data.data() + offset, data, size);
+	}
+
+	curFrameStats.bufferUpdates++;
+	curFrameStats.bytesUploaded += size;
+}
+
+void SoftwareDevice::ReleaseBuffer(Buffer* buffer)
+{
+	BufferSoftware* swBuffer = static_cast<BufferSoftware*>(buffer);
+
+	DS_ASSERT(swBuffer); // swBuffer must not be null
+
+	for (uint32 s = 0; s < SW_MAX_UNIFORM_SLOTS; s++)
+	{
+		if (curUniformBuffers[s] == swBuffer)
+		{
+			curUniformBuffers[s] = nullptr;
+		}
+	}
+
+	curFrameStats.resourcesReleased++;
+
+	delete swBuffer;
+}
+
+MeshHandle SoftwareDevice::CreateMeshHandle(const MeshData &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage)
+{
+	MeshSoftware* newMesh = static_cast<MeshSoftware*>(CreateMesh(meshData, vertexAttributeFlags, usage));
+
+	if (newMesh == nullptr)
+		return MeshHandle();
+
+	return meshes.CreateResource(newMesh);
+}
+
+void SoftwareDevice::UpdateMesh(MeshHandle mesh, const MeshData &meshData)
+{
+	MeshSoftware** swMesh;
+	RESOLVE_HANDLE(swMesh, meshes, mesh);
+
+	UpdateMesh(*swMesh, meshData);
+}
+
+void SoftwareDevice::DrawMeshIndexed(MeshHandle mesh, uint32 elementCount, uint32 vertexOffset, uint32 indexOffset)
+{
+	MeshSoftware** swMesh;
+	RESOLVE_HANDLE(swMesh, meshes, mesh);
+
+	DrawMeshIndexed(*swMesh, elementCount, vertexOffset, indexOffset);
+}
+
+void SoftwareDevice::ReleaseMesh(MeshHandle mesh)
+{
+	MeshSoftware** swMesh;
+	RESOLVE_HANDLE(swMesh, meshes, mesh);
+
+	ReleaseMesh(*swMesh);
+	meshes.ReleaseResource(mesh);
+}
+
+ShaderHandle SoftwareDevice::CreateShaderHandle(const std::string &name)
+{
+	ShaderSoftware* newShader = static_cast<ShaderSoftware*>(CreateShader(name));
+
+	if (newShader == nullptr)
+		return ShaderHandle();
+
+	return shaders.CreateResource(newShader);
+}
+
+void SoftwareDevice::SetShader(ShaderHandle shader)
+{
+	ShaderSoftware** swShader;
+	RESOLVE_HANDLE(swShader, shaders, shader);
+
+	SetShader(*swShader);
+}
+
+void SoftwareDevice::ReleaseShader(ShaderHandle shader)
+{
+	ShaderSoftware** swShader;
+	RESOLVE_HANDLE(swShader, shaders, shader);
+
+	ReleaseShader(*swShader);
+	shaders.ReleaseResource(shader);
+}
+
+TextureHandle SoftwareDevice::CreateTextureHandle(uint8 *data, const TextureSettings &settings)
+{
+	TextureSoftware* newTexture = static_cast<TextureSoftware*>(CreateTexture(data, settings));
+
+	if (newTexture == nullptr)
+		return TextureHandle();
+
+	return textures.CreateResource(newTexture);
+}
+
+void SoftwareDevice::SetTexture(TextureHandle texture, uint32 slot)
+{
+	TextureSoftware** swTexture;
+	RESOLVE_HANDLE(swTexture, textures, texture);
+
+	SetTexture(*swTexture, slot);
+}
+
+void SoftwareDevice::ReleaseTexture(TextureHandle texture)
+{
+	TextureSoftware** swTexture;
+	RESOLVE_HANDLE(swTexture, textures, texture);
+
+	ReleaseTexture(*swTexture);
+	textures.ReleaseResource(texture);
+}
+
+BufferHandle SoftwareDevice::CreateBufferHandle(const void* data, uint32 size, BufferTarget target, BufferUsage usage)
+{
+	BufferSoftware* newBuffer = CreateBuffer(data, size, target, usage);
+
+	if (newBuffer == nullptr)
+		return BufferHandle();
+
+	return buffers.CreateResource(newBuffer);
+}
+
+void SoftwareDevice::UpdateBuffer(BufferHandle buffer, const void* data, uint32 size)
+{
+	BufferSoftware** swBuffer;
+	RESOLVE_HANDLE(swBuffer, buffers, buffer);
+
+	UpdateBuffer(*swBuffer, data, size);
+}
+
+void SoftwareDevice::UpdateBufferRegion(BufferHandle buffer, const void* data, uint32 offset, uint32 size)
+{
+	BufferSoftware** swBuffer;
+	RESOLVE_HANDLE(swBuffer, buffers, buffer);
+
+	UpdateBufferRegion(*swBuffer, data, offset, size);
+}
+
+void SoftwareDevice::SetUniformBuffer(uint32 slot, BufferHandle buffer, ShaderStage stage)
+{
+	BufferSoftware** swBuffer;
+	RESOLVE_HANDLE(swBuffer, buffers, buffer);
+
+	SetUniformBuffer(slot, *swBuffer, stage);
+}
+
+void SoftwareDevice::ReleaseBuffer(BufferHandle buffer)
+{
+	BufferSoftware** swBuffer;
+	RESOLVE_HANDLE(swBuffer, buffers, buffer);
+
+	ReleaseBuffer(*swBuffer);
+	buffers.ReleaseResource(buffer);
+}
+
+RenderTarget* SoftwareDevice::CreateRenderTarget(const RenderTargetDesc &desc)
+{
+	if (desc.width == 0 || desc.height == 0)
+	{
+		LOG_ERROR("Failed creating render target, size must not be 0");
+		return nullptr;
+	}
+
+	if (desc.sampleCount > 1)
+	{
+		LOG_WARNING("Software device does not support multisampling, render target created with 1 sample");
+	}
+
+	curFrameStats.resourcesCreated++;
+
+	return new RenderTargetSoftware(desc);
+}
+
+void SoftwareDevice::ReleaseRenderTarget(RenderTarget* target)
+{
+	RenderTargetSoftware* swTarget = static_cast<RenderTargetSoftware*>(target);
+
+	if (swTarget == nullptr)
+		return;
+
+	// triangles already binned may still be rendered to or sample the target
+	rasterizer.Flush();
+	InvalidateDrawState();
+
+	if (curColorTarget == swTarget || curDepthTarget == swTarget)
+	{
+		curColorTarget = (curColorTarget == swTarget) ? nullptr : curColorTarget;
+		curDepthTarget = (curDepthTarget == swTarget) ? nullptr : curDepthTarget;
+
+		BindRasterizerTargets(curColorTarget, curDepthTarget);
+	}
+
+	for (uint32 t = 0; t < SW_MAX_TEXTURE_SLOTS; t++)
+	{
+		if (curTextures[t] == &swTarget->colorTexture)
+		{
+			curTextures[t] = nullptr;
+		}
+	}
+
+	curFrameStats.resourcesReleased++;
+
+	delete swTarget;
+}
+
+void SoftwareDevice::SetRenderTargets(uint32 numColorTargets, RenderTarget* const* pColorTargets, RenderTarget* depthTarget)
+{
+	// the rasterizer has a single color output, any further color targets are not written
+	RenderTargetSoftware* colorTarget = (numColorTargets > 0) ? static_cast<RenderTargetSoftware*>(pColorTargets[0]) : nullptr;
+	RenderTargetSoftware* swDepthTarget = static_cast<RenderTargetSoftware*>(depthTarget);
+
+	if (colorTarget == curColorTarget && swDepthTarget == curDepthTarget)
+		return;
+
+	if (colorTarget && swDepthTarget && (colorTarget->GetDesc().width != swDepthTarget->GetDesc().width ||
+										 colorTarget->GetDesc().height != swDepthTarget->GetDesc().height))
+	{
+		LOG_ERROR("Failed setting render targets, color and depth targets must be the same size");
+		return;
+	}
+
+	curColorTarget = colorTarget;
+	curDepthTarget = swDepthTarget;
+
+	BindRasterizerTargets(curColorTarget, curDepthTarget);
+	InvalidateDrawState();
+
+	curFrameStats.stateChanges++;
+}
+
+void SoftwareDevice::ClearRenderTarget(RenderTarget* target, const vec4 &color, float depth, uint8 stencil)
+{
+	RenderTargetSoftware* swTarget = static_cast<RenderTargetSoftware*>(target);
+
+	if (swTarget == nullptr)
+		return;
+
+	// the clear fills whole tiles so it is not limited by the scissor rect
+	bool isDepth = IsDepthFormat(swTarget->GetDesc().format);
+
+	BindRasterizerTargets(isDepth ? nullptr : swTarget, isDepth ? swTarget : nullptr);
+	rasterizer.Clear(color, depth, stencil);
+	BindRasterizerTargets(curColorTarget, curDepthTarget);
+
+	InvalidateDrawState();
+}
+
+void SoftwareDevice::ResolveRenderTarget(RenderTarget* source, RenderTarget* destination)
+{
+	RenderTargetSoftware* swSource = static_cast<RenderTargetSoftware*>(source);
+	RenderTargetSoftware* swDestination = static_cast<RenderTargetSoftware*>(destination);
+
+	if (swSource == nullptr || swDestination == nullptr || swSource->GetDesc().width != swDestination->GetDesc().width ||
+		swSource->GetDesc().height != swDestination->GetDesc().height)
+	{
+		LOG_ERROR("Failed resolving render target, targets must be the same size");
+		return;
+	}
+
+	rasterizer.Flush();
+
+	// multisampled targets only hold one sample, resolving is a copy
+	swDestination->colorTexture.texels = swSource->colorTexture.texels;
+	swDestination->depth = swSource->depth;
+	swDestination->stencil = swSource->stencil;
+
+	curFrameStats.bytesUploaded += static_cast<uint32>(swSource->colorTexture.texels.size() * 4);
+}
+
+void SoftwareDevice::RequestReadback(RenderTarget* target, ReadbackCallback callback)
+{
+	RenderTargetSoftware* swTarget = static_cast<RenderTargetSoftware*>(target);
+
+	const uint32* source;
+	uint32 width;
+	uint32 height;
+
+	if (swTarget)
+	{
+		const RenderTargetDesc &desc = swTarget->GetDesc();
+
+		if (desc.format != RenderTargetFormat::RGBA8 || desc.sampleCount > 1)
+		{
+			LOG_ERROR("Readback requires a single sampled RGBA8 target");
+			return;
+		}
+
+		source = swTarget->GetColorBuffer();
+		width = desc.width;
+		height = desc.height;
+	}
+	else
+	{
+		source = rasterizer.GetBackBuffer();
+		width = rasterizer.GetWidth();
+		height = rasterizer.GetHeight();
+	}
+
+	// triangles already binned have not been written to the pixels yet
+	rasterizer.Flush();
+
+	const uint8* pixels = reinterpret_cast<const uint8*>(source);
+
+	ReadbackSoftware readback;
+	readback.pixels.assign(pixels, pixels + width * height * 4);
+	readback.width = width;
+	readback.height = height;
+	readback.callback = std::move(callback);
+
+	pendingReadbacks.push_back(std::move(readback));
+}
+
+void SoftwareDevice::BindRasterizerTargets(RenderTargetSoftware* colorTarget, RenderTargetSoftware* depthTarget)
+{
+	if (colorTarget == nullptr && depthTarget == nullptr)
+	{
+		rasterizer.SetRenderTarget(nullptr, nullptr, nullptr, 0, 0);
+		return;
+	}
+
+	const RenderTargetDesc &desc = colorTarget ? colorTarget->GetDesc() : depthTarget->GetDesc();
+
+	rasterizer.SetRenderTarget(colorTarget ? colorTarget->GetColorBuffer() : nullptr,
+							   depthTarget ? depthTarget->GetDepthBuffer() : nullptr,
+							   depthTarget ? depthTarget->GetStencilBuffer() : nullptr,
+							   desc.width, desc.height);
+}
+
+void SoftwareDevice::SetScissorRects(uint32 numRects, const DSRect* pRects)
+{
+	if (!pRects || numRects == 0)
+		return;
+
+	numScissorRects = glm::min(numRects, static_cast<uint32>(SW_MAX_SCISSOR_RECTS));
+
+	for (uint32 r = 0; r < numScissorRects; r++)
+	{
+		scissorRects[r] = pRects[r];
+	}
+
+	// only the first scissor rect is used, as with a single viewport on the other devices
+	rasterizer.SetScissorRect(scissorRects[0]);
+
+	curFrameStats.stateChanges++;
+}
+
+void SoftwareDevice::GetScissorRects(uint32* pNumRects, DSRect* pRects)
+{
+	if (pNumRects)
+		*pNumRects = numScissorRects;
+
+	if (pRects)
+	{
+		for (uint32 r = 0; r < numScissorRects; r++)
+		{
+			pRects[r] = scissorRects[r];
+		}
+	}
+}
+
+BlendState* SoftwareDevice::CreateBlendState(BlendProperties properties)
+{
+	// return the existing state if one was already created with the same properties
+	uint32 key = properties.CalculateKey();
+	BlendStateSoftware* state = blendStates.Find(key, properties);
+
+	if (state != nullptr)
+		return state;
+
+	state = new BlendStateSoftware();
+	state->properties = properties;
+
+	curFrameStats.resourcesCreated++;
+
+	return blendStates.Add(key, properties, state);
+}
+
+void SoftwareDevice::SetBlendState(BlendState* state)
+{
+	if (state == nullptr)
+		return;
+
+	if (curBlendState != state)
+	{
+		curBlendState = static_cast<BlendStateSoftware*>(state);
+		curFrameStats.stateChanges++;
+
+		InvalidateDrawState();
+	}
+}
+
+DepthStencilStateSoftware* SoftwareDevice::CreateDepthStencilState(DepthStencilStateDesc& desc)
+{
+	// return the existing state if one was already created with the same descriptor
+	uint32 key = desc.CalculateKey();
+	DepthStencilStateSoftware* state = depthStencilStates.Find(key, desc);
+
+	if (state != nullptr)
+		return state;
+
+	curFrameStats.resourcesCreated++;
+
+	return depthStencilStates.Add(key, desc, new DepthStencilStateSoftware(desc));
+}
+
+DepthStencilState* SoftwareDevice::GetCurrentDepthStencilState()
+{
+	return curDepthStencilState;
+}
+
+void SoftwareDevice::SetDepthStencilState(DepthStencilState* state)
+{
+	DepthStencilStateSoftware* swState = static_cast<DepthStencilStateSoftware*>(state);
+
+	if (state == nullptr)
+	{
+		SetDepthStencilState(defaultDepthStencilState);
+		return;
+	}
+
+	if (curDepthStencilState != swState)
+	{
+		curDepthStencilState = swState;
+		curFrameStats.stateChanges++;
+
+		InvalidateDrawState();
+	}
+}
+
+RasterizerState* SoftwareDevice::CreateRasterizerState(const RasterizerStateDesc &desc)
+{
+	// return the existing state if one was already created with the same descriptor
+	uint32 key = desc.CalculateKey();
+	RasterizerStateSoftware* state = rasterizerStates.Find(key, desc);
+
+	if (state != nullptr)
+		return state;
+
+	state = new RasterizerStateSoftware();
+	state->desc = desc;
+
+	curFrameStats.resourcesCreated++;
+
+	return rasterizerStates.Add(key, desc, state);
+}
+
+void SoftwareDevice::SetRasterizerState(RasterizerState* state)
+{
+	RasterizerStateSoftware* swState = static_cast<RasterizerStateSoftware*>(state);
+
+	if (state == nullptr)
+	{
+		SetRasterizerState(defaultRasterizerState);
+		return;
+	}
+
+	if (curRasterizerState != swState)
+	{
+		curRasterizerState = swState;
+		curFrameStats.stateChanges++;
+
+		InvalidateDrawState();
+	}
+}
+
+GraphicsStats SoftwareDevice::GetFrameStats()
+{
+	return lastFrameStats;
+}
+
+void SoftwareDevice::SetClearColor(const vec4 &color)
+{
+	clearColor = color;
+}
+
+void SoftwareDevice::SetViewport(int32 x, int32 y, int32 width, int32 height)
+{
+	rasterizer.SetViewport(x, y, width, height);
+
+	curFrameStats.stateChanges++;
+}
+
+void SoftwareDevice::OnResolutionChanged(uint32 width, uint32 height)
+{
+	renderInfo.resolutionX = width;
+	renderInfo.resolutionY = height;
+
+	rasterizer.Resize(width, height);
+	InvalidateDrawState();
+
+	// resizing binds the back buffer, offscreen targets are kept bound
+	BindRasterizerTargets(curColorTarget, curDepthTarget);
+
+	// the scissor rect is kept across resizes, as it is on the other devices
+	if (numScissorRects > 0)
+	{
+		rasterizer.SetScissorRect(scissorRects[0]);
+	}
+
+	SetViewport(0, 0, width, height);
+}
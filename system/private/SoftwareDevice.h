@@ -0,0 +1,246 @@
+#ifndef _SOFTWARE_DEVICE_H
+#define _SOFTWARE_DEVICE_H
+
+#include "SoftwareRasterizer.h"
+#include "utility/StateCache.h"
+
+// SoftwareDevice implements IGraphicsDevice on the CPU without a context or a window, frames are presented
+// to memory and can be read back with GetFrontBuffer, giving a GPU free reference for pixel output
+class SoftwareDevice : public IGraphicsDevice
+{
+public:
+
+	std::string GetAPIName();
+
+	bool Create(const RenderInfo& info);
+
+	void Initialize();
+	void Destroy();
+
+	void Clear();
+	void Present();
+
+	void SetVSync(bool enabled);
+
+	void SetFramesInFlight(uint32 count);
+
+	uint32 GetFramesInFlight() { return framesInFlight; }
+
+	uint32 GetFrameSlot() { return frameSlot; }
+
+	void SetShader(Shader* shader);
+
+	void SetTexture(Texture* texture, uint32 slot);
+
+	void SetClearColor(const vec4 &color);
+
+	void SetViewport(int32 x, int32 y, int32 width, int32 height);
+
+	void OnResolutionChanged(uint32 width, uint32 height);
+
+	void DrawMesh(Mesh* mesh);
+	void DrawMeshIndexed(Mesh* mesh, uint32 elementCount = 0, uint32 vertexOffset = 0, uint32 indexOffset = 0);
+
+	void DrawMeshIndexedInstanced(Mesh* mesh, Buffer* instanceBuffer, VertexAttributes instanceAttributeFlags, uint32 instanceCount,
+								  uint32 firstInstance = 0, uint32 elementCount = 0, uint32 vertexOffset = 0, uint32 indexOffset = 0);
+
+	// Mesh Resource Handling
+	Mesh* CreateMesh(const MeshData &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage);
+
+	Mesh* CreateMesh(const MeshDataList &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage);
+
+	void UpdateMesh(Mesh* mesh, const MeshData &meshData);
+
+	void UpdateMesh(Mesh* mesh, const MeshDataList &meshData);
+
+	void ReleaseMesh(Mesh* mesh);
+
+	// Mesh Arenas
+	void SetMeshArenasEnabled(bool enabled);
+	void DefragmentMeshArenas();
+	MeshArenaStats GetMeshArenaStats();
+
+	Shader* CreateShader(const std::string &name, ShaderFeatures features = ShaderFeatures::None);
+	void ReleaseShader(Shader* shader);
+
+	Shader* CreateShaderAsync(const std::string &name, ShaderFeatures features = ShaderFeatures::None);
+
+	bool IsShaderReady(Shader* shader);
+
+	Texture* CreateTexture(uint8 *data, const TextureSettings &settings);
+	void ReleaseTexture(Texture* pTexture);
+	void UpdateTextureLayer(Texture* texture, uint32 layer, const uint8* data);
+
+	Texture* CreateTextureAsync(const uint8* data, const TextureSettings &settings);
+
+	bool IsTextureReady(Texture* texture);
+
+	void SetTextureUploadBudget(uint32 bytesPerFrame);
+
+	// Uniform Buffer Resource Handling
+	void SetUniformBuffer(uint32 slot, Buffer* buffer, ShaderStage stage);
+	void SetUniformBufferRange(uint32 slot, Buffer* buffer, uint32 offset, uint32 size, ShaderStage stage);
+
+	uint32 GetUniformBufferAlignment();
+
+	// Buffer Resource Handling
+	BufferSoftware* CreateBuffer(const void* data, uint32 size, BufferTarget target, BufferUsage usage);
+	BufferSoftware* CreateBuffer(const std::vector<BufferData> &data, uint32 dataCount, uint32 bufferSize, BufferTarget target, BufferUsage usage);
+
+	void UpdateBuffer(Buffer* buffer, const void* data, uint32 size);
+	void UpdateBuffer(Buffer* buffer, const std::vector<BufferData> &data, uint32 dataCount, uint32 bufferSize);
+
+	void UpdateBufferRegion(Buffer* buffer, const void* data, uint32 offset, uint32 size);
+
+	void ReleaseBuffer(Buffer* buffer);
+
+	// Handle Resources
+	MeshHandle CreateMeshHandle(const MeshData &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage);
+	void UpdateMesh(MeshHandle mesh, const MeshData &meshData);
+	void DrawMeshIndexed(MeshHandle mesh, uint32 elementCount = 0, uint32 vertexOffset = 0, uint32 indexOffset = 0);
+	void ReleaseMesh(MeshHandle mesh);
+
+	ShaderHandle CreateShaderHandle(const std::string &name);
+	void SetShader(ShaderHandle shader);
+	void ReleaseShader(ShaderHandle shader);
+
+	TextureHandle CreateTextureHandle(uint8 *data, const TextureSettings &settings);
+	void SetTexture(TextureHandle texture, uint32 slot);
+	void ReleaseTexture(TextureHandle texture);
+
+	BufferHandle CreateBufferHandle(const void* data, uint32 size, BufferTarget target, BufferUsage usage);
+	void UpdateBuffer(BufferHandle buffer, const void* data, uint32 size);
+	void UpdateBufferRegion(BufferHandle buffer, const void* data, uint32 offset, uint32 size);
+	void SetUniformBuffer(uint32 slot, BufferHandle buffer, ShaderStage stage);
+	void ReleaseBuffer(BufferHandle buffer);
+
+	// Render Targets
+	RenderTarget* CreateRenderTarget(const RenderTargetDesc &desc);
+	void ReleaseRenderTarget(RenderTarget* target);
+
+	void SetRenderTargets(uint32 numColorTargets, RenderTarget* const* pColorTargets, RenderTarget* depthTarget);
+
+	void ClearRenderTarget(RenderTarget* target, const vec4 &color, float depth = 1.0f, uint8 stencil = 0);
+
+	void ResolveRenderTarget(RenderTarget* source, RenderTarget* destination);
+
+	void RequestReadback(RenderTarget* target, ReadbackCallback callback);
+
+	// Scissor
+	void SetScissorRects(uint32 numRects, const DSRect* pRects);
+
+	void GetScissorRects(uint32* pNumRects, DSRect* pRects);
+
+	// Blend State
+	BlendState* CreateBlendState(BlendProperties properties);
+
+	void SetBlendState(BlendState* state);
+
+	// Depth/Stencil State
+	DepthStencilStateSoftware* CreateDepthStencilState(DepthStencilStateDesc& desc);
+
+	DepthStencilState* GetCurrentDepthStencilState();
+
+	void SetDepthStencilState(DepthStencilState* state);
+
+	// Rasterizer State
+	RasterizerState* CreateRasterizerState(const RasterizerStateDesc &desc);
+
+	void SetRasterizerState(RasterizerState* state);
+
+	// Statistics
+	GraphicsStats GetFrameStats();
+
+	// returns the pixels of the last presented frame, RGBA8 with red in the lowest byte, rows from top to bottom
+	const uint32* GetFrontBuffer() const { return rasterizer.GetFrontBuffer(); }
+
+	uint32 GetThreadCount() const { return rasterizer.GetThreadCount(); }
+
+private:
+
+	// runs the vertex shader over the vertices referenced by the indices and submits the triangles to the rasterizer
+	// once for each instance, instances is null for non instanced draws
+	void DrawTriangles(MeshSoftware* mesh, const uint8* indices, IndexFormat indexFormat, uint32 elementCount, uint32 vertexOffset,
+					   const SoftwareInstanceStream* instances = nullptr, uint32 instanceCount = 1);
+
+	void ReadVertex(const MeshSoftware* mesh, uint32 vertexIndex, SoftwareVertexInput &input);
+
+	void ReadInstance(const SoftwareInstanceStream &instances, uint32 instanceIndex, SoftwareVertexInput &input);
+
+	// converts texels in the given format to RGBA8, returns false for formats the device can not decode
+	bool ConvertTexels(const uint8* data, TextureFormat format, uint32 texelCount, uint32* texels);
+
+	// returns the index of the draw state used by the next draw, a new state is only added after a state change
+	uint32 GetDrawState();
+
+	// marks the current state as changed, the next draw stores a new snapshot
+	void InvalidateDrawState() { drawStateValid = false; }
+
+	RenderInfo renderInfo;
+
+	SoftwareRasterizer rasterizer;
+
+	// post transform vertex cache, a vertex is shaded once per draw or instance, stamps identify the draw that shaded it
+	std::vector<SoftwareVertexOutput> transformedVertices;
+	std::vector<uint32> transformedStamps;
+	uint32 drawStamp = 0;
+
+	// fallback index list for non indexed draws
+	std::vector<uint16> sequentialIndices;
+
+	// holds 32 bit indices narrowed to 16 bit while they are uploaded
+	std::vector<uint16> indexScratch;
+
+	// readbacks requested since the last Present
+	std::vector<ReadbackSoftware> pendingReadbacks;
+
+	// counters for the frame currently being recorded and the last presented frame
+	GraphicsStats curFrameStats;
+	GraphicsStats lastFrameStats;
+
+	// frames are finished when Present returns, slots are cycled so code versioning resources by slot runs unchanged
+	uint32 framesInFlight = DS_MAX_FRAMES_IN_FLIGHT;
+	uint32 frameSlot = 0;
+
+	// States
+	ShaderSoftware* curShader = nullptr;
+	TextureSoftware* curTextures[SW_MAX_TEXTURE_SLOTS] = {};
+	BufferSoftware* curUniformBuffers[SW_MAX_UNIFORM_SLOTS] = {};
+	uint32 curUniformOffsets[SW_MAX_UNIFORM_SLOTS] = {};
+
+	// null while rendering to the back buffer
+	RenderTargetSoftware* curColorTarget = nullptr;
+	RenderTargetSoftware* curDepthTarget = nullptr;
+
+	BlendStateSoftware* defaultBlendState = nullptr;
+	BlendStateSoftware* curBlendState = nullptr;
+	DepthStencilStateSoftware* defaultDepthStencilState = nullptr;
+	DepthStencilStateSoftware* curDepthStencilState = nullptr;
+	RasterizerStateSoftware* defaultRasterizerState = nullptr;
+	RasterizerStateSoftware* curRasterizerState = nullptr;
+
+	// every state object created is kept here, identical descriptors share one object
+	StateCache<BlendProperties, BlendStateSoftware> blendStates;
+	StateCache<DepthStencilStateDesc, DepthStencilStateSoftware> depthStencilStates;
+	StateCache<RasterizerStateDesc, RasterizerStateSoftware> rasterizerStates;
+
+	// resources created through handles, the rasterizer holds on to texture and buffer pointers until the
+	// binned triangles are shaded so the containers store pointers rather than moving the resources
+	ResourceContainer<MeshSoftware*, MeshHandle> meshes;
+	ResourceContainer<ShaderSoftware*, ShaderHandle> shaders;
+	ResourceContainer<TextureSoftware*, TextureHandle> textures;
+	ResourceContainer<BufferSoftware*, BufferHandle> buffers;
+
+	uint32 drawStateIndex = 0;
+	bool drawStateValid = false;
+
+	// points the rasterizer at the buffers of the targets, both null binds the back buffer
+	void BindRasterizerTargets(RenderTargetSoftware* colorTarget, RenderTargetSoftware* depthTarget);
+
+	DSRect scissorRects[SW_MAX_SCISSOR_RECTS];
+	uint32 numScissorRects = 0;
+
+	vec4 clearColor;
+};
+
+#endif // _SOFTWARE_DEVICE_H
@@ -0,0 +1,807 @@
+#include "SoftwareRasterizer.h"
+
+#define SW_MAX_CLIP_VERTICES 12
+#define SW_CLIP_PLANE_COUNT 6
+
+SoftwareRasterizer::SoftwareRasterizer() :
+	nextTile(0)
+{
+
+}
+
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+	Destroy();
+}
+
+void SoftwareRasterizer::Initialize(uint32 width, uint32 height, uint32 threadCount)
+{
+	if (threadCount == 0)
+	{
+		threadCount = glm::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	Resize(width, height);
+
+	// the calling thread also works on each job, so one less worker is created. workers start from the current
+	// generation, a worker reading it once it runs could miss a job started before then
+	quit = false;
+	for (uint32 t = 1; t < threadCount; t++)
+	{
+		workers.push_back(std::thread(&SoftwareRasterizer::WorkerLoop, this, jobGeneration));
+	}
+
+	LOG("Software rasterizer using %u threads", threadCount);
+}
+
+void SoftwareRasterizer::Destroy()
+{
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		quit = true;
+	}
+
+	jobCondition.notify_all();
+
+	for (std::thread &worker : workers)
+	{
+		worker.join();
+	}
+
+	workers.clear();
+}
+
+void SoftwareRasterizer::Resize(uint32 newWidth, uint32 newHeight)
+{
+	// any triangles binned for the old size are dropped, along with their indices in the bins
+	triangles.clear();
+	drawStates.clear();
+
+	for (std::vector<uint32> &bin : tileBins)
+	{
+		bin.clear();
+	}
+
+	width = newWidth;
+	height = newHeight;
+
+	backBuffer.assign(width * height, 0);
+	frontBuffer.assign(width * height, 0);
+	depthBuffer.assign(width * height, 1.0f);
+	stencilBuffer.assign(width * height, 0);
+
+	BindBackBuffer();
+
+	SetViewport(0, 0, width, height);
+	SetScissorRect(DSRect(0, 0, width, height));
+}
+
+void SoftwareRasterizer::SetRenderTarget(uint32* color, float* depth, uint8* stencil, uint32 newTargetWidth, uint32 newTargetHeight)
+{
+	Flush();
+
+	if (color == nullptr && depth == nullptr && stencil == nullptr)
+	{
+		BindBackBuffer();
+		return;
+	}
+
+	colorTarget = color;
+	depthTarget = depth;
+	stencilTarget = stencil;
+	backBufferBound = false;
+
+	SetTileGrid(newTargetWidth, newTargetHeight);
+}
+
+void SoftwareRasterizer::BindBackBuffer()
+{
+	colorTarget = backBuffer.data();
+	depthTarget = depthBuffer.data();
+	stencilTarget = stencilBuffer.data();
+	backBufferBound = true;
+
+	SetTileGrid(width, height);
+}
+
+void SoftwareRasterizer::SetTileGrid(uint32 gridWidth, uint32 gridHeight)
+{
+	targetWidth = gridWidth;
+	targetHeight = gridHeight;
+
+	tilesX = (targetWidth + SW_TILE_SIZE - 1) >> SW_TILE_SIZE_SHIFT;
+	tilesY = (targetHeight + SW_TILE_SIZE - 1) >> SW_TILE_SIZE_SHIFT;
+
+	// bins are only added, switching between targets does not reallocate them
+	if (tileBins.size() < tilesX * tilesY)
+	{
+		tileBins.resize(tilesX * tilesY);
+	}
+}
+
+void SoftwareRasterizer::SetViewport(int32 x, int32 y, int32 w, int32 h)
+{
+	viewportX = x;
+	viewportY = y;
+	viewportWidth = w;
+	viewportHeight = h;
+}
+
+void SoftwareRasterizer::SetScissorRect(const DSRect &rect)
+{
+	scissorRect = rect;
+}
+
+uint32 SoftwareRasterizer::AddDrawState(const SoftwareDrawState &state)
+{
+	drawStates.push_back(state);
+
+	// expand the 4 bit color mask to a byte mask for each channel
+	SoftwareDrawState &added = drawStates.back();
+	added.colorWriteMask = 0;
+
+	for (uint32 c = 0; c < 4; c++)
+	{
+		if (added.blend.colorMask & (1 << c))
+		{
+			added.colorWriteMask |= 0xFF << (c * 8);
+		}
+	}
+
+	return static_cast<uint32>(drawStates.size() - 1);
+}
+
+// returns the signed distance of a clip space position to one of the clipping planes, positive is inside
+static float ClipDistance(const vec4 &p, uint32 plane, float guardX, float guardY)
+{
+	switch (plane)
+	{
+		case 0: return p.z + p.w;				// near
+		case 1: return p.w - p.z;				// far
+		case 2: return guardX * p.w + p.x;		// left guard band
+		case 3: return guardX * p.w - p.x;		// right guard band
+		case 4: return guardY * p.w + p.y;		// bottom guard band
+		default: return guardY * p.w - p.y;		// top guard band
+	}
+}
+
+static void LerpVertex(const SoftwareVertexOutput &a, const SoftwareVertexOutput &b, float t, uint32 varyingCount, SoftwareVertexOutput &out)
+{
+	out.position = glm::mix(a.position, b.position, t);
+
+	for (uint32 v = 0; v < varyingCount; v++)
+	{
+		out.varyings[v] = a.varyings[v] + (b.varyings[v] - a.varyings[v]) * t;
+	}
+}
+
+void SoftwareRasterizer::SubmitTriangle(const SoftwareVertexOutput &v0, const SoftwareVertexOutput &v1, const SoftwareVertexOutput &v2,
+										uint32 varyingCount, uint32 stateIndex)
+{
+	if (viewportWidth <= 0 || viewportHeight <= 0)
+		return;
+
+	float guardX = SW_GUARD_BAND_PIXELS / (static_cast<float>(viewportWidth) * 0.5f);
+	float guardY = SW_GUARD_BAND_PIXELS / (static_cast<float>(viewportHeight) * 0.5f);
+
+	const SoftwareVertexOutput* input[3] = { &v0, &v1, &v2 };
+
+	// build an outcode for each vertex, one bit per plane the vertex is outside of
+	uint32 outcodes[3] = { 0, 0, 0 };
+	for (uint32 v = 0; v < 3; v++)
+	{
+		for (uint32 p = 0; p < SW_CLIP_PLANE_COUNT; p++)
+		{
+			if (ClipDistance(input[v]->position, p, guardX, guardY) < 0.0f)
+			{
+				outcodes[v] |= 1 << p;
+			}
+		}
+	}
+
+	// all vertices outside the same plane, the triangle can not be visible
+	if (outcodes[0] & outcodes[1] & outcodes[2])
+		return;
+
+	// all vertices inside every plane, no clipping required
+	if ((outcodes[0] | outcodes[1] | outcodes[2]) == 0)
+	{
+		SetupTriangle(input, varyingCount, stateIndex);
+		return;
+	}
+
+	// clip the triangle against each plane it crosses, producing a convex polygon
+	SoftwareVertexOutput bufferA[SW_MAX_CLIP_VERTICES];
+	SoftwareVertexOutput bufferB[SW_MAX_CLIP_VERTICES];
+
+	SoftwareVertexOutput* src = bufferA;
+	SoftwareVertexOutput* dst = bufferB;
+	uint32 count = 3;
+
+	src[0] = v0;
+	src[1] = v1;
+	src[2] = v2;
+
+	uint32 planeMask = outcodes[0] | outcodes[1] | outcodes[2];
+	for (uint32 p = 0; p < SW_CLIP_PLANE_COUNT && count >= 3; p++)
+	{
+		if (!(planeMask & (1 << p)))
+			continue;
+
+		uint32 outCount = 0;
+		for (uint32 v = 0; v < count; v++)
+		{
+			const SoftwareVertexOutput &a = src[v];
+			const SoftwareVertexOutput &b = src[(v + 1) % count];
+
+			float da = ClipDistance(a.position, p, guardX, guardY);
+			float db = ClipDistance(b.position, p, guardX, guardY);
+
+			if (da >= 0.0f)
+			{
+				dst[outCount++] = a;
+			}
+
+			// edge crosses the plane, add the intersection point
+			if ((da >= 0.0f) != (db >= 0.0f) && outCount < SW_MAX_CLIP_VERTICES)
+			{
+				LerpVertex(a, b, da / (da - db), varyingCount, dst[outCount++]);
+			}
+		}
+
+		std::swap(src, dst);
+		count = outCount;
+	}
+
+	// triangulate the clipped polygon as a fan
+	for (uint32 v = 1; v + 1 < count; v++)
+	{
+		const SoftwareVertexOutput* fan[3] = { &src[0], &src[v], &src[v + 1] };
+		SetupTriangle(fan, varyingCount, stateIndex);
+	}
+}
+
+void SoftwareRasterizer::SetupTriangle(const SoftwareVertexOutput* vertices[3], uint32 varyingCount, uint32 stateIndex)
+{
+	SoftwareTriangle tri;
+
+	int32 fx[3], fy[3];
+	float invW[3];
+
+	// project to screen space, rows go from top to bottom
+	for (uint32 v = 0; v < 3; v++)
+	{
+		const vec4 &p = vertices[v]->position;
+
+		if (p.w <= 0.0f)
+			return;
+
+		invW[v] = 1.0f / p.w;
+
+		float sx = static_cast<float>(viewportX) + (p.x * invW[v] * 0.5f + 0.5f) * static_cast<float>(viewportWidth);
+		float sy = static_cast<float>(viewportY) + (0.5f - p.y * invW[v] * 0.5f) * static_cast<float>(viewportHeight);
+
+		fx[v] = static_cast<int32>(floor(sx * SW_SUBPIXEL_STEPS + 0.5f));
+		fy[v] = static_cast<int32>(floor(sy * SW_SUBPIXEL_STEPS + 0.5f));
+	}
+
+	int64 area = static_cast<int64>(fx[1] - fx[0]) * (fy[2] - fy[0]) - static_cast<int64>(fy[1] - fy[0]) * (fx[2] - fx[0]);
+
+	if (area == 0)
+		return;
+
+	const RasterizerStateDesc &rasterizerState = drawStates[stateIndex].rasterizer;
+
+	// a positive area is counter clockwise in normalized device coordinates
+	bool clockwise = area < 0;
+	tri.backFacing = rasterizerState.frontCounterClockwise ? clockwise : !clockwise;
+
+	if ((rasterizerState.cullMode == CullMode::Back && tri.backFacing) ||
+		(rasterizerState.cullMode == CullMode::Front && !tri.backFacing))
+		return;
+
+	// flip clockwise triangles so area is positive
+	uint32 order[3] = { 0, 1, 2 };
+
+	if (clockwise)
+	{
+		order[1] = 2;
+		order[2] = 1;
+		area = -area;
+	}
+
+	// pixel bounding box, a pixel is covered if its centre is inside the triangle
+	int32 minFX = glm::min(fx[0], glm::min(fx[1], fx[2]));
+	int32 minFY = glm::min(fy[0], glm::min(fy[1], fy[2]));
+	int32 maxFX = glm::max(fx[0], glm::max(fx[1], fx[2]));
+	int32 maxFY = glm::max(fy[0], glm::max(fy[1], fy[2]));
+
+	const int32 halfPixel = SW_SUBPIXEL_STEPS / 2;
+	tri.minX = (minFX - halfPixel + SW_SUBPIXEL_STEPS - 1) >> SW_SUBPIXEL_BITS;
+	tri.minY = (minFY - halfPixel + SW_SUBPIXEL_STEPS - 1) >> SW_SUBPIXEL_BITS;
+	tri.maxX = (maxFX - halfPixel) >> SW_SUBPIXEL_BITS;
+	tri.maxY = (maxFY - halfPixel) >> SW_SUBPIXEL_BITS;
+
+	// clip bounding box against the viewport, scissor and the render target
+	DSRect clipRect = rasterizerState.scissorEnabled ? scissorRect : DSRect(0, 0, targetWidth, targetHeight);
+
+	tri.minX = glm::max(tri.minX, glm::max(viewportX, glm::max(clipRect.left, 0)));
+	tri.minY = glm::max(tri.minY, glm::max(viewportY, glm::max(clipRect.top, 0)));
+	tri.maxX = glm::min(tri.maxX, glm::min(viewportX + viewportWidth, glm::min(clipRect.right, static_cast<int32>(targetWidth))) - 1);
+	tri.maxY = glm::min(tri.maxY, glm::min(viewportY + viewportHeight, glm::min(clipRect.bottom, static_cast<int32>(targetHeight))) - 1);
+
+	if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+		return;
+
+	// setup the edge functions, edge i goes from vertex i+1 to vertex i+2
+	for (uint32 e = 0; e < 3; e++)
+	{
+		uint32 a = order[(e + 1) % 3];
+		uint32 b = order[(e + 2) % 3];
+
+		int32 dx = fx[b] - fx[a];
+		int32 dy = fy[b] - fy[a];
+
+		tri.edgeA[e] = -dy;
+		tri.edgeB[e] = dx;
+		tri.edgeC[e] = static_cast<int64>(dy) * fx[a] - static_cast<int64>(dx) * fy[a];
+
+		// fill rule, pixels exactly on an edge belong to the triangle only for top and left edges
+		bool topLeft = dy < 0 || (dy == 0 && dx > 0);
+		if (!topLeft)
+		{
+			tri.edgeC[e] -= 1;
+		}
+	}
+
+	tri.invArea = 1.0f / static_cast<float>(area);
+	tri.varyingCount = varyingCount;
+	tri.stateIndex = stateIndex;
+
+	for (uint32 v = 0; v < 3; v++)
+	{
+		uint32 src = order[v];
+		const SoftwareVertexOutput* vertex = vertices[src];
+
+		tri.invW[v] = invW[src];
+		tri.z[v] = vertex->position.z * invW[src] * 0.5f + 0.5f;
+
+		for (uint32 i = 0; i < varyingCount; i++)
+		{
+			tri.varyings[v][i] = vertex->varyings[i] * invW[src];
+		}
+	}
+
+	// bin the triangle in to every tile its bounding box overlaps
+	uint32 triangleIndex = static_cast<uint32>(triangles.size());
+	triangles.push_back(tri);
+
+	int32 tileMinX = tri.minX >> SW_TILE_SIZE_SHIFT;
+	int32 tileMinY = tri.minY >> SW_TILE_SIZE_SHIFT;
+	int32 tileMaxX = tri.maxX >> SW_TILE_SIZE_SHIFT;
+	int32 tileMaxY = tri.maxY >> SW_TILE_SIZE_SHIFT;
+
+	for (int32 ty = tileMinY; ty <= tileMaxY; ty++)
+	{
+		for (int32 tx = tileMinX; tx <= tileMaxX; tx++)
+		{
+			tileBins[ty * tilesX + tx].push_back(triangleIndex);
+		}
+	}
+}
+
+void SoftwareRasterizer::Clear(const vec4 &color, float depth, uint8 stencil)
+{
+	Flush();
+
+	clearColor = PackColorRGBA8(color);
+	clearDepth = depth;
+	clearStencil = stencil;
+
+	RunJob(JobType::Clear);
+}
+
+void SoftwareRasterizer::Flush()
+{
+	if (triangles.empty())
+	{
+		drawStates.clear();
+		return;
+	}
+
+	RunJob(JobType::Rasterize);
+
+	triangles.clear();
+	drawStates.clear();
+
+	for (std::vector<uint32> &bin : tileBins)
+	{
+		bin.clear();
+	}
+}
+
+void SoftwareRasterizer::Present()
+{
+	Flush();
+
+	backBuffer.swap(frontBuffer);
+
+	if (backBufferBound)
+	{
+		colorTarget = backBuffer.data();
+	}
+}
+
+void SoftwareRasterizer::RunJob(JobType type)
+{
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+
+		curJob = type;
+		nextTile = 0;
+		activeWorkers = static_cast<uint32>(workers.size());
+		jobGeneration++;
+	}
+
+	jobCondition.notify_all();
+
+	// the calling thread takes tiles too, then waits for the workers still finishing theirs
+	ProcessTiles();
+
+	std::unique_lock<std::mutex> lock(jobMutex);
+	doneCondition.wait(lock, [this] { return activeWorkers == 0; });
+}
+
+void SoftwareRasterizer::WorkerLoop(uint32 lastGeneration)
+{
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobCondition.wait(lock, [&] { return quit || jobGeneration != lastGeneration; });
+
+			if (quit)
+				return;
+
+			lastGeneration = jobGeneration;
+		}
+
+		ProcessTiles();
+
+		std::lock_guard<std::mutex> lock(jobMutex);
+		if (--activeWorkers == 0)
+		{
+			doneCondition.notify_one();
+		}
+	}
+}
+
+void SoftwareRasterizer::ProcessTiles()
+{
+	uint32 tileCount = tilesX * tilesY;
+
+	// tiles are handed out one at a time, a tile is only ever touched by a single thread
+	for (uint32 tile = nextTile++; tile < tileCount; tile = nextTile++)
+	{
+		if (curJob == JobType::Clear)
+		{
+			ClearTile(tile);
+		}
+		else
+		{
+			RasterizeTile(tile);
+		}
+	}
+}
+
+void SoftwareRasterizer::ClearTile(uint32 tileIndex)
+{
+	uint32 x0 = (tileIndex % tilesX) << SW_TILE_SIZE_SHIFT;
+	uint32 y0 = (tileIndex / tilesX) << SW_TILE_SIZE_SHIFT;
+	uint32 x1 = glm::min(x0 + SW_TILE_SIZE, targetWidth);
+	uint32 y1 = glm::min(y0 + SW_TILE_SIZE, targetHeight);
+
+	for (uint32 y = y0; y < y1; y++)
+	{
+		uint32 row = y * targetWidth;
+
+		if (colorTarget)
+			std::fill(colorTarget + row + x0, colorTarget + row + x1, clearColor);
+
+		if (depthTarget)
+			std::fill(depthTarget + row + x0, depthTarget + row + x1, clearDepth);
+
+		if (stencilTarget)
+			std::fill(stencilTarget + row + x0, stencilTarget + row + x1, clearStencil);
+	}
+}
+
+void SoftwareRasterizer::RasterizeTile(uint32 tileIndex)
+{
+	int32 tileX0 = (tileIndex % tilesX) << SW_TILE_SIZE_SHIFT;
+	int32 tileY0 = (tileIndex / tilesX) << SW_TILE_SIZE_SHIFT;
+	int32 tileX1 = tileX0 + SW_TILE_SIZE - 1;
+	int32 tileY1 = tileY0 + SW_TILE_SIZE - 1;
+
+	// triangles are stored in submission order so blending within the tile is correct
+	for (uint32 triangleIndex : tileBins[tileIndex])
+	{
+		const SoftwareTriangle &tri = triangles[triangleIndex];
+
+		RasterizeTriangle(tri,
+						  glm::max(tri.minX, tileX0), glm::max(tri.minY, tileY0),
+						  glm::min(tri.maxX, tileX1), glm::min(tri.maxY, tileY1));
+	}
+}
+
+void SoftwareRasterizer::RasterizeTriangle(const SoftwareTriangle &tri, int32 x0, int32 y0, int32 x1, int32 y1)
+{
+	if (x0 > x1 || y0 > y1)
+		return;
+
+	const SoftwareDrawState &state = drawStates[tri.stateIndex];
+
+	int32 rectWidth = x1 - x0;
+	int32 rectHeight = y1 - y0;
+
+	// evaluate the edge functions at the centre of the first pixel, moving one pixel steps A or B subpixels
+	int64 edgeStart[3];
+	int32 stepX[3], stepY[3];
+	bool partial[3];
+
+	int64 px = (static_cast<int64>(x0) << SW_SUBPIXEL_BITS) + SW_SUBPIXEL_STEPS / 2;
+	int64 py = (static_cast<int64>(y0) << SW_SUBPIXEL_BITS) + SW_SUBPIXEL_STEPS / 2;
+
+	for (uint32 e = 0; e < 3; e++)
+	{
+		stepX[e] = tri.edgeA[e] * SW_SUBPIXEL_STEPS;
+		stepY[e] = tri.edgeB[e] * SW_SUBPIXEL_STEPS;
+		edgeStart[e] = tri.edgeA[e] * px + tri.edgeB[e] * py + tri.edgeC[e];
+
+		// find the smallest and largest edge value inside the rect, the extremes are always at a corner
+		int64 edgeMin = edgeStart[e] + static_cast<int64>(glm::min(stepX[e], 0)) * rectWidth + static_cast<int64>(glm::min(stepY[e], 0)) * rectHeight;
+		int64 edgeMax = edgeStart[e] + static_cast<int64>(glm::max(stepX[e], 0)) * rectWidth + static_cast<int64>(glm::max(stepY[e], 0)) * rectHeight;
+
+		// the whole rect is outside this edge
+		if (edgeMax < 0)
+			return;
+
+		// edges the whole rect is inside of do not need testing per pixel, values of partially covering edges
+		// are bounded by the step sizes times the tile size and always fit in 32 bits
+		partial[e] = edgeMin < 0;
+	}
+
+	int64 edgeRow[3] = { edgeStart[0], edgeStart[1], edgeStart[2] };
+
+	for (int32 y = y0; y <= y1; y++)
+	{
+		uint32 rowIndex = y * targetWidth;
+
+#if defined(SW_USE_SSE2)
+		__m128i laneEdge[3];
+		__m128i laneStep[3];
+		__m128i testMask[3];
+
+		for (uint32 e = 0; e < 3; e++)
+		{
+			int32 rowValue = partial[e] ? static_cast<int32>(edgeRow[e]) : 0;
+
+			laneEdge[e] = _mm_add_epi32(_mm_set1_epi32(rowValue), _mm_set_epi32(3 * stepX[e], 2 * stepX[e], stepX[e], 0));
+			laneStep[e] = _mm_set1_epi32(4 * stepX[e]);
+			testMask[e] = _mm_set1_epi32(partial[e] ? 0 : -1);
+		}
+
+		const __m128i minusOne = _mm_set1_epi32(-1);
+#endif
+
+		for (int32 x = x0; x <= x1; x += 4)
+		{
+			uint32 laneCount = static_cast<uint32>(glm::min(4, x1 - x + 1));
+			uint32 coverage = (1 << laneCount) - 1;
+
+#if defined(SW_USE_SSE2)
+			// test 4 pixels against the three edges at once, edges fully covering the rect always pass
+			__m128i inside = _mm_set1_epi32(-1);
+			for (uint32 e = 0; e < 3; e++)
+			{
+				__m128i edgeInside = _mm_or_si128(_mm_cmpgt_epi32(laneEdge[e], minusOne), testMask[e]);
+				inside = _mm_and_si128(inside, edgeInside);
+				laneEdge[e] = _mm_add_epi32(laneEdge[e], laneStep[e]);
+			}
+
+			coverage &= static_cast<uint32>(_mm_movemask_ps(_mm_castsi128_ps(inside)));
+#else
+			for (uint32 lane = 0; lane < laneCount; lane++)
+			{
+				for (uint32 e = 0; e < 3; e++)
+				{
+					int64 value = edgeRow[e] + static_cast<int64>(stepX[e]) * (x - x0 + lane);
+					if (value < 0)
+					{
+						coverage &= ~(1 << lane);
+					}
+				}
+			}
+#endif
+
+			if (coverage == 0)
+				continue;
+
+			// barycentric weights for vertex 0 and 1, computed in floating point since fully covering edges may exceed 32 bits
+			float edge0 = static_cast<float>(edgeRow[0] + static_cast<int64>(stepX[0]) * (x - x0));
+			float edge1 = static_cast<float>(edgeRow[1] + static_cast<int64>(stepX[1]) * (x - x0));
+
+			for (uint32 mask = coverage; mask; mask &= mask - 1)
+			{
+				uint32 lane = Bit::LeastSignifcantBit(mask);
+
+				float b0 = (edge0 + static_cast<float>(stepX[0]) * lane) * tri.invArea;
+				float b1 = (edge1 + static_cast<float>(stepX[1]) * lane) * tri.invArea;
+
+				ShadePixel(tri, state, rowIndex + x + lane, b0, b1);
+			}
+		}
+
+		for (uint32 e = 0; e < 3; e++)
+		{
+			edgeRow[e] += stepY[e];
+		}
+	}
+}
+
+static bool CompareFunc(ComparisonFunc func, float a, float b)
+{
+	switch (func)
+	{
+		case ComparisonFunc::Never:			return false;
+		case ComparisonFunc::Less:			return a < b;
+		case ComparisonFunc::Equal:			return a == b;
+		case ComparisonFunc::LessEqual:		return a <= b;
+		case ComparisonFunc::Greater:		return a > b;
+		case ComparisonFunc::NotEqual:		return a != b;
+		case ComparisonFunc::GreaterEqual:	return a >= b;
+		default:							return true;
+	}
+}
+
+static uint8 ApplyStencilOp(StencilOp op, uint8 value, uint8 reference)
+{
+	switch (op)
+	{
+		case StencilOp::Zero:		return 0;
+		case StencilOp::Replace:	return reference;
+		case StencilOp::IncrSat:	return value == 0xFF ? value : value + 1;
+		case StencilOp::DecrSat:	return value == 0 ? value : value - 1;
+		case StencilOp::Invert:		return ~value;
+		case StencilOp::Incr:		return value + 1;
+		case StencilOp::Decr:		return value - 1;
+		default:					return value;
+	}
+}
+
+// returns the blend factor for one channel, channel 3 is alpha. written on scalars since this runs for every blended pixel
+static inline float GetBlendFactor(BlendFactor factor, const float* src, const float* dst, uint32 channel)
+{
+	switch (factor)
+	{
+		case BlendFactor::Zero:				return 0.0f;
+		case BlendFactor::One:				return 1.0f;
+		case BlendFactor::SrcColor:			return src[channel];
+		case BlendFactor::InvSrcColor:		return 1.0f - src[channel];
+		case BlendFactor::SrcAlpha:			return src[3];
+		case BlendFactor::InvSrcAlpha:		return 1.0f - src[3];
+		case BlendFactor::DestAlpha:		return dst[3];
+		case BlendFactor::InvDestAlpha:		return 1.0f - dst[3];
+		case BlendFactor::DestColor:		return dst[channel];
+		case BlendFactor::InvDestColor:		return 1.0f - dst[channel];
+		case BlendFactor::SrcAlphaSat:		return channel == 3 ? 1.0f : glm::min(src[3], 1.0f - dst[3]);
+		case BlendFactor::ConstantColor:	return 0.0f;	// the blend constant is always zero, as in DX11Device
+		default:							return 1.0f;	// InvConstantColor
+	}
+}
+
+static inline float ApplyBlendOp(BlendOperation op, float src, float dst)
+{
+	switch (op)
+	{
+		case BlendOperation::Subtract:			return src - dst;
+		case BlendOperation::ReverseSubtract:	return dst - src;
+		case BlendOperation::Min:				return glm::min(src, dst);
+		case BlendOperation::Max:				return glm::max(src, dst);
+		default:								return src + dst;
+	}
+}
+
+void SoftwareRasterizer::ShadePixel(const SoftwareTriangle &tri, const SoftwareDrawState &state, uint32 pixelIndex, float b0, float b1)
+{
+	float b2 = 1.0f - b0 - b1;
+
+	// depth and stencil tests run before shading, the built in shaders never discard or write depth
+	const DepthStencilStateDesc &ds = state.depthStencil;
+	float z = b0 * tri.z[0] + b1 * tri.z[1] + b2 * tri.z[2];
+
+	// targets without a depth or stencil buffer always pass the test
+	bool depthTest = ds.depthEnabled && depthTarget != nullptr;
+	bool depthPass = !depthTest || CompareFunc(ds.depthFunc, z, depthTarget[pixelIndex]);
+
+	if (ds.stencilEnabled && stencilTarget != nullptr)
+	{
+		const DepthStencilOp &face = tri.backFacing ? ds.backFace : ds.frontFace;
+
+		// the stencil reference value is always 0, matching the GL3 and DX11 devices
+		uint8 stencil = stencilTarget[pixelIndex];
+		bool stencilPass = CompareFunc(face.stencilFunc, 0.0f, static_cast<float>(stencil & ds.stencilRead));
+
+		StencilOp op = !stencilPass ? face.stencilfailOp : (!depthPass ? face.depthFailOp : face.stencilPassOp);
+		uint8 result = ApplyStencilOp(op, stencil, 0);
+
+		stencilTarget[pixelIndex] = (stencil & ~ds.stencilWrite) | (result & ds.stencilWrite);
+
+		if (!stencilPass)
+			return;
+	}
+
+	if (!depthPass)
+		return;
+
+	if (depthTest && ds.depthWriteEnabled)
+	{
+		depthTarget[pixelIndex] = z;
+	}
+
+	// depth only targets still run the depth and stencil tests above
+	if (colorTarget == nullptr)
+		return;
+
+	// perspective correct interpolation of the varyings
+	SoftwarePixelInput input;
+	input.textures = state.textures;
+
+	float w = 1.0f / (b0 * tri.invW[0] + b1 * tri.invW[1] + b2 * tri.invW[2]);
+	for (uint32 v = 0; v < tri.varyingCount; v++)
+	{
+		input.varyings[v] = (b0 * tri.varyings[0][v] + b1 * tri.varyings[1][v] + b2 * tri.varyings[2][v]) * w;
+	}
+
+	vec4 color = state.program->pixelShader(input);
+
+	const BlendProperties &blend = state.blend;
+	uint32 dstPacked = colorTarget[pixelIndex];
+
+	float src[4] = { color.r, color.g, color.b, color.a };
+
+	if (blend.enabled)
+	{
+		float dst[4];
+		for (uint32 c = 0; c < 4; c++)
+		{
+			dst[c] = static_cast<float>((dstPacked >> (c * 8)) & 0xFF) * (1.0f / 255.0f);
+		}
+
+		float result[4];
+		for (uint32 c = 0; c < 3; c++)
+		{
+			result[c] = ApplyBlendOp(blend.blendOp,
+									 src[c] * GetBlendFactor(blend.srcBlend, src, dst, c),
+									 dst[c] * GetBlendFactor(blend.dstBlend, src, dst, c));
+		}
+
+		result[3] = ApplyBlendOp(blend.blendOpAlpha,
+								 src[3] * GetBlendFactor(blend.srcBlendAlpha, src, dst, 3),
+								 dst[3] * GetBlendFactor(blend.dstBlendAlpha, src, dst, 3));
+
+		for (uint32 c = 0; c < 4; c++)
+		{
+			src[c] = result[c];
+		}
+	}
+
+	uint32 srcPacked = 0;
+	for (uint32 c = 0; c < 4; c++)
+	{
+		float value = src[c] < 0.0f ? 0.0f : (src[c] > 1.0f ? 1.0f : src[c]);
+		srcPacked |= static_cast<uint32>(static_cast<int32>(value * 255.0f + 0.5f)) << (c * 8);
+	}
+
+	colorTarget[pixelIndex] = (dstPacked & ~state.colorWriteMask) | (srcPacked & state.colorWriteMask);
+}
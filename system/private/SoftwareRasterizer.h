@@ -0,0 +1,150 @@
+#ifndef _SOFTWARE_RASTERIZER_H
+#define _SOFTWARE_RASTERIZER_H
+
+#include "SoftwareDefinitions.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// triangle after clipping, projection and edge function setup
+struct SoftwareTriangle
+{
+	// edge functions E(x,y) = A*x + B*y + C in fixed point pixel coordinates, edge i is opposite vertex i
+	int32 edgeA[3];
+	int32 edgeB[3];
+	int64 edgeC[3];
+
+	// pixel bounding box, inclusive, already clipped against the viewport and scissor rect
+	int32 minX, minY, maxX, maxY;
+
+	float invArea;
+
+	// values interpolated linearly in screen space, varyings are pre divided by w for perspective correction
+	float z[3];
+	float invW[3];
+	float varyings[3][SW_MAX_VARYINGS];
+	uint32 varyingCount;
+
+	uint32 stateIndex;
+	bool backFacing;
+};
+
+// SoftwareRasterizer bins triangles in to screen tiles and rasterizes the tiles in parallel across all cores
+class SoftwareRasterizer
+{
+public:
+
+	SoftwareRasterizer();
+	~SoftwareRasterizer();
+
+	// starts the worker threads, a thread count of 0 uses one thread per hardware thread
+	void Initialize(uint32 width, uint32 height, uint32 threadCount = 0);
+	void Destroy();
+
+	void Resize(uint32 width, uint32 height);
+
+	void SetViewport(int32 x, int32 y, int32 width, int32 height);
+	void SetScissorRect(const DSRect &rect);
+
+	// stores a copy of the state used by the triangles submitted after it, returns the index of the state
+	uint32 AddDrawState(const SoftwareDrawState &state);
+
+	// clips, projects and bins a triangle given in clip space
+	void SubmitTriangle(const SoftwareVertexOutput &v0, const SoftwareVertexOutput &v1, const SoftwareVertexOutput &v2,
+						uint32 varyingCount, uint32 stateIndex);
+
+	// rasterizes all binned triangles, then clears the back buffer
+	void Clear(const vec4 &color, float depth, uint8 stencil);
+
+	// rasterizes all binned triangles in submission order across the worker threads
+	void Flush();
+
+	// flushes and swaps the back buffer with the front buffer
+	void Present();
+
+	// flushes, then renders and clears in to the given buffers of width * height pixels until the back buffer is
+	// bound again by passing no buffers. A null depth or stencil buffer disables the depth or stencil test
+	void SetRenderTarget(uint32* color, float* depth, uint8* stencil, uint32 targetWidth, uint32 targetHeight);
+
+	// returns the pixels of the last presented frame, RGBA8 with red in the lowest byte, rows from top to bottom
+	const uint32* GetFrontBuffer() const { return frontBuffer.data(); }
+
+	// returns the pixels of the frame being rendered, binned triangles are only in it after a Flush
+	const uint32* GetBackBuffer() const { return backBuffer.data(); }
+
+	uint32 GetWidth() const { return width; }
+	uint32 GetHeight() const { return height; }
+	uint32 GetThreadCount() const { return static_cast<uint32>(workers.size()) + 1; }
+
+private:
+
+	enum class JobType
+	{
+		Rasterize,
+		Clear
+	};
+
+	void SetupTriangle(const SoftwareVertexOutput* vertices[3], uint32 varyingCount, uint32 stateIndex);
+
+	void RunJob(JobType type);
+	void WorkerLoop(uint32 lastGeneration);
+	void ProcessTiles();
+
+	void RasterizeTile(uint32 tileIndex);
+	void ClearTile(uint32 tileIndex);
+	void RasterizeTriangle(const SoftwareTriangle &tri, int32 x0, int32 y0, int32 x1, int32 y1);
+	void ShadePixel(const SoftwareTriangle &tri, const SoftwareDrawState &state, uint32 pixelIndex, float b0, float b1);
+
+	// points the targets at the back buffer and sizes the tile grid for it
+	void BindBackBuffer();
+	void SetTileGrid(uint32 gridWidth, uint32 gridHeight);
+
+	// back buffer
+	uint32 width = 0;
+	uint32 height = 0;
+	std::vector<uint32> backBuffer;
+	std::vector<uint32> frontBuffer;
+	std::vector<float> depthBuffer;
+	std::vector<uint8> stencilBuffer;
+
+	// buffers triangles are rasterized in to, either the back buffer or an offscreen target
+	uint32* colorTarget = nullptr;
+	float* depthTarget = nullptr;
+	uint8* stencilTarget = nullptr;
+	uint32 targetWidth = 0;
+	uint32 targetHeight = 0;
+	bool backBufferBound = true;
+
+	// tiles
+	uint32 tilesX = 0;
+	uint32 tilesY = 0;
+	std::vector<std::vector<uint32>> tileBins;
+
+	// frame data, the vectors keep their capacity between frames
+	std::vector<SoftwareTriangle> triangles;
+	std::vector<SoftwareDrawState> drawStates;
+
+	// viewport and scissor used when setting up triangles
+	int32 viewportX = 0, viewportY = 0, viewportWidth = 0, viewportHeight = 0;
+	DSRect scissorRect;
+
+	// clear values
+	uint32 clearColor = 0;
+	float clearDepth = 1.0f;
+	uint8 clearStencil = 0;
+
+	// worker threads
+	std::vector<std::thread> workers;
+	std::mutex jobMutex;
+	std::condition_variable jobCondition;
+	std::condition_variable doneCondition;
+	JobType curJob = JobType::Rasterize;
+	uint32 jobGeneration = 0;
+	uint32 activeWorkers = 0;
+	std::atomic<uint32> nextTile;
+	bool quit = false;
+};
+
+#endif // _SOFTWARE_RASTERIZER_H
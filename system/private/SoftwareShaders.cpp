@@ -0,0 +1,204 @@
+#include "SoftwareShaders.h"
+
+// byte offsets of the members of the perFrameUniforms block bound at slot 0
+#define SW_UNIFORM_VIEW_PROJECTION 0
+#define SW_UNIFORM_UI_ORTHO_PROJECTION 64
+
+// varying layout shared by the textured shaders
+#define SW_VARYING_TEXCOORD 0
+#define SW_VARYING_COLOR 2
+
+static mat4 ReadUniformMatrix(const SoftwareUniforms &uniforms, uint32 slot, uint32 offset)
+{
+	mat4 matrix(1.0f);
+
+	if (uniforms.slots[slot] != nullptr)
+	{
+		memcpy(&matrix, uniforms.slots[slot] + offset, sizeof(mat4));
+	}
+
+	return matrix;
+}
+
+static void WriteVaryings(SoftwareVertexOutput &output, uint32 offset, const vec2 &value)
+{
+	output.varyings[offset] = value.x;
+	output.varyings[offset + 1] = value.y;
+}
+
+static void WriteVaryings(SoftwareVertexOutput &output, uint32 offset, const vec4 &value)
+{
+	output.varyings[offset] = value.x;
+	output.varyings[offset + 1] = value.y;
+	output.varyings[offset + 2] = value.z;
+	output.varyings[offset + 3] = value.w;
+}
+
+static vec2 ReadVec2(const SoftwarePixelInput &input, uint32 offset)
+{
+	return vec2(input.varyings[offset], input.varyings[offset + 1]);
+}
+
+static vec4 ReadVec4(const SoftwarePixelInput &input, uint32 offset)
+{
+	return vec4(input.varyings[offset], input.varyings[offset + 1], input.varyings[offset + 2], input.varyings[offset + 3]);
+}
+
+// ==============================================
+// TestShader
+// ==============================================
+
+static void TestShaderVS(const SoftwareVertexInput &input, const SoftwareUniforms &uniforms, SoftwareVertexOutput &output)
+{
+	mat4 viewProjection = ReadUniformMatrix(uniforms, 0, SW_UNIFORM_VIEW_PROJECTION);
+
+	output.position = viewProjection * vec4(input.position, 1.0f);
+	WriteVaryings(output, SW_VARYING_TEXCOORD, input.texCoord);
+	WriteVaryings(output, SW_VARYING_COLOR, input.color);
+}
+
+static vec4 TestShaderPS(const SoftwarePixelInput &input)
+{
+	return SampleTexture(input.textures[0], ReadVec2(input, SW_VARYING_TEXCOORD)) * ReadVec4(input, SW_VARYING_COLOR);
+}
+
+// ==============================================
+// InstancedShader
+// ==============================================
+
+static void InstancedShaderVS(const SoftwareVertexInput &input, const SoftwareUniforms &uniforms, SoftwareVertexOutput &output)
+{
+	mat4 viewProjection = ReadUniformMatrix(uniforms, 0, SW_UNIFORM_VIEW_PROJECTION);
+
+	output.position = viewProjection * input.instanceWorld * vec4(input.position, 1.0f);
+	WriteVaryings(output, SW_VARYING_TEXCOORD, input.texCoord);
+	WriteVaryings(output, SW_VARYING_COLOR, input.color * input.instanceColor);
+}
+
+// ==============================================
+// MaterialShader
+// ==============================================
+
+#define SW_VARYING_MATERIAL_LAYER 6
+
+static void MaterialShaderVS(const SoftwareVertexInput &input, const SoftwareUniforms &uniforms, SoftwareVertexOutput &output)
+{
+	InstancedShaderVS(input, uniforms, output);
+	output.varyings[SW_VARYING_MATERIAL_LAYER] = input.instanceMaterial;
+}
+
+static vec4 MaterialShaderPS(const SoftwarePixelInput &input)
+{
+	// the layer is the same at every vertex, interpolating it leaves it unchanged
+	float layer = input.varyings[SW_VARYING_MATERIAL_LAYER];
+
+	return SampleTexture(input.textures[0], ReadVec2(input, SW_VARYING_TEXCOORD), layer) * ReadVec4(input, SW_VARYING_COLOR);
+}
+
+// ==============================================
+// UIShader
+// ==============================================
+
+static void UIShaderVS(const SoftwareVertexInput &input, const SoftwareUniforms &uniforms, SoftwareVertexOutput &output)
+{
+	mat4 uiOrthoProjection = ReadUniformMatrix(uniforms, 0, SW_UNIFORM_UI_ORTHO_PROJECTION);
+
+	output.position = uiOrthoProjection * vec4(input.uiPosition, 0.0f, 1.0f);
+	WriteVaryings(output, SW_VARYING_TEXCOORD, input.texCoord);
+	WriteVaryings(output, SW_VARYING_COLOR, input.color);
+}
+
+static vec4 UIShaderPS(const SoftwarePixelInput &input)
+{
+	return SampleTexture(input.textures[0], ReadVec2(input, SW_VARYING_TEXCOORD)) * ReadVec4(input, SW_VARYING_COLOR);
+}
+
+// ==============================================
+// ColorShader
+// ==============================================
+
+static void ColorShaderVS(const SoftwareVertexInput &input, const SoftwareUniforms &uniforms, SoftwareVertexOutput &output)
+{
+	output.position = vec4(input.position, 1.0f);
+	WriteVaryings(output, 0, input.color);
+}
+
+static vec4 ColorShaderPS(const SoftwarePixelInput &input)
+{
+	return ReadVec4(input, 0);
+}
+
+// ==============================================
+
+static const SoftwareShaderProgram softwareShaderPrograms[] =
+{
+	{ "TestShader",			&TestShaderVS,		&TestShaderPS,	6 },
+	{ "InstancedShader",	&InstancedShaderVS,	&TestShaderPS,	6 },
+	{ "MaterialShader",		&MaterialShaderVS,	&MaterialShaderPS,	7 },
+	{ "UIShader",			&UIShaderVS,		&UIShaderPS,	6 },
+	{ "ColorShader",		&ColorShaderVS,		&ColorShaderPS,	4 }
+};
+
+const SoftwareShaderProgram* FindSoftwareShaderProgram(const std::string &name)
+{
+	for (const SoftwareShaderProgram &program : softwareShaderPrograms)
+	{
+		if (name == program.name)
+		{
+			return &program;
+		}
+	}
+
+	return nullptr;
+}
+
+static uint32 WrapCoordinate(int32 coord, uint32 size, TextureWrapMode wrapMode)
+{
+	if (wrapMode == TextureWrapMode::Clamp)
+	{
+		return static_cast<uint32>(glm::clamp(coord, 0, static_cast<int32>(size) - 1));
+	}
+
+	int32 wrapped = coord % static_cast<int32>(size);
+	return static_cast<uint32>(wrapped < 0 ? wrapped + static_cast<int32>(size) : wrapped);
+}
+
+vec4 SampleTexture(const TextureSoftware* texture, const vec2 &texCoord, float layer)
+{
+	if (texture == nullptr || texture->texels.empty())
+	{
+		return vec4(1.0f);
+	}
+
+	int32 layerIndex = glm::clamp(static_cast<int32>(floor(layer + 0.5f)), 0, static_cast<int32>(texture->arraySize) - 1);
+	const uint32* texels = texture->texels.data() + layerIndex * texture->width * texture->height;
+
+	// mip maps are not generated by the software device, bilinear and trilinear both filter the top level
+	float u = texCoord.x * static_cast<float>(texture->width) - 0.5f;
+	float v = texCoord.y * static_cast<float>(texture->height) - 0.5f;
+
+	if (texture->filterMode == TextureFilterMode::Point)
+	{
+		uint32 x = WrapCoordinate(static_cast<int32>(floor(u + 0.5f)), texture->width, texture->wrapMode);
+		uint32 y = WrapCoordinate(static_cast<int32>(floor(v + 0.5f)), texture->height, texture->wrapMode);
+
+		return UnpackColorRGBA8(texels[y * texture->width + x]);
+	}
+
+	float fu = floor(u);
+	float fv = floor(v);
+	float tx = u - fu;
+	float ty = v - fv;
+
+	uint32 x0 = WrapCoordinate(static_cast<int32>(fu), texture->width, texture->wrapMode);
+	uint32 x1 = WrapCoordinate(static_cast<int32>(fu) + 1, texture->width, texture->wrapMode);
+	uint32 y0 = WrapCoordinate(static_cast<int32>(fv), texture->height, texture->wrapMode);
+	uint32 y1 = WrapCoordinate(static_cast<int32>(fv) + 1, texture->height, texture->wrapMode);
+
+	vec4 c00 = UnpackColorRGBA8(texels[y0 * texture->width + x0]);
+	vec4 c10 = UnpackColorRGBA8(texels[y0 * texture->width + x1]);
+	vec4 c01 = UnpackColorRGBA8(texels[y1 * texture->width + x0]);
+	vec4 c11 = UnpackColorRGBA8(texels[y1 * texture->width + x1]);
+
+	return glm::mix(glm::mix(c00, c10, tx), glm::mix(c01, c11, tx), ty);
+}
@@ -0,0 +1,13 @@
+#ifndef _SOFTWARE_SHADERS_H
+#define _SOFTWARE_SHADERS_H
+
+#include "SoftwareDefinitions.h"
+
+// returns the native replica of the shader program with the given name, or nullptr if none exists
+const SoftwareShaderProgram* FindSoftwareShaderProgram(const std::string &name);
+
+// samples a texture using its wrap and filter modes, returns white if no texture is bound. The layer of a texture
+// array is rounded to the nearest layer and clamped as it is on the GPU
+vec4 SampleTexture(const TextureSoftware* texture, const vec2 &texCoord, float layer = 0.0f);
+
+#endif // _SOFTWARE_SHADERS_H
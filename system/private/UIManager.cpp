@@ -3,9 +3,9 @@
 #include "DemoSystem.h"
 #include "IGraphicsDevice.h"
 
-#include <imgui\imgui.h>
-#include <glm\gtc\matrix_transform.hpp>
-#include <glm\gtx\matrix_major_storage.hpp>
+#include <imgui/imgui.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/matrix_major_storage.hpp>
 
 BaseUIValues UIManager::lastUIValues;
 BaseUIValues UIManager::curUIValues;
@@ -174,7 +174,7 @@ void UIManager::DrawUI()
 		if (ImGui::CollapsingHeader("Graphics", nullptr, true, true))
 		{
 			StartRow("Graphics API", labelWidth, inputWidth);
-			ImGui::Combo("##GraphicsAPI", &curUIValues.graphicsAPIItemIndex, "DirectX 11\0OpenGL 3\0\0");
+			ImGui::Combo("##GraphicsAPI", &curUIValues.graphicsAPIItemIndex, "DirectX 11\0OpenGL 3\0Null\0Software\0\0");
 			EndRow();
 
 			StartRow("FOV", labelWidth, inputWidth);
@@ -269,13 +269,20 @@ void UIManager::EndFrame()
 		// Set a new graphics API if it changed in the UI
 		if (lastUIValues.graphicsAPIItemIndex != curUIValues.graphicsAPIItemIndex)
 		{
-			if (curUIValues.graphicsAPIItemIndex == 0)
+			switch (curUIValues.graphicsAPIItemIndex)
 			{
-				demoSystem->SetGraphicsAPI(GraphicsAPIOptions::DirectX11);
-			}
-			else
-			{
-				demoSystem->SetGraphicsAPI(GraphicsAPIOptions::OpenGL3);
+				case 0:
+					demoSystem->SetGraphicsAPI(GraphicsAPIOptions::DirectX11);
+				break;
+				case 1:
+					demoSystem->SetGraphicsAPI(GraphicsAPIOptions::OpenGL3);
+				break;
+				case 2:
+					demoSystem->SetGraphicsAPI(GraphicsAPIOptions::Null);
+				break;
+				case 3:
+					demoSystem->SetGraphicsAPI(GraphicsAPIOptions::Software);
+				break;
 			}
 		}
 
@@ -301,6 +308,7 @@ void UIManager::ImGuiDraw(ImDrawData* drawData)
 
 	uiMeshDataList.vertexCount = 0;
 	uiMeshDataList.indexCount = 0;
+	uiMeshDataList.indexFormat = sizeof(ImDrawIdx) == sizeof(uint32) ? IndexFormat::UInt32 : IndexFormat::UInt16;
 	for (int n = 0; n < drawData->CmdListsCount; n++)
 	{
 		const ImDrawList* cmd_list = drawData->CmdLists[n];
@@ -308,7 +316,7 @@ void UIManager::ImGuiDraw(ImDrawData* drawData)
 		uiMeshDataList.SetVertices(n, &cmd_list->VtxBuffer[0], cmd_list->VtxBuffer.size() * sizeof(ImDrawVert));
 		uiMeshDataList.vertexCount += cmd_list->VtxBuffer.size();
 
-		uiMeshDataList.SetIndices(n, &cmd_list->IdxBuffer[0], cmd_list->IdxBuffer.size() * sizeof(uint16));
+		uiMeshDataList.SetIndices(n, &cmd_list->IdxBuffer[0], cmd_list->IdxBuffer.size() * sizeof(ImDrawIdx));
 		uiMeshDataList.indexCount += cmd_list->IdxBuffer.size();
 	}
 
@@ -0,0 +1,120 @@
+#include "UniformAllocator.h"
+#include "IGraphicsDevice.h"
+
+UniformAllocator::UniformAllocator()
+{
+	alignment = 256;
+	usedBytes = 0;
+	flushedBytes = 0;
+	bufferIndex = 0;
+}
+
+bool UniformAllocator::Create(IGraphicsDevice* device, uint32 capacityBytes)
+{
+	DS_ASSERT(buffers.empty()); // allocator must be released before it is created again
+
+	alignment = device->GetUniformBufferAlignment();
+
+	// the capacity is rounded up so the last slice never runs past the end of the buffer
+	capacityBytes = (capacityBytes + alignment - 1) / alignment * alignment;
+
+	frameData.resize(capacityBytes);
+
+	if (!CreateNextBuffer(device))
+	{
+		frameData.clear();
+		return false;
+	}
+
+	Reset();
+
+	return true;
+}
+
+void UniformAllocator::Release(IGraphicsDevice* device)
+{
+	for (Buffer* buffer : buffers)
+	{
+		device->ReleaseBuffer(buffer);
+	}
+
+	buffers.clear();
+
+	frameData.clear();
+	Reset();
+}
+
+void UniformAllocator::Reset()
+{
+	usedBytes = 0;
+	flushedBytes = 0;
+	bufferIndex = 0;
+}
+
+void* UniformAllocator::Allocate(uint32 size, UniformSlice &slice)
+{
+	uint32 alignedSize = (size + alignment - 1) / alignment * alignment;
+
+	if (bufferIndex >= buffers.size() || usedBytes + alignedSize > frameData.size())
+	{
+		slice = UniformSlice();
+		return nullptr;
+	}
+
+	// offsets are from the start of the data uploaded by the next flush
+	slice.buffer = buffers[bufferIndex];
+	slice.offset = usedBytes - flushedBytes;
+	slice.size = size;
+
+	void* data = &frameData[usedBytes];
+	usedBytes += alignedSize;
+
+	return data;
+}
+
+UniformSlice UniformAllocator::Push(const void* data, uint32 size)
+{
+	UniformSlice slice;
+	void* dest = Allocate(size, slice);
+
+	if (dest)
+	{
+		memcpy(dest, data, size);
+	}
+
+	return slice;
+}
+
+void UniformAllocator::Flush(IGraphicsDevice* device)
+{
+	if (bufferIndex >= buffers.size() || usedBytes == flushedBytes)
+		return;
+
+	device->UpdateBuffer(buffers[bufferIndex], &frameData[flushedBytes], usedBytes - flushedBytes);
+	flushedBytes = usedBytes;
+
+	// slices allocated after this go in to the next buffer, writing them to this one would move the slices
+	// that are already bound. allocations fail for the rest of the frame if it can't be created
+	bufferIndex++;
+
+	if (bufferIndex == buffers.size())
+	{
+		CreateNextBuffer(device);
+	}
+}
+
+bool UniformAllocator::CreateNextBuffer(IGraphicsDevice* device)
+{
+	uint32 capacityBytes = static_cast<uint32>(frameData.size());
+	Buffer* buffer = device->CreateBuffer(nullptr, capacityBytes, BufferTarget::Uniform, BufferUsage::Stream);
+
+	if (buffer == nullptr)
+	{
+		LOG_ERROR("Failed creating uniform allocator buffer of %u bytes", capacityBytes);
+		return false;
+	}
+
+	buffers.push_back(buffer);
+
+	return true;
+}
@@ -0,0 +1,253 @@
+#include "VertexQuantization.h"
+
+#include <glm/gtc/packing.hpp>
+
+// full precision attribute each attribute is a variant of
+static const uint32 attributeKinds[DS_VERTEX_ATTRIBUTE_COUNT] =
+{
+	ATTR_POSITION,			// ATTR_POSITION
+	ATTR_POSITION,			// ATTR_POSITION_HALF
+	ATTR_UI_POSITION,		// ATTR_UI_POSITION
+	ATTR_TEXCOORD,			// ATTR_TEXCOORD
+	ATTR_TEXCOORD,			// ATTR_TEXCOORD_HALF
+	ATTR_TEXCOORD,			// ATTR_TEXCOORD_UNORM16
+	ATTR_COLOR32,			// ATTR_COLOR32
+	ATTR_NORMAL,			// ATTR_NORMAL
+	ATTR_NORMAL,			// ATTR_NORMAL_SNORM16
+	ATTR_NORMAL,			// ATTR_NORMAL_PACKED
+	ATTR_INSTANCE_WORLD,	// ATTR_INSTANCE_WORLD
+	ATTR_INSTANCE_COLOR32,	// ATTR_INSTANCE_COLOR32
+	ATTR_INSTANCE_MATERIAL	// ATTR_INSTANCE_MATERIAL
+};
+
+// ==============================================
+// Helpers
+// ==============================================
+
+static float ReadComponent(BaseType type, bool normalized, const uint8* src)
+{
+	switch (type)
+	{
+		case BaseType::Int8:	{ int8 v; memcpy(&v, src, 1); return normalized ? glm::max(v / 127.0f, -1.0f) : v; }
+		case BaseType::UInt8:	{ uint8 v; memcpy(&v, src, 1); return normalized ? v / 255.0f : v; }
+		case BaseType::Int16:	{ int16 v; memcpy(&v, src, 2); return normalized ? glm::max(v / 32767.0f, -1.0f) : v; }
+		case BaseType::UInt16:	{ uint16 v; memcpy(&v, src, 2); return normalized ? v / 65535.0f : v; }
+		case BaseType::Int32:	{ int32 v; memcpy(&v, src, 4); return normalized ? static_cast<float>(glm::max(v / 2147483647.0, -1.0)) : v; }
+		case BaseType::UInt32:	{ uint32 v; memcpy(&v, src, 4); return normalized ? static_cast<float>(v / 4294967295.0) : v; }
+		case BaseType::Float:	{ float v; memcpy(&v, src, 4); return v; }
+		case BaseType::Double:	{ double v; memcpy(&v, src, 8); return static_cast<float>(v); }
+		case BaseType::HalfFloat: { uint16 v; memcpy(&v, src, 2); return glm::unpackHalf1x16(v); }
+		default: break;
+	}
+
+	DS_ASSERT(false); // packed types are read whole
+	return 0.0f;
+}
+
+static void WriteComponent(BaseType type, bool normalized, float value, uint8* dst)
+{
+	switch (type)
+	{
+		case BaseType::Int8:	{ int8 v = normalized ? static_cast<int8>(glm::packSnorm1x8(value)) : static_cast<int8>(value); memcpy(dst, &v, 1); return; }
+		case BaseType::UInt8:	{ uint8 v = normalized ? glm::packUnorm1x8(value) : static_cast<uint8>(value); memcpy(dst, &v, 1); return; }
+		case BaseType::Int16:	{ int16 v = normalized ? static_cast<int16>(glm::packSnorm1x16(value)) : static_cast<int16>(value); memcpy(dst, &v, 2); return; }
+		case BaseType::UInt16:	{ uint16 v = normalized ? glm::packUnorm1x16(value) : static_cast<uint16>(value); memcpy(dst, &v, 2); return; }
+		case BaseType::Int32:	{ int32 v = normalized ? static_cast<int32>(glm::round(glm::clamp(static_cast<double>(value), -1.0, 1.0) * 2147483647.0)) : static_cast<int32>(value); memcpy(dst, &v, 4); return; }
+		case BaseType::UInt32:	{ uint32 v = normalized ? static_cast<uint32>(glm::round(glm::clamp(static_cast<double>(value), 0.0, 1.0) * 4294967295.0)) : static_cast<uint32>(value); memcpy(dst, &v, 4); return; }
+		case BaseType::Float:	{ memcpy(dst, &value, 4); return; }
+		case BaseType::Double:	{ double v = value; memcpy(dst, &v, 8); return; }
+		case BaseType::HalfFloat: { uint16 v = glm::packHalf1x16(value); memcpy(dst, &v, 2); return; }
+		default: break;
+	}
+
+	DS_ASSERT(false); // packed types are written whole
+}
+
+// ==============================================
+// Vertex Quantization
+// ==============================================
+
+VertexAttributes GetCompactVertexAttributes(VertexAttributes attributeFlags, bool unitTexCoords)
+{
+	VertexAttributes compact = attributeFlags;
+
+	if (CheckFlags(compact, VertexAttributes::Position))
+	{
+		compact = (compact & ~VertexAttributes::Position) | VertexAttributes::PositionHalf;
+	}
+
+	if (CheckFlags(compact, VertexAttributes::TexCoord))
+	{
+		compact = (compact & ~VertexAttributes::TexCoord) | (unitTexCoords ? VertexAttributes::TexCoordUNorm16 : VertexAttributes::TexCoordHalf);
+	}
+
+	if (CheckFlags(compact, VertexAttributes::Normal))
+	{
+		compact = (compact & ~VertexAttributes::Normal) | VertexAttributes::NormalPacked;
+	}
+
+	return compact;
+}
+
+uint32 GetAttributeKind(uint32 attributeIndex)
+{
+	DS_ASSERT(attributeIndex < DS_VERTEX_ATTRIBUTE_COUNT); // index must be a VertexAttributes bit
+
+	return attributeKinds[attributeIndex];
+}
+
+vec4 ReadVertexAttribute(uint32 attributeIndex, const uint8* src)
+{
+	const AttributeProperties &properties = attributeProperties[attributeIndex];
+
+	DS_ASSERT(properties.components <= 4); // matrices are read a column at a time by the devices
+
+	vec4 value(0.0f, 0.0f, 0.0f, 1.0f);
+
+	if (properties.type == BaseType::UInt10_10_10_2)
+	{
+		uint32 packed;
+		memcpy(&packed, src, sizeof(uint32));
+
+		value = properties.normalized ? glm::unpackUnorm3x10_1x2(packed) : vec4(glm::unpackU3x10_1x2(packed));
+	}
+	else
+	{
+		for (uint32 c = 0; c < properties.components; c++)
+		{
+			value[c] = ReadComponent(properties.type, properties.normalized, src + c * properties.typeSizeBytes);
+		}
+	}
+
+	// normals are stored biased in to [0, 1] as no API has a signed 10:10:10:2 vertex format in common
+	if (attributeIndex == ATTR_NORMAL_PACKED)
+	{
+		value = vec4(vec3(value) * 2.0f - 1.0f, 0.0f);
+	}
+
+	return value;
+}
+
+void WriteVertexAttribute(uint32 attributeIndex, const vec4 &value, uint8* dst)
+{
+	const AttributeProperties &properties = attributeProperties[attributeIndex];
+
+	DS_ASSERT(properties.components <= 4); // matrices are written a column at a time
+
+	vec4 stored = value;
+
+	// the padding component of compact positions and normals is fixed so shaders can read them as vec4
+	if (attributeIndex == ATTR_POSITION_HALF)
+	{
+		stored.w = 1.0f;
+	}
+	else if (attributeIndex == ATTR_NORMAL_SNORM16)
+	{
+		stored.w = 0.0f;
+	}
+	else if (attributeIndex == ATTR_NORMAL_PACKED)
+	{
+		stored = vec4(vec3(value) * 0.5f + 0.5f, 0.0f);
+	}
+
+	if (properties.type == BaseType::UInt10_10_10_2)
+	{
+		uint32 packed = properties.normalized ? glm::packUnorm3x10_1x2(stored) : glm::packU3x10_1x2(glm::uvec4(stored));
+		memcpy(dst, &packed, sizeof(uint32));
+		return;
+	}
+
+	for (uint32 c = 0; c < properties.components; c++)
+	{
+		WriteComponent(properties.type, properties.normalized, stored[c], dst + c * properties.typeSizeBytes);
+	}
+}
+
+bool QuantizeVertices(const void* src, VertexAttributes srcFlags, void* dst, VertexAttributes dstFlags, uint32 vertexCount)
+{
+	// byte offset in the source vertex of the attribute of each kind, -1 if the source has none
+	int32 srcOffsets[DS_VERTEX_ATTRIBUTE_COUNT];
+	int32 srcIndices[DS_VERTEX_ATTRIBUTE_COUNT];
+
+	for (uint32 a = 0; a < DS_VERTEX_ATTRIBUTE_COUNT; a++)
+	{
+		srcOffsets[a] = -1;
+		srcIndices[a] = -1;
+	}
+
+	int32 offset = 0;
+	for (uint32 mask = ToIntegral(srcFlags); mask; mask &= mask - 1)
+	{
+		uint32 index = Bit::LeastSignifcantBit(mask);
+
+		srcOffsets[attributeKinds[index]] = offset;
+		srcIndices[attributeKinds[index]] = index;
+		offset += attributeProperties[index].sizeBytes;
+	}
+
+	for (uint32 mask = ToIntegral(dstFlags); mask; mask &= mask - 1)
+	{
+		uint32 index = Bit::LeastSignifcantBit(mask);
+
+		if (srcIndices[attributeKinds[index]] < 0)
+		{
+			LOG_ERROR("Unable to quantize vertices, the source has no attribute for attribute %u", index);
+			return false;
+		}
+	}
+
+	uint32 srcStride = GetAttributeMaskSize(srcFlags);
+	uint32 dstStride = GetAttributeMaskSize(dstFlags);
+
+	const uint8* srcVertex = static_cast<const uint8*>(src);
+	uint8* dstVertex = static_cast<uint8*>(dst);
+
+	for (uint32 v = 0; v < vertexCount; v++)
+	{
+		uint32 dstOffset = 0;
+
+		for (uint32 mask = ToIntegral(dstFlags); mask; mask &= mask - 1)
+		{
+			uint32 index = Bit::LeastSignifcantBit(mask);
+			uint32 kind = attributeKinds[index];
+			const AttributeProperties &properties = attributeProperties[index];
+
+			const uint8* srcAttribute = srcVertex + srcOffsets[kind];
+			uint8* dstAttribute = dstVertex + dstOffset;
+
+			// attributes that are already in the right format are copied, which also covers the wide instance matrix
+			if (srcIndices[kind] == static_cast<int32>(index))
+			{
+				memcpy(dstAttribute, srcAttribute, properties.sizeBytes);
+			}
+			else
+			{
+				WriteVertexAttribute(index, ReadVertexAttribute(srcIndices[kind], srcAttribute), dstAttribute);
+			}
+
+			dstOffset += properties.sizeBytes;
+		}
+
+		srcVertex += srcStride;
+		dstVertex += dstStride;
+	}
+
+	return true;
+}
+
+MeshData QuantizeMeshData(const MeshData &meshData, VertexAttributes srcFlags, VertexAttributes dstFlags, std::vector<uint8> &storage)
+{
+	MeshData quantized = meshData;
+
+	storage.resize(GetAttributeMaskSize(dstFlags) * meshData.vertexCount);
+
+	if (!QuantizeVertices(meshData.vertexData, srcFlags, storage.data(), dstFlags, meshData.vertexCount))
+	{
+		quantized.vertexData = nullptr;
+		return quantized;
+	}
+
+	quantized.vertexData = storage.data();
+
+	return quantized;
+}
@@ -0,0 +1,58 @@
+#ifndef _BUFFER_UPDATE_BATCH_H
+#define _BUFFER_UPDATE_BATCH_H
+
+#include "GraphicsDefinitions.h"
+
+class IGraphicsDevice;
+
+// BufferUpdateBatch collects region writes to buffers and uploads them together. Writes to the same buffer that
+// overlap or touch are merged in to one contiguous upload when the batch is submitted, later writes replace the
+// bytes of earlier ones, so many small writes per frame cost one UpdateBufferRegion per changed range rather than
+// one per write or a full buffer upload. Memory is kept between frames
+class BufferUpdateBatch
+{
+public:
+
+	BufferUpdateBatch(uint32 initialSizeBytes = 4096);
+
+	// removes all writes, the memory is kept for the next frame
+	void Reset();
+
+	// data is copied in to the batch, the source can be freed straight after
+	void Write(Buffer* buffer, const void* data, uint32 offset, uint32 size);
+
+	// merges the writes and issues one UpdateBufferRegion for each contiguous range to the device
+	void Submit(IGraphicsDevice* device);
+
+	uint32 GetWriteCount() const { return static_cast<uint32>(writes.size()); }
+
+	// number of uploads issued by the last Submit
+	uint32 GetUploadCount() const { return uploadCount; }
+
+	bool IsEmpty() const { return writes.empty(); }
+
+private:
+
+	struct BufferWrite
+	{
+		Buffer* buffer;
+		uint32 offset;
+		uint32 size;
+
+		// position of the data in writeData
+		uint32 dataOffset;
+
+		// order the write was made in, overlapping writes are applied in this order
+		uint32 sequence;
+	};
+
+	std::vector<BufferWrite> writes;
+	std::vector<uint8> writeData;
+
+	// a merged range is assembled here before it is uploaded
+	std::vector<uint8> mergeData;
+
+	uint32 uploadCount;
+};
+
+#endif // _BUFFER_UPDATE_BATCH_H
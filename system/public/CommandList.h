@@ -0,0 +1,96 @@
+#ifndef _COMMAND_LIST_H
+#define _COMMAND_LIST_H
+
+#include "GraphicsDefinitions.h"
+
+class IGraphicsDevice;
+
+// identifies the command encoded after each CommandHeader
+enum class CommandType : uint32
+{
+	SetShader,
+	SetTexture,
+	SetUniformBuffer,
+	SetUniformBufferRange,
+	SetBlendState,
+	SetDepthStencilState,
+	SetRasterizerState,
+	SetScissorRects,
+	SetViewport,
+	UpdateBuffer,
+	UpdateBufferRegion,
+	DrawMesh,
+	DrawMeshIndexed,
+	DrawMeshIndexedInstanced
+};
+
+// every command starts with a header, size includes the header and any data appended to the command
+struct CommandHeader
+{
+	CommandType type;
+	uint32 size;
+};
+
+// CommandList records graphics device calls in to a compact byte stream without touching the graphics API,
+// allowing lists to be recorded on any thread and executed later in order by IGraphicsDevice::ExecuteCommandLists
+// a list must only be recorded by one thread at a time, resources referenced must stay alive until it is executed
+class CommandList
+{
+public:
+
+	CommandList(uint32 initialSizeBytes = 4096);
+
+	// clears all recorded commands, the memory is kept for the next recording
+	void Reset();
+
+	void SetShader(Shader* shader);
+
+	void SetTexture(Texture* texture, uint32 slot);
+
+	void SetUniformBuffer(uint32 slot, Buffer* buffer, ShaderStage stage);
+
+	// offset must be a multiple of IGraphicsDevice::GetUniformBufferAlignment, e.g. a slice from a UniformAllocator
+	void SetUniformBufferRange(uint32 slot, Buffer* buffer, uint32 offset, uint32 size, ShaderStage stage);
+
+	void SetBlendState(BlendState* state);
+
+	void SetDepthStencilState(DepthStencilState* state);
+
+	void SetRasterizerState(RasterizerState* state);
+
+	void SetScissorRects(uint32 numRects, const DSRect* pRects);
+
+	void SetViewport(int32 x, int32 y, int32 width, int32 height);
+
+	// data is copied in to the list when recorded, the source can be freed straight after
+	void UpdateBuffer(Buffer* buffer, const void* data, uint32 size);
+
+	void UpdateBufferRegion(Buffer* buffer, const void* data, uint32 offset, uint32 size);
+
+	void DrawMesh(Mesh* mesh);
+
+	void DrawMeshIndexed(Mesh* mesh, uint32 elementCount = 0, uint32 vertexOffset = 0, uint32 indexOffset = 0);
+
+	void DrawMeshIndexedInstanced(Mesh* mesh, Buffer* instanceBuffer, VertexAttributes instanceAttributeFlags, uint32 instanceCount,
+								  uint32 firstInstance = 0, uint32 elementCount = 0, uint32 vertexOffset = 0, uint32 indexOffset = 0);
+
+	// decodes the recorded commands and issues them to the device
+	void Execute(IGraphicsDevice* device) const;
+
+	uint32 GetCommandCount() const { return commandCount; }
+	uint32 GetSizeBytes() const { return usedBytes; }
+
+	bool IsEmpty() const { return commandCount == 0; }
+
+private:
+
+	// appends a command of the given payload size plus extra bytes and returns a pointer to the payload
+	uint8* AllocateCommand(CommandType type, uint32 payloadSize, uint32 extraSize = 0);
+
+	// the vector only grows, usedBytes marks the end of the recorded commands
+	std::vector<uint8> data;
+	uint32 usedBytes;
+	uint32 commandCount;
+};
+
+#endif // _COMMAND_LIST_H
@@ -2,6 +2,7 @@
 #define _DEMO_H
 
 #include "DemoCommon.h"
+#include "RenderGraph.h"
 
 class DemoSystem;
 class IGraphicsDevice;
@@ -24,6 +25,13 @@ public:
 	// TODO : Render
 	virtual void Draw(IGraphicsDevice* gDevice) = 0;
 
+	// called each frame to declare the passes rendering the frame, by default a single pass calls Draw on the back buffer.
+	// demos with offscreen passes override this, passes that do not lead to the back buffer are culled
+	virtual void BuildRenderGraph(RenderGraph &graph, RenderGraphResource backBuffer)
+	{
+		graph.AddPass("Draw", [this](IGraphicsDevice* gDevice, const RenderGraph &) { Draw(gDevice); }).Write(backBuffer);
+	}
+
 	// cleanup graphics resources when a rendering api is swapped or the program is exiting
 	// TODO : ReleaseResources
 	virtual void ReleaseGraphics(IGraphicsDevice* gDevice) = 0;
@@ -1,9 +1,14 @@
 #ifndef _DEMO_DEFINITIONS_H
 #define _DEMO_DEFINITIONS_H
 
+#if defined(_WIN32)
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
+#endif
 
+#include <cassert>
+#include <cstdio>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -5,11 +5,18 @@
 
 #include <SDL.h>
 #include <SDL_syswm.h>
-#include <imgui\imgui.h>
+#include <imgui/imgui.h>
 
 #include "DemoCommon.h"
 #include "Input.h"
 #include "IGraphicsDevice.h"
+#include "RenderQueue.h"
+#include "BufferUpdateBatch.h"
+#include "UniformAllocator.h"
+#include "RenderTargetPool.h"
+#include "RenderGraph.h"
+#include "MaterialTable.h"
+#include "JobSystem.h"
 
 #include <map>
 #include <vector>
@@ -38,7 +45,9 @@ enum class GraphicsAPIOptions
 {
 	None,
 	DirectX11,
-	OpenGL3
+	OpenGL3,
+	Null,		// headless device that records and counts calls without rendering, used for CPU benchmarking
+	Software	// CPU rasterizer that presents to memory, used as a GPU free reference renderer
 };
 
 struct PerFrameUniforms
@@ -65,6 +74,8 @@ struct DisplaySettings
 		vsync = true;
 		fullscreenMode = FullscreenMode::Windowed;
 		windowTitle = "Window";
+		headless = false;
+		framesInFlight = DS_MAX_FRAMES_IN_FLIGHT;
 	}
 
 	int32 width;
@@ -73,6 +84,12 @@ struct DisplaySettings
 	bool vsync;
 	FullscreenMode fullscreenMode;
 	std::string windowTitle;
+
+	// no window is made, the graphics device renders to an offscreen back buffer. used for batch rendering and benchmarks
+	bool headless;
+
+	// frames the CPU may run ahead of the GPU, 1 for the lowest latency up to DS_MAX_FRAMES_IN_FLIGHT for throughput
+	uint32 framesInFlight;
 };
 
 struct DisplayMode
@@ -133,13 +150,42 @@ public:
 
 	const char* GetClipboardText();
 
-	Texture* LoadTexture(std::string fileName);
+	// an async texture is created straight away and filled in over the following frames within the devices upload
+	// budget, it can be drawn with once IsTextureReady returns true. the image is decoded before returning either way
+	Texture* LoadTexture(std::string fileName, bool async = false);
+
+	// decodes the images on every thread of the job system and creates the textures once they are all decoded,
+	// the returned list matches fileNames with a null texture for every image that could not be loaded
+	std::vector<Texture*> LoadTextures(const std::vector<std::string> &fileNames, bool async = false);
+
+	// loads an image in to a free layer of the table, returns DS_INVALID_MATERIAL if it can not be loaded,
+	// does not match the size of the table or the table is full
+	uint32 LoadMaterial(MaterialTable &table, std::string fileName);
 
 	bool IsRunning();
 	void SetRunning(bool IsRunning);
 
 	Input input;
 
+	// draws pushed here during Demo::Draw or a render graph pass are sorted and submitted when the pass returns
+	RenderQueue renderQueue;
+
+	// buffer region writes made during Demo::Update and Demo::Draw are merged and uploaded before drawing
+	BufferUpdateBatch bufferUpdates;
+
+	// per draw uniforms for the current frame, flushed before the render queue is submitted
+	UniformAllocator uniformAllocator;
+
+	// transient targets for offscreen passes, every target acquired during a frame is returned when it is presented
+	RenderTargetPool renderTargetPool;
+
+	// rebuilt from Demo::BuildRenderGraph every frame, its transient targets come from renderTargetPool
+	RenderGraph renderGraph;
+
+	// runs jobs on every hardware thread, waiting on it from the main thread also runs jobs on the main thread.
+	// graphics device calls stay on the main thread, jobs prepare the data the device is given afterwards
+	JobSystem jobs;
+
 private:
 
 	void CreateResources();
@@ -147,6 +193,9 @@ private:
 
 	void OnRenderAPIChanged();
 
+	// uploads the buffer writes and uniforms of a render graph pass and draws the items it pushed
+	void SubmitPass(IGraphicsDevice* device);
+
 	// UI
 	void DrawBaseUI();
 
@@ -3,6 +3,10 @@
 
 #include "DemoCommon.h"
 #include "utility/ResourceContainer.h"
+#include "utility/Hash.h"
+
+#include <atomic>
+#include <functional>
 
 // create handle objects for all resource types
 DEFINE_RESOURCE_HANDLE(BufferHandle);
@@ -10,6 +14,13 @@ DEFINE_RESOURCE_HANDLE(ShaderHandle);
 DEFINE_RESOURCE_HANDLE(TextureHandle);
 DEFINE_RESOURCE_HANDLE(MeshHandle);
 
+// returns a new id used to sort resources, ids are unique for the lifetime of the program and 0 is never returned
+inline uint32 NextResourceSortID()
+{
+	static std::atomic<uint32> nextSortID(1);
+	return nextSortID++;
+}
+
 namespace World
 {
 	static const vec3 Right(1, 0, 0);
@@ -20,6 +31,9 @@ namespace World
 	static const vec3 Down(0, 0, -1);
 }
 
+// most frames the CPU may record ahead of the GPU, each frame in flight has its own slot of transient resources
+#define DS_MAX_FRAMES_IN_FLIGHT 3
+
 struct RenderInfo
 {
 	RenderInfo()
@@ -30,6 +44,8 @@ struct RenderInfo
 		depthBits	= 32;
 		stencilBits = 8;
 		wndPointer	= nullptr;
+		headless	= false;
+		framesInFlight = DS_MAX_FRAMES_IN_FLIGHT;
 	}
 
 	uint32 resolutionX, resolutionY;
@@ -37,6 +53,12 @@ struct RenderInfo
 	uint32 depthBits;
 	uint32 stencilBits;
 	void* wndPointer;
+
+	// render to an offscreen back buffer without a window, Present doesn't swap or wait on vsync
+	bool headless;
+
+	// 1 to DS_MAX_FRAMES_IN_FLIGHT, fewer frames lower the latency of input, more keep the GPU busy
+	uint32 framesInFlight;
 };
 
 // ==============================================
@@ -81,57 +103,109 @@ class Buffer { };
 
 enum class BaseType : int32
 {
-	Int8	= 0,
-	UInt8	= 1,
-	Int16	= 2,
-	UInt16	= 3,
-	Int32	= 4,
-	UInt32	= 5,
-	Float	= 6,
-	Double	= 7
+	Int8		= 0,
+	UInt8		= 1,
+	Int16		= 2,
+	UInt16		= 3,
+	Int32		= 4,
+	UInt32		= 5,
+	Float		= 6,
+	Double		= 7,
+	HalfFloat	= 8,
+	UInt10_10_10_2	= 9		// 4 components packed in to 32 bits, x in the low 10 bits and w in the top 2
 };
 
-static const uint32 BaseTypeSize[] = { 1, 1, 2, 2, 4, 4, 4, 8 };
+// size of one component, a packed type is the size of all of its components together
+static const uint32 BaseTypeSize[] = { 1, 1, 2, 2, 4, 4, 4, 8, 2, 4 };
 
 #define DS_TYPE_SIZE(_type) BaseTypeSize[static_cast<int32>(_type)]
+#define DS_TYPE_PACKED(_type) ((_type) == BaseType::UInt10_10_10_2)
 
+// the compact variants of an attribute sit next to the full precision one, attributes keep the same order in the
+// vertex as the full precision ones they replace so a shader reads either. a mesh has at most one of each kind
 enum class VertexAttributes
 {
-	None		= 0,
-	Position	= 1,
-	UIPosition	= 2,
-	TexCoord	= 4,
-	Color32		= 8,
-	Normal		= 16
+	None			= 0,
+	Position		= 1,
+	PositionHalf	= 2,	// 4 half floats, w is written as 1
+	UIPosition		= 4,
+	TexCoord		= 8,
+	TexCoordHalf	= 16,
+	TexCoordUNorm16	= 32,	// texture coordinates inside [0, 1] only
+	Color32			= 64,
+	Normal			= 128,
+	NormalSNorm16	= 256,	// 4 snorm16, w is written as 0
+	NormalPacked	= 512,	// unorm 10:10:10:2, stored as n * 0.5 + 0.5, shaders expand it with n * 2 - 1
+
+	// per instance attributes, read from the instance buffer of an instanced draw
+	InstanceWorld		= 1024,
+	InstanceColor32		= 2048,
+	InstanceMaterial	= 4096
 };
 ENUM_FLAGS(VertexAttributes)
 
+// bit index of each attribute in VertexAttributes, which is also its index in to attributeProperties
+#define ATTR_POSITION				0
+#define ATTR_POSITION_HALF			1
+#define ATTR_UI_POSITION			2
+#define ATTR_TEXCOORD				3
+#define ATTR_TEXCOORD_HALF			4
+#define ATTR_TEXCOORD_UNORM16		5
+#define ATTR_COLOR32				6
+#define ATTR_NORMAL					7
+#define ATTR_NORMAL_SNORM16			8
+#define ATTR_NORMAL_PACKED			9
+#define ATTR_INSTANCE_WORLD			10
+#define ATTR_INSTANCE_COLOR32		11
+#define ATTR_INSTANCE_MATERIAL		12
+
+#define DS_VERTEX_ATTRIBUTE_COUNT	13
+
+// mask of every attribute that advances once per instance instead of once per vertex
+#define INSTANCE_VERTEX_ATTRIBUTES (VertexAttributes::InstanceWorld | VertexAttributes::InstanceColor32 | VertexAttributes::InstanceMaterial)
+
 class AttributeProperties
 {
 public:
 
-	AttributeProperties(BaseType type, uint32 components, bool normalized) :
+	AttributeProperties(BaseType type, uint32 components, bool normalized, bool perInstance = false) :
 		type(type),
 		components(components),
-		normalized(normalized)
+		normalized(normalized),
+		perInstance(perInstance)
 	{
 		typeSizeBytes = DS_TYPE_SIZE(type);
+		sizeBytes = DS_TYPE_PACKED(type) ? typeSizeBytes : typeSizeBytes * components;
+
+		// attributes with more than 4 components, such as matrices, are split over several 4 component slots
+		slotCount = (components + 3) / 4;
 	}
 
 	BaseType type;
 	uint32 components;
 	bool normalized;
+	bool perInstance;
 
 	uint32 typeSizeBytes;
+	uint32 sizeBytes;
+	uint32 slotCount;
 };
 
-static const AttributeProperties attributeProperties[] =
+static const AttributeProperties attributeProperties[DS_VERTEX_ATTRIBUTE_COUNT] =
 {
-	AttributeProperties(BaseType::Float, 3, false),	// ATTR_POSITION
-	AttributeProperties(BaseType::Float, 2, false),	// ATTR_UI_POSITION
-	AttributeProperties(BaseType::Float, 2, false),	// ATTR_TEXCOORD
-	AttributeProperties(BaseType::UInt8, 4, true),	// ATTR_COLOR32
-	AttributeProperties(BaseType::Float, 3, false)	// ATTR_NORMAL
+	AttributeProperties(BaseType::Float, 3, false),				// ATTR_POSITION
+	AttributeProperties(BaseType::HalfFloat, 4, false),			// ATTR_POSITION_HALF
+	AttributeProperties(BaseType::Float, 2, false),				// ATTR_UI_POSITION
+	AttributeProperties(BaseType::Float, 2, false),				// ATTR_TEXCOORD
+	AttributeProperties(BaseType::HalfFloat, 2, false),			// ATTR_TEXCOORD_HALF
+	AttributeProperties(BaseType::UInt16, 2, true),				// ATTR_TEXCOORD_UNORM16
+	AttributeProperties(BaseType::UInt8, 4, true),				// ATTR_COLOR32
+	AttributeProperties(BaseType::Float, 3, false),				// ATTR_NORMAL
+	AttributeProperties(BaseType::Int16, 4, true),				// ATTR_NORMAL_SNORM16
+	AttributeProperties(BaseType::UInt10_10_10_2, 4, true),		// ATTR_NORMAL_PACKED
+	AttributeProperties(BaseType::Float, 16, false, true),		// ATTR_INSTANCE_WORLD
+	AttributeProperties(BaseType::UInt8, 4, true, true),		// ATTR_INSTANCE_COLOR32
+	AttributeProperties(BaseType::Float, 1, false, true)		// ATTR_INSTANCE_MATERIAL
 };
 
 // returns the total size of the vertex attributes active in attributeFlags
@@ -143,7 +217,7 @@ static uint32 GetAttributeMaskSize(VertexAttributes attributeFlags)
 	for (uint32 mask = ToIntegral(attributeFlags); mask; mask &= mask - 1)
 	{
 		uint32 index = Bit::LeastSignifcantBit(mask);
-		sizeBytes += attributeProperties[index].components * attributeProperties[index].typeSizeBytes;
+		sizeBytes += attributeProperties[index].sizeBytes;
 	}
 
 	return sizeBytes;
@@ -153,13 +227,56 @@ static uint32 GetAttributeMaskSize(VertexAttributes attributeFlags)
 // Mesh
 // ==============================================
 
+// type of each index in an index buffer
+enum class IndexFormat
+{
+	UInt16 = 0,
+	UInt32 = 1
+};
+
+#define DS_INDEX_SIZE(_format) ((_format) == IndexFormat::UInt32 ? sizeof(uint32) : sizeof(uint16))
+
+// returns the format indices are stored in on the device, 32 bit indices are narrowed to 16 bit
+// when every vertex of the mesh can be addressed with 16 bits, halving the index bandwidth
+inline IndexFormat GetDeviceIndexFormat(IndexFormat format, uint32 vertexCount)
+{
+	if (format == IndexFormat::UInt32 && vertexCount <= 0x10000)
+	{
+		return IndexFormat::UInt16;
+	}
+
+	return format;
+}
+
+// returns index data in the device format, indices that need narrowing are converted in to scratch
+inline const void* ConvertIndices(const void* indexData, uint32 indexCount, IndexFormat format, IndexFormat deviceFormat, std::vector<uint16> &scratch)
+{
+	if (indexData == nullptr || format == deviceFormat)
+	{
+		return indexData;
+	}
+
+	DS_ASSERT(format == IndexFormat::UInt32 && deviceFormat == IndexFormat::UInt16);
+
+	const uint32* indices = static_cast<const uint32*>(indexData);
+	scratch.resize(indexCount);
+
+	for (uint32 i = 0; i < indexCount; i++)
+	{
+		scratch[i] = static_cast<uint16>(indices[i]);
+	}
+
+	return scratch.data();
+}
+
 struct MeshData
 {
-	MeshData(void* vertexData, uint32 vertexCount, void* indexData, uint32 indexCount) :
+	MeshData(void* vertexData, uint32 vertexCount, void* indexData, uint32 indexCount, IndexFormat indexFormat = IndexFormat::UInt16) :
 		vertexData(vertexData),
 		vertexCount(vertexCount),
 		indexData(indexData),
-		indexCount(indexCount)
+		indexCount(indexCount),
+		indexFormat(indexFormat)
 	{}
 
 	void* vertexData;
@@ -167,6 +284,7 @@ struct MeshData
 
 	void* indexData;
 	uint32 indexCount;
+	IndexFormat indexFormat;
 };
 
 class MeshDataList
@@ -197,6 +315,9 @@ public:
 
 	uint32 vertexCount;
 	uint32 indexCount;
+
+	// indices gathered from several sources are uploaded as they are, they are never narrowed
+	IndexFormat indexFormat = IndexFormat::UInt16;
 };
 
 class Mesh
@@ -242,7 +363,8 @@ struct TextureSettings
 					TextureFilterMode filterMode = TextureFilterMode::Trilinear,
 					float anisoLevel = 16.0f,
 					bool mipMaps = true,
-					bool editable = false) :
+					bool editable = false,
+					uint32 arraySize = 1) :
 		width(width),
 		height(height),
 		format(format),
@@ -250,7 +372,8 @@ struct TextureSettings
 		filterMode(filterMode),
 		anisoLevel(anisoLevel),
 		mipMaps(mipMaps),
-		editable(editable)
+		editable(editable),
+		arraySize(arraySize)
 	{}
 
 	uint32 width;
@@ -261,9 +384,131 @@ struct TextureSettings
 	bool mipMaps;
 	bool editable;
 	TextureWrapMode wrapMode;
+
+	// a size above 1 creates a 2D texture array, the layers are stored one after another in the initial data.
+	// shaders sample arrays with sampler2DArray/Texture2DArray and the layer as the third coordinate
+	uint32 arraySize;
+};
+
+// bytes of texture data created with CreateTextureAsync that a device copies to the GPU each frame
+#define DS_DEFAULT_TEXTURE_UPLOAD_BUDGET (4 * 1024 * 1024)
+
+// bytes per texel of the formats textures are uploaded in, compressed formats have no fixed size
+inline uint32 GetTexelSize(TextureFormat format)
+{
+	switch (format)
+	{
+		case TextureFormat::RGB:
+		case TextureFormat::BGR:
+			return 3;
+		case TextureFormat::RGBA:
+		case TextureFormat::BGRA:
+			return 4;
+		default:
+			return 0;
+	}
+}
+
+class Texture
+{
+public:
+
+	// used by the render queue to group draws that use the same texture
+	uint32 sortID = NextResourceSortID();
+};
+
+// ==============================================
+
+// ==============================================
+// Render Targets
+// ==============================================
+
+#define DS_MAX_RENDER_TARGETS 4
+
+enum class RenderTargetFormat : int32
+{
+	RGBA8			= 0,
+	RGBA16F			= 1,
+	RGBA32F			= 2,
+	R32F			= 3,
+	Depth24Stencil8	= 4,
+	Depth32F		= 5
 };
 
-class Texture {};
+inline bool IsDepthFormat(RenderTargetFormat format)
+{
+	return format == RenderTargetFormat::Depth24Stencil8 || format == RenderTargetFormat::Depth32F;
+}
+
+// bytes per sample
+inline uint32 GetFormatSize(RenderTargetFormat format)
+{
+	switch (format)
+	{
+		case RenderTargetFormat::RGBA16F: return 8;
+		case RenderTargetFormat::RGBA32F: return 16;
+		default: return 4;
+	}
+}
+
+struct RenderTargetDesc
+{
+	RenderTargetDesc(uint32 width = 0, uint32 height = 0, RenderTargetFormat format = RenderTargetFormat::RGBA8, uint32 sampleCount = 1) :
+		width(width),
+		height(height),
+		format(format),
+		sampleCount(sampleCount)
+	{}
+
+	bool operator==(const RenderTargetDesc &other) const
+	{
+		return width == other.width &&
+			   height == other.height &&
+			   format == other.format &&
+			   sampleCount == other.sampleCount;
+	}
+
+	bool operator!=(const RenderTargetDesc &other) const { return !(*this == other); }
+
+	uint32 width;
+	uint32 height;
+	RenderTargetFormat format;
+
+	// a count above 1 creates a multisampled target, it has to be resolved before it can be sampled
+	uint32 sampleCount;
+};
+
+// a color or depth target that can be rendered to with SetRenderTargets
+class RenderTarget
+{
+public:
+
+	RenderTarget(const RenderTargetDesc &desc) :
+		desc(desc)
+	{}
+
+	// the texture bound with SetTexture to sample the target, owned by the target. Multisampled targets have no
+	// texture and neither does any target the device can not sample
+	Texture* GetTexture() const { return texture; }
+
+	const RenderTargetDesc& GetDesc() const { return desc; }
+
+protected:
+
+	RenderTargetDesc desc;
+	Texture* texture = nullptr;
+};
+
+// pixels copied back from a color target or the back buffer, RGBA8 rows from top to bottom with no padding.
+// the pixels belong to the device and are only valid during the callback they are passed to
+struct ReadbackData
+{
+	const uint8* pixels;
+	uint32 width;
+	uint32 height;
+};
+
+typedef std::function<void(const ReadbackData &data)> ReadbackCallback;
 
 // ==============================================
 
@@ -271,7 +516,13 @@ class Texture {};
 // Shaders
 // ==============================================
 
-class Shader {};
+class Shader
+{
+public:
+
+	// used by the render queue to group draws that use the same shader
+	uint32 sortID = NextResourceSortID();
+};
 
 enum class ShaderStage : int32
 {
@@ -281,6 +532,21 @@ enum class ShaderStage : int32
 };
 ENUM_FLAGS(ShaderStage)
 
+// options a shader variant is compiled with, each set flag defines its DS_ name to 1 before the shader source so
+// shaders select features with #if instead of branching. every combination requested is compiled once and shared
+enum class ShaderFeatures : int32
+{
+	None		= 0,
+	Textured	= 1,	// DS_TEXTURED, the color is modulated by the texture bound to slot 0
+	VertexColor	= 2,	// DS_VERTEX_COLOR, the color is modulated by the per vertex color
+	Instanced	= 4		// DS_INSTANCED, the world matrix and color are read per instance
+};
+ENUM_FLAGS(ShaderFeatures)
+
+#define DS_SHADER_FEATURE_COUNT 3
+
+static const char* const ShaderFeatureDefines[DS_SHADER_FEATURE_COUNT] = { "DS_TEXTURED", "DS_VERTEX_COLOR", "DS_INSTANCED" };
+
 // ==============================================
 
 // ==============================================
@@ -326,6 +592,18 @@ ENUM_FLAGS(ColorMask)
 
 struct BlendProperties
 {
+	BlendProperties()
+	{
+		enabled = false;
+		srcBlend = BlendFactor::One;
+		dstBlend = BlendFactor::Zero;
+		blendOp = BlendOperation::Add;
+		srcBlendAlpha = BlendFactor::One;
+		dstBlendAlpha = BlendFactor::Zero;
+		blendOpAlpha = BlendOperation::Add;
+		colorMask = static_cast<uint8>(ColorMask::All);
+	}
+
 	bool			enabled;
 	BlendFactor		srcBlend;
 	BlendFactor		dstBlend;
@@ -334,6 +612,34 @@ struct BlendProperties
 	BlendFactor		dstBlendAlpha;
 	BlendOperation	blendOpAlpha;
 	uint8			colorMask;
+
+	uint32 CalculateKey() const
+	{
+		uint32 key = FNV1A_OFFSET_BASIS;
+
+		key = Hash::Combine(key, enabled);
+		key = Hash::Combine(key, srcBlend);
+		key = Hash::Combine(key, dstBlend);
+		key = Hash::Combine(key, blendOp);
+		key = Hash::Combine(key, srcBlendAlpha);
+		key = Hash::Combine(key, dstBlendAlpha);
+		key = Hash::Combine(key, blendOpAlpha);
+		key = Hash::Combine(key, colorMask);
+
+		return key;
+	}
+
+	bool operator==(const BlendProperties &other) const
+	{
+		return enabled == other.enabled &&
+			   srcBlend == other.srcBlend &&
+			   dstBlend == other.dstBlend &&
+			   blendOp == other.blendOp &&
+			   srcBlendAlpha == other.srcBlendAlpha &&
+			   dstBlendAlpha == other.dstBlendAlpha &&
+			   blendOpAlpha == other.blendOpAlpha &&
+			   colorMask == other.colorMask;
+	}
 };
 
 class BlendState
@@ -341,6 +647,9 @@ class BlendState
 public:
 
 	BlendProperties properties;
+
+	// unique id given by the devices state cache, identical properties always return the same state
+	uint32 stateID = 0;
 };
 
 // ==============================================
@@ -379,6 +688,24 @@ struct DepthStencilOp
 	StencilOp stencilPassOp;
 	StencilOp depthFailOp;
 	ComparisonFunc stencilFunc;
+
+	uint32 CalculateKey(uint32 key) const
+	{
+		key = Hash::Combine(key, stencilfailOp);
+		key = Hash::Combine(key, stencilPassOp);
+		key = Hash::Combine(key, depthFailOp);
+		key = Hash::Combine(key, stencilFunc);
+
+		return key;
+	}
+
+	bool operator==(const DepthStencilOp &other) const
+	{
+		return stencilfailOp == other.stencilfailOp &&
+			   stencilPassOp == other.stencilPassOp &&
+			   depthFailOp == other.depthFailOp &&
+			   stencilFunc == other.stencilFunc;
+	}
 };
 
 struct DepthStencilStateDesc
@@ -419,15 +746,188 @@ struct DepthStencilStateDesc
 
 	uint32 CalculateKey()
 	{
-		stateKey = 0;
+		stateKey = FNV1A_OFFSET_BASIS;
+
+		stateKey = Hash::Combine(stateKey, depthEnabled);
+		stateKey = Hash::Combine(stateKey, depthWriteEnabled);
+		stateKey = Hash::Combine(stateKey, depthFunc);
 
+		stateKey = Hash::Combine(stateKey, stencilEnabled);
+		stateKey = Hash::Combine(stateKey, stencilRead);
+		stateKey = Hash::Combine(stateKey, stencilWrite);
 
+		stateKey = frontFace.CalculateKey(stateKey);
+		stateKey = backFace.CalculateKey(stateKey);
 
 		return stateKey;
 	}
+
+	// stateKey is derived from the other members so it is not compared
+	bool operator==(const DepthStencilStateDesc &other) const
+	{
+		return depthEnabled == other.depthEnabled &&
+			   depthWriteEnabled == other.depthWriteEnabled &&
+			   depthFunc == other.depthFunc &&
+			   stencilEnabled == other.stencilEnabled &&
+			   stencilRead == other.stencilRead &&
+			   stencilWrite == other.stencilWrite &&
+			   frontFace == other.frontFace &&
+			   backFace == other.backFace;
+	}
 };
 
-class DepthStencilState {};
+class DepthStencilState
+{
+public:
+
+	// unique id given by the devices state cache, identical descriptors always return the same state
+	uint32 stateID = 0;
+};
+
+// ==============================================
+
+// ==============================================
+// Rasterizer State
+// ==============================================
+
+enum class CullMode : int32
+{
+	None	= 0,
+	Front	= 1,
+	Back	= 2
+};
+
+enum class FillMode : int32
+{
+	Solid		= 0,
+	Wireframe	= 1
+};
+
+struct RasterizerStateDesc
+{
+	RasterizerStateDesc()
+	{
+		cullMode = CullMode::None;
+		fillMode = FillMode::Solid;
+		frontCounterClockwise = false;
+		scissorEnabled = true;
+		depthBias = 0;
+		slopeScaledDepthBias = 0.0f;
+	}
+
+	CullMode cullMode;
+	FillMode fillMode;
+
+	// winding of front facing triangles in normalized device coordinates
+	bool frontCounterClockwise;
+	bool scissorEnabled;
+
+	int32 depthBias;
+	float slopeScaledDepthBias;
+
+	uint32 CalculateKey() const
+	{
+		uint32 key = FNV1A_OFFSET_BASIS;
+
+		key = Hash::Combine(key, cullMode);
+		key = Hash::Combine(key, fillMode);
+		key = Hash::Combine(key, frontCounterClockwise);
+		key = Hash::Combine(key, scissorEnabled);
+		key = Hash::Combine(key, depthBias);
+		key = Hash::Combine(key, slopeScaledDepthBias);
+
+		return key;
+	}
+
+	bool operator==(const RasterizerStateDesc &other) const
+	{
+		return cullMode == other.cullMode &&
+			   fillMode == other.fillMode &&
+			   frontCounterClockwise == other.frontCounterClockwise &&
+			   scissorEnabled == other.scissorEnabled &&
+			   depthBias == other.depthBias &&
+			   slopeScaledDepthBias == other.slopeScaledDepthBias;
+	}
+};
+
+class RasterizerState
+{
+public:
+
+	RasterizerStateDesc desc;
+
+	// unique id given by the devices state cache, identical descriptors always return the same state
+	uint32 stateID = 0;
+};
+
+// ==============================================
+
+// ==============================================
+// Statistics
+// ==============================================
+
+// counters gathered by a graphics device over a single frame
+struct GraphicsStats
+{
+	GraphicsStats()
+	{
+		Reset();
+	}
+
+	void Reset()
+	{
+		drawCalls = 0;
+		primitives = 0;
+		stateChanges = 0;
+		stateChangesElided = 0;
+		bufferUpdates = 0;
+		bytesUploaded = 0;
+		resourcesCreated = 0;
+		resourcesReleased = 0;
+		frameWaits = 0;
+	}
+
+	void Accumulate(const GraphicsStats &other)
+	{
+		drawCalls += other.drawCalls;
+		primitives += other.primitives;
+		stateChanges += other.stateChanges;
+		stateChangesElided += other.stateChangesElided;
+		bufferUpdates += other.bufferUpdates;
+		bytesUploaded += other.bytesUploaded;
+		resourcesCreated += other.resourcesCreated;
+		resourcesReleased += other.resourcesReleased;
+		frameWaits += other.frameWaits;
+	}
+
+	uint64 drawCalls;			// number of DrawMesh/DrawMeshIndexed calls
+	uint64 primitives;			// number of triangles submitted by draw calls
+	uint64 stateChanges;		// number of shader, texture, scissor, viewport, blend and depth/stencil changes issued
+	uint64 stateChangesElided;	// number of state changes skipped because the value was already set
+	uint64 bufferUpdates;		// number of buffer and mesh update calls
+	uint64 bytesUploaded;		// total bytes passed to buffer, mesh and texture create/update calls
+	uint64 resourcesCreated;	// number of resources created
+	uint64 resourcesReleased;	// number of resources released
+	uint64 frameWaits;			// number of times Present blocked until the GPU finished the frame slot being reused
+};
+
+struct MeshArenaStats
+{
+	MeshArenaStats()
+	{
+		arenaCount = 0;
+		meshCount = 0;
+		bytesReserved = 0;
+		bytesUsed = 0;
+		freeRanges = 0;
+	}
+
+	uint32 arenaCount;		// number of vertex format and index format combinations with an arena
+	uint32 meshCount;		// number of meshes stored in arenas
+	uint64 bytesReserved;	// size of every arena vertex and index buffer
+	uint64 bytesUsed;		// bytes of the arena buffers holding mesh data
+	uint32 freeRanges;		// number of free ranges over all arenas, more than two per arena means they are fragmented
+};
 
 // ==============================================
 
@@ -440,6 +940,14 @@ class UniformBuffer
 
 };
 
+// a range of a uniform buffer, bound with SetUniformBufferRange
+struct UniformSlice
+{
+	Buffer* buffer = nullptr;
+	uint32 offset = 0;
+	uint32 size = 0;
+};
+
 // ==============================================
 
 #endif // _GRAPHICS_DEFINITIONS_H
\ No newline at end of file
@@ -3,13 +3,15 @@
 
 #include "GraphicsDefinitions.h"
 
+class CommandList;
+
 #define ALLOW_UNIMPLEMENTED_API_CALLS
 
 #if defined(_DEBUG) || defined(ALLOW_UNIMPLEMENTED_API_CALLS)
 
 #define API_IMPLEMENT(_funcName, ...)														\
 	{																						\
-		Log::WriteError("RenderAPI does not implement called function " ## _funcName);		\
+		Log::WriteError("RenderAPI does not implement called function " _funcName);			\
 		return __VA_ARGS__;																	\
 	}																						\
 
@@ -19,6 +21,16 @@
 
 #endif
 
+// resolves to the resource a handle refers to in the devices container, a stale or invalid handle is logged and
+// the calling function returns
+#define RESOLVE_HANDLE(_pResource, _container, _handle, ...)						\
+	_pResource = _container.GetResourcePointer(_handle);							\
+	if (_pResource == nullptr)														\
+	{																				\
+		LOG_ERROR("%s called with a stale or invalid handle", __FUNCTION__);		\
+		return __VA_ARGS__;															\
+	}																				\
+
 // IGraphicsDevice defines a simplistic abstraction of a Graphics API
 class IGraphicsDevice
 {
@@ -41,11 +53,25 @@ public:
 	// Drawing
 	virtual void DrawMesh(Mesh* mesh) API_IMPLEMENT("DrawMesh");
 
-	virtual void DrawMeshIndexed(Mesh* mesh, uint32 elementCount = 0, uint32 vertexOffset = 0, uint16 indexOffset = 0) API_IMPLEMENT("DrawMeshIndexed");
+	virtual void DrawMeshIndexed(Mesh* mesh, uint32 elementCount = 0, uint32 vertexOffset = 0, uint32 indexOffset = 0) API_IMPLEMENT("DrawMeshIndexed");
+
+	// draws instanceCount copies of the mesh in a single call, instanceBuffer holds one element per instance made of the
+	// per instance attributes in instanceAttributeFlags, in attribute order, drawing starts at element firstInstance
+	virtual void DrawMeshIndexedInstanced(Mesh* mesh, Buffer* instanceBuffer, VertexAttributes instanceAttributeFlags, uint32 instanceCount,
+										  uint32 firstInstance = 0, uint32 elementCount = 0, uint32 vertexOffset = 0, uint32 indexOffset = 0) API_IMPLEMENT("DrawMeshIndexedInstanced");
 
 	// Render API State
 	virtual void SetVSync(bool enabled) API_IMPLEMENT("SetVsync");
 
+	// sets how many frames the CPU may record before Present waits on the GPU, clamped to [1, DS_MAX_FRAMES_IN_FLIGHT]
+	virtual void SetFramesInFlight(uint32 count) API_IMPLEMENT("SetFramesInFlight");
+
+	virtual uint32 GetFramesInFlight() API_IMPLEMENT("GetFramesInFlight", 1);
+
+	// slot of the frame being recorded, in [0, GetFramesInFlight()). the GPU has finished the last frame that used the
+	// slot, so per frame copies of dynamic data indexed by it can be overwritten without waiting
+	virtual uint32 GetFrameSlot() API_IMPLEMENT("GetFrameSlot", 0);
+
 	virtual void SetShader(Shader* shader) API_IMPLEMENT("SetShader");
 
 	virtual void SetTexture(Texture* texture, uint32 slot) API_IMPLEMENT("SetTexture");
@@ -68,19 +94,60 @@ public:
 
 	virtual void ReleaseMesh(Mesh* mesh) = 0;
 
+	// Mesh Arenas
+	// while enabled, static meshes created from MeshData are sub-allocated from large vertex and index buffers
+	// shared by every mesh of the same vertex format, so drawing many of them does not rebind buffers. dynamic and
+	// stream meshes keep their own buffers. meshes created before the mode changes keep the storage they were created with
+	virtual void SetMeshArenasEnabled(bool enabled) API_IMPLEMENT("SetMeshArenasEnabled");
+
+	// moves the meshes of every arena together so their free space is one range, and releases arenas left empty.
+	// run it after releasing many meshes, e.g. when a level is unloaded
+	virtual void DefragmentMeshArenas() API_IMPLEMENT("DefragmentMeshArenas");
+
+	virtual MeshArenaStats GetMeshArenaStats() API_IMPLEMENT("GetMeshArenaStats", MeshArenaStats());
+
 	// Shader Resource Handling
-	virtual Shader* CreateShader(const std::string &name) API_IMPLEMENT("CreateShader", nullptr);
+	// features select the variant of the shader to compile, sources may #include files relative to their own directory.
+	// devices that compile shaders share each variant between every create of it, so release once per create
+	virtual Shader* CreateShader(const std::string &name, ShaderFeatures features = ShaderFeatures::None) API_IMPLEMENT("CreateShader", nullptr);
 
 	virtual void ReleaseShader(Shader* shader) API_IMPLEMENT("UpdateMesh");
 
+	// starts compiling the shader and returns straight away, shaders created this way compile in parallel with each
+	// other and with rendering. draws made while the bound shader is not ready are skipped. a shader that fails to
+	// compile logs its errors and never becomes ready. returns null if the shader sources can't be read
+	virtual Shader* CreateShaderAsync(const std::string &name, ShaderFeatures features = ShaderFeatures::None) API_IMPLEMENT("CreateShaderAsync", nullptr);
+
+	virtual bool IsShaderReady(Shader* shader) API_IMPLEMENT("IsShaderReady", true);
+
 	// Texture Resource Handling
 	virtual Texture* CreateTexture(uint8 *data, const TextureSettings &settings) API_IMPLEMENT("CreatureTexture", nullptr);
 
+	// replaces one layer of a texture array, or the only layer of a 2D texture, and regenerates its mip maps.
+	// data is in the format and size the texture was created with
+	virtual void UpdateTextureLayer(Texture* texture, uint32 layer, const uint8* data) API_IMPLEMENT("UpdateTextureLayer");
+
 	virtual void ReleaseTexture(Texture* pTexture) API_IMPLEMENT("ReleaseTexture");
 
+	// creates the texture straight away but copies its data to the GPU over the following frames, no more than the
+	// upload budget each frame, so large textures can be loaded while rendering without stalling a frame. the data
+	// is copied and can be freed after the call, the texture must not be sampled until IsTextureReady returns true
+	virtual Texture* CreateTextureAsync(const uint8* data, const TextureSettings &settings) API_IMPLEMENT("CreateTextureAsync", nullptr);
+
+	virtual bool IsTextureReady(Texture* texture) API_IMPLEMENT("IsTextureReady", true);
+
+	// bytes of asynchronous texture data copied each frame, uploads complete in the order they were created
+	virtual void SetTextureUploadBudget(uint32 bytesPerFrame) API_IMPLEMENT("SetTextureUploadBudget");
+
 	// Uniform Buffer Resource Handling
 	virtual void SetUniformBuffer(uint32 slot, Buffer* buffer, ShaderStage stage) API_IMPLEMENT("SetUniformBuffer");
 
+	// binds size bytes of the buffer starting at offset, offset must be a multiple of GetUniformBufferAlignment
+	virtual void SetUniformBufferRange(uint32 slot, Buffer* buffer, uint32 offset, uint32 size, ShaderStage stage) API_IMPLEMENT("SetUniformBufferRange");
+
+	// returns the alignment required for uniform buffer range offsets
+	virtual uint32 GetUniformBufferAlignment() API_IMPLEMENT("GetUniformBufferAlignment", 256);
+
 	// Buffer Resource Handling
 	virtual Buffer* CreateBuffer(const void* data, uint32 size, BufferTarget target, BufferUsage usage) API_IMPLEMENT("CreateBuffer", nullptr);
 
@@ -92,7 +159,63 @@ public:
 
 	virtual void ReleaseBuffer(Buffer* buffer) API_IMPLEMENT("ReleaseBuffer");
 
-	// UpdateBufferRegion?
+	// writes size bytes at offset in to the buffer leaving the rest of its contents untouched, the region must lie
+	// inside the buffer. Stream buffers are written in full every frame and can not be partially updated
+	virtual void UpdateBufferRegion(Buffer* buffer, const void* data, uint32 offset, uint32 size) API_IMPLEMENT("UpdateBufferRegion");
+
+	// Handle Resources
+	// resources created through a handle are owned by the device and stored by value in contiguous arrays, a
+	// released handle is detected as stale and ignored, any remaining resources are released by Destroy
+	virtual MeshHandle CreateMeshHandle(const MeshData &meshData, VertexAttributes vertexAttributeFlags, BufferUsage usage) API_IMPLEMENT("CreateMeshHandle", MeshHandle());
+
+	virtual void UpdateMesh(MeshHandle mesh, const MeshData &meshData) API_IMPLEMENT("UpdateMesh");
+
+	virtual void DrawMeshIndexed(MeshHandle mesh, uint32 elementCount = 0, uint32 vertexOffset = 0, uint32 indexOffset = 0) API_IMPLEMENT("DrawMeshIndexed");
+
+	virtual void ReleaseMesh(MeshHandle mesh) API_IMPLEMENT("ReleaseMesh");
+
+	virtual ShaderHandle CreateShaderHandle(const std::string &name) API_IMPLEMENT("CreateShaderHandle", ShaderHandle());
+
+	virtual void SetShader(ShaderHandle shader) API_IMPLEMENT("SetShader");
+
+	virtual void ReleaseShader(ShaderHandle shader) API_IMPLEMENT("ReleaseShader");
+
+	virtual TextureHandle CreateTextureHandle(uint8 *data, const TextureSettings &settings) API_IMPLEMENT("CreateTextureHandle", TextureHandle());
+
+	virtual void SetTexture(TextureHandle texture, uint32 slot) API_IMPLEMENT("SetTexture");
+
+	virtual void ReleaseTexture(TextureHandle texture) API_IMPLEMENT("ReleaseTexture");
+
+	virtual BufferHandle CreateBufferHandle(const void* data, uint32 size, BufferTarget target, BufferUsage usage) API_IMPLEMENT("CreateBufferHandle", BufferHandle());
+
+	virtual void UpdateBuffer(BufferHandle buffer, const void* data, uint32 size) API_IMPLEMENT("UpdateBuffer");
+
+	virtual void UpdateBufferRegion(BufferHandle buffer, const void* data, uint32 offset, uint32 size) API_IMPLEMENT("UpdateBufferRegion");
+
+	virtual void SetUniformBuffer(uint32 slot, BufferHandle buffer, ShaderStage stage) API_IMPLEMENT("SetUniformBuffer");
+
+	virtual void ReleaseBuffer(BufferHandle buffer) API_IMPLEMENT("ReleaseBuffer");
+
+	// Render Targets
+	virtual RenderTarget* CreateRenderTarget(const RenderTargetDesc &desc) API_IMPLEMENT("CreateRenderTarget", nullptr);
+
+	virtual void ReleaseRenderTarget(RenderTarget* target) API_IMPLEMENT("ReleaseRenderTarget");
+
+	// binds up to DS_MAX_RENDER_TARGETS color targets and an optional depth target, all of the same size and sample
+	// count. Binding no targets renders to the back buffer again, the viewport is not changed by either
+	virtual void SetRenderTargets(uint32 numColorTargets, RenderTarget* const* pColorTargets, RenderTarget* depthTarget) API_IMPLEMENT("SetRenderTargets");
+
+	// clears the whole target ignoring the scissor rect and write masks, color targets use color and depth targets
+	// use depth and stencil
+	virtual void ClearRenderTarget(RenderTarget* target, const vec4 &color, float depth = 1.0f, uint8 stencil = 0) API_IMPLEMENT("ClearRenderTarget");
+
+	// resolves a multisampled color target in to a single sampled target with the same size and format
+	virtual void ResolveRenderTarget(RenderTarget* source, RenderTarget* destination) API_IMPLEMENT("ResolveRenderTarget");
+
+	// copies the pixels of a single sampled RGBA8 target, or of the back buffer when target is null, without waiting on
+	// the GPU. the callback is made from a later Present once the copy has finished, usually a few frames on, and
+	// callbacks are made in the order they were requested. the back buffer must be read back before Present
+	virtual void RequestReadback(RenderTarget* target, ReadbackCallback callback) API_IMPLEMENT("RequestReadback");
 
 	// Scissor
 	virtual void SetScissorRects(uint32 numRects, const DSRect* pRects) API_IMPLEMENT("SetScissorRects");
@@ -100,6 +223,7 @@ public:
 	virtual void GetScissorRects(uint32* pNumRects, DSRect* pRects) API_IMPLEMENT("GetScissorRects");
 
 	// Blend State
+	// state objects are cached by the device, creating a state from an identical descriptor returns the same object
 	virtual BlendState* CreateBlendState(BlendProperties properties) API_IMPLEMENT("CreateBlendState", nullptr);
 
 	virtual void SetBlendState(BlendState* state) API_IMPLEMENT("SetBlendState");
@@ -110,6 +234,20 @@ public:
 	virtual DepthStencilState* GetCurrentDepthStencilState() API_IMPLEMENT("GetCurrentDepthStencilState", nullptr);
 
 	virtual void SetDepthStencilState(DepthStencilState* state) API_IMPLEMENT("SetDepthStencilState");
+
+	// Rasterizer State
+	virtual RasterizerState* CreateRasterizerState(const RasterizerStateDesc &desc) API_IMPLEMENT("CreateRasterizerState", nullptr);
+
+	virtual void SetRasterizerState(RasterizerState* state) API_IMPLEMENT("SetRasterizerState");
+
+	// Command Lists
+	// executes the commands recorded in each list in order on the calling thread, which must own the device
+	// the default implementation decodes each command in to the matching call on this device
+	virtual void ExecuteCommandLists(uint32 numLists, CommandList* const* pLists);
+
+	// Statistics
+	// returns the counters gathered over the last presented frame
+	virtual GraphicsStats GetFrameStats() API_IMPLEMENT("GetFrameStats", GraphicsStats());
 };
 
 #endif // _I_GRAPHICS_DEVICE_H
\ No newline at end of file
@@ -0,0 +1,120 @@
+#ifndef _JOB_SYSTEM_H
+#define _JOB_SYSTEM_H
+
+#include "DemoCommon.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+typedef std::function<void()> JobFunction;
+
+// JobCounter tracks a group of jobs, it is raised when a job is queued with it and lowered when the job finishes.
+// jobs queued with RunAfter wait for it to reach zero before they start. a counter must be waited on before it is
+// destroyed, the last job may still hold it when IsDone returns true. it can be reused once it has been waited on
+class JobCounter
+{
+public:
+
+	JobCounter() : count(0) {}
+
+	bool IsDone() const { return count.load(std::memory_order_acquire) == 0; }
+
+private:
+
+	friend class JobSystem;
+
+	std::atomic<uint32> count;
+
+	// jobs queued with RunAfter while the counter was above zero, started by the job that lowers it to zero.
+	// the count is only lowered while holding the mutex so no continuation can be added after it has been taken
+	std::mutex continuationMutex;
+	std::vector<std::pair<JobFunction, JobCounter*>> continuations;
+};
+
+// JobSystem runs jobs across all hardware threads. Every thread has its own queue, jobs queued from a thread go on
+// the back of its queue and it takes them from the back again so related jobs run while their data is in its cache.
+// threads that run out of jobs steal from the front of the other queues. the thread that initialized the system
+// runs jobs whenever it waits, so waiting on jobs from the main thread never leaves a core idle
+class JobSystem
+{
+public:
+
+	JobSystem();
+	~JobSystem();
+
+	// starts the workers, a thread count of 0 uses one thread per hardware thread. the calling thread is one of them
+	void Initialize(uint32 threadCount = 0);
+
+	// finishes every queued job and stops the workers
+	void Destroy();
+
+	// queues a job, the counter is raised now and lowered once the job has finished
+	void Run(JobFunction job, JobCounter* counter = nullptr);
+
+	// queues a job that starts once dependency reaches zero, straight away if it already has
+	void RunAfter(JobCounter &dependency, JobFunction job, JobCounter* counter = nullptr);
+
+	// runs queued jobs on the calling thread until the counter reaches zero
+	void Wait(JobCounter &counter);
+
+	// calls func(begin, end) for ranges covering [0, count) across all threads and returns once every range is done.
+	// ranges hold at least minBatchSize indices so small loop bodies are not outweighed by queueing them
+	void ParallelForRange(uint32 count, uint32 minBatchSize, const std::function<void(uint32 begin, uint32 end)> &func);
+
+	// calls func(index) for every index in [0, count) across all threads and returns once every call is done
+	template <typename TFunc>
+	void ParallelFor(uint32 count, uint32 minBatchSize, const TFunc &func)
+	{
+		ParallelForRange(count, minBatchSize, [&func](uint32 begin, uint32 end)
+		{
+			for (uint32 i = begin; i < end; i++)
+			{
+				func(i);
+			}
+		});
+	}
+
+	// number of threads running jobs including the one that initialized the system, 1 before Initialize
+	uint32 GetThreadCount() const { return static_cast<uint32>(queues.size() > 0 ? queues.size() : 1); }
+
+private:
+
+	struct Job
+	{
+		JobFunction function;
+		JobCounter* counter;
+	};
+
+	struct JobQueue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	void Push(Job job);
+
+	// takes a job from the back of the calling threads queue, or steals one from the front of another queue
+	bool Pop(Job &job);
+
+	void Execute(Job &job);
+
+	void WorkerLoop(uint32 queueIndex);
+
+	// one queue per thread, index 0 belongs to the thread that initialized the system and to threads outside of it
+	std::vector<std::unique_ptr<JobQueue>> queues;
+	std::vector<std::thread> workers;
+
+	// workers without jobs sleep until one is queued
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+	std::atomic<uint32> sleepingWorkers;
+	std::atomic<uint32> queuedJobs;
+	bool quit = false;
+};
+
+#endif // _JOB_SYSTEM_H
@@ -0,0 +1,71 @@
+#ifndef _MATERIAL_TABLE_H
+#define _MATERIAL_TABLE_H
+
+#include "GraphicsDefinitions.h"
+
+class IGraphicsDevice;
+
+#define DS_INVALID_MATERIAL 0xFFFFFFFF
+
+// MaterialTable keeps the textures of many materials as the layers of one texture array. Draws pass the layer
+// of their material per instance (VertexAttributes::InstanceMaterial), so objects with different materials
+// share the same texture binding and can be drawn in one instanced draw instead of one draw per texture.
+// every material must have the same size and format as the table. Material ids stay valid until removed,
+// the layer behind an id is reused once it has been removed
+class MaterialTable
+{
+public:
+
+	MaterialTable();
+
+	// creates the texture array, capacity is the most materials the table can hold. the array always has at
+	// least 2 layers since a texture with a single layer is created as a plain 2D texture
+	bool Create(IGraphicsDevice* device, uint32 width, uint32 height, uint32 capacity,
+				TextureFilterMode filterMode = TextureFilterMode::Trilinear, bool mipMaps = true);
+
+	void Release(IGraphicsDevice* device);
+
+	// uploads the texels of the material in to a free layer, data is width * height RGBA texels.
+	// returns DS_INVALID_MATERIAL when the table is full
+	uint32 AddMaterial(IGraphicsDevice* device, const uint8* data);
+
+	// replaces the texels of an existing material
+	void UpdateMaterial(IGraphicsDevice* device, uint32 materialID, const uint8* data);
+
+	// frees the layer of the material for reuse, the texels are left in place until it is overwritten
+	void RemoveMaterial(uint32 materialID);
+
+	bool IsValid(uint32 materialID) const;
+
+	// the value written to the InstanceMaterial attribute of instances using the material
+	float GetLayer(uint32 materialID) const;
+
+	Texture* GetTexture() const { return texture; }
+
+	uint32 GetWidth() const { return width; }
+	uint32 GetHeight() const { return height; }
+
+	uint32 GetMaterialCount() const { return materialCount; }
+	uint32 GetCapacity() const { return capacity; }
+
+private:
+
+	Texture* texture;
+
+	uint32 width;
+	uint32 height;
+	uint32 capacity;
+	uint32 materialCount;
+
+	// layer of each material id, DS_INVALID_MATERIAL for ids that have been removed
+	std::vector<uint32> materialLayers;
+
+	// removed ids and layers, reused before new ones are handed out
+	std::vector<uint32> freeMaterials;
+	std::vector<uint32> freeLayers;
+
+	// layers below this have been handed out at least once
+	uint32 nextLayer;
+};
+
+#endif // _MATERIAL_TABLE_H
@@ -0,0 +1,169 @@
+#ifndef _RENDER_GRAPH_H
+#define _RENDER_GRAPH_H
+
+#include "GraphicsDefinitions.h"
+
+#include <functional>
+
+class IGraphicsDevice;
+class RenderGraph;
+class RenderTargetPool;
+
+#define RENDER_GRAPH_INVALID_INDEX 0xFFFFFFFF
+
+// a render target declared in a RenderGraph, only valid until the graph is reset
+struct RenderGraphResource
+{
+	uint32 index = RENDER_GRAPH_INVALID_INDEX;
+
+	bool IsValid() const { return index != RENDER_GRAPH_INVALID_INDEX; }
+};
+
+// called when a pass runs, the targets it writes are already bound and the viewport covers them
+typedef std::function<void(IGraphicsDevice* device, const RenderGraph &graph)> RenderGraphExecute;
+
+// called after each pass has run while its targets are still bound, e.g. to draw what the pass queued up
+typedef std::function<void(IGraphicsDevice* device)> RenderGraphPassEnd;
+
+// declares the resources a pass uses, returned by RenderGraph::AddPass
+class RenderGraphPassBuilder
+{
+public:
+
+	RenderGraphPassBuilder(RenderGraph* graph, uint32 passIndex) :
+		graph(graph),
+		passIndex(passIndex)
+	{}
+
+	// the pass samples the resource, it runs after every pass that writes it
+	RenderGraphPassBuilder& Read(RenderGraphResource resource);
+
+	// the pass renders to the resource, color targets are bound in the order they are written
+	RenderGraphPassBuilder& Write(RenderGraphResource resource);
+
+	// the pass is never culled, for passes with results outside of the graph such as readbacks. a pass that
+	// writes nothing is culled unless it has side effects, and runs with the back buffer bound
+	RenderGraphPassBuilder& SideEffect();
+
+private:
+
+	RenderGraph* graph;
+	uint32 passIndex;
+};
+
+struct RenderGraphStats
+{
+	uint32 passCount = 0;
+	uint32 culledPassCount = 0;
+
+	// transient resources declared and the targets they were placed in
+	uint32 resourceCount = 0;
+	uint32 targetCount = 0;
+
+	// estimated memory of the targets used, and of one target per resource without aliasing
+	uint64 targetBytes = 0;
+	uint64 unaliasedBytes = 0;
+};
+
+// RenderGraph is rebuilt every frame from passes that declare the render targets they read and write. Compiling
+// orders the passes so every resource is written before it is read, culls passes whose results are never read by
+// a pass that reaches the back buffer, along with passes that have no results or side effects at all, and works
+// out the first and last pass each resource is used in. Resources with the same description whose lifetimes do
+// not overlap are placed in the same target, and the targets come from a RenderTargetPool so a graph that does not
+// change between frames creates no targets. GL3 and DX11 can not place several textures in one allocation, so only
+// resources with identical descriptions can share a target
+class RenderGraph
+{
+public:
+
+	// removes every pass and resource, outstanding resources become invalid
+	void Reset();
+
+	// a transient target, only allocated while the passes using it run
+	RenderGraphResource CreateTarget(const char* name, const RenderTargetDesc &desc);
+
+	// the back buffer, passes writing to it are the roots that keep the rest of the graph alive
+	RenderGraphResource ImportBackBuffer(uint32 width, uint32 height);
+
+	RenderGraphPassBuilder AddPass(const char* name, RenderGraphExecute execute);
+
+	// orders and culls the passes and assigns targets to the transient resources
+	void Compile();
+
+	// runs the passes in order, binding the targets each one writes. The back buffer is bound when it returns
+	void Execute(IGraphicsDevice* device, RenderTargetPool &pool, const RenderGraphPassEnd &passEnd = nullptr);
+
+	// only valid from inside a pass that reads or writes the resource
+	RenderTarget* GetTarget(RenderGraphResource resource) const;
+	Texture* GetTexture(RenderGraphResource resource) const;
+
+	const RenderTargetDesc& GetDesc(RenderGraphResource resource) const { return resources[resource.index].desc; }
+
+	const RenderGraphStats& GetStats() const { return stats; }
+
+private:
+
+	friend class RenderGraphPassBuilder;
+
+	struct ResourceNode
+	{
+		const char* name;
+		RenderTargetDesc desc;
+		bool imported;
+
+		// passes writing the resource in the order they were added, and the number of passes reading it
+		std::vector<uint32> writers;
+		uint32 readerCount;
+		uint32 refCount;
+
+		// positions in the execution order of the first and last pass using the resource
+		uint32 firstUse;
+		uint32 lastUse;
+
+		uint32 targetIndex;
+	};
+
+	struct PassNode
+	{
+		const char* name;
+		RenderGraphExecute execute;
+
+		std::vector<uint32> reads;
+		std::vector<uint32> writes;
+
+		bool sideEffect;
+		bool culled;
+		uint32 refCount;
+	};
+
+	// a target shared by resources with the same description, acquired from the pool for firstUse to lastUse
+	struct TransientTarget
+	{
+		RenderTargetDesc desc;
+		uint32 firstUse;
+		uint32 lastUse;
+		RenderTarget* target;
+	};
+
+	void CullPasses();
+	void OrderPasses();
+	void AssignTargets();
+
+	void BindPassTargets(IGraphicsDevice* device, const PassNode &pass);
+
+	bool Writes(const PassNode &pass, uint32 resourceIndex) const;
+
+	std::vector<ResourceNode> resources;
+	std::vector<PassNode> passes;
+
+	// indices of the passes left after culling, in the order they run
+	std::vector<uint32> order;
+
+	std::vector<TransientTarget> targets;
+
+	uint32 backBufferIndex = RENDER_GRAPH_INVALID_INDEX;
+
+	RenderGraphStats stats;
+};
+
+#endif // _RENDER_GRAPH_H
@@ -0,0 +1,103 @@
+#ifndef _RENDER_QUEUE_H
+#define _RENDER_QUEUE_H
+
+#include "GraphicsDefinitions.h"
+
+class IGraphicsDevice;
+
+#define RENDER_QUEUE_MAX_TEXTURES 4
+
+// per draw uniforms are bound to this slot for the vertex and pixel stages, slot 0 holds the per frame uniforms
+#define RENDER_QUEUE_UNIFORM_SLOT 1
+
+// a single draw pushed in to the render queue. null blend, depth stencil and rasterizer states use the devices
+// default state, a null shader or texture keeps whatever was bound for the previous draw
+struct RenderItem
+{
+	RenderItem()
+	{
+		mesh = nullptr;
+		shader = nullptr;
+
+		for (uint32 t = 0; t < RENDER_QUEUE_MAX_TEXTURES; t++)
+		{
+			textures[t] = nullptr;
+		}
+
+		blendState = nullptr;
+		depthStencilState = nullptr;
+		rasterizerState = nullptr;
+
+		elementCount = 0;
+		vertexOffset = 0;
+		indexOffset = 0;
+
+		viewDepth = 0.0f;
+		transparent = false;
+	}
+
+	Mesh* mesh;
+	Shader* shader;
+	Texture* textures[RENDER_QUEUE_MAX_TEXTURES];
+
+	BlendState* blendState;
+	DepthStencilState* depthStencilState;
+	RasterizerState* rasterizerState;
+
+	// usually allocated from a UniformAllocator, not bound when it has no buffer
+	UniformSlice uniforms;
+
+	// passed to DrawMeshIndexed, an element count of 0 draws every index in the mesh
+	uint32 elementCount;
+	uint32 vertexOffset;
+	uint32 indexOffset;
+
+	// distance from the camera along the view direction, opaque items are drawn front to back
+	// and transparent items back to front
+	float viewDepth;
+	bool transparent;
+};
+
+// RenderQueue collects the draws for a frame and sorts them by a 64 bit key before submitting them to a device.
+// opaque items are grouped by shader, state and texture so the fewest state changes are made, transparent items
+// are ordered by depth first so they blend correctly. Memory is kept between frames, once the queue has grown to
+// the number of items drawn in a frame no more allocations are made
+class RenderQueue
+{
+public:
+
+	RenderQueue(uint32 initialCapacity = 1024);
+
+	// removes all items, the memory is kept for the next frame
+	void Reset();
+
+	void Push(const RenderItem &item);
+
+	// sorts the items by their keys, called by Submit when the queue has changed since it was last sorted
+	void Sort();
+
+	// sorts and issues every item to the device, only state that differs from the previous item is set
+	void Submit(IGraphicsDevice* device);
+
+	uint32 GetItemCount() const { return static_cast<uint32>(items.size()); }
+
+	// number of shader, texture and state changes issued by the last Submit
+	uint32 GetStateChangeCount() const { return stateChanges; }
+
+private:
+
+	uint64 CalculateKey(const RenderItem &item) const;
+
+	std::vector<RenderItem> items;
+
+	// keys and item indices are sorted together, the temp arrays are used by the radix sort passes
+	std::vector<uint64> keys;
+	std::vector<uint64> tempKeys;
+	std::vector<uint32> sortedItems;
+	std::vector<uint32> tempItems;
+
+	bool sorted;
+	uint32 stateChanges;
+};
+
+#endif // _RENDER_QUEUE_H
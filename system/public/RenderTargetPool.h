@@ -0,0 +1,57 @@
+#ifndef _RENDER_TARGET_POOL_H
+#define _RENDER_TARGET_POOL_H
+
+#include "GraphicsDefinitions.h"
+
+class IGraphicsDevice;
+
+// frames a pooled target can go without being acquired before it is destroyed
+#define RENDER_TARGET_POOL_MAX_UNUSED_FRAMES 8
+
+// RenderTargetPool hands out transient render targets for passes such as post processing. A target acquired with
+// the same description as one released earlier is reused instead of created, so once the passes of a frame have run
+// once no targets are created or destroyed. Targets are only valid until they are released or the frame ends, every
+// target still acquired is returned to the pool by EndFrame. Targets that go unused are destroyed after a few frames
+class RenderTargetPool
+{
+public:
+
+	RenderTargetPool(uint32 maxUnusedFrames = RENDER_TARGET_POOL_MAX_UNUSED_FRAMES);
+
+	// returns a free target matching the description, creating one when there is none. Returns nullptr on failure
+	RenderTarget* Acquire(IGraphicsDevice* device, const RenderTargetDesc &desc);
+
+	// returns the target to the pool before the end of the frame so a later pass in the frame can reuse it
+	void Release(RenderTarget* target);
+
+	// returns every acquired target to the pool and destroys the targets that have not been used recently
+	void EndFrame(IGraphicsDevice* device);
+
+	// destroys every target, outstanding targets must no longer be used
+	void Clear(IGraphicsDevice* device);
+
+	uint32 GetTargetCount() const { return static_cast<uint32>(targets.size()); }
+	uint32 GetAcquiredCount() const;
+
+	// number of targets created during the last frame, 0 once the pool has settled
+	uint32 GetCreatedLastFrame() const { return createdLastFrame; }
+
+private:
+
+	struct PooledTarget
+	{
+		RenderTarget* target;
+		uint64 lastUsedFrame;
+		bool acquired;
+	};
+
+	std::vector<PooledTarget> targets;
+
+	uint64 frame;
+	uint32 maxUnusedFrames;
+
+	uint32 createdThisFrame;
+	uint32 createdLastFrame;
+};
+
+#endif // _RENDER_TARGET_POOL_H
@@ -0,0 +1,64 @@
+#ifndef _UNIFORM_ALLOCATOR_H
+#define _UNIFORM_ALLOCATOR_H
+
+#include "GraphicsDefinitions.h"
+
+class IGraphicsDevice;
+
+// UniformAllocator hands out aligned slices of large uniform buffers for per draw constants. Slices are written
+// on the CPU and uploaded with a single buffer update when the allocator is flushed, each draw then binds its own
+// slice with SetUniformBufferRange. A flush only uploads the slices allocated since the previous one, in to a
+// buffer of their own so slices from earlier flushes keep their offsets. Most frames flush once, a frame flushed
+// between render graph passes uses one buffer per flush. The buffers are stream buffers so the upload never
+// waits on the GPU reading the previous frame. Slices are only valid until the allocator is reset
+class UniformAllocator
+{
+public:
+
+	UniformAllocator();
+
+	// creates the buffer, capacityBytes is the most uniform data that can be allocated in one frame
+	bool Create(IGraphicsDevice* device, uint32 capacityBytes);
+
+	void Release(IGraphicsDevice* device);
+
+	// starts a new frame, every slice from the previous frame is discarded
+	void Reset();
+
+	// returns a pointer to size bytes to be filled in before the allocator is flushed, or nullptr when the
+	// capacity of the frame has been used up
+	void* Allocate(uint32 size, UniformSlice &slice);
+
+	template <typename T>
+	T* Allocate(UniformSlice &slice) { return static_cast<T*>(Allocate(sizeof(T), slice)); }
+
+	// copies the data in to a new slice, the returned slice has no buffer when the capacity has been used up
+	UniformSlice Push(const void* data, uint32 size);
+
+	// uploads the slices allocated since the last flush in one update, draws that use them must be issued after this
+	void Flush(IGraphicsDevice* device);
+
+	uint32 GetUsedBytes() const { return usedBytes; }
+	uint32 GetCapacity() const { return static_cast<uint32>(frameData.size()); }
+
+private:
+
+	bool CreateNextBuffer(IGraphicsDevice* device);
+
+	// one per flush made in a frame, created the first time a frame flushes that often
+	std::vector<Buffer*> buffers;
+
+	// buffer the slices allocated since the last flush are uploaded to
+	uint32 bufferIndex;
+
+	// the frames slices, uploaded by Flush
+	std::vector<uint8> frameData;
+
+	uint32 alignment;
+	uint32 usedBytes;
+
+	// bytes of frameData already uploaded this frame, the slices of bufferIndex start here
+	uint32 flushedBytes;
+};
+
+#endif // _UNIFORM_ALLOCATOR_H
@@ -0,0 +1,35 @@
+#ifndef _VERTEX_QUANTIZATION_H
+#define _VERTEX_QUANTIZATION_H
+
+#include "GraphicsDefinitions.h"
+
+// Vertex quantization converts vertices between the full precision attributes and their compact variants on the
+// CPU, so meshes can be authored with floats and uploaded with half the vertex size. the conversion is done once
+// when the mesh is loaded, devices read the compact attributes directly.
+// attributes of the same kind (e.g. Position and PositionHalf) hold the same value at different precisions
+
+// returns attributeFlags with each full precision attribute replaced by its compact variant. positions and
+// texture coordinates become half floats, unitTexCoords selects unorm16 coordinates instead for meshes whose
+// coordinates are all inside [0, 1], normals are packed in to 10:10:10:2
+VertexAttributes GetCompactVertexAttributes(VertexAttributes attributeFlags, bool unitTexCoords = false);
+
+// the full precision attribute index of the kind an attribute index belongs to, e.g. ATTR_POSITION for ATTR_POSITION_HALF
+uint32 GetAttributeKind(uint32 attributeIndex);
+
+// reads the value of the attribute stored at src, normalized and packed values are expanded back in to the range
+// they were written from. components the attribute doesn't store read as 0, except w which reads as 1
+vec4 ReadVertexAttribute(uint32 attributeIndex, const uint8* src);
+
+// stores value at dst in the format of the attribute, values are clamped to the range of normalized formats
+void WriteVertexAttribute(uint32 attributeIndex, const vec4 &value, uint8* dst);
+
+// converts vertexCount vertices laid out with srcFlags in to dst laid out with dstFlags, each attribute in
+// dstFlags is written from the attribute of the same kind in srcFlags. dst must hold GetAttributeMaskSize(dstFlags)
+// bytes per vertex. returns false without writing anything if an attribute of dstFlags has no source
+bool QuantizeVertices(const void* src, VertexAttributes srcFlags, void* dst, VertexAttributes dstFlags, uint32 vertexCount);
+
+// converts the vertices of meshData in to storage and returns mesh data using them, the indices are shared with
+// meshData. the returned vertex data is null if the conversion failed
+MeshData QuantizeMeshData(const MeshData &meshData, VertexAttributes srcFlags, VertexAttributes dstFlags, std::vector<uint8> &storage);
+
+#endif // _VERTEX_QUANTIZATION_H
@@ -2,17 +2,24 @@
 #define _DS_BIT_H
 
 #include "DemoTypes.h"
-#include <intrin.h>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
 #pragma intrinsic(_BitScanForward)
+#endif
 
 namespace Bit
 {
+	// mask must be non zero
 	inline uint32 LeastSignifcantBit(uint32 mask)
 	{
+#if defined(_MSC_VER)
 		unsigned long index;
 		_BitScanForward(&index, mask);
 		return index;
+#else
+		return static_cast<uint32>(__builtin_ctz(mask));
+#endif
 	}
 }
 
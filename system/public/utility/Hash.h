@@ -0,0 +1,50 @@
+#ifndef _DS_HASH_H
+#define _DS_HASH_H
+
+#include "DemoTypes.h"
+
+#define FNV1A_OFFSET_BASIS 2166136261u
+#define FNV1A_PRIME 16777619u
+
+#define FNV1A_64_OFFSET_BASIS 14695981039346656037ull
+#define FNV1A_64_PRIME 1099511628211ull
+
+namespace Hash
+{
+	// 32 bit FNV-1a hash of size bytes, pass a previous result as hash to continue hashing more data
+	inline uint32 FNV1a(const void* data, uint32 size, uint32 hash = FNV1A_OFFSET_BASIS)
+	{
+		const uint8* bytes = static_cast<const uint8*>(data);
+
+		for (uint32 i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= FNV1A_PRIME;
+		}
+
+		return hash;
+	}
+
+	// 64 bit FNV-1a hash, used for keys that are stored and compared across runs where a collision would go unnoticed
+	inline uint64 FNV1a64(const void* data, uint64 size, uint64 hash = FNV1A_64_OFFSET_BASIS)
+	{
+		const uint8* bytes = static_cast<const uint8*>(data);
+
+		for (uint64 i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= FNV1A_64_PRIME;
+		}
+
+		return hash;
+	}
+
+	// hashes a single value on to hash, structures are hashed member by member so padding is never read
+	template <typename T>
+	inline uint32 Combine(uint32 hash, const T &value)
+	{
+		return FNV1a(&value, sizeof(T), hash);
+	}
+}
+
+#endif // _DS_HASH_H
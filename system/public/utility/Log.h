@@ -96,10 +96,10 @@ private:
 	}
 };
 
-#define LOG(_format, ...) Log::Write(_format, __VA_ARGS__)
+#define LOG(_format, ...) Log::Write(_format, ##__VA_ARGS__)
 
-#define LOG_ERROR(_format, ...) Log::WriteError(_format, __VA_ARGS__)
+#define LOG_ERROR(_format, ...) Log::WriteError(_format, ##__VA_ARGS__)
 
-#define LOG_WARNING(_format, ...) Log::WriteWarning(_format, __VA_ARGS__)
+#define LOG_WARNING(_format, ...) Log::WriteWarning(_format, ##__VA_ARGS__)
 
 #endif // _LOG_H
\ No newline at end of file
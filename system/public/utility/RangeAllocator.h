@@ -0,0 +1,169 @@
+#ifndef _DS_RANGE_ALLOCATOR_H
+#define _DS_RANGE_ALLOCATOR_H
+
+#include "DemoCommon.h"
+
+#include <iterator>
+#include <map>
+
+#define _RANGE_INVALID_OFFSET 0xFFFFFFFF
+
+// RangeAllocator sub-allocates ranges of a linear space, e.g. the elements of a buffer shared by many meshes.
+// Units are whatever the caller counts in, the allocator never touches the memory itself. Free ranges are kept
+// sorted by offset and merged with their neighbours when a range is freed, an allocation takes the smallest free
+// range it fits in so large free ranges are kept for large allocations
+class RangeAllocator
+{
+public:
+
+	static const uint32 InvalidOffset = _RANGE_INVALID_OFFSET;
+
+	RangeAllocator(uint32 capacity = 0)
+	{
+		Reset(capacity);
+	}
+
+	// forgets every allocation, the whole space is one free range again
+	void Reset(uint32 newCapacity)
+	{
+		freeRanges.clear();
+
+		capacity = newCapacity;
+		freeSize = newCapacity;
+
+		if (newCapacity > 0)
+		{
+			freeRanges[0] = newCapacity;
+		}
+	}
+
+	// returns the offset of size free units, InvalidOffset if no free range is large enough
+	uint32 Allocate(uint32 size)
+	{
+		// empty allocations take no space, any offset is as good as another
+		if (size == 0)
+			return 0;
+
+		auto best = freeRanges.end();
+
+		for (auto range = freeRanges.begin(); range != freeRanges.end(); ++range)
+		{
+			if (range->second >= size && (best == freeRanges.end() || range->second < best->second))
+			{
+				best = range;
+
+				if (range->second == size)
+					break;
+			}
+		}
+
+		if (best == freeRanges.end())
+			return InvalidOffset;
+
+		uint32 offset = best->first;
+		uint32 remaining = best->second - size;
+
+		freeRanges.erase(best);
+
+		if (remaining > 0)
+		{
+			freeRanges[offset + size] = remaining;
+		}
+
+		freeSize -= size;
+
+		return offset;
+	}
+
+	// returns a range given out by Allocate
+	void Free(uint32 offset, uint32 size)
+	{
+		if (size == 0)
+			return;
+
+		DS_ASSERT(offset + size <= capacity); // range must lie inside the space
+
+		auto next = freeRanges.lower_bound(offset);
+
+		DS_ASSERT(next == freeRanges.end() || offset + size <= next->first); // range must not be free already
+
+		// merge with the free range that ends where this one starts
+		if (next != freeRanges.begin())
+		{
+			auto prev = std::prev(next);
+
+			DS_ASSERT(prev->first + prev->second <= offset); // range must not be free already
+
+			if (prev->first + prev->second == offset)
+			{
+				offset = prev->first;
+				size += prev->second;
+				freeRanges.erase(prev);
+			}
+		}
+
+		// and the one that starts where it ends
+		if (next != freeRanges.end() && next->first == offset + size)
+		{
+			size += next->second;
+			freeRanges.erase(next);
+		}
+
+		freeRanges[offset] = size;
+		freeSize += size;
+	}
+
+	// extends the space, the added units join the free range at the end if there is one
+	void Grow(uint32 newCapacity)
+	{
+		DS_ASSERT(newCapacity >= capacity); // the space can only grow, Reset shrinks it
+
+		uint32 added = newCapacity - capacity;
+		uint32 oldCapacity = capacity;
+
+		capacity = newCapacity;
+
+		// the added units were never part of freeSize, freeing them counts them
+		if (added > 0)
+		{
+			Free(oldCapacity, added);
+		}
+	}
+
+	uint32 GetCapacity() const { return capacity; }
+
+	uint32 GetFreeSize() const { return freeSize; }
+
+	uint32 GetUsedSize() const { return capacity - freeSize; }
+
+	// a space with more than one free range is fragmented, allocations may fail even though GetFreeSize is large enough
+	uint32 GetFreeRangeCount() const { return static_cast<uint32>(freeRanges.size()); }
+
+	// true when the free space is one range at the end, compacting the allocations would not gain anything
+	bool IsCompact() const
+	{
+		return freeRanges.empty() || (freeRanges.size() == 1 && freeRanges.begin()->first + freeRanges.begin()->second == capacity);
+	}
+
+	uint32 GetLargestFreeRange() const
+	{
+		uint32 largest = 0;
+
+		for (auto const &range : freeRanges)
+		{
+			largest = range.second > largest ? range.second : largest;
+		}
+
+		return largest;
+	}
+
+private:
+
+	// offset to size of every free range
+	std::map<uint32, uint32> freeRanges;
+
+	uint32 capacity;
+	uint32 freeSize;
+};
+
+#endif // _DS_RANGE_ALLOCATOR_H
@@ -1,69 +1,177 @@
 #ifndef _DS_RESOURCE_CONTAINER_H
 #define _DS_RESOURCE_CONTAINER_H
 
-#include "DemoTypes.h"
+#include "DemoCommon.h"
 
-#define _CONTAINER_INITIAL_SIZE 4
-#define _CONTAINER_EXPAND 2
-
-#define DEFINE_RESOURCE_HANDLE(_name)		\
-		struct _name { uint32 index; };	\
+#include <vector>
 
+#define _CONTAINER_INITIAL_SIZE 4
+#define _CONTAINER_INVALID_INDEX 0xFFFFFFFF
+
+// a handle is the index of a slot in a ResourceContainer and the generation of that slot when the resource
+// was created, a generation of 0 is never given out so a default constructed handle is always invalid
+#define DEFINE_RESOURCE_HANDLE(_name)															\
+		struct _name																			\
+		{																						\
+			uint32 index = 0;																	\
+			uint32 generation = 0;																\
+																								\
+			bool IsValid() const { return generation != 0; }									\
+																								\
+			bool operator==(const _name &other) const											\
+			{																					\
+				return index == other.index && generation == other.generation;					\
+			}																					\
+																								\
+			bool operator!=(const _name &other) const { return !(*this == other); }				\
+		};																						\
+
+// ResourceContainer is a generational slot map. Resources are stored by value in a dense array and handed out
+// as handles, create, release and lookup are all O(1). Releasing a resource moves the last resource in to its
+// place to keep the array dense and increments the generation of its slot, so any handle to the released
+// resource no longer matches and is detected as stale instead of reading another resource.
+// pointers returned by GetResourcePointer are only valid until the next CreateResource or ReleaseResource
 template <typename T, typename H>
 class ResourceContainer
 {
 public:
-	
-	ResourceContainer(uint32 initialSize = containerInitialiSize)
+
+	ResourceContainer(uint32 initialSize = _CONTAINER_INITIAL_SIZE)
 	{
-		resources = new T[initialSize];
-		capacity = initialSize;
+		resources.reserve(initialSize);
+		denseToSlot.reserve(initialSize);
+		slots.reserve(initialSize);
 	}
 
-	~ResourceContainer()
+	// moves the resource in to the container and returns a handle to it
+	H CreateResource(T resource)
 	{
-		delete[] resources;
+		uint32 slotIndex = freeSlot;
+
+		if (slotIndex != _CONTAINER_INVALID_INDEX)
+		{
+			freeSlot = slots[slotIndex].nextFree;
+		}
+		else
+		{
+			slotIndex = static_cast<uint32>(slots.size());
+			slots.push_back(Slot());
+		}
+
+		Slot &slot = slots[slotIndex];
+		slot.denseIndex = static_cast<uint32>(resources.size());
+		slot.nextFree = _CONTAINER_INVALID_INDEX;
+
+		resources.push_back(std::move(resource));
+		denseToSlot.push_back(slotIndex);
+
+		H handle;
+		handle.index = slotIndex;
+		handle.generation = slot.generation;
+
+		return handle;
 	}
 
-	H CreateResource()
+	// returns false if the handle is stale or invalid
+	bool ReleaseResource(H handle)
 	{
-		H a;
-		return a;
+		if (!IsValid(handle))
+			return false;
+
+		Slot &slot = slots[handle.index];
+		uint32 denseIndex = slot.denseIndex;
+		uint32 lastIndex = static_cast<uint32>(resources.size()) - 1;
+
+		// fill the hole with the last resource so the array stays dense
+		if (denseIndex != lastIndex)
+		{
+			resources[denseIndex] = std::move(resources[lastIndex]);
+			denseToSlot[denseIndex] = denseToSlot[lastIndex];
+			slots[denseToSlot[denseIndex]].denseIndex = denseIndex;
+		}
+
+		resources.pop_back();
+		denseToSlot.pop_back();
+
+		// outstanding handles to this slot become stale, 0 is skipped as it marks an invalid handle
+		if (++slot.generation == 0)
+		{
+			slot.generation = 1;
+		}
+
+		slot.denseIndex = _CONTAINER_INVALID_INDEX;
+		slot.nextFree = freeSlot;
+		freeSlot = handle.index;
+
+		return true;
 	}
 
-	void ReleaseResource(H handle)
+	bool IsValid(H handle) const
 	{
-
+		return handle.generation != 0 &&
+			   handle.index < slots.size() &&
+			   slots[handle.index].generation == handle.generation;
 	}
 
+	// the handle must be valid
 	T& GetResource(H handle)
 	{
-		T a;
-		return a;
+		DS_ASSERT(IsValid(handle));
+		return resources[slots[handle.index].denseIndex];
 	}
 
+	// returns nullptr if the handle is stale or invalid
 	T* GetResourcePointer(H handle)
 	{
+		if (!IsValid(handle))
+			return nullptr;
 
+		return &resources[slots[handle.index].denseIndex];
 	}
 
-private:
-
-	void Expand()
+	// releases every resource, all outstanding handles become stale
+	void Clear()
 	{
-
+		for (uint32 denseIndex = 0; denseIndex < denseToSlot.size(); denseIndex++)
+		{
+			Slot &slot = slots[denseToSlot[denseIndex]];
+
+			if (++slot.generation == 0)
+			{
+				slot.generation = 1;
+			}
+
+			slot.denseIndex = _CONTAINER_INVALID_INDEX;
+			slot.nextFree = freeSlot;
+			freeSlot = denseToSlot[denseIndex];
+		}
+
+		resources.clear();
+		denseToSlot.clear();
 	}
 
-	void Resize() 
-	{
+	uint32 GetCount() const { return static_cast<uint32>(resources.size()); }
 
-	}
+	// iterates the live resources in dense order, which is not the order they were created in
+	typename std::vector<T>::iterator begin() { return resources.begin(); }
+	typename std::vector<T>::iterator end() { return resources.end(); }
 
-	T* resources = nullptr;
-	uint32 capacity = 0;
+private:
 
-	static const uint32 containerInitialiSize = 4;
-	static const uint32 containerExpand = 2;
+	struct Slot
+	{
+		uint32 denseIndex = _CONTAINER_INVALID_INDEX;
+		uint32 generation = 1;
+		uint32 nextFree = _CONTAINER_INVALID_INDEX;
+	};
+
+	// resources and the slot that owns each of them, in the same order
+	std::vector<T> resources;
+	std::vector<uint32> denseToSlot;
+
+	// indexed by handle.index, released slots form a linked list starting at freeSlot
+	std::vector<Slot> slots;
+	uint32 freeSlot = _CONTAINER_INVALID_INDEX;
 };
 
-#endif // _DS_RESOURCE_CONTAINER_H
\ No newline at end of file
+#endif // _DS_RESOURCE_CONTAINER_H
@@ -0,0 +1,70 @@
+#ifndef _DS_STATE_CACHE_H
+#define _DS_STATE_CACHE_H
+
+#include "DemoTypes.h"
+
+#include <unordered_map>
+
+// StateCache deduplicates immutable state objects created from a descriptor. States are found by the hash
+// of their descriptor and the full descriptor is compared to resolve collisions. Every state added is given
+// a small unique stateID that can be used to sort draws by state. The cache owns the states it holds
+template <typename TDesc, typename TState>
+class StateCache
+{
+public:
+
+	// returns the cached state created from an identical descriptor, or nullptr
+	TState* Find(uint32 key, const TDesc &desc) const
+	{
+		auto range = states.equal_range(key);
+
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			if (it->second.desc == desc)
+			{
+				return it->second.state;
+			}
+		}
+
+		return nullptr;
+	}
+
+	TState* Add(uint32 key, const TDesc &desc, TState* state)
+	{
+		state->stateID = nextStateID++;
+
+		CachedState cached = { desc, state };
+		states.insert(std::make_pair(key, cached));
+
+		return state;
+	}
+
+	// passes every cached state to release and empties the cache
+	template <typename TRelease>
+	void Clear(TRelease release)
+	{
+		for (auto &cached : states)
+		{
+			release(cached.second.state);
+		}
+
+		states.clear();
+	}
+
+	uint32 GetCount() const { return static_cast<uint32>(states.size()); }
+
+private:
+
+	struct CachedState
+	{
+		TDesc desc;
+		TState* state;
+	};
+
+	std::unordered_multimap<uint32, CachedState> states;
+
+	// 0 is never given out so it can be used for no state
+	uint32 nextStateID = 1;
+};
+
+#endif // _DS_STATE_CACHE_H
@@ -1,10 +1,14 @@
-#ifndef _TIME_H
-#define _TIME_H
+#ifndef _DS_TIME_H
+#define _DS_TIME_H
 
 #include "DemoTypes.h"
 #include "DemoCommon.h"
 
-#define MILLISECONDS_2_SECONDS 0.001f
+#if !defined(_WIN32)
+#include <time.h>
+#endif
+
+#define MICROSECONDS_2_SECONDS 0.000001
 
 class Time
 {
@@ -16,14 +20,14 @@ public:
 		SetDeltaTime(0.0f);
 		SetTime(0.0f);
 		SetFrameCount(0);
-		SetLastTime(MillisecondsNow());
+		SetLastTime(MicrosecondsNow());
 	}
 
 	// updates the time, should only be called by DemoSystem once per frame, not by the user
 	static void UpdateTime()
 	{
 		// calculate time since last update, and update the total time
-		int64 now = MillisecondsNow();
+		int64 now = MicrosecondsNow();
 		SetDeltaTime(GetElapsedTime(now));
 		SetTime(GetTime() + GetDeltaTime());
 
@@ -35,7 +39,7 @@ public:
 	// returns the real time since the application started in seconds
 	static float GetRealTime()
 	{
-		return GetTime() + GetElapsedTime(MillisecondsNow());
+		return GetTime() + GetElapsedTime(MicrosecondsNow());
 	}
 
 	// amount of time passed since the last update in seconds
@@ -67,12 +71,12 @@ private:
 
 	static float GetElapsedTime(int64 now)
 	{
-		return static_cast<float>(now - GetLastTime()) * MILLISECONDS_2_SECONDS;
+		return static_cast<float>(static_cast<double>(now - GetLastTime()) * MICROSECONDS_2_SECONDS);
 	}
 
-	// #if define(_PLATFORM_WIN32)
-	// #elif define(_PLATFORM_LINUX)
-	static int64 MillisecondsNow()
+	// microsecond resolution keeps delta time non zero for uncapped headless runs
+#if defined(_WIN32)
+	static int64 MicrosecondsNow()
 	{
 		static LARGE_INTEGER frequency;
 		static BOOL useQPC = QueryPerformanceFrequency(&frequency);
@@ -81,13 +85,21 @@ private:
 		{
 			LARGE_INTEGER now;
 			QueryPerformanceCounter(&now);
-			return (1000LL * now.QuadPart) / frequency.QuadPart;
+			return (now.QuadPart / frequency.QuadPart) * 1000000LL + ((now.QuadPart % frequency.QuadPart) * 1000000LL) / frequency.QuadPart;
 		}
 		else
 		{
-			return GetTickCount();
+			return static_cast<int64>(GetTickCount()) * 1000LL;
 		}
 	}
+#else
+	static int64 MicrosecondsNow()
+	{
+		timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return static_cast<int64>(now.tv_sec) * 1000000LL + now.tv_nsec / 1000;
+	}
+#endif
 };
 
-#endif // _TIME_H
\ No newline at end of file
+#endif // _DS_TIME_H
\ No newline at end of file